@@ -23,10 +23,23 @@
 */
 
 #include "BehaviorOrchard.hpp"
+#include "view/IconArtProvider.hpp"
 
 bool BehaviorOrchard::OnInit()
 {
-    auto frame = new MainFrame();
+    startup.mark("toolkit");
+    // "--startup-time" prints how long each phase took up to the first frame and quits, for scripts
+    // tracking the cold start.
+    auto exit_after_start = false;
+    for(const auto &argument: argv.GetArguments())
+    {
+        exit_after_start = exit_after_start || argument == "--startup-time";
+    }
+
+    wxArtProvider::Push(new IconArtProvider);
+    auto frame = new MainFrame(startup, exit_after_start);
+    startup.mark("main frame");
     frame->Show(true);
+    startup.mark("shown");
     return true;
 }
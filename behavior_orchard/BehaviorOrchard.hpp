@@ -25,6 +25,7 @@
 #pragma once
 
 #include "frames/MainFrame.hpp"
+#include "view/StartupTimer.hpp"
 
 #include <wx/app.h>
 
@@ -33,6 +34,10 @@ class BehaviorOrchard: public wxApp
 {
 public:
     bool OnInit() override;
+
+private:
+    // Started with the application object, which wxWidgets creates before initializing the toolkit.
+    StartupTimer startup;
 };
 
 
@@ -0,0 +1,267 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "BatchCommand.hpp"
+
+#include "BatchProcessor.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <ostream>
+#include <stdexcept>
+
+namespace
+{
+    constexpr auto usage = "usage: behavior_orchard batch [options] <tree file or directory>...\n"
+                           "Validates the trees; directories are searched for .tree and .btree files.\n"
+                           "  --convert text|binary  also save each tree in the given format\n"
+                           "  --generate             also write the header of Generate Code for each tree\n"
+                           "  --no-validate          skip validation\n"
+                           "  --output <directory>   where converted trees and headers go (default: next to each tree)\n"
+                           "  --cache <file>         skip trees unchanged since they last passed with the same options\n"
+                           "  --threads <count>      worker threads (default: one per core)\n";
+
+    struct Command
+    {
+        BatchOptions options;
+        std::filesystem::path cache_path;
+        size_t thread_count = 0;
+        std::vector<std::filesystem::path> inputs;
+        bool help = false;
+    };
+
+    // Throws std::invalid_argument naming the problem.
+    Command parse_arguments(const std::vector<std::string> &arguments)
+    {
+        Command command;
+        for(size_t argument = 0; argument < arguments.size(); ++argument)
+        {
+            const auto &name = arguments[argument];
+            const auto get_value = [&]() -> const std::string &
+            {
+                if(argument + 1 == arguments.size())
+                {
+                    throw std::invalid_argument(name + " needs a value");
+                }
+                return arguments[++argument];
+            };
+
+            if(name == "--help" || name == "-h")
+            {
+                command.help = true;
+            }
+            else if(name == "--convert")
+            {
+                const auto &format = get_value();
+                if(format == "text")
+                {
+                    command.options.convert = BatchOptions::Conversion::text;
+                }
+                else if(format == "binary")
+                {
+                    command.options.convert = BatchOptions::Conversion::binary;
+                }
+                else
+                {
+                    throw std::invalid_argument("unknown format '" + format + "'");
+                }
+            }
+            else if(name == "--generate")
+            {
+                command.options.generate = true;
+            }
+            else if(name == "--no-validate")
+            {
+                command.options.validate = false;
+            }
+            else if(name == "--output")
+            {
+                command.options.output_directory = get_value();
+            }
+            else if(name == "--cache")
+            {
+                command.cache_path = get_value();
+            }
+            else if(name == "--threads")
+            {
+                const auto &count = get_value();
+                if(count.empty() || count.find_first_not_of("0123456789") != std::string::npos)
+                {
+                    throw std::invalid_argument("thread count '" + count + "' is not a number");
+                }
+                command.thread_count = std::stoul(count);
+            }
+            else if(name.size() > 1 && name.front() == '-')
+            {
+                throw std::invalid_argument("unknown option " + name);
+            }
+            else if(std::filesystem::is_directory(name))
+            {
+                const auto found = find_tree_files(name);
+                command.inputs.insert(command.inputs.end(), found.begin(), found.end());
+            }
+            else
+            {
+                command.inputs.emplace_back(name);
+            }
+        }
+        return command;
+    }
+
+    const char *get_status_name(BatchStatus status)
+    {
+        switch(status)
+        {
+            case BatchStatus::done:
+                return "done";
+            case BatchStatus::skipped:
+                return "skipped";
+            case BatchStatus::invalid:
+                return "invalid";
+            case BatchStatus::failed:
+                return "failed";
+        }
+        return "";
+    }
+
+    double get_total(const BatchFileResult &result)
+    {
+        return result.reading + result.validating + result.converting + result.generating;
+    }
+
+    void print_result(std::ostream &output, const BatchFileResult &result)
+    {
+        char line[160];
+        std::snprintf(line, sizeof(line),
+                      "%-8s %9.2f ms  read %8.2f  validate %8.2f  convert %8.2f  generate %8.2f  %8zu nodes  ",
+                      get_status_name(result.status), get_total(result), result.reading, result.validating,
+                      result.converting, result.generating, result.node_count);
+        output << line << result.path.string() << '\n';
+        for(const auto &message: result.messages)
+        {
+            output << "    " << message << '\n';
+        }
+    }
+
+    void print_summary(std::ostream &output, const std::vector<BatchFileResult> &results, double wall_time,
+                       size_t thread_count)
+    {
+        size_t counts[4] = {};
+        BatchFileResult steps;
+        const BatchFileResult *slowest = nullptr;
+        for(const auto &result: results)
+        {
+            ++counts[static_cast<size_t>(result.status)];
+            steps.reading += result.reading;
+            steps.validating += result.validating;
+            steps.converting += result.converting;
+            steps.generating += result.generating;
+            if(slowest == nullptr || get_total(result) > get_total(*slowest))
+            {
+                slowest = &result;
+            }
+        }
+
+        char line[200];
+        std::snprintf(line, sizeof(line), "%zu files: %zu done, %zu skipped, %zu invalid, %zu failed\n",
+                      results.size(), counts[0], counts[1], counts[2], counts[3]);
+        output << line;
+        std::snprintf(line, sizeof(line),
+                      "%.2f ms on %zu thread%s; per file %.2f ms in total: read %.2f, validate %.2f, convert %.2f, "
+                      "generate %.2f\n", wall_time, thread_count, thread_count == 1 ? "" : "s", get_total(steps),
+                      steps.reading, steps.validating, steps.converting, steps.generating);
+        output << line;
+        if(slowest != nullptr)
+        {
+            std::snprintf(line, sizeof(line), "slowest %.2f ms: ", get_total(*slowest));
+            output << line << slowest->path.string() << '\n';
+        }
+    }
+}
+
+int run_batch_command(const std::vector<std::string> &arguments, std::ostream &output, std::ostream &errors)
+{
+    Command command;
+    try
+    {
+        command = parse_arguments(arguments);
+    }
+    catch(const std::exception &error)
+    {
+        errors << "batch: " << error.what() << '\n' << usage;
+        return 2;
+    }
+    if(command.help)
+    {
+        output << usage;
+        return 0;
+    }
+    if(command.inputs.empty())
+    {
+        errors << "batch: no tree files given\n" << usage;
+        return 2;
+    }
+
+    BatchCache cache;
+    if(!command.cache_path.empty())
+    {
+        cache.load(command.cache_path);
+    }
+    const auto start = std::chrono::steady_clock::now();
+    WorkStealingPool pool{command.thread_count};
+    std::vector<BatchFileResult> results;
+    try
+    {
+        results = process_tree_files(command.inputs, command.options, pool,
+                                     command.cache_path.empty() ? nullptr : &cache);
+    }
+    catch(const std::exception &error)
+    {
+        errors << "batch: " << error.what() << '\n';
+        return 1;
+    }
+    const auto wall_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    auto passed = true;
+    for(const auto &result: results)
+    {
+        print_result(output, result);
+        passed = passed && (result.status == BatchStatus::done || result.status == BatchStatus::skipped);
+    }
+    print_summary(output, results, wall_time, pool.get_thread_count());
+
+    if(!command.cache_path.empty())
+    {
+        try
+        {
+            cache.save(command.cache_path);
+        }
+        catch(const std::exception &error)
+        {
+            errors << "batch: " << error.what() << '\n';
+            return 1;
+        }
+    }
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,37 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// "behavior_orchard batch [options] <tree file or directory>...": validates, converts and generates
+// code for many trees at once without a display - wxWidgets is never initialized. Arguments are those
+// after "batch". Prints one line of timings per file and a summary to output, usage problems to
+// errors. Returns the process exit code: 0 if every file passed, 1 if some did not, 2 for bad usage.
+int run_batch_command(const std::vector<std::string> &arguments, std::ostream &output, std::ostream &errors);
+
+
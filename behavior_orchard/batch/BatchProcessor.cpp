@@ -0,0 +1,391 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "BatchProcessor.hpp"
+
+#include "../codegen/StaticTreeGenerator.hpp"
+#include "../io/MappedFile.hpp"
+#include "../io/TreeBinaryFormat.hpp"
+#include "../io/TreeFile.hpp"
+#include "../io/TreeTextFormat.hpp"
+#include "../model/TreeValidator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+    constexpr std::string_view cache_header = "behavior_orchard_batch_cache 1";
+    // Bumped when the outputs for the same input and options change, e.g. with the code generator.
+    constexpr uint64_t output_version = 1;
+
+    double get_milliseconds_since(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Finalizer of splitmix64.
+    uint64_t mix(uint64_t value)
+    {
+        value = (value ^ (value >> 30u)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27u)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31u);
+    }
+
+    // Eight bytes at a time; the same on every run and platform of the same byte order, unlike
+    // std::hash.
+    uint64_t hash_bytes(const unsigned char *bytes, size_t size)
+    {
+        auto hash = mix(size);
+        size_t offset = 0;
+        for(; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t))
+        {
+            uint64_t word;
+            std::memcpy(&word, bytes + offset, sizeof(word));
+            hash = mix(hash ^ word);
+        }
+        uint64_t tail = 0;
+        if(offset < size)
+        {
+            std::memcpy(&tail, bytes + offset, size - offset);
+        }
+        return mix(hash ^ tail);
+    }
+
+    uint64_t hash_options(const BatchOptions &options)
+    {
+        const auto directory = options.output_directory.string();
+        auto hash = mix(output_version);
+        hash = mix(hash ^ static_cast<uint64_t>(options.validate));
+        hash = mix(hash ^ static_cast<uint64_t>(options.convert));
+        hash = mix(hash ^ static_cast<uint64_t>(options.generate));
+        return mix(hash ^ hash_bytes(reinterpret_cast<const unsigned char *>(directory.data()), directory.size()));
+    }
+
+    std::string get_cache_name(const std::filesystem::path &file)
+    {
+        return std::filesystem::absolute(file).lexically_normal().string();
+    }
+
+    struct Outputs
+    {
+        std::filesystem::path tree;
+        std::filesystem::path header;
+    };
+
+    Outputs get_outputs(const std::filesystem::path &path, const BatchOptions &options)
+    {
+        const auto directory = options.output_directory.empty() ? path.parent_path() : options.output_directory;
+        const auto stem = path.stem().string();
+        Outputs outputs;
+        if(options.convert != BatchOptions::Conversion::none)
+        {
+            const auto extension = options.convert == BatchOptions::Conversion::binary ? tree_binary_extension
+                                                                                       : tree_text_extension;
+            // Tree already in the format stays as it is.
+            const auto tree = directory / (stem + extension);
+            if(get_cache_name(tree) != get_cache_name(path))
+            {
+                outputs.tree = tree;
+            }
+        }
+        if(options.generate)
+        {
+            outputs.header = directory / (stem + ".hpp");
+        }
+        return outputs;
+    }
+
+    bool exist(const Outputs &outputs)
+    {
+        return (outputs.tree.empty() || std::filesystem::exists(outputs.tree)) &&
+               (outputs.header.empty() || std::filesystem::exists(outputs.header));
+    }
+
+    void generate_header(const TreeDocument &document, const std::filesystem::path &path)
+    {
+        // Class is named after the file, as Generate Code of the editor does.
+        auto class_name = make_callback_name(path.stem().string());
+        if(class_name.empty())
+        {
+            class_name = "GeneratedTree";
+        }
+        const auto code = generate_static_tree(document, class_name);
+        std::ofstream output{path, std::ios::binary | std::ios::trunc};
+        output << code;
+        if(!output)
+        {
+            throw std::runtime_error("cannot write " + path.string());
+        }
+    }
+
+    void process_tree_file(const BatchOptions &options, uint64_t options_hash, const BatchCache *cache,
+                           const std::vector<std::string> &conflicts, BatchFileResult &result)
+    {
+        const auto outputs = get_outputs(result.path, options);
+        auto start = std::chrono::steady_clock::now();
+        TreeDocument document;
+        {
+            const MappedFile file{result.path};
+            result.key = mix(options_hash ^ hash_bytes(file.data(), file.size()));
+            if(cache != nullptr && cache->contains(result.path, result.key) && exist(outputs))
+            {
+                result.status = BatchStatus::skipped;
+                result.reading = get_milliseconds_since(start);
+                return;
+            }
+            if(!conflicts.empty())
+            {
+                result.status = BatchStatus::failed;
+                result.messages = conflicts;
+                return;
+            }
+            load_tree(file.data(), file.size(), document);
+        }
+        result.node_count = document.size();
+        result.reading = get_milliseconds_since(start);
+
+        if(options.validate)
+        {
+            start = std::chrono::steady_clock::now();
+            const auto issues = validate_tree(document);
+            result.validating = get_milliseconds_since(start);
+            if(!issues.empty())
+            {
+                result.status = BatchStatus::invalid;
+                for(const auto &issue: issues)
+                {
+                    result.messages.push_back("#" + std::to_string(document.get_id(issue.node)) + ": " +
+                                              issue.message);
+                }
+                return;
+            }
+        }
+        if(!outputs.tree.empty())
+        {
+            start = std::chrono::steady_clock::now();
+            if(options.convert == BatchOptions::Conversion::binary)
+            {
+                save_tree_binary(document, outputs.tree);
+            }
+            else
+            {
+                save_tree_text(document, outputs.tree);
+            }
+            result.converting = get_milliseconds_since(start);
+        }
+        if(!outputs.header.empty())
+        {
+            start = std::chrono::steady_clock::now();
+            generate_header(document, outputs.header);
+            result.generating = get_milliseconds_since(start);
+        }
+    }
+}
+
+void BatchCache::load(const std::filesystem::path &path)
+{
+    keys.clear();
+    std::ifstream input{path};
+    std::string line;
+    if(!std::getline(input, line) || line != cache_header)
+    {
+        return;
+    }
+    while(std::getline(input, line))
+    {
+        // Sixteen hex digits, a space and the path.
+        char *end = nullptr;
+        const auto key = std::strtoull(line.c_str(), &end, 16);
+        if(line.size() < 18 || end != line.c_str() + 16 || line[16] != ' ')
+        {
+            keys.clear();
+            return;
+        }
+        keys[line.substr(17)] = key;
+    }
+}
+
+void BatchCache::save(const std::filesystem::path &path) const
+{
+    std::ofstream output{path, std::ios::trunc};
+    output << cache_header << '\n';
+    for(const auto &[file, key]: keys)
+    {
+        char text[20];
+        std::snprintf(text, sizeof(text), "%016" PRIx64 " ", key);
+        output << text << file << '\n';
+    }
+    if(!output)
+    {
+        throw std::runtime_error("BatchCache: cannot write " + path.string());
+    }
+}
+
+bool BatchCache::contains(const std::filesystem::path &file, uint64_t key) const
+{
+    const auto found = keys.find(get_cache_name(file));
+    return found != keys.end() && found->second == key;
+}
+
+void BatchCache::insert(const std::filesystem::path &file, uint64_t key)
+{
+    keys[get_cache_name(file)] = key;
+}
+
+void BatchCache::erase(const std::filesystem::path &file)
+{
+    keys.erase(get_cache_name(file));
+}
+
+size_t BatchCache::size() const
+{
+    return keys.size();
+}
+
+std::vector<std::filesystem::path> find_tree_files(const std::filesystem::path &directory)
+{
+    std::vector<std::filesystem::path> files;
+    for(const auto &entry: std::filesystem::recursive_directory_iterator{directory})
+    {
+        const auto extension = entry.path().extension();
+        if(entry.is_regular_file() && (extension == tree_text_extension || extension == tree_binary_extension))
+        {
+            files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+std::vector<BatchFileResult> process_tree_files(const std::vector<std::filesystem::path> &paths,
+                                                const BatchOptions &options, WorkStealingPool &pool,
+                                                BatchCache *cache)
+{
+    std::vector<BatchFileResult> results(paths.size());
+    std::vector<Outputs> outputs(paths.size());
+    std::unordered_map<std::string, size_t> inputs;
+    for(size_t file = 0; file < paths.size(); ++file)
+    {
+        results[file].path = paths[file];
+        outputs[file] = get_outputs(paths[file], options);
+        inputs.emplace(get_cache_name(paths[file]), file);
+    }
+
+    // An input which another one converts to is an output of that one rather than a tree of its own,
+    // so converting a directory again rewrites what the last run wrote instead of tripping over it.
+    std::vector<bool> runs(paths.size(), true);
+    for(size_t file = 0; file < paths.size(); ++file)
+    {
+        if(!runs[file] || outputs[file].tree.empty())
+        {
+            continue;
+        }
+        const auto converted = inputs.find(get_cache_name(outputs[file].tree));
+        if(converted != inputs.end() && runs[converted->second])
+        {
+            runs[converted->second] = false;
+            results[converted->second].status = BatchStatus::skipped;
+            results[converted->second].messages.push_back("converted from " + paths[file].string());
+        }
+    }
+
+    // Files writing the same output all fail, whichever comes first. They are only rejected once the
+    // cache did not skip them, so files written by an earlier run are not reported again.
+    std::unordered_map<std::string, std::vector<size_t>> writers;
+    for(size_t file = 0; file < paths.size(); ++file)
+    {
+        for(const auto &output: {outputs[file].tree, outputs[file].header})
+        {
+            if(runs[file] && !output.empty())
+            {
+                writers[get_cache_name(output)].push_back(file);
+            }
+        }
+    }
+    std::vector<std::vector<std::string>> conflicts(paths.size());
+    for(size_t file = 0; file < paths.size(); ++file)
+    {
+        for(const auto &output: {outputs[file].tree, outputs[file].header})
+        {
+            if(!runs[file] || output.empty())
+            {
+                continue;
+            }
+            const auto &output_writers = writers[get_cache_name(output)];
+            if(output_writers.size() > 1)
+            {
+                const auto other = output_writers[output_writers[0] == file ? 1 : 0];
+                conflicts[file].push_back("writes " + output.string() + " as " + paths[other].string() + " does");
+            }
+        }
+    }
+    if(!options.output_directory.empty())
+    {
+        std::filesystem::create_directories(options.output_directory);
+    }
+
+    const auto options_hash = hash_options(options);
+    pool.parallel_for(paths.size(), 1, [&](size_t begin, size_t end, size_t)
+    {
+        for(auto file = begin; file < end; ++file)
+        {
+            if(!runs[file])
+            {
+                continue;
+            }
+            auto &result = results[file];
+            try
+            {
+                process_tree_file(options, options_hash, cache, conflicts[file], result);
+            }
+            catch(const std::exception &error)
+            {
+                result.status = BatchStatus::failed;
+                result.messages.assign(1, error.what());
+            }
+        }
+    });
+
+    if(cache != nullptr)
+    {
+        for(const auto &result: results)
+        {
+            if(result.status == BatchStatus::done)
+            {
+                cache->insert(result.path, result.key);
+            }
+            else if(result.status != BatchStatus::skipped)
+            {
+                cache->erase(result.path);
+            }
+        }
+    }
+    return results;
+}
@@ -0,0 +1,112 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include "../runtime/WorkStealingPool.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// What to do with every tree file; steps run in this order and a file stops at the first one failing.
+struct BatchOptions
+{
+    enum class Conversion: uint8_t
+    {
+        none,
+        text,
+        binary
+    };
+
+    bool validate = true;
+    // Saves each tree in the given format, next to it or in the output directory. A tree already in
+    // the format is not saved over itself; the other steps still run for it.
+    Conversion convert = Conversion::none;
+    // Writes the header of "Generate Code" for each tree, with the class named after the file.
+    bool generate = false;
+    // Empty puts converted trees and headers next to the trees they come from.
+    std::filesystem::path output_directory;
+};
+
+enum class BatchStatus: uint8_t
+{
+    done,
+    // Content and options are the same as when the file last passed, and its outputs are still there;
+    // or the file is what another file of the batch converts to, and gets written by that one.
+    skipped,
+    // Validation found problems; nothing was written.
+    invalid,
+    failed
+};
+
+struct BatchFileResult
+{
+    std::filesystem::path path;
+    BatchStatus status = BatchStatus::done;
+    // Validation issues or the error which stopped the file.
+    std::vector<std::string> messages;
+    size_t node_count = 0;
+    // Content hash combined with the options, what the cache remembers.
+    uint64_t key = 0;
+    // Milliseconds per step, zero for steps not taken; reading includes hashing and parsing.
+    double reading = 0.0;
+    double validating = 0.0;
+    double converting = 0.0;
+    double generating = 0.0;
+};
+
+// Keys of the files which last passed, by absolute path. Stored as text, one "key path" line each.
+class BatchCache
+{
+public:
+    // A missing or malformed file leaves the cache empty, so that everything is processed again.
+    void load(const std::filesystem::path &path);
+    // Throws std::runtime_error if the file cannot be written.
+    void save(const std::filesystem::path &path) const;
+
+    bool contains(const std::filesystem::path &file, uint64_t key) const;
+    void insert(const std::filesystem::path &file, uint64_t key);
+    void erase(const std::filesystem::path &file);
+    size_t size() const;
+
+private:
+    std::unordered_map<std::string, uint64_t> keys;
+};
+
+// Tree files (by extension) in the directory and all below it, sorted.
+std::vector<std::filesystem::path> find_tree_files(const std::filesystem::path &directory);
+
+// Processes the files in parallel on the pool, one file per chunk; results come in the order of
+// paths. Files the cache (if given) knows with their current key are skipped without parsing, and
+// the cache is updated with the outcome of the others. Files which would write the same output fail
+// instead; a file which another one converts to counts as its output, so converting the same
+// directory again is not disturbed by the trees converted before.
+std::vector<BatchFileResult> process_tree_files(const std::vector<std::filesystem::path> &paths,
+                                                const BatchOptions &options, WorkStealingPool &pool,
+                                                BatchCache *cache = nullptr);
+
+
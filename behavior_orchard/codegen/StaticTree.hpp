@@ -0,0 +1,168 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include "IBehavior.hpp"
+
+#include <array>
+#include <cstdint>
+
+// Building blocks for trees emitted by "Generate Code". The whole tree is one type, so every tick is
+// a chain of direct calls the compiler can inline down to the agent's member functions - no virtual
+// calls and no allocations. Evaluation is the same as in BehaviorTree (see TreeProgram.hpp).
+// Nodes are stateless types; running children and counters live in Counters, one slot per stateful
+// node.
+namespace static_tree
+{
+    template<size_t count>
+    using Counters = std::array<uint32_t, count>;
+
+    // Children in order while they return go_on; fold stops at the first one which does not.
+    template<BehaviorState go_on, size_t slot, typename... Children, typename Agent, typename State>
+    BehaviorState evaluate_children(Agent &agent, State &state)
+    {
+        auto &running = std::get<slot>(state);
+        const auto skipped = running;
+        uint32_t index = 0;
+        auto result = go_on;
+        (void) (((index++ < skipped) || (result = Children::evaluate(agent, state), result == go_on)) && ...);
+        running = result == BehaviorState::running ? index - 1 : 0;
+        return result;
+    }
+
+    // Slot keeps the index of the running child, which the next tick resumes from.
+    template<size_t slot, typename... Children>
+    struct Selector
+    {
+        template<typename Agent, typename State>
+        static BehaviorState evaluate(Agent &agent, State &state)
+        {
+            return evaluate_children<BehaviorState::failure, slot, Children...>(agent, state);
+        }
+    };
+
+    template<size_t slot, typename... Children>
+    struct Sequence
+    {
+        template<typename Agent, typename State>
+        static BehaviorState evaluate(Agent &agent, State &state)
+        {
+            return evaluate_children<BehaviorState::success, slot, Children...>(agent, state);
+        }
+    };
+
+    template<auto callback>
+    struct Action
+    {
+        template<typename Agent, typename State>
+        static BehaviorState evaluate(Agent &agent, State &)
+        {
+            return (agent.*callback)();
+        }
+    };
+
+    template<auto callback>
+    struct Condition
+    {
+        template<typename Agent, typename State>
+        static BehaviorState evaluate(Agent &agent, State &)
+        {
+            return (agent.*callback)() ? BehaviorState::success : BehaviorState::failure;
+        }
+    };
+
+    template<typename Child>
+    struct Invert
+    {
+        template<typename Agent, typename State>
+        static BehaviorState evaluate(Agent &agent, State &state)
+        {
+            switch(const auto result = Child::evaluate(agent, state))
+            {
+                case BehaviorState::success:
+                    return BehaviorState::failure;
+                case BehaviorState::failure:
+                    return BehaviorState::success;
+                default:
+                    return result;
+            }
+        }
+    };
+
+    template<size_t slot, uint32_t count, typename Child>
+    struct Loop
+    {
+        template<typename Agent, typename State>
+        static BehaviorState evaluate(Agent &agent, State &state)
+        {
+            const auto result = Child::evaluate(agent, state);
+            if(result == BehaviorState::running)
+            {
+                return result;
+            }
+            auto &iterations = std::get<slot>(state);
+            if(++iterations < count)
+            {
+                return BehaviorState::running;
+            }
+            iterations = 0;
+            return result;
+        }
+    };
+
+    template<size_t slot, uint32_t count, typename Child>
+    struct MaxNTries
+    {
+        template<typename Agent, typename State>
+        static BehaviorState evaluate(Agent &agent, State &state)
+        {
+            auto &failures = std::get<slot>(state);
+            if(failures >= count)
+            {
+                return BehaviorState::failure;
+            }
+            const auto result = Child::evaluate(agent, state);
+            if(result == BehaviorState::failure)
+            {
+                ++failures;
+            }
+            return result;
+        }
+    };
+
+    // Target is a function rather than a type, so a node can link to its own ancestor without the
+    // type referring to itself.
+    template<auto target>
+    struct Link
+    {
+        template<typename Agent, typename State>
+        static BehaviorState evaluate(Agent &agent, State &state)
+        {
+            return target(agent, state);
+        }
+    };
+}
+
+
@@ -0,0 +1,393 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "StaticTreeGenerator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    using index_t = TreeDocument::index_t;
+
+    constexpr size_t indent_width = 4;
+
+    bool is_identifier_start(char character)
+    {
+        return (character >= 'a' && character <= 'z') || (character >= 'A' && character <= 'Z') || character == '_';
+    }
+
+    bool is_identifier_part(char character)
+    {
+        return is_identifier_start(character) || (character >= '0' && character <= '9');
+    }
+
+    // Words a label must not turn into, up to C++20; sorted.
+    constexpr std::array<std::string_view, 92> reserved_words = {
+        "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break", "case", "catch",
+        "char", "char16_t", "char32_t", "char8_t", "class", "co_await", "co_return", "co_yield", "compl", "concept",
+        "const", "const_cast", "consteval", "constexpr", "constinit", "continue", "decltype", "default", "delete",
+        "do", "double", "dynamic_cast", "else", "enum", "explicit", "export", "extern", "false", "float", "for",
+        "friend", "goto", "if", "inline", "int", "long", "mutable", "namespace", "new", "noexcept", "not", "not_eq",
+        "nullptr", "operator", "or", "or_eq", "private", "protected", "public", "register", "reinterpret_cast",
+        "requires", "return", "short", "signed", "sizeof", "static", "static_assert", "static_cast", "struct",
+        "switch", "template", "this", "thread_local", "throw", "true", "try", "typedef", "typeid", "typename",
+        "union", "unsigned", "using", "virtual", "void", "volatile", "wchar_t", "while", "xor", "xor_eq"};
+
+    bool is_reserved_word(std::string_view name)
+    {
+        return std::binary_search(reserved_words.begin(), reserved_words.end(), name);
+    }
+
+    std::string describe(const TreeDocument &document, index_t node)
+    {
+        return std::string{get_node_kind_name(document.get_kind(node))} + " #" + std::to_string(document.get_id(node));
+    }
+
+    class Generator
+    {
+    public:
+        Generator(const TreeDocument &tree, std::string_view tree_class_name):
+                document{tree},
+                class_name{tree_class_name},
+                slot_count{0}
+        {
+        }
+
+        std::string generate()
+        {
+            if(document.is_empty())
+            {
+                throw std::invalid_argument("generate_static_tree: tree is empty");
+            }
+            collect();
+
+            std::ostringstream body;
+            for(const auto target: link_targets)
+            {
+                body << "    using Node" << document.get_id(target) << " =\n";
+                write_expression(body, target, 2);
+                body << ";\n";
+            }
+            body << "    using Root =\n";
+            if(is_link_target(document.get_root()))
+            {
+                body << std::string(2 * indent_width, ' ');
+                write_alias(body, document.get_root());
+            }
+            else
+            {
+                write_expression(body, document.get_root(), 2);
+            }
+            body << ";\n";
+
+            std::ostringstream output;
+            output << "// Generated by Behavior Orchard from a tree of " << document.size() << " nodes.\n"
+                   << "// Do not edit - change the tree and use Generate Code again.\n"
+                   << "\n"
+                   << "#pragma once\n"
+                   << "\n"
+                   << "#include \"StaticTree.hpp\"\n"
+                   << "\n";
+            write_requirements(output);
+            output << "template<typename Agent>\n"
+                   << "class " << class_name << "\n"
+                   << "{\n"
+                   << "public:\n"
+                   << "    BehaviorState evaluate(Agent &agent)\n"
+                   << "    {\n"
+                   << "        return Root::evaluate(agent, counters);\n"
+                   << "    }\n"
+                   << "\n"
+                   << "    // Forgets running children and zeroes counters.\n"
+                   << "    void reset()\n"
+                   << "    {\n"
+                   << "        counters.fill(0);\n"
+                   << "    }\n"
+                   << "\n"
+                   << "private:\n"
+                   << "    using Counters = static_tree::Counters<" << slot_count << ">;\n"
+                   << "\n";
+            for(const auto target: link_targets)
+            {
+                output << "    static BehaviorState node_" << document.get_id(target) << "(Agent &agent, Counters &state);\n";
+            }
+            if(!link_targets.empty())
+            {
+                output << "\n";
+            }
+            output << body.str()
+                   << "\n"
+                   << "    Counters counters{};\n"
+                   << "};\n";
+            for(const auto target: link_targets)
+            {
+                const auto id = document.get_id(target);
+                output << "\n"
+                       << "template<typename Agent>\n"
+                       << "BehaviorState " << class_name << "<Agent>::node_" << id << "(Agent &agent, Counters &state)\n"
+                       << "{\n"
+                       << "    return Node" << id << "::evaluate(agent, state);\n"
+                       << "}\n";
+            }
+            return output.str();
+        }
+
+    private:
+        // Finds link targets and callback names; checks everything that could fail.
+        void collect()
+        {
+            std::vector<std::pair<size_t, index_t>> targets_by_depth;
+            std::vector<std::pair<index_t, size_t>> pending{{document.get_root(), 0}};
+            while(!pending.empty())
+            {
+                const auto [node, depth] = pending.back();
+                pending.pop_back();
+
+                const auto kind = document.get_kind(node);
+                if(get_max_children(kind) == 1 && document.get_child_count(node) == 0)
+                {
+                    throw std::invalid_argument("generate_static_tree: " + describe(document, node) + " has no child");
+                }
+                if(kind == NodeKind::action || kind == NodeKind::condition)
+                {
+                    add_callback(node);
+                }
+                if(kind == NodeKind::link)
+                {
+                    const auto target = document.find_by_id(document.get_parameter(node));
+                    if(target == TreeDocument::no_node)
+                    {
+                        throw std::invalid_argument("generate_static_tree: " + describe(document, node) +
+                                                    " points to a missing node");
+                    }
+                    targets_by_depth.emplace_back(0, target);
+                }
+                for(auto child = document.get_first_child(node); child != TreeDocument::no_node;
+                    child = document.get_next_sibling(child))
+                {
+                    pending.emplace_back(child, depth + 1);
+                }
+            }
+
+            // Deepest first, so an alias never names one declared after it.
+            for(auto &[depth, target]: targets_by_depth)
+            {
+                for(auto ancestor = document.get_parent(target); ancestor != TreeDocument::no_node;
+                    ancestor = document.get_parent(ancestor))
+                {
+                    ++depth;
+                }
+            }
+            std::sort(targets_by_depth.begin(), targets_by_depth.end(),
+                      [](const auto &left, const auto &right) { return left.first > right.first; });
+            for(const auto &[depth, target]: targets_by_depth)
+            {
+                if(std::find(link_targets.begin(), link_targets.end(), target) == link_targets.end())
+                {
+                    link_targets.push_back(target);
+                }
+            }
+        }
+
+        // Nodes with the same label share their callback; different labels (or an action and a
+        // condition) which come out as the same name would silently call one function for both.
+        void add_callback(index_t node)
+        {
+            const auto label = document.get_label(node);
+            const auto name = make_callback_name(label);
+            if(name.empty())
+            {
+                throw std::invalid_argument("generate_static_tree: label of " + describe(document, node) +
+                                            " does not make a function name");
+            }
+            const auto clash = [&](index_t other)
+            {
+                const auto [earlier, later] = std::minmax(other, node, [this](index_t left, index_t right)
+                                                          { return document.get_id(left) < document.get_id(right); });
+                return std::invalid_argument("generate_static_tree: " + describe(document, earlier) + " and " +
+                                             describe(document, later) + " would both call " + name);
+            };
+            const auto is_action = document.get_kind(node) == NodeKind::action;
+            const auto &others = is_action ? conditions : actions;
+            const auto other = others.find(name);
+            if(other != others.end())
+            {
+                throw clash(other->second);
+            }
+            const auto first = (is_action ? actions : conditions).emplace(name, node).first->second;
+            if(document.get_label(first) != label)
+            {
+                throw clash(first);
+            }
+        }
+
+        void write_requirements(std::ostream &output) const
+        {
+            if(actions.empty() && conditions.empty())
+            {
+                return;
+            }
+            output << "// Agent has to provide:\n";
+            for(const auto &[name, node]: actions)
+            {
+                output << "//     BehaviorState " << name << "();\n";
+            }
+            for(const auto &[name, node]: conditions)
+            {
+                output << "//     bool " << name << "();\n";
+            }
+            output << "\n";
+        }
+
+        bool is_link_target(index_t node) const
+        {
+            return std::find(link_targets.begin(), link_targets.end(), node) != link_targets.end();
+        }
+
+        // Writes the type of the subtree; link targets below it are referred to by their alias.
+        void write_expression(std::ostream &output, index_t top, size_t base_depth)
+        {
+            auto node = top;
+            auto depth = base_depth;
+            while(true)
+            {
+                output << std::string(depth * indent_width, ' ');
+                const auto opened = node != top && is_link_target(node) ? write_alias(output, node)
+                                                                         : write_node(output, node);
+                if(opened)
+                {
+                    node = document.get_first_child(node);
+                    ++depth;
+                    continue;
+                }
+                while(node != top && document.get_next_sibling(node) == TreeDocument::no_node)
+                {
+                    node = document.get_parent(node);
+                    --depth;
+                    output << '>';
+                }
+                if(node == top)
+                {
+                    return;
+                }
+                output << ",\n";
+                node = document.get_next_sibling(node);
+            }
+        }
+
+        bool write_alias(std::ostream &output, index_t node) const
+        {
+            output << "Node" << document.get_id(node);
+            return false;
+        }
+
+        // Returns true when the node was opened and its children have to follow.
+        bool write_node(std::ostream &output, index_t node)
+        {
+            const auto has_children = document.get_child_count(node) > 0;
+            const auto parameter = document.get_parameter(node);
+            switch(document.get_kind(node))
+            {
+                case NodeKind::selector:
+                    output << "static_tree::Selector<" << slot_count++ << (has_children ? ",\n" : ">");
+                    return has_children;
+                case NodeKind::sequence:
+                    output << "static_tree::Sequence<" << slot_count++ << (has_children ? ",\n" : ">");
+                    return has_children;
+                case NodeKind::action:
+                    output << "static_tree::Action<&Agent::" << make_callback_name(document.get_label(node)) << '>';
+                    return false;
+                case NodeKind::condition:
+                    output << "static_tree::Condition<&Agent::" << make_callback_name(document.get_label(node)) << '>';
+                    return false;
+                case NodeKind::link:
+                    output << "static_tree::Link<&" << class_name << "::node_" << parameter << '>';
+                    return false;
+                case NodeKind::invert:
+                    output << "static_tree::Invert<\n";
+                    return true;
+                case NodeKind::loop:
+                    output << "static_tree::Loop<" << slot_count++ << ", " << parameter << ",\n";
+                    return true;
+                case NodeKind::max_n_tries:
+                    output << "static_tree::MaxNTries<" << slot_count++ << ", " << parameter << ",\n";
+                    return true;
+            }
+            return false;
+        }
+
+        const TreeDocument &document;
+        std::string_view class_name;
+        size_t slot_count;
+        // Nodes which links point to, deepest first; each gets an alias and a node_<ID> function.
+        std::vector<index_t> link_targets;
+        // Callback names with the first node calling them.
+        std::map<std::string, index_t> actions;
+        std::map<std::string, index_t> conditions;
+    };
+}
+
+std::string generate_static_tree(const TreeDocument &document, std::string_view class_name)
+{
+    if(class_name.empty() || !is_identifier_start(class_name.front()) ||
+       !std::all_of(class_name.begin(), class_name.end(), is_identifier_part) || is_reserved_word(class_name))
+    {
+        throw std::invalid_argument("generate_static_tree: '" + std::string{class_name} + "' is not a class name");
+    }
+    return Generator{document, class_name}.generate();
+}
+
+std::string make_callback_name(std::string_view label)
+{
+    std::string name;
+    for(const auto character: label)
+    {
+        if(is_identifier_part(character))
+        {
+            name.push_back(character);
+        }
+        else if(!name.empty() && name.back() != '_')
+        {
+            name.push_back('_');
+        }
+    }
+    while(!name.empty() && name.back() == '_')
+    {
+        name.pop_back();
+    }
+    if(!name.empty() && !is_identifier_start(name.front()))
+    {
+        name.insert(0, "on_");
+    }
+    if(is_reserved_word(name))
+    {
+        name.push_back('_');
+    }
+    return name;
+}
@@ -0,0 +1,46 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include "../model/TreeDocument.hpp"
+
+#include <string>
+#include <string_view>
+
+// Emits the document as a header with one class template, class_name<Agent>, built from the types in
+// StaticTree.hpp. Actions and conditions become member functions of Agent, named after the node
+// label (anything but letters, digits and '_' turns into '_'): BehaviorState name() for actions,
+// bool name() for conditions. Nesting depth of the tree is bounded by the compiler's template
+// instantiation depth.
+// Throws std::invalid_argument if the document is empty, a decorator has no child, a link points
+// nowhere, a label does not make an identifier or two different labels (or an action and a condition)
+// make the same one.
+std::string generate_static_tree(const TreeDocument &document, std::string_view class_name);
+
+// Identifier used for the callback of a node with the given label; empty if there is none. C++
+// keywords get a trailing '_'.
+std::string make_callback_name(std::string_view label);
+
+
@@ -22,41 +22,17 @@ GeneratedMainFrame::GeneratedMainFrame( wxWindow* parent, wxWindowID id, const w
 	ribbon_page_general = new wxRibbonPage( m_ribbonBar1, wxID_ANY, wxT("General") , wxNullBitmap , 0 );
 	ribbon_panel_file = new wxRibbonPanel( ribbon_page_general, wxID_ANY, wxT("File") , wxNullBitmap , wxDefaultPosition, wxDefaultSize, wxRIBBON_PANEL_DEFAULT_STYLE );
 	m_ribbonButtonBar1 = new wxRibbonButtonBar( ribbon_panel_file, wxID_ANY, wxDefaultPosition, wxDefaultSize, 0 );
-	m_ribbonButtonBar1->AddButton( wxID_ANY, wxT("New Tree"), wxBitmap( wxT("../resources/icons/temp1.png"), wxBITMAP_TYPE_ANY ), wxEmptyString);
-	m_ribbonButtonBar1->AddButton( wxID_ANY, wxT("Open Tree"), wxBitmap( wxT("../resources/icons/temp0.png"), wxBITMAP_TYPE_ANY ), wxEmptyString);
-	m_ribbonButtonBar1->AddButton( wxID_ANY, wxT("Save Tree"), wxBitmap( wxT("../resources/icons/temp1.png"), wxBITMAP_TYPE_ANY ), wxEmptyString);
+	m_ribbonButtonBar1->AddButton( ID_NEW_TREE, wxT("New Tree"), wxArtProvider::GetBitmap( wxT("temp1"), wxART_TOOLBAR ), wxEmptyString);
+	m_ribbonButtonBar1->AddButton( ID_OPEN_TREE, wxT("Open Tree"), wxArtProvider::GetBitmap( wxT("temp0"), wxART_TOOLBAR ), wxEmptyString);
+	m_ribbonButtonBar1->AddButton( ID_SAVE_TREE, wxT("Save Tree"), wxArtProvider::GetBitmap( wxT("temp1"), wxART_TOOLBAR ), wxEmptyString);
+	m_ribbonButtonBar1->AddButton( ID_CANCEL_OPEN, wxT("Cancel Open"), wxArtProvider::GetBitmap( wxT("temp0"), wxART_TOOLBAR ), wxEmptyString);
 	ribbon_panel_misc = new wxRibbonPanel( ribbon_page_general, wxID_ANY, wxT("Misc") , wxNullBitmap , wxDefaultPosition, wxDefaultSize, wxRIBBON_PANEL_DEFAULT_STYLE );
 	m_ribbonButtonBar6 = new wxRibbonButtonBar( ribbon_panel_misc, wxID_ANY, wxDefaultPosition, wxDefaultSize, 0 );
-	m_ribbonButtonBar6->AddToggleButton( wxID_ANY, wxT("Show Properties"), wxBitmap( wxT("../resources/icons/temp0.png"), wxBITMAP_TYPE_ANY ), wxEmptyString);
-	m_ribbonButtonBar6->AddButton( wxID_ANY, wxT("Generate Code"), wxBitmap( wxT("../resources/icons/temp0.png"), wxBITMAP_TYPE_ANY ), wxEmptyString);
+	m_ribbonButtonBar6->AddToggleButton( wxID_ANY, wxT("Show Properties"), wxArtProvider::GetBitmap( wxT("temp0"), wxART_TOOLBAR ), wxEmptyString);
+	m_ribbonButtonBar6->AddButton( ID_GENERATE_CODE, wxT("Generate Code"), wxArtProvider::GetBitmap( wxT("temp0"), wxART_TOOLBAR ), wxEmptyString);
+	m_ribbonButtonBar6->AddButton( ID_LOAD_TRACE, wxT("Load Trace"), wxArtProvider::GetBitmap( wxT("temp1"), wxART_TOOLBAR ), wxEmptyString);
+	m_ribbonButtonBar6->AddButton( ID_CLEAR_TRACE, wxT("Clear Trace"), wxArtProvider::GetBitmap( wxT("temp0"), wxART_TOOLBAR ), wxEmptyString);
 	ribbon_page_nodes = new wxRibbonPage( m_ribbonBar1, wxID_ANY, wxT("Nodes") , wxNullBitmap , 0 );
-	ribbon_panel_create = new wxRibbonPanel( ribbon_page_nodes, wxID_ANY, wxT("Create node") , wxNullBitmap , wxDefaultPosition, wxDefaultSize, wxRIBBON_PANEL_DEFAULT_STYLE );
-	m_ribbonButtonBar21 = new wxRibbonButtonBar( ribbon_panel_create, wxID_ANY, wxDefaultPosition, wxDefaultSize, 0 );
-	m_ribbonButtonBar21->AddButton( wxID_ANY, wxT("New Selector"), wxBitmap( wxT("../resources/icons/temp1.png"), wxBITMAP_TYPE_ANY ), wxEmptyString);
-	m_ribbonButtonBar21->AddButton( wxID_ANY, wxT("New Sequence"), wxBitmap( wxT("../resources/icons/temp0.png"), wxBITMAP_TYPE_ANY ), wxEmptyString);
-	m_ribbonButtonBar21->AddButton( wxID_ANY, wxT("New Action"), wxBitmap( wxT("../resources/icons/temp1.png"), wxBITMAP_TYPE_ANY ), wxEmptyString);
-	m_ribbonButtonBar21->AddButton( wxID_ANY, wxT("New Condition"), wxBitmap( wxT("../resources/icons/temp0.png"), wxBITMAP_TYPE_ANY ), wxEmptyString);
-	m_ribbonButtonBar21->AddButton( wxID_ANY, wxT("New Link"), wxBitmap( wxT("../resources/icons/temp1.png"), wxBITMAP_TYPE_ANY ), wxEmptyString);
-	m_ribbonButtonBar21->AddButton( wxID_ANY, wxT("New Invert"), wxBitmap( wxT("../resources/icons/temp0.png"), wxBITMAP_TYPE_ANY ), wxEmptyString);
-	m_ribbonButtonBar21->AddButton( wxID_ANY, wxT("New Loop"), wxBitmap( wxT("../resources/icons/temp1.png"), wxBITMAP_TYPE_ANY ), wxEmptyString);
-	m_ribbonButtonBar21->AddButton( wxID_ANY, wxT("New MaxNTries"), wxBitmap( wxT("../resources/icons/temp0.png"), wxBITMAP_TYPE_ANY ), wxEmptyString);
-	ribbon_panel_edit = new wxRibbonPanel( ribbon_page_nodes, wxID_ANY, wxT("Edit") , wxNullBitmap , wxDefaultPosition, wxDefaultSize, wxRIBBON_PANEL_DEFAULT_STYLE );
-	m_ribbonButtonBar611 = new wxRibbonButtonBar( ribbon_panel_edit, wxID_ANY, wxDefaultPosition, wxDefaultSize, 0 );
-	m_ribbonButtonBar611->AddButton( wxID_ANY, wxT("Modify Node"), wxBitmap( wxT("../resources/icons/temp1.png"), wxBITMAP_TYPE_ANY ), wxEmptyString);
-	m_ribbonButtonBar611->AddButton( wxID_ANY, wxT("Delete Node"), wxBitmap( wxT("../resources/icons/temp0.png"), wxBITMAP_TYPE_ANY ), wxEmptyString);
-	ribbon_panel_goto = new wxRibbonPanel( ribbon_page_nodes, wxID_ANY, wxT("Go to") , wxNullBitmap , wxDefaultPosition, wxDefaultSize, wxRIBBON_PANEL_DEFAULT_STYLE );
-	m_ribbonButtonBar32 = new wxRibbonButtonBar( ribbon_panel_goto, wxID_ANY, wxDefaultPosition, wxDefaultSize, 0 );
-	m_ribbonButtonBar32->AddButton( wxID_ANY, wxT("Goto Parent"), wxBitmap( wxT("../resources/icons/temp1.png"), wxBITMAP_TYPE_ANY ), wxEmptyString);
-	m_ribbonButtonBar32->AddButton( wxID_ANY, wxT("Goto Newest"), wxBitmap( wxT("../resources/icons/temp0.png"), wxBITMAP_TYPE_ANY ), wxEmptyString);
-	m_ribbonButtonBar32->AddButton( wxID_ANY, wxT("Goto <"), wxBitmap( wxT("../resources/icons/temp1.png"), wxBITMAP_TYPE_ANY ), wxEmptyString);
-	m_ribbonButtonBar32->AddButton( wxID_ANY, wxT("Goto >"), wxBitmap( wxT("../resources/icons/temp0.png"), wxBITMAP_TYPE_ANY ), wxEmptyString);
-	m_ribbonButtonBar32->AddButton( wxID_ANY, wxT("Goto child <"), wxBitmap( wxT("../resources/icons/temp1.png"), wxBITMAP_TYPE_ANY ), wxEmptyString);
-	m_ribbonButtonBar32->AddButton( wxID_ANY, wxT("Goto child >"), wxBitmap( wxT("../resources/icons/temp0.png"), wxBITMAP_TYPE_ANY ), wxEmptyString);
-	ribbon_panel_show = new wxRibbonPanel( ribbon_page_nodes, wxID_ANY, wxT("Show") , wxNullBitmap , wxDefaultPosition, wxDefaultSize, wxRIBBON_PANEL_DEFAULT_STYLE );
-	m_ribbonButtonBar311 = new wxRibbonButtonBar( ribbon_panel_show, wxID_ANY, wxDefaultPosition, wxDefaultSize, 0 );
-	m_ribbonButtonBar311->AddButton( wxID_ANY, wxT("Show Parent"), wxBitmap( wxT("../resources/icons/temp1.png"), wxBITMAP_TYPE_ANY ), wxEmptyString);
-	m_ribbonButtonBar311->AddButton( wxID_ANY, wxT("Show Current"), wxBitmap( wxT("../resources/icons/temp0.png"), wxBITMAP_TYPE_ANY ), wxEmptyString);
-	m_ribbonButtonBar311->AddButton( wxID_ANY, wxT("Show Newest"), wxBitmap( wxT("../resources/icons/temp1.png"), wxBITMAP_TYPE_ANY ), wxEmptyString);
 	m_ribbonBar1->Realize();
 
 	main_sizer->Add( m_ribbonBar1, 0, wxALL|wxEXPAND, 5 );
@@ -77,6 +53,28 @@ GeneratedMainFrame::GeneratedMainFrame( wxWindow* parent, wxWindowID id, const w
 	wxBoxSizer* sizer_properties;
 	sizer_properties = new wxBoxSizer( wxVERTICAL );
 
+	wxStaticBoxSizer* sizer_search;
+	sizer_search = new wxStaticBoxSizer( new wxStaticBox( this, wxID_ANY, wxT("Find node") ), wxVERTICAL );
+
+	search_text = new wxTextCtrl( sizer_search->GetStaticBox(), wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize, 0 );
+	search_text->SetToolTip( wxT("Part of a label, or # and a node ID") );
+
+	sizer_search->Add( search_text, 0, wxALL|wxEXPAND, 5 );
+
+	wxString search_kindChoices[] = { wxT("All kinds"), wxT("Selector"), wxT("Sequence"), wxT("Action"), wxT("Condition"), wxT("Link"), wxT("Invert"), wxT("Loop"), wxT("MaxNTries") };
+	int search_kindNChoices = sizeof( search_kindChoices ) / sizeof( wxString );
+	search_kind = new wxChoice( sizer_search->GetStaticBox(), wxID_ANY, wxDefaultPosition, wxDefaultSize, search_kindNChoices, search_kindChoices, 0 );
+	search_kind->SetSelection( 0 );
+	sizer_search->Add( search_kind, 0, wxALL|wxEXPAND, 5 );
+
+	search_results = new wxListBox( sizer_search->GetStaticBox(), wxID_ANY, wxDefaultPosition, wxDefaultSize, 0, NULL, 0 );
+	search_results->SetMinSize( wxSize( -1,150 ) );
+
+	sizer_search->Add( search_results, 0, wxALL|wxEXPAND, 5 );
+
+
+	sizer_properties->Add( sizer_search, 0, wxEXPAND, 5 );
+
 	wxStaticBoxSizer* sbSizer2;
 	sbSizer2 = new wxStaticBoxSizer( new wxStaticBox( this, wxID_ANY, wxT("Node label") ), wxVERTICAL );
 
@@ -122,48 +120,10 @@ GeneratedMainFrame::GeneratedMainFrame( wxWindow* parent, wxWindowID id, const w
 
 	sizer_properties->Add( sbSizer7, 0, wxEXPAND, 5 );
 
-	wxStaticBoxSizer* sbSizer8;
-	sbSizer8 = new wxStaticBoxSizer( new wxStaticBox( this, wxID_ANY, wxT("Additional") ), wxVERTICAL );
-
-	m_scintilla1 = new wxStyledTextCtrl( sbSizer8->GetStaticBox(), wxID_ANY, wxDefaultPosition, wxDefaultSize, 0, wxEmptyString );
-	m_scintilla1->SetUseTabs( true );
-	m_scintilla1->SetTabWidth( 4 );
-	m_scintilla1->SetIndent( 4 );
-	m_scintilla1->SetTabIndents( true );
-	m_scintilla1->SetBackSpaceUnIndents( true );
-	m_scintilla1->SetViewEOL( false );
-	m_scintilla1->SetViewWhiteSpace( false );
-	m_scintilla1->SetMarginWidth( 2, 0 );
-	m_scintilla1->SetIndentationGuides( true );
-	m_scintilla1->SetMarginType( 1, wxSTC_MARGIN_SYMBOL );
-	m_scintilla1->SetMarginMask( 1, wxSTC_MASK_FOLDERS );
-	m_scintilla1->SetMarginWidth( 1, 16);
-	m_scintilla1->SetMarginSensitive( 1, true );
-	m_scintilla1->SetProperty( wxT("fold"), wxT("1") );
-	m_scintilla1->SetFoldFlags( wxSTC_FOLDFLAG_LINEBEFORE_CONTRACTED | wxSTC_FOLDFLAG_LINEAFTER_CONTRACTED );
-	m_scintilla1->SetMarginType( 0, wxSTC_MARGIN_NUMBER );
-	m_scintilla1->SetMarginWidth( 0, m_scintilla1->TextWidth( wxSTC_STYLE_LINENUMBER, wxT("_99999") ) );
-	m_scintilla1->MarkerDefine( wxSTC_MARKNUM_FOLDER, wxSTC_MARK_BOXPLUS );
-	m_scintilla1->MarkerSetBackground( wxSTC_MARKNUM_FOLDER, wxColour( wxT("BLACK") ) );
-	m_scintilla1->MarkerSetForeground( wxSTC_MARKNUM_FOLDER, wxColour( wxT("WHITE") ) );
-	m_scintilla1->MarkerDefine( wxSTC_MARKNUM_FOLDEROPEN, wxSTC_MARK_BOXMINUS );
-	m_scintilla1->MarkerSetBackground( wxSTC_MARKNUM_FOLDEROPEN, wxColour( wxT("BLACK") ) );
-	m_scintilla1->MarkerSetForeground( wxSTC_MARKNUM_FOLDEROPEN, wxColour( wxT("WHITE") ) );
-	m_scintilla1->MarkerDefine( wxSTC_MARKNUM_FOLDERSUB, wxSTC_MARK_EMPTY );
-	m_scintilla1->MarkerDefine( wxSTC_MARKNUM_FOLDEREND, wxSTC_MARK_BOXPLUS );
-	m_scintilla1->MarkerSetBackground( wxSTC_MARKNUM_FOLDEREND, wxColour( wxT("BLACK") ) );
-	m_scintilla1->MarkerSetForeground( wxSTC_MARKNUM_FOLDEREND, wxColour( wxT("WHITE") ) );
-	m_scintilla1->MarkerDefine( wxSTC_MARKNUM_FOLDEROPENMID, wxSTC_MARK_BOXMINUS );
-	m_scintilla1->MarkerSetBackground( wxSTC_MARKNUM_FOLDEROPENMID, wxColour( wxT("BLACK") ) );
-	m_scintilla1->MarkerSetForeground( wxSTC_MARKNUM_FOLDEROPENMID, wxColour( wxT("WHITE") ) );
-	m_scintilla1->MarkerDefine( wxSTC_MARKNUM_FOLDERMIDTAIL, wxSTC_MARK_EMPTY );
-	m_scintilla1->MarkerDefine( wxSTC_MARKNUM_FOLDERTAIL, wxSTC_MARK_EMPTY );
-	m_scintilla1->SetSelBackground( true, wxSystemSettings::GetColour( wxSYS_COLOUR_HIGHLIGHT ) );
-	m_scintilla1->SetSelForeground( true, wxSystemSettings::GetColour( wxSYS_COLOUR_HIGHLIGHTTEXT ) );
-	sbSizer8->Add( m_scintilla1, 1, wxEXPAND | wxALL, 5 );
-
-
-	sizer_properties->Add( sbSizer8, 1, wxEXPAND, 5 );
+	sizer_additional = new wxStaticBoxSizer( new wxStaticBox( this, wxID_ANY, wxT("Additional") ), wxVERTICAL );
+
+
+	sizer_properties->Add( sizer_additional, 1, wxEXPAND, 5 );
 
 
 	workspace_outer_sizer->Add( sizer_properties, 1, wxEXPAND, 5 );
@@ -179,11 +139,31 @@ GeneratedMainFrame::GeneratedMainFrame( wxWindow* parent, wxWindowID id, const w
 
 	// Connect Events
 	this->Connect( wxEVT_CLOSE_WINDOW, wxCloseEventHandler( GeneratedMainFrame::MainFrameOnClose ) );
+	this->Connect( ID_NEW_TREE, wxEVT_COMMAND_RIBBONBUTTON_CLICKED, wxRibbonButtonBarEventHandler( GeneratedMainFrame::OnNewTreeClicked ) );
+	this->Connect( ID_OPEN_TREE, wxEVT_COMMAND_RIBBONBUTTON_CLICKED, wxRibbonButtonBarEventHandler( GeneratedMainFrame::OnOpenTreeClicked ) );
+	this->Connect( ID_SAVE_TREE, wxEVT_COMMAND_RIBBONBUTTON_CLICKED, wxRibbonButtonBarEventHandler( GeneratedMainFrame::OnSaveTreeClicked ) );
+	this->Connect( ID_CANCEL_OPEN, wxEVT_COMMAND_RIBBONBUTTON_CLICKED, wxRibbonButtonBarEventHandler( GeneratedMainFrame::OnCancelOpenClicked ) );
+	this->Connect( ID_GENERATE_CODE, wxEVT_COMMAND_RIBBONBUTTON_CLICKED, wxRibbonButtonBarEventHandler( GeneratedMainFrame::OnGenerateCodeClicked ) );
+	this->Connect( ID_LOAD_TRACE, wxEVT_COMMAND_RIBBONBUTTON_CLICKED, wxRibbonButtonBarEventHandler( GeneratedMainFrame::OnLoadTraceClicked ) );
+	this->Connect( ID_CLEAR_TRACE, wxEVT_COMMAND_RIBBONBUTTON_CLICKED, wxRibbonButtonBarEventHandler( GeneratedMainFrame::OnClearTraceClicked ) );
+	search_text->Connect( wxEVT_COMMAND_TEXT_UPDATED, wxCommandEventHandler( GeneratedMainFrame::OnSearchTextChanged ), NULL, this );
+	search_kind->Connect( wxEVT_COMMAND_CHOICE_SELECTED, wxCommandEventHandler( GeneratedMainFrame::OnSearchKindChanged ), NULL, this );
+	search_results->Connect( wxEVT_COMMAND_LISTBOX_SELECTED, wxCommandEventHandler( GeneratedMainFrame::OnSearchResultSelected ), NULL, this );
 }
 
 GeneratedMainFrame::~GeneratedMainFrame()
 {
 	// Disconnect Events
 	this->Disconnect( wxEVT_CLOSE_WINDOW, wxCloseEventHandler( GeneratedMainFrame::MainFrameOnClose ) );
+	this->Disconnect( ID_NEW_TREE, wxEVT_COMMAND_RIBBONBUTTON_CLICKED, wxRibbonButtonBarEventHandler( GeneratedMainFrame::OnNewTreeClicked ) );
+	this->Disconnect( ID_OPEN_TREE, wxEVT_COMMAND_RIBBONBUTTON_CLICKED, wxRibbonButtonBarEventHandler( GeneratedMainFrame::OnOpenTreeClicked ) );
+	this->Disconnect( ID_SAVE_TREE, wxEVT_COMMAND_RIBBONBUTTON_CLICKED, wxRibbonButtonBarEventHandler( GeneratedMainFrame::OnSaveTreeClicked ) );
+	this->Disconnect( ID_CANCEL_OPEN, wxEVT_COMMAND_RIBBONBUTTON_CLICKED, wxRibbonButtonBarEventHandler( GeneratedMainFrame::OnCancelOpenClicked ) );
+	this->Disconnect( ID_GENERATE_CODE, wxEVT_COMMAND_RIBBONBUTTON_CLICKED, wxRibbonButtonBarEventHandler( GeneratedMainFrame::OnGenerateCodeClicked ) );
+	this->Disconnect( ID_LOAD_TRACE, wxEVT_COMMAND_RIBBONBUTTON_CLICKED, wxRibbonButtonBarEventHandler( GeneratedMainFrame::OnLoadTraceClicked ) );
+	this->Disconnect( ID_CLEAR_TRACE, wxEVT_COMMAND_RIBBONBUTTON_CLICKED, wxRibbonButtonBarEventHandler( GeneratedMainFrame::OnClearTraceClicked ) );
+	search_text->Disconnect( wxEVT_COMMAND_TEXT_UPDATED, wxCommandEventHandler( GeneratedMainFrame::OnSearchTextChanged ), NULL, this );
+	search_kind->Disconnect( wxEVT_COMMAND_CHOICE_SELECTED, wxCommandEventHandler( GeneratedMainFrame::OnSearchKindChanged ), NULL, this );
+	search_results->Disconnect( wxEVT_COMMAND_LISTBOX_SELECTED, wxCommandEventHandler( GeneratedMainFrame::OnSearchResultSelected ), NULL, this );
 
 }
@@ -27,11 +27,23 @@
 #include <wx/sizer.h>
 #include <wx/statbox.h>
 #include <wx/textctrl.h>
-#include <wx/stc/stc.h>
+#include <wx/choice.h>
+#include <wx/listbox.h>
 #include <wx/frame.h>
 
 ///////////////////////////////////////////////////////////////////////////
 
+enum
+{
+	ID_CANCEL_OPEN = 1000,
+	ID_CLEAR_TRACE,
+	ID_GENERATE_CODE,
+	ID_LOAD_TRACE,
+	ID_NEW_TREE,
+	ID_OPEN_TREE,
+	ID_SAVE_TREE
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Class GeneratedMainFrame
 ///////////////////////////////////////////////////////////////////////////////
@@ -47,24 +59,29 @@ class GeneratedMainFrame : public wxFrame
 		wxRibbonPanel* ribbon_panel_misc;
 		wxRibbonButtonBar* m_ribbonButtonBar6;
 		wxRibbonPage* ribbon_page_nodes;
-		wxRibbonPanel* ribbon_panel_create;
-		wxRibbonButtonBar* m_ribbonButtonBar21;
-		wxRibbonPanel* ribbon_panel_edit;
-		wxRibbonButtonBar* m_ribbonButtonBar611;
-		wxRibbonPanel* ribbon_panel_goto;
-		wxRibbonButtonBar* m_ribbonButtonBar32;
-		wxRibbonPanel* ribbon_panel_show;
-		wxRibbonButtonBar* m_ribbonButtonBar311;
 		wxScrolledWindow* workspace;
+		wxTextCtrl* search_text;
+		wxChoice* search_kind;
+		wxListBox* search_results;
 		wxTextCtrl* m_textCtrl1;
 		wxTextCtrl* m_textCtrl2;
 		wxTextCtrl* m_textCtrl3;
 		wxTextCtrl* m_textCtrl4;
 		wxTextCtrl* m_textCtrl5;
-		wxStyledTextCtrl* m_scintilla1;
+		wxStaticBoxSizer* sizer_additional;
 
 		// Virtual event handlers, overide them in your derived class
 		virtual void MainFrameOnClose( wxCloseEvent& event ) { event.Skip(); }
+		virtual void OnNewTreeClicked( wxRibbonButtonBarEvent& event ) { event.Skip(); }
+		virtual void OnOpenTreeClicked( wxRibbonButtonBarEvent& event ) { event.Skip(); }
+		virtual void OnSaveTreeClicked( wxRibbonButtonBarEvent& event ) { event.Skip(); }
+		virtual void OnCancelOpenClicked( wxRibbonButtonBarEvent& event ) { event.Skip(); }
+		virtual void OnGenerateCodeClicked( wxRibbonButtonBarEvent& event ) { event.Skip(); }
+		virtual void OnLoadTraceClicked( wxRibbonButtonBarEvent& event ) { event.Skip(); }
+		virtual void OnClearTraceClicked( wxRibbonButtonBarEvent& event ) { event.Skip(); }
+		virtual void OnSearchTextChanged( wxCommandEvent& event ) { event.Skip(); }
+		virtual void OnSearchKindChanged( wxCommandEvent& event ) { event.Skip(); }
+		virtual void OnSearchResultSelected( wxCommandEvent& event ) { event.Skip(); }
 
 
 	public:
@@ -23,7 +23,1089 @@
 */
 
 #include "MainFrame.hpp"
+#include "../codegen/StaticTreeGenerator.hpp"
+#include "../io/ProfileFile.hpp"
+#include "../io/TraceFile.hpp"
+#include "../io/TreeBinaryFormat.hpp"
+#include "../io/TreeFile.hpp"
 
-MainFrame::MainFrame(): GeneratedMainFrame(nullptr)
+#include <wx/artprov.h>
+#include <wx/filedlg.h>
+#include <wx/msgdlg.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    constexpr int32_t label_padding = 24;
+    constexpr int32_t minimal_node_width = 60;
+    constexpr int load_poll_interval = 50;
+    // Problems listed when an opened tree does not validate; the rest are only counted.
+    constexpr size_t listed_issues = 20;
+    // Results listed for a search; narrowing the text finds the rest.
+    constexpr size_t listed_search_results = 200;
+    // Smaller repeated subtrees are not worth a link - it is a node itself, and harder to read.
+    constexpr uint32_t minimal_folded_size = 4;
+
+    // Buttons of the "Nodes" page; it is built by MainFrame rather than the generated frame, so that
+    // the page costs nothing until it is opened.
+    enum
+    {
+        ID_NEW_SELECTOR = 2000,
+        ID_NEW_SEQUENCE,
+        ID_NEW_ACTION,
+        ID_NEW_CONDITION,
+        ID_NEW_LINK,
+        ID_NEW_INVERT,
+        ID_NEW_LOOP,
+        ID_NEW_MAX_N_TRIES,
+        ID_MODIFY_NODE,
+        ID_DELETE_NODE,
+        ID_UNDO,
+        ID_REDO,
+        ID_FOLD_DUPLICATES,
+        ID_GOTO_PARENT,
+        ID_GOTO_NEWEST,
+        ID_GOTO_PREVIOUS_SIBLING,
+        ID_GOTO_NEXT_SIBLING,
+        ID_GOTO_FIRST_CHILD,
+        ID_GOTO_LAST_CHILD,
+        ID_SHOW_PARENT,
+        ID_SHOW_CURRENT,
+        ID_SHOW_NEWEST
+    };
+
+    const wxString tree_file_wildcard = "Behavior trees (*.btree;*.tree)|*.btree;*.tree|"
+                                        "Binary tree (*.btree)|*.btree|Text tree (*.tree)|*.tree";
+
+    const wxString trace_file_wildcard = "Traces and profiles (*.bttrace;*.btprof)|*.bttrace;*.btprof|"
+                                         "Trace dumps (*.bttrace)|*.bttrace|Latency profiles (*.btprof)|*.btprof";
+
+    double get_milliseconds_since(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // What keeping and opening the document costs, measured on a copy saved to and loaded from memory.
+    struct DocumentCost
+    {
+        size_t memory_bytes;
+        size_t file_bytes;
+        double load_milliseconds;
+    };
+
+    DocumentCost measure_document_cost(const TreeDocument &document)
+    {
+        std::ostringstream output;
+        save_tree_binary(document, output);
+        const auto image = output.str();
+        const BinaryTreeView view{reinterpret_cast<const unsigned char *>(image.data()), image.size()};
+        TreeDocument loaded;
+        const auto start = std::chrono::steady_clock::now();
+        load_tree_binary(view, loaded);
+        return {loaded.get_memory_usage(), image.size(), get_milliseconds_since(start)};
+    }
+
+    wxColour get_node_colour(NodeKind kind)
+    {
+        switch(kind)
+        {
+            case NodeKind::selector:
+                return {170, 200, 240};
+            case NodeKind::sequence:
+                return {180, 225, 180};
+            case NodeKind::action:
+                return {250, 220, 160};
+            case NodeKind::condition:
+                return {240, 190, 190};
+            case NodeKind::link:
+                return {210, 210, 210};
+            case NodeKind::invert:
+            case NodeKind::loop:
+            case NodeKind::max_n_tries:
+                return {215, 195, 235};
+        }
+        return {255, 255, 255};
+    }
+
+    // Pale for rarely visited nodes, red for the hottest; logarithmic, as hit counts of a tree span
+    // orders of magnitude.
+    wxColour get_heat_colour(uint64_t hits, uint64_t max_hits)
+    {
+        const auto heat = max_hits > 1 ? std::log1p(static_cast<double>(hits)) / std::log1p(static_cast<double>(max_hits))
+                                       : static_cast<double>(hits);
+        const auto mix = [heat](int cold, int hot)
+        {
+            return static_cast<unsigned char>(std::lround(cold + (hot - cold) * heat));
+        };
+        return {mix(235, 230), mix(235, 60), mix(235, 40)};
+    }
+
+    wxString format_hits(uint64_t hits)
+    {
+        if(hits >= 10000000)
+        {
+            return wxString::Format("%.0fM", static_cast<double>(hits) / 1e6);
+        }
+        if(hits >= 10000)
+        {
+            return wxString::Format("%.0fk", static_cast<double>(hits) / 1e3);
+        }
+        return wxString::Format("%u", static_cast<unsigned>(hits));
+    }
+
+    wxString to_wx(std::string_view text)
+    {
+        return wxString::FromUTF8(text.data(), text.size());
+    }
+
+    const char *get_stage_name(TreeLoader::Stage stage)
+    {
+        switch(stage)
+        {
+            case TreeLoader::Stage::reading:
+                return "reading";
+            case TreeLoader::Stage::validating:
+                return "validating";
+            case TreeLoader::Stage::laying_out:
+                return "laying out";
+            default:
+                return "";
+        }
+    }
+}
+
+MainFrame::MainFrame(StartupTimer &startup_timer, bool exit_when_started):
+        GeneratedMainFrame(nullptr), startup{startup_timer}, exit_after_start{exit_when_started}, started{false},
+        nodes_page_built{false}, additional_field{nullptr}, label_metrics{label_padding, minimal_node_width},
+        load_timer{this}, showing_preview{false}, layout{document}, hashes{document}, search_index{document},
+        renderer{workspace}, current{TreeDocument::no_node}
+{
+    // First field for messages, second for the frame timer.
+    CreateStatusBar(2);
+    renderer.set_frame_listener([this](const FrameTimer &timer)
+    {
+        show_frame_time(timer);
+        if(!started)
+        {
+            on_first_frame();
+        }
+    });
+    m_ribbonBar1->Bind(wxEVT_RIBBONBAR_PAGE_CHANGING, &MainFrame::on_ribbon_page_changing, this);
+
+    // Printable ASCII is measured exactly; any other character is taken as wide as an average letter.
+    const auto average_width = workspace->GetTextExtent("n").GetWidth();
+    for(unsigned byte = 0xC0; byte <= 0xFF; ++byte)
+    {
+        label_metrics.set_advance(static_cast<unsigned char>(byte), average_width);
+    }
+    for(char character = ' '; character <= '~'; ++character)
+    {
+        label_metrics.set_advance(static_cast<unsigned char>(character),
+                                  workspace->GetTextExtent(wxString{character}).GetWidth());
+    }
+    loader = std::make_unique<TreeLoader>(pool, label_metrics, layout.get_settings());
+    Bind(wxEVT_TIMER, &MainFrame::on_load_timer, this);
+}
+
+void MainFrame::on_ribbon_page_changing(wxRibbonBarEvent &event)
+{
+    if(event.GetPage() == ribbon_page_nodes && !nodes_page_built)
+    {
+        build_nodes_page();
+    }
+    event.Skip();
+}
+
+void MainFrame::build_nodes_page()
+{
+    struct Button
+    {
+        int id;
+        const char *label;
+        const char *icon;
+        void (MainFrame::*handler)(wxRibbonButtonBarEvent &);
+    };
+    struct Panel
+    {
+        const char *label;
+        std::vector<Button> buttons;
+    };
+    const Panel panels[] = {
+            {"Create node", {{ID_NEW_SELECTOR, "New Selector", "temp1", &MainFrame::OnNewSelectorClicked},
+                             {ID_NEW_SEQUENCE, "New Sequence", "temp0", &MainFrame::OnNewSequenceClicked},
+                             {ID_NEW_ACTION, "New Action", "temp1", &MainFrame::OnNewActionClicked},
+                             {ID_NEW_CONDITION, "New Condition", "temp0", &MainFrame::OnNewConditionClicked},
+                             {ID_NEW_LINK, "New Link", "temp1", &MainFrame::OnNewLinkClicked},
+                             {ID_NEW_INVERT, "New Invert", "temp0", &MainFrame::OnNewInvertClicked},
+                             {ID_NEW_LOOP, "New Loop", "temp1", &MainFrame::OnNewLoopClicked},
+                             {ID_NEW_MAX_N_TRIES, "New MaxNTries", "temp0", &MainFrame::OnNewMaxNTriesClicked}}},
+            {"Edit", {{ID_MODIFY_NODE, "Modify Node", "temp1", &MainFrame::OnModifyNodeClicked},
+                      {ID_DELETE_NODE, "Delete Node", "temp0", &MainFrame::OnDeleteNodeClicked},
+                      {ID_UNDO, "Undo", "temp1", &MainFrame::OnUndoClicked},
+                      {ID_REDO, "Redo", "temp0", &MainFrame::OnRedoClicked},
+                      {ID_FOLD_DUPLICATES, "Fold Duplicates", "temp1", &MainFrame::OnFoldDuplicatesClicked}}},
+            {"Go to", {{ID_GOTO_PARENT, "Goto Parent", "temp1", &MainFrame::OnGotoParentClicked},
+                       {ID_GOTO_NEWEST, "Goto Newest", "temp0", &MainFrame::OnGotoNewestClicked},
+                       {ID_GOTO_PREVIOUS_SIBLING, "Goto <", "temp1", &MainFrame::OnGotoPreviousSiblingClicked},
+                       {ID_GOTO_NEXT_SIBLING, "Goto >", "temp0", &MainFrame::OnGotoNextSiblingClicked},
+                       {ID_GOTO_FIRST_CHILD, "Goto child <", "temp1", &MainFrame::OnGotoFirstChildClicked},
+                       {ID_GOTO_LAST_CHILD, "Goto child >", "temp0", &MainFrame::OnGotoLastChildClicked}}},
+            {"Show", {{ID_SHOW_PARENT, "Show Parent", "temp1", &MainFrame::OnShowParentClicked},
+                      {ID_SHOW_CURRENT, "Show Current", "temp0", &MainFrame::OnShowCurrentClicked},
+                      {ID_SHOW_NEWEST, "Show Newest", "temp1", &MainFrame::OnShowNewestClicked}}}};
+
+    for(const auto &panel: panels)
+    {
+        auto ribbon_panel = new wxRibbonPanel(ribbon_page_nodes, wxID_ANY, panel.label);
+        auto button_bar = new wxRibbonButtonBar(ribbon_panel);
+        for(const auto &button: panel.buttons)
+        {
+            button_bar->AddButton(button.id, button.label, wxArtProvider::GetBitmap(button.icon, wxART_TOOLBAR),
+                                  wxEmptyString);
+            Bind(wxEVT_RIBBONBUTTONBAR_CLICKED, button.handler, this, button.id);
+        }
+    }
+    nodes_page_built = true;
+    m_ribbonBar1->Realize();
+}
+
+void MainFrame::on_first_frame()
+{
+    started = true;
+    startup.mark("first frame");
+    // After this paint has finished, so that nothing is built between the window appearing and its
+    // first frame.
+    CallAfter([this]
+    {
+        get_additional_field();
+        startup.mark("deferred panels");
+        const auto total = std::chrono::duration<double, std::milli>(startup.get_total()).count();
+        SetStatusText(wxString::Format("Started in %.1f ms", total));
+        if(exit_after_start)
+        {
+            std::cout << startup.format() << std::flush;
+            Close();
+        }
+    });
+}
+
+wxStyledTextCtrl &MainFrame::get_additional_field()
+{
+    if(additional_field == nullptr)
+    {
+        additional_field = new wxStyledTextCtrl(sizer_additional->GetStaticBox(), wxID_ANY);
+        additional_field->SetUseTabs(true);
+        additional_field->SetTabWidth(4);
+        additional_field->SetIndent(4);
+        additional_field->SetTabIndents(true);
+        additional_field->SetBackSpaceUnIndents(true);
+        additional_field->SetMarginType(0, wxSTC_MARGIN_NUMBER);
+        additional_field->SetMarginWidth(0, additional_field->TextWidth(wxSTC_STYLE_LINENUMBER, "_99999"));
+        additional_field->SetSelBackground(true, wxSystemSettings::GetColour(wxSYS_COLOUR_HIGHLIGHT));
+        additional_field->SetSelForeground(true, wxSystemSettings::GetColour(wxSYS_COLOUR_HIGHLIGHTTEXT));
+        sizer_additional->Add(additional_field, 1, wxEXPAND | wxALL, 5);
+        Layout();
+    }
+    return *additional_field;
+}
+
+void MainFrame::OnNewTreeClicked(wxRibbonButtonBarEvent &)
+{
+    loader->cancel();
+    load_timer.Stop();
+    showing_preview = false;
+    document.clear();
+    layout.clear();
+    hashes.clear();
+    search_index.clear();
+    renderer.clear();
+    history.clear();
+    trace.clear();
+    profile.clear();
+    current = TreeDocument::no_node;
+    show_properties();
+    run_search(false);
+}
+
+void MainFrame::OnOpenTreeClicked(wxRibbonButtonBarEvent &)
+{
+    if(reject_while_loading())
+    {
+        return;
+    }
+    wxFileDialog dialog{this, "Open Tree", wxEmptyString, wxEmptyString, tree_file_wildcard,
+                        wxFD_OPEN | wxFD_FILE_MUST_EXIST};
+    if(dialog.ShowModal() != wxID_OK)
+    {
+        return;
+    }
+
+    loader->start(dialog.GetPath().ToStdString());
+    load_timer.Start(load_poll_interval);
+    SetStatusText("Opening " + dialog.GetFilename());
+}
+
+void MainFrame::OnSaveTreeClicked(wxRibbonButtonBarEvent &)
+{
+    if(reject_while_loading())
+    {
+        return;
+    }
+    wxFileDialog dialog{this, "Save Tree", wxEmptyString, wxEmptyString, tree_file_wildcard,
+                        wxFD_SAVE | wxFD_OVERWRITE_PROMPT};
+    if(dialog.ShowModal() != wxID_OK)
+    {
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    try
+    {
+        save_tree(document, dialog.GetPath().ToStdString());
+    }
+    catch(const std::exception &error)
+    {
+        wxMessageBox(wxString::FromUTF8(error.what()), "Save Tree", wxOK | wxICON_ERROR, this);
+        return;
+    }
+    SetStatusText(wxString::Format("Saved %s nodes in %.1f ms", std::to_string(document.size()),
+                                   get_milliseconds_since(start)));
+}
+
+void MainFrame::OnCancelOpenClicked(wxRibbonButtonBarEvent &)
+{
+    if(loader->is_running())
+    {
+        loader->cancel();
+        SetStatusText("Cancelling...");
+    }
+}
+
+void MainFrame::OnNewSelectorClicked(wxRibbonButtonBarEvent &)
+{
+    add_node(NodeKind::selector);
+}
+
+void MainFrame::OnNewSequenceClicked(wxRibbonButtonBarEvent &)
+{
+    add_node(NodeKind::sequence);
+}
+
+void MainFrame::OnNewActionClicked(wxRibbonButtonBarEvent &)
+{
+    add_node(NodeKind::action);
+}
+
+void MainFrame::OnNewConditionClicked(wxRibbonButtonBarEvent &)
+{
+    add_node(NodeKind::condition);
+}
+
+void MainFrame::OnNewLinkClicked(wxRibbonButtonBarEvent &)
+{
+    add_node(NodeKind::link);
+}
+
+void MainFrame::OnNewInvertClicked(wxRibbonButtonBarEvent &)
+{
+    add_node(NodeKind::invert);
+}
+
+void MainFrame::OnNewLoopClicked(wxRibbonButtonBarEvent &)
+{
+    add_node(NodeKind::loop);
+}
+
+void MainFrame::OnNewMaxNTriesClicked(wxRibbonButtonBarEvent &)
+{
+    add_node(NodeKind::max_n_tries);
+}
+
+void MainFrame::OnModifyNodeClicked(wxRibbonButtonBarEvent &)
+{
+    if(current == TreeDocument::no_node || reject_while_loading())
+    {
+        return;
+    }
+    const std::string label{m_textCtrl1->GetValue().ToUTF8().data()};
+
+    // Numeric parameter of loops, MaxNTries and links is typed into the first line of the "Additional"
+    // field.
+    const auto kind = document.get_kind(current);
+    auto parameter = document.get_parameter(current);
+    unsigned long typed_parameter = 0;
+    if((kind == NodeKind::loop || kind == NodeKind::max_n_tries || kind == NodeKind::link) &&
+       get_additional_field().GetText().BeforeFirst('\n').Trim().Trim(false).ToULong(&typed_parameter))
+    {
+        parameter = static_cast<uint32_t>(typed_parameter);
+    }
+    history.modify_node(document, current, label, parameter);
+    hashes.invalidate(current);
+    search_index.update(current);
+
+    layout.set_width(current, measure_label(label));
+    // Label may not change the width; the renderer still needs the new text.
+    renderer.set_node(current, document.get_parent(current), layout.get_bounds(current), to_wx(label),
+                      get_node_colour(kind));
+    refresh_workspace();
+}
+
+void MainFrame::OnDeleteNodeClicked(wxRibbonButtonBarEvent &)
+{
+    if(current == TreeDocument::no_node || reject_while_loading())
+    {
+        return;
+    }
+    const auto parent = document.get_parent(current);
+    removed.clear();
+    history.remove_subtree(document, current, removed);
+    for(const auto node: removed)
+    {
+        renderer.remove_node(node);
+        layout.forget(node);
+        hashes.forget(node);
+        search_index.forget(node);
+    }
+    layout.invalidate(parent);
+    hashes.invalidate(parent);
+    current = parent;
+    refresh_workspace();
+}
+
+void MainFrame::OnUndoClicked(wxRibbonButtonBarEvent &)
+{
+    if(reject_while_loading())
+    {
+        return;
+    }
+    if(!history.undo(document, change))
+    {
+        SetStatusText("Nothing to undo");
+        return;
+    }
+    apply_change();
+}
+
+void MainFrame::OnRedoClicked(wxRibbonButtonBarEvent &)
+{
+    if(reject_while_loading())
+    {
+        return;
+    }
+    if(!history.redo(document, change))
+    {
+        SetStatusText("Nothing to redo");
+        return;
+    }
+    apply_change();
+}
+
+void MainFrame::OnFoldDuplicatesClicked(wxRibbonButtonBarEvent &)
+{
+    if(reject_while_loading() || document.is_empty())
+    {
+        return;
+    }
+    hashes.update();
+    const auto folds = find_foldable_subtrees(document, hashes, minimal_folded_size);
+    if(folds.empty())
+    {
+        SetStatusText(wxString::Format("No repeated subtrees of %u nodes or more", minimal_folded_size));
+        return;
+    }
+    size_t folded_nodes = 0;
+    for(const auto &fold: folds)
+    {
+        folded_nodes += fold.size - 1;
+    }
+    const auto question = wxString::Format("%s repeated subtrees can be replaced by links to their first occurrence, "
+                                           "%s nodes fewer.\n\nA link runs the nodes it points to, so each copy will "
+                                           "share the running state of the original. Folding cannot be undone.\n\n"
+                                           "Fold them?", std::to_string(folds.size()), std::to_string(folded_nodes));
+    if(wxMessageBox(question, "Fold Duplicates", wxYES_NO | wxICON_QUESTION, this) != wxYES)
+    {
+        return;
+    }
+
+    const auto node_count = document.size();
+    const auto before = measure_document_cost(document);
+    fold_subtrees(document, folds);
+    const auto after = measure_document_cost(document);
+    reload_workspace();
+    SetStatusText(wxString::Format("Folded %s subtrees: %s -> %s nodes, %.1f -> %.1f kB in memory, "
+                                   "%.1f -> %.1f kB on disk, loading in %.1f -> %.1f ms",
+                                   std::to_string(folds.size()), std::to_string(node_count),
+                                   std::to_string(document.size()), static_cast<double>(before.memory_bytes) / 1024.0,
+                                   static_cast<double>(after.memory_bytes) / 1024.0,
+                                   static_cast<double>(before.file_bytes) / 1024.0,
+                                   static_cast<double>(after.file_bytes) / 1024.0, before.load_milliseconds,
+                                   after.load_milliseconds));
+}
+
+void MainFrame::OnGotoParentClicked(wxRibbonButtonBarEvent &)
+{
+    if(current != TreeDocument::no_node)
+    {
+        go_to(document.get_parent(current));
+    }
+}
+
+void MainFrame::OnGotoNewestClicked(wxRibbonButtonBarEvent &)
+{
+    go_to(document.get_newest());
+}
+
+void MainFrame::OnGotoPreviousSiblingClicked(wxRibbonButtonBarEvent &)
 {
+    if(current != TreeDocument::no_node)
+    {
+        go_to(document.get_previous_sibling(current));
+    }
+}
+
+void MainFrame::OnGotoNextSiblingClicked(wxRibbonButtonBarEvent &)
+{
+    if(current != TreeDocument::no_node)
+    {
+        go_to(document.get_next_sibling(current));
+    }
+}
+
+void MainFrame::OnGotoFirstChildClicked(wxRibbonButtonBarEvent &)
+{
+    if(current != TreeDocument::no_node)
+    {
+        go_to(document.get_first_child(current));
+    }
+}
+
+void MainFrame::OnGotoLastChildClicked(wxRibbonButtonBarEvent &)
+{
+    if(current != TreeDocument::no_node)
+    {
+        go_to(document.get_last_child(current));
+    }
+}
+
+void MainFrame::OnShowParentClicked(wxRibbonButtonBarEvent &)
+{
+    if(current != TreeDocument::no_node)
+    {
+        show(document.get_parent(current));
+    }
+}
+
+void MainFrame::OnShowCurrentClicked(wxRibbonButtonBarEvent &)
+{
+    show(current);
+}
+
+void MainFrame::OnShowNewestClicked(wxRibbonButtonBarEvent &)
+{
+    show(document.get_newest());
+}
+
+void MainFrame::OnGenerateCodeClicked(wxRibbonButtonBarEvent &)
+{
+    if(reject_while_loading())
+    {
+        return;
+    }
+    wxFileDialog dialog{this, "Generate Code", wxEmptyString, "GeneratedTree.hpp", "C++ header (*.hpp)|*.hpp",
+                        wxFD_SAVE | wxFD_OVERWRITE_PROMPT};
+    if(dialog.ShowModal() != wxID_OK)
+    {
+        return;
+    }
+
+    // Class is named after the file, so the header can be included next to others generated.
+    const std::filesystem::path path{dialog.GetPath().ToStdString()};
+    auto class_name = make_callback_name(path.stem().string());
+    if(class_name.empty())
+    {
+        class_name = "GeneratedTree";
+    }
+    try
+    {
+        const auto code = generate_static_tree(document, class_name);
+        std::ofstream output{path, std::ios::binary | std::ios::trunc};
+        output << code;
+        if(!output)
+        {
+            throw std::runtime_error("cannot write " + path.string());
+        }
+    }
+    catch(const std::exception &error)
+    {
+        wxMessageBox(wxString::FromUTF8(error.what()), "Generate Code", wxOK | wxICON_ERROR, this);
+        return;
+    }
+    SetStatusText(wxString::Format("Generated %s<Agent>; it needs codegen/StaticTree.hpp on the include path",
+                                   class_name));
+}
+
+void MainFrame::OnLoadTraceClicked(wxRibbonButtonBarEvent &)
+{
+    wxFileDialog dialog{this, "Load Trace", wxEmptyString, wxEmptyString, trace_file_wildcard,
+                        wxFD_OPEN | wxFD_FILE_MUST_EXIST};
+    if(dialog.ShowModal() != wxID_OK)
+    {
+        return;
+    }
+
+    const std::filesystem::path path{dialog.GetPath().ToStdString()};
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<TraceEvent> events;
+    std::vector<NodeLatency> latencies;
+    try
+    {
+        if(path.extension() == profile_extension)
+        {
+            load_profile(path, latencies);
+        }
+        else
+        {
+            load_trace(path, events);
+        }
+    }
+    catch(const std::exception &error)
+    {
+        wxMessageBox(wxString::FromUTF8(error.what()), "Load Trace", wxOK | wxICON_ERROR, this);
+        return;
+    }
+
+    if(path.extension() == profile_extension)
+    {
+        profile.clear();
+        for(const auto &latency: latencies)
+        {
+            profile.insert_or_assign(latency.node, latency.histogram);
+        }
+        show_properties();
+        SetStatusText(wxString::Format("Loaded latencies of %s nodes in %.1f ms", std::to_string(profile.size()),
+                                       get_milliseconds_since(start)));
+        return;
+    }
+    trace.clear();
+    trace.add(events);
+    for(index_t node = 0; node < document.get_capacity(); ++node)
+    {
+        show_trace(node);
+    }
+    SetStatusText(wxString::Format("Loaded %s trace events in %.1f ms", std::to_string(events.size()),
+                                   get_milliseconds_since(start)));
+}
+
+void MainFrame::OnClearTraceClicked(wxRibbonButtonBarEvent &)
+{
+    trace.clear();
+    renderer.clear_overlays();
+    if(!profile.empty())
+    {
+        profile.clear();
+        get_additional_field().ClearAll();
+    }
+}
+
+void MainFrame::OnSearchTextChanged(wxCommandEvent &)
+{
+    run_search(true);
+}
+
+void MainFrame::OnSearchKindChanged(wxCommandEvent &)
+{
+    run_search(true);
+}
+
+void MainFrame::OnSearchResultSelected(wxCommandEvent &event)
+{
+    const auto selection = event.GetSelection();
+    if(selection < 0 || static_cast<size_t>(selection) >= search_matches.size())
+    {
+        return;
+    }
+    const auto node = search_matches[static_cast<size_t>(selection)];
+    if(document.contains(node))
+    {
+        go_to(node);
+        show(node);
+    }
+}
+
+void MainFrame::add_node(NodeKind kind)
+{
+    if(reject_while_loading())
+    {
+        return;
+    }
+    const auto parent = document.is_empty() ? TreeDocument::no_node : current;
+    if(parent != TreeDocument::no_node && !document.can_add_child(parent))
+    {
+        SetStatusText(wxString::Format("%s node cannot take another child", get_node_kind_name(document.get_kind(parent))));
+        return;
+    }
+
+    const auto label = std::string{get_node_kind_name(kind)} + " " + std::to_string(document.get_next_id());
+    const auto node = history.add_node(document, parent, kind, label, get_default_parameter(kind));
+    if(node == TreeDocument::no_node)
+    {
+        SetStatusText("No node IDs left");
+        return;
+    }
+    layout.set_width(node, measure_label(label));
+    layout.invalidate(parent);
+    hashes.invalidate(node);
+    search_index.update(node);
+
+    if(parent == TreeDocument::no_node)
+    {
+        current = node;
+    }
+    refresh_workspace();
+}
+
+void MainFrame::go_to(index_t node)
+{
+    if(node == TreeDocument::no_node)
+    {
+        return;
+    }
+    current = node;
+    renderer.set_current(current);
+    show_properties();
+}
+
+void MainFrame::show(index_t node)
+{
+    if(node != TreeDocument::no_node)
+    {
+        renderer.scroll_to(node);
+    }
+}
+
+int32_t MainFrame::measure_label(std::string_view label) const
+{
+    return label_metrics.measure(label);
+}
+
+void MainFrame::reload_workspace()
+{
+    layout.clear();
+    for(index_t node = 0; node < document.get_capacity(); ++node)
+    {
+        if(document.contains(node))
+        {
+            layout.set_width(node, measure_label(document.get_label(node)));
+        }
+    }
+    layout.update();
+    populate_workspace();
+}
+
+void MainFrame::populate_workspace()
+{
+    renderer.clear();
+    history.clear();
+    hashes.rebuild();
+    search_index.rebuild();
+    for(index_t node = 0; node < document.get_capacity(); ++node)
+    {
+        if(document.contains(node))
+        {
+            renderer.set_node(node, document.get_parent(node), layout.get_bounds(node),
+                              to_wx(document.get_label(node)), get_node_colour(document.get_kind(node)));
+            show_trace(node);
+        }
+    }
+    current = document.is_empty() ? TreeDocument::no_node : document.get_root();
+    renderer.set_current(current);
+    show_properties();
+    run_search(false);
+}
+
+void MainFrame::on_load_timer(wxTimerEvent &)
+{
+    const auto progress = loader->get_progress();
+    switch(progress.stage)
+    {
+        case TreeLoader::Stage::reading:
+        case TreeLoader::Stage::validating:
+        case TreeLoader::Stage::laying_out:
+            if(loader->take_preview(document, layout))
+            {
+                populate_workspace();
+                showing_preview = true;
+            }
+            SetStatusText(wxString::Format("Opening: %s %.0f%%", get_stage_name(progress.stage), progress.done * 100.0));
+            return;
+        case TreeLoader::Stage::finished:
+        {
+            load_timer.Stop();
+            std::vector<ValidationIssue> issues;
+            loader->take_result(document, layout, issues);
+            showing_preview = false;
+            populate_workspace();
+            show_loaded_tree(issues);
+            return;
+        }
+        case TreeLoader::Stage::failed:
+            load_timer.Stop();
+            wxMessageBox(to_wx(loader->get_error()), "Open Tree", wxOK | wxICON_ERROR, this);
+            break;
+        case TreeLoader::Stage::cancelled:
+            load_timer.Stop();
+            SetStatusText("Opening cancelled");
+            break;
+        case TreeLoader::Stage::idle:
+            load_timer.Stop();
+            break;
+    }
+    // A preview of a tree which never arrived is not worth keeping.
+    if(showing_preview)
+    {
+        showing_preview = false;
+        document.clear();
+        layout.clear();
+        populate_workspace();
+    }
+}
+
+void MainFrame::show_loaded_tree(const std::vector<ValidationIssue> &issues)
+{
+    const auto timings = loader->get_timings();
+    SetStatusText(wxString::Format("Loaded %s nodes: read %.1f ms, validated %.1f ms, laid out %.1f ms",
+                                   std::to_string(document.size()), timings.reading, timings.validating,
+                                   timings.laying_out));
+    if(issues.empty())
+    {
+        return;
+    }
+
+    wxString message = wxString::Format("%s problems found:\n", std::to_string(issues.size()));
+    for(size_t issue = 0; issue < std::min(issues.size(), listed_issues); ++issue)
+    {
+        message += "\n" + to_wx(issues[issue].message);
+    }
+    if(issues.size() > listed_issues)
+    {
+        message += "\n...";
+    }
+    go_to(issues.front().node);
+    show(current);
+    wxMessageBox(message, "Open Tree", wxOK | wxICON_WARNING, this);
+}
+
+bool MainFrame::reject_while_loading()
+{
+    if(!loader->is_running())
+    {
+        return false;
+    }
+    SetStatusText("Still opening a tree - wait for it or cancel it first");
+    return true;
+}
+
+void MainFrame::apply_change()
+{
+    for(const auto node: change.removed)
+    {
+        renderer.remove_node(node);
+        layout.forget(node);
+        hashes.forget(node);
+        search_index.forget(node);
+    }
+    for(const auto node: change.added)
+    {
+        layout.set_width(node, measure_label(document.get_label(node)));
+        hashes.invalidate(node);
+        search_index.update(node);
+    }
+    if(change.modified != TreeDocument::no_node)
+    {
+        const auto node = change.modified;
+        hashes.invalidate(node);
+        search_index.update(node);
+        layout.set_width(node, measure_label(document.get_label(node)));
+        renderer.set_node(node, document.get_parent(node), layout.get_bounds(node), to_wx(document.get_label(node)),
+                          get_node_colour(document.get_kind(node)));
+    }
+    layout.invalidate(change.parent);
+    hashes.invalidate(change.parent);
+    current = change.focus != TreeDocument::no_node || document.is_empty() ? change.focus : document.get_root();
+    refresh_workspace();
+    show_history();
+}
+
+void MainFrame::show_history()
+{
+    SetStatusText(wxString::Format("%s steps to undo, %s to redo, %.1f kB of history",
+                                   std::to_string(history.get_undo_count()), std::to_string(history.get_redo_count()),
+                                   static_cast<double>(history.get_memory_usage()) / 1024.0));
+}
+
+void MainFrame::refresh_workspace()
+{
+    for(const auto node: layout.update())
+    {
+        renderer.set_node(node, document.get_parent(node), layout.get_bounds(node),
+                          to_wx(document.get_label(node)), get_node_colour(document.get_kind(node)));
+        show_trace(node);
+    }
+    renderer.set_current(current);
+    show_properties();
+    run_search(false);
+}
+
+void MainFrame::show_properties()
+{
+    if(current == TreeDocument::no_node)
+    {
+        m_textCtrl1->Clear();
+        m_textCtrl2->Clear();
+        m_textCtrl3->Clear();
+        m_textCtrl4->Clear();
+        m_textCtrl5->Clear();
+        if(!profile.empty())
+        {
+            get_additional_field().ClearAll();
+        }
+        return;
+    }
+    const auto parent = document.get_parent(current);
+    m_textCtrl1->ChangeValue(to_wx(document.get_label(current)));
+    m_textCtrl2->ChangeValue(wxString::Format("%u", document.get_id(current)));
+    m_textCtrl3->ChangeValue(parent == TreeDocument::no_node ? wxString{"-"}
+                                                             : wxString::Format("%u", document.get_id(parent)));
+    m_textCtrl4->ChangeValue(get_node_kind_name(document.get_kind(current)));
+    m_textCtrl5->ChangeValue(wxString::Format("%u", document.get_child_count(current)));
+    show_latency();
+}
+
+void MainFrame::show_latency()
+{
+    if(profile.empty())
+    {
+        return;
+    }
+    // Parameter stays on the first line, where Modify Node reads it from.
+    wxString text;
+    const auto kind = document.get_kind(current);
+    if(kind == NodeKind::loop || kind == NodeKind::max_n_tries || kind == NodeKind::link)
+    {
+        text << wxString::Format("%u\n", document.get_parameter(current));
+    }
+    const auto latency = profile.find(document.get_id(current));
+    if(latency == profile.end())
+    {
+        text << "not timed";
+    }
+    else
+    {
+        const auto &histogram = latency->second;
+        text << wxString::Format("p50 %s\np99 %s\nmax %s\n%s timed evaluations",
+                                 format_latency(histogram.get_percentile(0.5)),
+                                 format_latency(histogram.get_percentile(0.99)), format_latency(histogram.get_max()),
+                                 std::to_string(histogram.get_count()));
+    }
+    get_additional_field().SetText(text);
+}
+
+void MainFrame::show_trace(index_t node)
+{
+    if(trace.is_empty() || !document.contains(node))
+    {
+        return;
+    }
+    const auto &totals = trace.get(document.get_id(node));
+    const auto finished = totals.successes + totals.failures + totals.running;
+    WorkspaceRenderer::Overlay overlay;
+    overlay.heat = get_heat_colour(totals.hits, trace.get_max_hits());
+    if(finished > 0)
+    {
+        overlay.success_share = static_cast<double>(totals.successes) / static_cast<double>(finished);
+        overlay.failure_share = static_cast<double>(totals.failures) / static_cast<double>(finished);
+        overlay.caption = wxString::Format("%s  %.0f%% / %.0f%%", format_hits(totals.hits),
+                                           overlay.success_share * 100.0, overlay.failure_share * 100.0);
+    }
+    else
+    {
+        overlay.caption = format_hits(totals.hits);
+    }
+    renderer.set_overlay(node, overlay);
+}
+
+void MainFrame::show_frame_time(const FrameTimer &timer)
+{
+    const auto to_ms = [](FrameTimer::duration time) { return static_cast<double>(time.count()) / 1000.0; };
+    SetStatusText(wxString::Format("Frame: %.2f ms (avg %.2f ms, worst %.2f ms, %llu of %llu over budget)",
+                                   to_ms(timer.get_last()), to_ms(timer.get_average()), to_ms(timer.get_worst()),
+                                   static_cast<unsigned long long>(timer.get_frames_over_budget()),
+                                   static_cast<unsigned long long>(timer.get_frame_count())), 1);
+}
+
+void MainFrame::run_search(bool report)
+{
+    const auto text = search_text->GetValue().ToStdString();
+    const auto kind = search_kind->GetSelection();
+    search_matches.clear();
+    // First choice takes every kind, the rest follow the order of NodeKind.
+    if(text.empty() && kind <= 0)
+    {
+        search_results->Clear();
+        return;
+    }
+
+    NodeQuery query;
+    query.text = text;
+    query.max_results = listed_search_results;
+    if(kind > 0)
+    {
+        query.kinds.reset();
+        query.kinds.set(static_cast<size_t>(kind - 1));
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const auto match = search_index.search(query, search_matches);
+    const auto elapsed = get_milliseconds_since(start);
+
+    wxArrayString items;
+    items.Alloc(search_matches.size());
+    for(const auto node: search_matches)
+    {
+        items.Add(wxString::Format("#%s  %s", std::to_string(document.get_id(node)), to_wx(document.get_label(node))));
+    }
+    search_results->Set(items);
+    if(!report)
+    {
+        return;
+    }
+    switch(match)
+    {
+        case NodeMatch::none:
+            SetStatusText(wxString::Format("Nothing found (%.2f ms)", elapsed));
+            break;
+        case NodeMatch::id:
+            go_to(search_matches.front());
+            show(current);
+            SetStatusText(wxString::Format("Node found by ID (%.2f ms)", elapsed));
+            break;
+        case NodeMatch::substring:
+            SetStatusText(wxString::Format("%s%s nodes found (%.2f ms)",
+                                           search_matches.size() == listed_search_results ? "First " : "",
+                                           std::to_string(search_matches.size()), elapsed));
+            break;
+        case NodeMatch::similar:
+            SetStatusText(wxString::Format("No label contains the text; %s similar nodes (%.2f ms)",
+                                           std::to_string(search_matches.size()), elapsed));
+            break;
+    }
 }
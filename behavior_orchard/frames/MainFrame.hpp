@@ -25,12 +25,136 @@
 #pragma once
 
 #include "Autogenerated.h"
+#include "../io/TreeLoader.hpp"
+#include "../layout/LabelMetrics.hpp"
+#include "../layout/TreeLayout.hpp"
+#include "../model/EditHistory.hpp"
+#include "../model/LatencyHistogram.hpp"
+#include "../model/NodeSearchIndex.hpp"
+#include "../model/SubtreeHashes.hpp"
+#include "../model/TraceStatistics.hpp"
+#include "../model/TreeDocument.hpp"
+#include "../runtime/WorkStealingPool.hpp"
+#include "../view/StartupTimer.hpp"
+#include "../view/WorkspaceRenderer.hpp"
+
+#include <wx/stc/stc.h>
+#include <wx/timer.h>
+
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 class MainFrame: public GeneratedMainFrame
 {
 public:
-    MainFrame();
-};
+    // Marks the startup phases up to the first frame; when exit_when_started is set, the phases are
+    // printed to stdout and the frame closes right after it.
+    MainFrame(StartupTimer &startup_timer, bool exit_when_started);
+
+protected:
+    void OnNewTreeClicked(wxRibbonButtonBarEvent &event) override;
+    void OnOpenTreeClicked(wxRibbonButtonBarEvent &event) override;
+    void OnSaveTreeClicked(wxRibbonButtonBarEvent &event) override;
+    void OnCancelOpenClicked(wxRibbonButtonBarEvent &event) override;
+    void OnGenerateCodeClicked(wxRibbonButtonBarEvent &event) override;
+    void OnLoadTraceClicked(wxRibbonButtonBarEvent &event) override;
+    void OnClearTraceClicked(wxRibbonButtonBarEvent &event) override;
+    void OnSearchTextChanged(wxCommandEvent &event) override;
+    void OnSearchKindChanged(wxCommandEvent &event) override;
+    void OnSearchResultSelected(wxCommandEvent &event) override;
+
+    // Buttons of the "Nodes" page, bound when the page is built.
+    void OnNewSelectorClicked(wxRibbonButtonBarEvent &event);
+    void OnNewSequenceClicked(wxRibbonButtonBarEvent &event);
+    void OnNewActionClicked(wxRibbonButtonBarEvent &event);
+    void OnNewConditionClicked(wxRibbonButtonBarEvent &event);
+    void OnNewLinkClicked(wxRibbonButtonBarEvent &event);
+    void OnNewInvertClicked(wxRibbonButtonBarEvent &event);
+    void OnNewLoopClicked(wxRibbonButtonBarEvent &event);
+    void OnNewMaxNTriesClicked(wxRibbonButtonBarEvent &event);
+    void OnModifyNodeClicked(wxRibbonButtonBarEvent &event);
+    void OnDeleteNodeClicked(wxRibbonButtonBarEvent &event);
+    void OnUndoClicked(wxRibbonButtonBarEvent &event);
+    void OnRedoClicked(wxRibbonButtonBarEvent &event);
+    void OnFoldDuplicatesClicked(wxRibbonButtonBarEvent &event);
+    void OnGotoParentClicked(wxRibbonButtonBarEvent &event);
+    void OnGotoNewestClicked(wxRibbonButtonBarEvent &event);
+    void OnGotoPreviousSiblingClicked(wxRibbonButtonBarEvent &event);
+    void OnGotoNextSiblingClicked(wxRibbonButtonBarEvent &event);
+    void OnGotoFirstChildClicked(wxRibbonButtonBarEvent &event);
+    void OnGotoLastChildClicked(wxRibbonButtonBarEvent &event);
+    void OnShowParentClicked(wxRibbonButtonBarEvent &event);
+    void OnShowCurrentClicked(wxRibbonButtonBarEvent &event);
+    void OnShowNewestClicked(wxRibbonButtonBarEvent &event);
 
+private:
+    using index_t = TreeDocument::index_t;
+
+    // Fills the "Nodes" ribbon page, which is not shown at startup, when it is first opened.
+    void on_ribbon_page_changing(wxRibbonBarEvent &event);
+    void build_nodes_page();
+    // Builds what is left of the window once the first frame is on screen and reports the startup time.
+    void on_first_frame();
+    // The "Additional" field; built by on_first_frame, or by whoever needs it before.
+    wxStyledTextCtrl &get_additional_field();
+    void add_node(NodeKind kind);
+    // Lays out the whole document from scratch and shows it.
+    void reload_workspace();
+    // Pushes every node to the renderer, after the loader handed over document and layout.
+    void populate_workspace();
+    // Polls the loader: shows the preview, then the whole tree, or reports progress.
+    void on_load_timer(wxTimerEvent &event);
+    void show_loaded_tree(const std::vector<ValidationIssue> &issues);
+    // Edits of the preview would be lost once the whole tree arrives; returns true (and says so) while
+    // a tree is being opened.
+    bool reject_while_loading();
+    // Brings layout and workspace up to date with an undo or redo.
+    void apply_change();
+    void show_history();
+    // Moves the current node; no_node (e.g. parent of the root) leaves it where it is.
+    void go_to(index_t node);
+    void show(index_t node);
+    int32_t measure_label(std::string_view label) const;
+    // Lays out what the last edit invalidated and pushes moved nodes to the renderer.
+    void refresh_workspace();
+    void show_properties();
+    // Writes p50 / p99 of the current node into the "Additional" field while a profile is loaded.
+    void show_latency();
+    // Overlays trace totals of the node on its box; nothing while no trace is loaded.
+    void show_trace(index_t node);
+    void show_frame_time(const FrameTimer &timer);
+    // Lists nodes matching the search box, if anything is typed or filtered; the status bar tells how
+    // it went only when asked to, so that edits refreshing the list keep their own message.
+    void run_search(bool report);
+
+    StartupTimer &startup;
+    bool exit_after_start;
+    bool started;
+    bool nodes_page_built;
+    wxStyledTextCtrl *additional_field;
+
+    WorkStealingPool pool;
+    LabelMetrics label_metrics;
+    std::unique_ptr<TreeLoader> loader;
+    wxTimer load_timer;
+    // Workspace shows the top levels of a tree which is still being opened.
+    bool showing_preview;
+
+    TreeDocument document;
+    TreeLayout layout;
+    SubtreeHashes hashes;
+    NodeSearchIndex search_index;
+    // Nodes in the order of the search results list.
+    std::vector<index_t> search_matches;
+    WorkspaceRenderer renderer;
+    index_t current;
+    TraceStatistics trace;
+    std::unordered_map<TreeDocument::id_t, LatencyHistogram> profile;
+    std::vector<index_t> removed;
+    EditHistory history;
+    EditChange change;
+};
 
 
@@ -0,0 +1,67 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#include "AtomicFile.hpp"
+
+#include <stdexcept>
+#include <system_error>
+
+AtomicFile::AtomicFile(const std::filesystem::path &target_path, std::ios::openmode mode):
+        target{target_path},
+        temporary{target_path.string() + ".tmp"},
+        stream{temporary, mode | std::ios::out | std::ios::trunc}
+{
+}
+
+AtomicFile::~AtomicFile()
+{
+    if(!committed)
+    {
+        stream.close();
+        std::error_code ignored;
+        std::filesystem::remove(temporary, ignored);
+    }
+}
+
+std::ofstream &AtomicFile::get_stream()
+{
+    return stream;
+}
+
+void AtomicFile::commit()
+{
+    stream.close();
+    if(!stream)
+    {
+        throw std::runtime_error("AtomicFile: cannot write " + temporary.string());
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, target, error);
+    if(error)
+    {
+        throw std::runtime_error("AtomicFile: cannot replace " + target.string() + ": " + error.message());
+    }
+    committed = true;
+}
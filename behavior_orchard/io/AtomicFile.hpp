@@ -0,0 +1,54 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+
+// Output file which replaces its target only once it is completely written: the content goes to a
+// sibling temporary file, renamed over the target by commit. A save which fails half-way (or never
+// commits) leaves the previous file as it was and removes the temporary one.
+class AtomicFile
+{
+public:
+    explicit AtomicFile(const std::filesystem::path &target_path, std::ios::openmode mode = std::ios::binary);
+    ~AtomicFile();
+
+    AtomicFile(const AtomicFile &) = delete;
+    AtomicFile &operator=(const AtomicFile &) = delete;
+
+    std::ofstream &get_stream();
+    // Throws std::runtime_error if the content could not be written or the target replaced.
+    void commit();
+
+private:
+    std::filesystem::path target;
+    std::filesystem::path temporary;
+    std::ofstream stream;
+    bool committed = false;
+};
+
+
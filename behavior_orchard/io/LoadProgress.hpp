@@ -0,0 +1,51 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+
+// Called by the loaders every few thousand nodes with the share of the input consumed so far (0 to 1).
+// Returning false abandons the load: the loader throws LoadCancelled, leaving the document partly filled.
+using LoadProgress = std::function<bool(double done)>;
+
+class LoadCancelled: public std::runtime_error
+{
+public:
+    LoadCancelled():
+            std::runtime_error{"load cancelled"}
+    {
+    }
+};
+
+namespace load_progress
+{
+    // Nodes between two calls of the progress callback.
+    constexpr uint32_t report_period = 4096;
+}
+
+
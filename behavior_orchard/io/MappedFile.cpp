@@ -0,0 +1,100 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "MappedFile.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ORCHARD_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::filesystem::path &path):
+        bytes{nullptr},
+        length{0}
+{
+#ifdef ORCHARD_HAS_MMAP
+    const auto descriptor = ::open(path.c_str(), O_RDONLY);
+    if(descriptor < 0)
+    {
+        throw std::runtime_error("MappedFile: cannot open " + path.string());
+    }
+    struct stat status{};
+    if(::fstat(descriptor, &status) != 0)
+    {
+        ::close(descriptor);
+        throw std::runtime_error("MappedFile: cannot stat " + path.string());
+    }
+    length = static_cast<size_t>(status.st_size);
+    if(length > 0)
+    {
+        auto mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if(mapping == MAP_FAILED)
+        {
+            ::close(descriptor);
+            throw std::runtime_error("MappedFile: cannot map " + path.string());
+        }
+        // Loaders walk the file front to back.
+        ::madvise(mapping, length, MADV_SEQUENTIAL);
+        bytes = static_cast<const unsigned char *>(mapping);
+    }
+    ::close(descriptor);
+#else
+    std::ifstream input{path, std::ios::binary | std::ios::ate};
+    if(!input)
+    {
+        throw std::runtime_error("MappedFile: cannot open " + path.string());
+    }
+    fallback.resize(static_cast<size_t>(input.tellg()));
+    input.seekg(0);
+    input.read(reinterpret_cast<char *>(fallback.data()), static_cast<std::streamsize>(fallback.size()));
+    bytes = fallback.data();
+    length = fallback.size();
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef ORCHARD_HAS_MMAP
+    if(bytes != nullptr)
+    {
+        ::munmap(const_cast<unsigned char *>(bytes), length);
+    }
+#endif
+}
+
+const unsigned char *MappedFile::data() const
+{
+    return bytes;
+}
+
+size_t MappedFile::size() const
+{
+    return length;
+}
@@ -0,0 +1,162 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#include "ProfileFile.hpp"
+#include "MappedFile.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    using namespace profile_file_format;
+
+    template<typename Integer>
+    Integer read(const unsigned char *source)
+    {
+        Integer value;
+        std::memcpy(&value, source, sizeof(value));
+        return value;
+    }
+
+    template<typename Integer>
+    void write(std::ostream &output, Integer value)
+    {
+        output.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    [[noreturn]] void fail(const std::string &reason)
+    {
+        throw std::runtime_error("profile file: " + reason);
+    }
+
+    void check_host()
+    {
+        const uint32_t probe = 1;
+        unsigned char first_byte = 0;
+        std::memcpy(&first_byte, &probe, 1);
+        if(first_byte != 1)
+        {
+            fail("big-endian hosts are not supported");
+        }
+    }
+}
+
+void save_profile(const std::vector<NodeLatency> &latencies, const std::filesystem::path &path)
+{
+    check_host();
+    std::ofstream output{path, std::ios::binary | std::ios::trunc};
+    if(!output)
+    {
+        fail("cannot open " + path.string() + " for writing");
+    }
+
+    output.write(magic, sizeof(magic));
+    write(output, version);
+    write(output, static_cast<uint32_t>(latencies.size()));
+    for(const auto &[node, histogram]: latencies)
+    {
+        uint32_t used_buckets = 0;
+        for(uint32_t bucket = 0; bucket < LatencyHistogram::bucket_count; ++bucket)
+        {
+            used_buckets += histogram.get_bucket_count(bucket) > 0 ? 1u : 0u;
+        }
+        write(output, node);
+        write(output, used_buckets);
+        write(output, histogram.get_sum());
+        write(output, histogram.get_min());
+        write(output, histogram.get_max());
+        for(uint32_t bucket = 0; bucket < LatencyHistogram::bucket_count; ++bucket)
+        {
+            if(histogram.get_bucket_count(bucket) > 0)
+            {
+                write(output, bucket);
+                write(output, histogram.get_bucket_count(bucket));
+            }
+        }
+    }
+    if(!output)
+    {
+        fail("cannot write " + path.string());
+    }
+}
+
+void load_profile(const std::filesystem::path &path, std::vector<NodeLatency> &latencies)
+{
+    check_host();
+    const MappedFile file{path};
+    const auto *image = file.data();
+    const auto size = file.size();
+    if(size < header_size || std::memcmp(image, magic, sizeof(magic)) != 0)
+    {
+        fail(path.string() + " is not a profile");
+    }
+    if(read<uint32_t>(image + 8) != version)
+    {
+        fail("unsupported version " + std::to_string(read<uint32_t>(image + 8)));
+    }
+
+    const auto node_count = read<uint32_t>(image + 12);
+    const auto first = latencies.size();
+    size_t offset = header_size;
+    for(uint32_t i = 0; i < node_count; ++i)
+    {
+        if(size - offset < node_header_size)
+        {
+            latencies.resize(first);
+            fail("truncated node " + std::to_string(i));
+        }
+        NodeLatency latency{read<uint32_t>(image + offset), {}};
+        const auto used_buckets = read<uint32_t>(image + offset + 4);
+        const auto sum = read<uint64_t>(image + offset + 8);
+        const auto minimum = read<uint64_t>(image + offset + 16);
+        const auto maximum = read<uint64_t>(image + offset + 24);
+        offset += node_header_size;
+        if((size - offset) / bucket_size < used_buckets)
+        {
+            latencies.resize(first);
+            fail("truncated buckets of node " + std::to_string(latency.node));
+        }
+        for(uint32_t j = 0; j < used_buckets; ++j, offset += bucket_size)
+        {
+            const auto bucket = read<uint32_t>(image + offset);
+            if(bucket >= LatencyHistogram::bucket_count)
+            {
+                latencies.resize(first);
+                fail("bucket " + std::to_string(bucket) + " out of range in node " + std::to_string(latency.node));
+            }
+            latency.histogram.add_to_bucket(bucket, read<uint64_t>(image + offset + 4));
+        }
+        latency.histogram.set_totals(sum, minimum, maximum);
+        latencies.push_back(latency);
+    }
+    if(offset != size)
+    {
+        latencies.resize(first);
+        fail("unexpected data after the last node");
+    }
+}
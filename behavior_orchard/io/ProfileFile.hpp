@@ -0,0 +1,55 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "../model/LatencyHistogram.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// Latency profile, version 1. All integers little-endian.
+//
+//   header  16 bytes  magic "BOPROF\r\n", version, node count
+//   nodes   per node: ID, number of non-empty buckets, total, minimum and maximum nanoseconds
+//           (32 bytes), then 12 bytes per non-empty bucket: bucket index and count
+namespace profile_file_format
+{
+    constexpr char magic[8] = {'B', 'O', 'P', 'R', 'O', 'F', '\r', '\n'};
+    constexpr uint32_t version = 1;
+    constexpr size_t header_size = 16;
+    constexpr size_t node_header_size = 32;
+    constexpr size_t bucket_size = 12;
+}
+
+constexpr auto profile_extension = ".btprof";
+
+void save_profile(const std::vector<NodeLatency> &latencies, const std::filesystem::path &path);
+// Appends the nodes of the profile; throws std::runtime_error for anything but a well-formed profile.
+void load_profile(const std::filesystem::path &path, std::vector<NodeLatency> &latencies);
+
+
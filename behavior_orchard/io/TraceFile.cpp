@@ -0,0 +1,124 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#include "TraceFile.hpp"
+#include "MappedFile.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    using namespace trace_file_format;
+
+    uint32_t read_u32(const unsigned char *source)
+    {
+        uint32_t value;
+        std::memcpy(&value, source, sizeof(value));
+        return value;
+    }
+
+    void write_u32(unsigned char *destination, uint32_t value)
+    {
+        std::memcpy(destination, &value, sizeof(value));
+    }
+
+    [[noreturn]] void fail(const std::string &reason)
+    {
+        throw std::runtime_error("trace file: " + reason);
+    }
+
+    bool is_little_endian()
+    {
+        const uint32_t probe = 1;
+        unsigned char first_byte = 0;
+        std::memcpy(&first_byte, &probe, 1);
+        return first_byte == 1;
+    }
+}
+
+void save_trace(const std::vector<TraceEvent> &events, const std::filesystem::path &path)
+{
+    if(!is_little_endian())
+    {
+        fail("big-endian hosts are not supported");
+    }
+    std::ofstream output{path, std::ios::binary | std::ios::trunc};
+    if(!output)
+    {
+        fail("cannot open " + path.string() + " for writing");
+    }
+
+    unsigned char header[header_size] = {};
+    std::memcpy(header, magic, sizeof(magic));
+    write_u32(header + 8, version);
+    output.write(reinterpret_cast<const char *>(header), sizeof(header));
+    // TraceEvent is laid out exactly as the record, so the events go out as they are.
+    output.write(reinterpret_cast<const char *>(events.data()),
+                 static_cast<std::streamsize>(events.size() * event_size));
+    if(!output)
+    {
+        fail("cannot write " + path.string());
+    }
+}
+
+void load_trace(const std::filesystem::path &path, std::vector<TraceEvent> &events)
+{
+    if(!is_little_endian())
+    {
+        fail("big-endian hosts are not supported");
+    }
+    const MappedFile file{path};
+    const auto *image = file.data();
+    if(file.size() < header_size || std::memcmp(image, magic, sizeof(magic)) != 0)
+    {
+        fail(path.string() + " is not a trace dump");
+    }
+    if(read_u32(image + 8) != version)
+    {
+        fail("unsupported version " + std::to_string(read_u32(image + 8)));
+    }
+    const auto payload = file.size() - header_size;
+    if(payload % event_size != 0)
+    {
+        fail("truncated event at the end of " + path.string());
+    }
+
+    const auto first = events.size();
+    const auto count = payload / event_size;
+    events.resize(first + count);
+    std::memcpy(events.data() + first, image + header_size, payload);
+    for(auto i = first; i < events.size(); ++i)
+    {
+        const auto &event = events[i];
+        if(event.type > TraceEventType::exit || event.result > TraceResult::running)
+        {
+            events.resize(first);
+            fail("malformed event " + std::to_string(i - first));
+        }
+    }
+}
@@ -0,0 +1,53 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "../model/TraceEvent.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// Trace dump, version 1. All integers little-endian.
+//
+//   header  16 bytes  magic "BOTRACE\n", version, reserved
+//   events   8 bytes per event: node ID, type, result, thread - in the order they were drained
+namespace trace_file_format
+{
+    constexpr char magic[8] = {'B', 'O', 'T', 'R', 'A', 'C', 'E', '\n'};
+    constexpr uint32_t version = 1;
+    constexpr size_t header_size = 16;
+    constexpr size_t event_size = 8;
+}
+
+constexpr auto trace_extension = ".bttrace";
+
+void save_trace(const std::vector<TraceEvent> &events, const std::filesystem::path &path);
+// Appends the events of the dump; throws std::runtime_error for anything but a well-formed dump.
+void load_trace(const std::filesystem::path &path, std::vector<TraceEvent> &events);
+
+
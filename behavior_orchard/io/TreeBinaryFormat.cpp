@@ -0,0 +1,294 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "TreeBinaryFormat.hpp"
+
+#include "AtomicFile.hpp"
+#include "MappedFile.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    using namespace tree_binary_format;
+    using index_t = TreeDocument::index_t;
+
+    bool is_little_endian()
+    {
+        const uint32_t probe = 1;
+        unsigned char first_byte = 0;
+        std::memcpy(&first_byte, &probe, 1);
+        return first_byte == 1;
+    }
+
+    void check_host()
+    {
+        if(!is_little_endian())
+        {
+            throw std::runtime_error("tree binary format: big-endian hosts are not supported");
+        }
+    }
+
+    uint32_t read_u32(const unsigned char *source)
+    {
+        uint32_t value;
+        std::memcpy(&value, source, sizeof(value));
+        return value;
+    }
+
+    void write_u32(unsigned char *destination, uint32_t value)
+    {
+        std::memcpy(destination, &value, sizeof(value));
+    }
+
+    [[noreturn]] void fail(const std::string &reason)
+    {
+        throw std::runtime_error("tree binary format: " + reason);
+    }
+}
+
+BinaryTreeView::BinaryTreeView(const unsigned char *image, size_t image_size)
+{
+    check_host();
+    if(!is_tree_binary(image, image_size))
+    {
+        fail("not a binary tree file");
+    }
+    if(read_u32(image + 8) != version)
+    {
+        fail("unsupported version " + std::to_string(read_u32(image + 8)));
+    }
+    node_count = read_u32(image + 12);
+    strings_size = read_u32(image + 16);
+    if(header_size + size_t{node_count} * record_size + strings_size > image_size)
+    {
+        fail("file is truncated");
+    }
+    nodes = image + header_size;
+    strings = reinterpret_cast<const char *>(nodes + size_t{node_count} * record_size);
+    label_bytes = 0;
+
+    // One linear pass keeps every later access in bounds: labels inside the pool, IDs in range,
+    // parents before children and every child range pointing back at its parent.
+    for(uint32_t position = 0; position < node_count; ++position)
+    {
+        const auto record = get_record(position);
+        if(static_cast<size_t>(record.kind) >= node_kind_count)
+        {
+            fail("unknown node kind at " + std::to_string(position));
+        }
+        if(size_t{record.label_offset} + record.label_length > strings_size)
+        {
+            fail("label out of bounds at " + std::to_string(position));
+        }
+        label_bytes += record.label_length;
+        if(record.id > TreeDocument::max_id)
+        {
+            fail("bad id at " + std::to_string(position));
+        }
+        if((position == 0) != (record.parent == no_position) || (position != 0 && record.parent >= position))
+        {
+            fail("bad parent at " + std::to_string(position));
+        }
+        if(record.child_count > get_max_children(record.kind) ||
+           (record.child_count > 0 && (record.first_child <= position ||
+                                       size_t{record.first_child} + record.child_count > node_count)))
+        {
+            fail("bad children at " + std::to_string(position));
+        }
+        for(uint32_t child = 0; child < record.child_count; ++child)
+        {
+            if(read_u32(nodes + size_t{record.first_child + child} * record_size + 20) != position)
+            {
+                fail("child does not point back at " + std::to_string(position));
+            }
+        }
+    }
+}
+
+uint32_t BinaryTreeView::get_node_count() const
+{
+    return node_count;
+}
+
+size_t BinaryTreeView::get_label_bytes() const
+{
+    return label_bytes;
+}
+
+BinaryTreeView::Record BinaryTreeView::get_record(uint32_t position) const
+{
+    const auto source = nodes + size_t{position} * record_size;
+    return {static_cast<NodeKind>(source[0]), read_u32(source + 4), read_u32(source + 8), read_u32(source + 12),
+            read_u32(source + 16), read_u32(source + 20), read_u32(source + 24), read_u32(source + 28)};
+}
+
+std::string_view BinaryTreeView::get_label(const Record &record) const
+{
+    return {strings + record.label_offset, record.label_length};
+}
+
+void save_tree_binary(const TreeDocument &document, std::ostream &output)
+{
+    check_host();
+    const auto node_count = static_cast<uint32_t>(document.size());
+
+    // Breadth-first order is what makes child ranges contiguous; positions are handed out as nodes
+    // are queued, so every record can be written the moment it is dequeued.
+    std::vector<index_t> order;
+    std::vector<uint32_t> parent_positions;
+    order.reserve(node_count);
+    parent_positions.reserve(node_count);
+    if(!document.is_empty())
+    {
+        order.push_back(document.get_root());
+        parent_positions.push_back(no_position);
+    }
+
+    std::string pool;
+    std::unordered_map<std::string_view, uint32_t> interned;
+    interned.reserve(node_count);
+    // Records go out in chunks; one stream call per record dominates the save otherwise.
+    constexpr size_t chunk_records = 4096;
+    std::vector<unsigned char> chunk;
+    chunk.reserve(chunk_records * record_size);
+
+    unsigned char header[header_size] = {};
+    std::memcpy(header, magic, sizeof(magic));
+    write_u32(header + 8, version);
+    write_u32(header + 12, node_count);
+    output.write(reinterpret_cast<const char *>(header), sizeof(header));
+
+    for(size_t position = 0; position < order.size(); ++position)
+    {
+        const auto node = order[position];
+        const auto first_child = static_cast<uint32_t>(order.size());
+        for(auto child = document.get_first_child(node); child != TreeDocument::no_node;
+            child = document.get_next_sibling(child))
+        {
+            order.push_back(child);
+            parent_positions.push_back(static_cast<uint32_t>(position));
+        }
+
+        const auto label = document.get_label(node);
+        auto label_offset = static_cast<uint32_t>(pool.size());
+        const auto known = interned.find(label);
+        if(known != interned.end())
+        {
+            label_offset = known->second;
+        }
+        else
+        {
+            // Keys view the document's own labels, which stay put while saving.
+            interned.emplace(label, label_offset);
+            pool.append(label);
+        }
+
+        chunk.resize(chunk.size() + record_size);
+        const auto record = chunk.data() + chunk.size() - record_size;
+        record[0] = static_cast<unsigned char>(document.get_kind(node));
+        write_u32(record + 4, document.get_id(node));
+        write_u32(record + 8, document.get_parameter(node));
+        write_u32(record + 12, label_offset);
+        write_u32(record + 16, static_cast<uint32_t>(label.size()));
+        write_u32(record + 20, parent_positions[position]);
+        write_u32(record + 24, document.get_child_count(node) > 0 ? first_child : no_position);
+        write_u32(record + 28, document.get_child_count(node));
+        if(chunk.size() == chunk_records * record_size || position + 1 == order.size())
+        {
+            output.write(reinterpret_cast<const char *>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+            chunk.clear();
+        }
+    }
+    output.write(pool.data(), static_cast<std::streamsize>(pool.size()));
+
+    // Pool size is known only now.
+    unsigned char pool_size[4];
+    write_u32(pool_size, static_cast<uint32_t>(pool.size()));
+    const auto end = output.tellp();
+    output.seekp(16, std::ios::beg);
+    output.write(reinterpret_cast<const char *>(pool_size), sizeof(pool_size));
+    output.seekp(end);
+    if(!output)
+    {
+        fail("write failed");
+    }
+}
+
+void save_tree_binary(const TreeDocument &document, const std::filesystem::path &path)
+{
+    // Written next to the target and renamed over it, so a failed save leaves the old file intact.
+    AtomicFile file{path};
+    if(!file.get_stream())
+    {
+        fail("cannot open " + path.string() + " for writing");
+    }
+    save_tree_binary(document, file.get_stream());
+    file.commit();
+}
+
+void load_tree_binary(const BinaryTreeView &view, TreeDocument &document, const LoadProgress &progress)
+{
+    document.clear();
+    const auto node_count = view.get_node_count();
+    document.reserve(node_count, view.get_label_bytes());
+
+    // Parents always precede children in the table, so one forward pass can attach every node.
+    std::vector<index_t> indices(node_count, TreeDocument::no_node);
+    for(uint32_t position = 0; position < node_count; ++position)
+    {
+        if(progress && position % load_progress::report_period == 0 && position != 0 &&
+           !progress(static_cast<double>(position) / node_count))
+        {
+            throw LoadCancelled{};
+        }
+        const auto record = view.get_record(position);
+        const auto parent = record.parent == no_position ? TreeDocument::no_node : indices[record.parent];
+        if(document.find_by_id(record.id) != TreeDocument::no_node)
+        {
+            fail("bad id at " + std::to_string(position));
+        }
+        indices[position] = document.add_node(parent, record.kind, view.get_label(record), record.parameter, record.id);
+        if(indices[position] == TreeDocument::no_node)
+        {
+            fail("bad node at " + std::to_string(position));
+        }
+    }
+}
+
+void load_tree_binary(const std::filesystem::path &path, TreeDocument &document)
+{
+    const MappedFile file{path};
+    load_tree_binary(BinaryTreeView{file.data(), file.size()}, document);
+}
+
+bool is_tree_binary(const unsigned char *image, size_t image_size)
+{
+    return image_size >= header_size && std::memcmp(image, magic, sizeof(magic)) == 0;
+}
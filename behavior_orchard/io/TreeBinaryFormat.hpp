@@ -0,0 +1,98 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include "LoadProgress.hpp"
+#include "../model/TreeDocument.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <string_view>
+
+// Binary tree file, version 1. All integers little-endian.
+//
+//   header      32 bytes  magic "BOTREE\r\n", version, node count, string pool size, reserved
+//   node table  32 bytes per node, breadth-first, so children of every node are one contiguous
+//               range of the table: kind, ID, parameter, label (offset and length into the pool),
+//               parent, first child, child count - all positions are table indices
+//   string pool labels, each distinct label stored once
+//
+// The table is usable in place: BinaryTreeView reads records straight from the mapped file.
+namespace tree_binary_format
+{
+    constexpr char magic[8] = {'B', 'O', 'T', 'R', 'E', 'E', '\r', '\n'};
+    constexpr uint32_t version = 1;
+    constexpr size_t header_size = 32;
+    constexpr size_t record_size = 32;
+    constexpr uint32_t no_position = UINT32_MAX;
+}
+
+// Validated view over a binary tree image; does not copy anything.
+class BinaryTreeView
+{
+public:
+    struct Record
+    {
+        NodeKind kind;
+        uint32_t id;
+        uint32_t parameter;
+        uint32_t label_offset;
+        uint32_t label_length;
+        uint32_t parent;
+        uint32_t first_child;
+        uint32_t child_count;
+    };
+
+    // Throws std::runtime_error if the image is not a well-formed tree.
+    BinaryTreeView(const unsigned char *image, size_t image_size);
+
+    uint32_t get_node_count() const;
+    // Total length of all labels as the document will store them (the file keeps each once).
+    size_t get_label_bytes() const;
+    Record get_record(uint32_t position) const;
+    std::string_view get_label(const Record &record) const;
+
+private:
+    const unsigned char *nodes;
+    const char *strings;
+    uint32_t node_count;
+    uint32_t strings_size;
+    size_t label_bytes;
+};
+
+// Streams the document out without building any intermediate representation.
+void save_tree_binary(const TreeDocument &document, std::ostream &output);
+void save_tree_binary(const TreeDocument &document, const std::filesystem::path &path);
+
+// Replaces the content of the document. Node IDs are kept as saved.
+void load_tree_binary(const BinaryTreeView &view, TreeDocument &document, const LoadProgress &progress = {});
+// Memory-maps the file and loads straight from the mapping.
+void load_tree_binary(const std::filesystem::path &path, TreeDocument &document);
+
+bool is_tree_binary(const unsigned char *image, size_t image_size);
+
+
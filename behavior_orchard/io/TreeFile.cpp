@@ -0,0 +1,81 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "TreeFile.hpp"
+
+#include "MappedFile.hpp"
+#include "TreeBinaryFormat.hpp"
+#include "TreeTextFormat.hpp"
+
+#include <stdexcept>
+
+namespace
+{
+    // False if the image is in neither format.
+    bool load_image(const unsigned char *image, size_t image_size, TreeDocument &document,
+                    const LoadProgress &progress)
+    {
+        if(is_tree_binary(image, image_size))
+        {
+            load_tree_binary(BinaryTreeView{image, image_size}, document, progress);
+            return true;
+        }
+        const std::string_view text{reinterpret_cast<const char *>(image), image_size};
+        if(is_tree_text(text))
+        {
+            parse_tree_text(text, document, progress);
+            return true;
+        }
+        return false;
+    }
+}
+
+void load_tree(const std::filesystem::path &path, TreeDocument &document, const LoadProgress &progress)
+{
+    const MappedFile file{path};
+    if(!load_image(file.data(), file.size(), document, progress))
+    {
+        throw std::runtime_error("load_tree: " + path.string() + " is not a tree file");
+    }
+}
+
+void load_tree(const unsigned char *image, size_t image_size, TreeDocument &document, const LoadProgress &progress)
+{
+    if(!load_image(image, image_size, document, progress))
+    {
+        throw std::runtime_error("load_tree: not a tree file");
+    }
+}
+
+void save_tree(const TreeDocument &document, const std::filesystem::path &path)
+{
+    if(path.extension() == tree_binary_extension)
+    {
+        save_tree_binary(document, path);
+    }
+    else
+    {
+        save_tree_text(document, path);
+    }
+}
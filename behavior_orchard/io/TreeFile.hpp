@@ -0,0 +1,45 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include "LoadProgress.hpp"
+#include "../model/TreeDocument.hpp"
+
+#include <cstddef>
+#include <filesystem>
+
+// Extension of the binary format; anything else is saved as text.
+constexpr auto tree_binary_extension = ".btree";
+constexpr auto tree_text_extension = ".tree";
+
+// Picks the format by the content of the file, so a renamed file still opens.
+void load_tree(const std::filesystem::path &path, TreeDocument &document, const LoadProgress &progress = {});
+// Same for a file already in memory.
+void load_tree(const unsigned char *image, size_t image_size, TreeDocument &document,
+               const LoadProgress &progress = {});
+// Picks the format by the extension.
+void save_tree(const TreeDocument &document, const std::filesystem::path &path);
+
+
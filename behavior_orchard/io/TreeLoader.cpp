@@ -0,0 +1,308 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#include "TreeLoader.hpp"
+
+#include "TreeFile.hpp"
+
+#include <chrono>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+    using index_t = TreeDocument::index_t;
+
+    double get_milliseconds_since(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Enough subtrees per thread for stealing to even out their different sizes.
+    constexpr size_t subtrees_per_thread = 8;
+}
+
+TreeLoader::TreeLoader(WorkStealingPool &worker_pool, const LabelMetrics &metrics, TreeLayoutSettings settings,
+                       size_t preview_size):
+        pool{worker_pool},
+        label_metrics{metrics},
+        preview_limit{std::max<size_t>(preview_size, 1)},
+        layout{document, settings},
+        preview_layout{preview, settings},
+        stage{Stage::idle},
+        done{0.0},
+        cancelling{false},
+        preview_ready{false},
+        preview_taken{false}
+{
+}
+
+TreeLoader::~TreeLoader()
+{
+    cancel();
+    wait();
+}
+
+void TreeLoader::start(const std::filesystem::path &path)
+{
+    if(is_running())
+    {
+        throw std::logic_error("TreeLoader: another tree is still loading");
+    }
+    wait();
+    cancelling = false;
+    preview_ready = false;
+    preview_taken = false;
+    issues.clear();
+    error.clear();
+    timings = Timings{};
+    set_stage(Stage::reading);
+    thread = std::thread{&TreeLoader::run, this, path};
+}
+
+void TreeLoader::cancel()
+{
+    cancelling = true;
+}
+
+void TreeLoader::wait()
+{
+    if(thread.joinable())
+    {
+        thread.join();
+    }
+}
+
+bool TreeLoader::is_running() const
+{
+    const auto current = stage.load();
+    return current == Stage::reading || current == Stage::validating || current == Stage::laying_out;
+}
+
+TreeLoader::Progress TreeLoader::get_progress() const
+{
+    return {stage.load(), done.load(std::memory_order_relaxed)};
+}
+
+bool TreeLoader::take_preview(TreeDocument &target, TreeLayout &target_layout)
+{
+    if(preview_taken || !preview_ready.load())
+    {
+        return false;
+    }
+    preview_taken = true;
+    target = std::move(preview);
+    target_layout.adopt(std::move(preview_layout));
+    return true;
+}
+
+bool TreeLoader::take_result(TreeDocument &target, TreeLayout &target_layout, std::vector<ValidationIssue> &found)
+{
+    if(stage.load() != Stage::finished)
+    {
+        return false;
+    }
+    wait();
+    target = std::move(document);
+    target_layout.adopt(std::move(layout));
+    found = std::move(issues);
+    set_stage(Stage::idle);
+    return true;
+}
+
+std::string TreeLoader::get_error() const
+{
+    return stage.load() == Stage::failed ? error : std::string{};
+}
+
+TreeLoader::Timings TreeLoader::get_timings() const
+{
+    return is_running() ? Timings{} : timings;
+}
+
+void TreeLoader::run(std::filesystem::path path)
+{
+    try
+    {
+        auto start = std::chrono::steady_clock::now();
+        read(path);
+        build_preview();
+        lay_out(preview, preview_layout, false);
+        preview_ready = true;
+        timings.reading = get_milliseconds_since(start);
+
+        start = std::chrono::steady_clock::now();
+        validate();
+        timings.validating = get_milliseconds_since(start);
+
+        start = std::chrono::steady_clock::now();
+        lay_out(document, layout, true);
+        timings.laying_out = get_milliseconds_since(start);
+        set_stage(Stage::finished);
+    }
+    catch(const LoadCancelled &)
+    {
+        set_stage(Stage::cancelled);
+    }
+    catch(const std::exception &exception)
+    {
+        error = exception.what();
+        set_stage(Stage::failed);
+    }
+}
+
+void TreeLoader::read(const std::filesystem::path &path)
+{
+    load_tree(path, document, [this](double share)
+    {
+        done.store(share, std::memory_order_relaxed);
+        return !cancelling.load(std::memory_order_relaxed);
+    });
+}
+
+void TreeLoader::build_preview()
+{
+    check_cancelled();
+    preview.clear();
+    if(document.is_empty())
+    {
+        return;
+    }
+
+    // Whole levels, breadth-first, as long as they fit; entries pair a node with its parent in the preview.
+    std::vector<std::pair<index_t, index_t>> level{{document.get_root(), TreeDocument::no_node}};
+    std::vector<std::pair<index_t, index_t>> next_level;
+    while(!level.empty() && preview.size() + level.size() <= preview_limit)
+    {
+        next_level.clear();
+        for(const auto &[node, parent]: level)
+        {
+            const auto copy = preview.add_node(parent, document.get_kind(node), document.get_label(node),
+                                               document.get_parameter(node), document.get_id(node));
+            for(auto child = document.get_first_child(node); child != TreeDocument::no_node;
+                child = document.get_next_sibling(child))
+            {
+                next_level.emplace_back(child, copy);
+            }
+        }
+        level.swap(next_level);
+    }
+}
+
+void TreeLoader::validate()
+{
+    check_cancelled();
+    set_stage(Stage::validating);
+    if(document.is_empty())
+    {
+        return;
+    }
+
+    // Splits the tree level by level into subtrees until there are enough of them to keep every
+    // worker busy; nodes above the split are checked here.
+    const auto wanted = pool.get_thread_count() * subtrees_per_thread;
+    std::vector<index_t> roots{document.get_root()};
+    std::vector<index_t> next_roots;
+    bool expanded = true;
+    while(roots.size() < wanted && expanded)
+    {
+        expanded = false;
+        next_roots.clear();
+        for(const auto node: roots)
+        {
+            if(document.get_child_count(node) == 0)
+            {
+                next_roots.push_back(node);
+                continue;
+            }
+            validate_node(document, node, issues);
+            expanded = true;
+            for(auto child = document.get_first_child(node); child != TreeDocument::no_node;
+                child = document.get_next_sibling(child))
+            {
+                next_roots.push_back(child);
+            }
+        }
+        roots.swap(next_roots);
+    }
+
+    std::vector<std::vector<ValidationIssue>> found(pool.get_thread_count());
+    std::atomic<size_t> validated{0};
+    pool.parallel_for(roots.size(), 1, [&](size_t begin, size_t end, size_t worker)
+    {
+        for(auto root = begin; root < end && !cancelling.load(std::memory_order_relaxed); ++root)
+        {
+            validate_subtree(document, roots[root], found[worker]);
+        }
+        const auto count = validated.fetch_add(end - begin) + end - begin;
+        done.store(static_cast<double>(count) / static_cast<double>(roots.size()), std::memory_order_relaxed);
+    });
+    check_cancelled();
+    for(auto &worker_issues: found)
+    {
+        issues.insert(issues.end(), std::make_move_iterator(worker_issues.begin()),
+                      std::make_move_iterator(worker_issues.end()));
+    }
+    validate_links(document, issues);
+    sort_issues(document, issues);
+}
+
+void TreeLoader::lay_out(const TreeDocument &tree, TreeLayout &tree_layout, bool report)
+{
+    check_cancelled();
+    if(report)
+    {
+        set_stage(Stage::laying_out);
+    }
+    tree_layout.clear();
+    const auto capacity = tree.get_capacity();
+    for(index_t node = 0; node < capacity; ++node)
+    {
+        if(report && node % load_progress::report_period == 0)
+        {
+            check_cancelled();
+            done.store(static_cast<double>(node) / capacity, std::memory_order_relaxed);
+        }
+        if(tree.contains(node))
+        {
+            tree_layout.set_width(node, label_metrics.measure(tree.get_label(node)));
+        }
+    }
+    tree_layout.update();
+}
+
+void TreeLoader::check_cancelled() const
+{
+    if(cancelling.load(std::memory_order_relaxed))
+    {
+        throw LoadCancelled{};
+    }
+}
+
+void TreeLoader::set_stage(Stage next)
+{
+    done.store(0.0, std::memory_order_relaxed);
+    stage.store(next);
+}
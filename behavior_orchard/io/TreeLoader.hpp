@@ -0,0 +1,134 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "../layout/LabelMetrics.hpp"
+#include "../layout/TreeLayout.hpp"
+#include "../model/TreeDocument.hpp"
+#include "../model/TreeValidator.hpp"
+#include "../runtime/WorkStealingPool.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Opens a tree file on a background thread: reads and parses it, validates it and lays it out, so
+// the UI thread only has to take the result. Progress of the running stage can be polled, the load
+// cancelled at any point, and the top levels of the tree - laid out separately as soon as the file is
+// parsed - taken for display long before the whole tree is ready. Subtrees are validated in parallel
+// on the pool.
+class TreeLoader
+{
+public:
+    enum class Stage: uint8_t
+    {
+        idle,
+        reading,
+        validating,
+        laying_out,
+        finished,
+        failed,
+        cancelled
+    };
+
+    struct Progress
+    {
+        Stage stage;
+        // Share of the stage done, 0 to 1; laying out reports only label measurement.
+        double done;
+    };
+
+    // Milliseconds spent in each stage of the last load.
+    struct Timings
+    {
+        double reading = 0.0;
+        double validating = 0.0;
+        double laying_out = 0.0;
+    };
+
+    // Preview holds the tree down to the deepest level which keeps it within preview_size nodes.
+    TreeLoader(WorkStealingPool &worker_pool, const LabelMetrics &metrics, TreeLayoutSettings settings = {},
+               size_t preview_size = 4096);
+    ~TreeLoader();
+
+    TreeLoader(const TreeLoader &) = delete;
+    TreeLoader &operator=(const TreeLoader &) = delete;
+
+    // Throws std::logic_error while another load is running.
+    void start(const std::filesystem::path &path);
+    // Returns at once; the loader stops at its next check and ends in the cancelled stage.
+    void cancel();
+    // Blocks until the background thread ends.
+    void wait();
+    bool is_running() const;
+
+    Progress get_progress() const;
+
+    // Moves the preview out once it is ready; true only for the first call of a load. The document
+    // replaces the content of the given one and the layout is adopted by the given layout, which has
+    // to refer to that document.
+    bool take_preview(TreeDocument &document, TreeLayout &layout);
+    // Same for the whole tree, once the finished stage is reached.
+    bool take_result(TreeDocument &document, TreeLayout &layout, std::vector<ValidationIssue> &issues);
+    // Reason of the failed stage.
+    std::string get_error() const;
+    Timings get_timings() const;
+
+private:
+    void run(std::filesystem::path path);
+    void read(const std::filesystem::path &path);
+    void build_preview();
+    void validate();
+    void lay_out(const TreeDocument &tree, TreeLayout &tree_layout, bool report);
+    void check_cancelled() const;
+    void set_stage(Stage stage);
+
+    WorkStealingPool &pool;
+    LabelMetrics label_metrics;
+    size_t preview_limit;
+
+    // Written by the background thread only; handed over once the matching flag is set.
+    TreeDocument document;
+    TreeLayout layout;
+    TreeDocument preview;
+    TreeLayout preview_layout;
+    std::vector<ValidationIssue> issues;
+    Timings timings;
+    std::string error;
+
+    std::thread thread;
+    std::atomic<Stage> stage;
+    std::atomic<double> done;
+    std::atomic<bool> cancelling;
+    std::atomic<bool> preview_ready;
+    // Used by the owning thread only.
+    bool preview_taken;
+};
+
+
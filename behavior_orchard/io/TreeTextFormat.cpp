@@ -0,0 +1,346 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "TreeTextFormat.hpp"
+
+#include "AtomicFile.hpp"
+#include "MappedFile.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using index_t = TreeDocument::index_t;
+
+    constexpr size_t indent_width = 4;
+
+    constexpr std::array<std::string_view, node_kind_count> kind_keywords = {
+        "selector", "sequence", "action", "condition", "link", "invert", "loop", "max_n_tries"};
+
+    class Parser
+    {
+    public:
+        explicit Parser(std::string_view source_text):
+                text{source_text},
+                total_size{source_text.size()},
+                line_number{0}
+        {
+        }
+
+        bool next_line(std::string_view &line)
+        {
+            while(!text.empty())
+            {
+                const auto end = text.find('\n');
+                line = text.substr(0, end);
+                text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+                ++line_number;
+                if(!line.empty() && line.back() == '\r')
+                {
+                    line.remove_suffix(1);
+                }
+                if(line.find_first_not_of(' ') != std::string_view::npos)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Share of the text already consumed.
+        double get_done() const
+        {
+            return total_size == 0 ? 1.0 : 1.0 - static_cast<double>(text.size()) / static_cast<double>(total_size);
+        }
+
+        [[noreturn]] void fail(const std::string &reason) const
+        {
+            throw std::runtime_error("tree text format: line " + std::to_string(line_number) + ": " + reason);
+        }
+
+        std::string_view take_word(std::string_view &line) const
+        {
+            const auto end = line.find(' ');
+            const auto word = line.substr(0, end);
+            line.remove_prefix(end == std::string_view::npos ? line.size() : end);
+            skip_spaces(line);
+            return word;
+        }
+
+        uint32_t parse_number(std::string_view word) const
+        {
+            uint32_t value = 0;
+            const auto result = std::from_chars(word.data(), word.data() + word.size(), value);
+            if(word.empty() || result.ec != std::errc{} || result.ptr != word.data() + word.size())
+            {
+                fail("expected a number, got '" + std::string{word} + "'");
+            }
+            return value;
+        }
+
+        NodeKind parse_kind(std::string_view word) const
+        {
+            for(size_t kind = 0; kind < kind_keywords.size(); ++kind)
+            {
+                if(kind_keywords[kind] == word)
+                {
+                    return static_cast<NodeKind>(kind);
+                }
+            }
+            fail("unknown node kind '" + std::string{word} + "'");
+        }
+
+        void parse_label(std::string_view &line, std::string &label) const
+        {
+            label.clear();
+            if(line.empty() || line.front() != '"')
+            {
+                fail("expected a quoted label");
+            }
+            size_t position = 1;
+            for(; position < line.size() && line[position] != '"'; ++position)
+            {
+                auto character = line[position];
+                if(character == '\\')
+                {
+                    if(++position == line.size())
+                    {
+                        break;
+                    }
+                    switch(line[position])
+                    {
+                        case 'n':
+                            character = '\n';
+                            break;
+                        case 't':
+                            character = '\t';
+                            break;
+                        case '"':
+                        case '\\':
+                            character = line[position];
+                            break;
+                        default:
+                            fail("unknown escape sequence in label");
+                    }
+                }
+                label.push_back(character);
+            }
+            if(position >= line.size())
+            {
+                fail("unterminated label");
+            }
+            line.remove_prefix(position + 1);
+            skip_spaces(line);
+        }
+
+    private:
+        static void skip_spaces(std::string_view &line)
+        {
+            const auto start = line.find_first_not_of(' ');
+            line.remove_prefix(start == std::string_view::npos ? line.size() : start);
+        }
+
+        std::string_view text;
+        size_t total_size;
+        size_t line_number;
+    };
+
+    void write_label(std::ostream &output, std::string_view label)
+    {
+        output.put('"');
+        for(const auto character: label)
+        {
+            switch(character)
+            {
+                case '"':
+                    output << "\\\"";
+                    break;
+                case '\\':
+                    output << "\\\\";
+                    break;
+                case '\n':
+                    output << "\\n";
+                    break;
+                case '\t':
+                    output << "\\t";
+                    break;
+                default:
+                    output.put(character);
+            }
+        }
+        output.put('"');
+    }
+}
+
+void save_tree_text(const TreeDocument &document, std::ostream &output)
+{
+    output << tree_text_format::header << '\n';
+    if(document.is_empty())
+    {
+        return;
+    }
+
+    // Iterative pre-order walk; depth is tracked by how far the walk climbs back up.
+    const std::string indentation(indent_width * 64, ' ');
+    size_t depth = 0;
+    auto node = document.get_root();
+    while(node != TreeDocument::no_node)
+    {
+        for(auto remaining = depth * indent_width; remaining > 0;)
+        {
+            const auto chunk = std::min(remaining, indentation.size());
+            output.write(indentation.data(), static_cast<std::streamsize>(chunk));
+            remaining -= chunk;
+        }
+        output << kind_keywords[static_cast<size_t>(document.get_kind(node))] << " #" << document.get_id(node) << ' ';
+        write_label(output, document.get_label(node));
+        if(document.get_parameter(node) != 0)
+        {
+            output << ' ' << document.get_parameter(node);
+        }
+        output << '\n';
+
+        if(document.get_first_child(node) != TreeDocument::no_node)
+        {
+            node = document.get_first_child(node);
+            ++depth;
+            continue;
+        }
+        while(node != TreeDocument::no_node && document.get_next_sibling(node) == TreeDocument::no_node)
+        {
+            node = document.get_parent(node);
+            --depth;
+        }
+        if(node != TreeDocument::no_node)
+        {
+            node = document.get_next_sibling(node);
+        }
+    }
+    if(!output)
+    {
+        throw std::runtime_error("tree text format: write failed");
+    }
+}
+
+void save_tree_text(const TreeDocument &document, const std::filesystem::path &path)
+{
+    // Written next to the target and renamed over it, so a failed save leaves the old file intact.
+    AtomicFile file{path};
+    if(!file.get_stream())
+    {
+        throw std::runtime_error("tree text format: cannot open " + path.string() + " for writing");
+    }
+    save_tree_text(document, file.get_stream());
+    file.commit();
+}
+
+void parse_tree_text(std::string_view text, TreeDocument &document, const LoadProgress &progress)
+{
+    Parser parser{text};
+    std::string_view line;
+    if(!parser.next_line(line) || line != tree_text_format::header)
+    {
+        parser.fail("missing header");
+    }
+
+    document.clear();
+    // Ancestors of the line being parsed, one per depth.
+    std::vector<index_t> path;
+    std::string label;
+    uint32_t until_report = load_progress::report_period;
+    while(parser.next_line(line))
+    {
+        if(progress && --until_report == 0)
+        {
+            until_report = load_progress::report_period;
+            if(!progress(parser.get_done()))
+            {
+                throw LoadCancelled{};
+            }
+        }
+        const auto indent = line.find_first_not_of(' ');
+        if(indent % indent_width != 0)
+        {
+            parser.fail("indentation is not a multiple of " + std::to_string(indent_width));
+        }
+        const auto depth = indent / indent_width;
+        if(depth > path.size() || (depth == 0 && !path.empty()))
+        {
+            parser.fail(depth == 0 ? "second root" : "indented too deep");
+        }
+        line.remove_prefix(indent);
+
+        const auto kind = parser.parse_kind(parser.take_word(line));
+        const auto id_word = parser.take_word(line);
+        if(id_word.empty() || id_word.front() != '#')
+        {
+            parser.fail("expected a node ID");
+        }
+        const auto id = parser.parse_number(id_word.substr(1));
+        if(id > TreeDocument::max_id)
+        {
+            parser.fail("bad id " + std::string{id_word});
+        }
+        parser.parse_label(line, label);
+        const auto parameter = line.empty() ? 0 : parser.parse_number(parser.take_word(line));
+        if(!line.empty())
+        {
+            parser.fail("unexpected text after the node");
+        }
+
+        path.resize(depth);
+        const auto parent = path.empty() ? TreeDocument::no_node : path.back();
+        index_t node = TreeDocument::no_node;
+        try
+        {
+            node = document.add_node(parent, kind, label, parameter, id);
+        }
+        catch(const std::exception &error)
+        {
+            parser.fail(error.what());
+        }
+        if(node == TreeDocument::no_node)
+        {
+            parser.fail("parent cannot have more children");
+        }
+        path.push_back(node);
+    }
+}
+
+void load_tree_text(const std::filesystem::path &path, TreeDocument &document)
+{
+    const MappedFile file{path};
+    parse_tree_text({reinterpret_cast<const char *>(file.data()), file.size()}, document);
+}
+
+bool is_tree_text(std::string_view text)
+{
+    return text.substr(0, tree_text_format::header.size()) == tree_text_format::header;
+}
@@ -0,0 +1,57 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include "LoadProgress.hpp"
+#include "../model/TreeDocument.hpp"
+
+#include <filesystem>
+#include <iosfwd>
+#include <string_view>
+
+// Human-readable tree file, meant for diffs and hand edits. One node per line, nesting by indentation:
+//
+//   behavior_orchard_tree 1
+//   selector #0 "Selector 0"
+//       loop #1 "Loop 1" 3
+//           action #2 "say \"hello\""
+//
+// Every line holds the kind, the ID, the quoted label (\" \\ \n \t escapes) and the parameter if it is
+// not zero. Depth is four spaces per level.
+namespace tree_text_format
+{
+    constexpr std::string_view header = "behavior_orchard_tree 1";
+}
+
+void save_tree_text(const TreeDocument &document, std::ostream &output);
+void save_tree_text(const TreeDocument &document, const std::filesystem::path &path);
+
+// Replaces the content of the document. Throws std::runtime_error naming the line of the first error.
+void parse_tree_text(std::string_view text, TreeDocument &document, const LoadProgress &progress = {});
+void load_tree_text(const std::filesystem::path &path, TreeDocument &document);
+
+bool is_tree_text(std::string_view text);
+
+
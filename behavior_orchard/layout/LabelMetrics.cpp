@@ -0,0 +1,55 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#include "LabelMetrics.hpp"
+
+#include <algorithm>
+
+LabelMetrics::LabelMetrics():
+        LabelMetrics{0, 0}
+{
+}
+
+LabelMetrics::LabelMetrics(int32_t label_padding, int32_t minimal_width):
+        advances{},
+        padding{label_padding},
+        minimal{minimal_width}
+{
+}
+
+void LabelMetrics::set_advance(unsigned char byte, int32_t width)
+{
+    advances[byte] = width;
+}
+
+int32_t LabelMetrics::measure(std::string_view label) const
+{
+    int32_t width = padding;
+    for(const auto character: label)
+    {
+        width += advances[static_cast<unsigned char>(character)];
+    }
+    return std::max(minimal, width);
+}
@@ -0,0 +1,51 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+// Width of node boxes without a device context, so labels can be measured on any thread. The
+// advance of every byte is taken from the font once; a label is as wide as the sum of its bytes
+// plus padding (UTF-8 continuation bytes add nothing, the lead byte carries the whole character).
+// Kerning is ignored, which only ever shifts a box by a few pixels.
+class LabelMetrics
+{
+public:
+    LabelMetrics();
+    LabelMetrics(int32_t label_padding, int32_t minimal_width);
+
+    void set_advance(unsigned char byte, int32_t width);
+    int32_t measure(std::string_view label) const;
+
+private:
+    std::array<int32_t, 256> advances;
+    int32_t padding;
+    int32_t minimal;
+};
+
+
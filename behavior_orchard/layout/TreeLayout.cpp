@@ -0,0 +1,374 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "TreeLayout.hpp"
+
+#include <algorithm>
+#include <limits>
+
+TreeLayout::TreeLayout(const TreeDocument &tree, Settings layout_settings):
+        document{tree},
+        settings{layout_settings}
+{
+}
+
+void TreeLayout::set_width(index_t node, int32_t width)
+{
+    auto &layout = get_layout(node);
+    if(layout.width == width && layout.placed)
+    {
+        return;
+    }
+    layout.resized = layout.placed;
+    layout.width = width;
+    mark_dirty(node);
+}
+
+void TreeLayout::invalidate(index_t node)
+{
+    if(node == TreeDocument::no_node)
+    {
+        return;
+    }
+    mark_dirty(node);
+}
+
+void TreeLayout::forget(index_t node)
+{
+    if(node < layouts.size())
+    {
+        layouts[node] = NodeLayout{};
+    }
+}
+
+void TreeLayout::clear()
+{
+    layouts.clear();
+    dirty_nodes.clear();
+    changed.clear();
+    root_centre_x = 0;
+}
+
+void TreeLayout::adopt(TreeLayout &&other)
+{
+    settings = other.settings;
+    layouts = std::move(other.layouts);
+    dirty_nodes = std::move(other.dirty_nodes);
+    root_centre_x = other.root_centre_x;
+    changed.clear();
+    other.clear();
+}
+
+const std::vector<TreeLayout::index_t> &TreeLayout::update()
+{
+    changed.clear();
+    if(document.is_empty())
+    {
+        dirty_nodes.clear();
+        return changed;
+    }
+
+    // Nodes removed and added again before this update may be queued twice; each is kept only once.
+    auto kept = dirty_nodes.begin();
+    for(const auto node: dirty_nodes)
+    {
+        if(document.contains(node) && layouts[node].dirty)
+        {
+            layouts[node].dirty = false;
+            *kept++ = node;
+        }
+    }
+    dirty_nodes.erase(kept, dirty_nodes.end());
+
+    // Dirty set is closed upwards. Laying each node out once all its dirty children are guarantees
+    // every child is ready when its parent is merged, without looking at any clean child.
+    for(const auto node: dirty_nodes)
+    {
+        layouts[node].dirty = true;
+        const auto parent = document.get_parent(node);
+        if(parent != TreeDocument::no_node)
+        {
+            ++layouts[parent].dirty_children;
+        }
+    }
+    pending.clear();
+    for(const auto node: dirty_nodes)
+    {
+        if(layouts[node].dirty_children == 0)
+        {
+            pending.push_back(node);
+        }
+    }
+    while(!pending.empty())
+    {
+        const auto node = pending.back();
+        pending.pop_back();
+        layout_subtree(node);
+        const auto parent = document.get_parent(node);
+        if(parent != TreeDocument::no_node && --layouts[parent].dirty_children == 0)
+        {
+            pending.push_back(parent);
+        }
+    }
+
+    place(document.get_root());
+    for(const auto node: dirty_nodes)
+    {
+        auto &layout = layouts[node];
+        // Node which got a new width without moving.
+        if(layout.resized)
+        {
+            layout.resized = false;
+            changed.push_back(node);
+        }
+        layout.dirty = false;
+    }
+    dirty_nodes.clear();
+    return changed;
+}
+
+Rect TreeLayout::get_bounds(index_t node) const
+{
+    const auto &layout = layouts.at(node);
+    return {layout.centre_x - layout.width / 2, settings.margin + layout.depth * (settings.node_height + settings.level_gap),
+            layout.width, settings.node_height};
+}
+
+const TreeLayout::Settings &TreeLayout::get_settings() const
+{
+    return settings;
+}
+
+TreeLayout::NodeLayout &TreeLayout::get_layout(index_t node)
+{
+    if(node >= layouts.size())
+    {
+        layouts.resize(node + 1);
+    }
+    return layouts[node];
+}
+
+void TreeLayout::mark_dirty(index_t node)
+{
+    // Stops at the first dirty ancestor - the rest of the spine is already queued.
+    while(node != TreeDocument::no_node)
+    {
+        auto &layout = get_layout(node);
+        if(layout.dirty)
+        {
+            return;
+        }
+        layout.dirty = true;
+        dirty_nodes.push_back(node);
+        node = document.get_parent(node);
+    }
+}
+
+TreeLayout::ContourStep TreeLayout::get_next_left(index_t node) const
+{
+    const auto child = document.get_first_child(node);
+    if(child != TreeDocument::no_node)
+    {
+        return {child, layouts[child].offset};
+    }
+    return {layouts[node].left_thread, layouts[node].left_thread_x};
+}
+
+TreeLayout::ContourStep TreeLayout::get_next_right(index_t node) const
+{
+    const auto child = document.get_last_child(node);
+    if(child != TreeDocument::no_node)
+    {
+        return {child, layouts[child].offset};
+    }
+    return {layouts[node].right_thread, layouts[node].right_thread_x};
+}
+
+void TreeLayout::clear_threads(const NodeLayout &layout)
+{
+    // Threads at the bottom of a child come from an earlier layout of its parent (or of an ancestor,
+    // which is dirty too) and are set again while the child is merged; those within it stay valid.
+    for(const auto extreme: {layout.left_extreme, layout.right_extreme})
+    {
+        layouts[extreme].left_thread = TreeDocument::no_node;
+        layouts[extreme].right_thread = TreeDocument::no_node;
+    }
+}
+
+void TreeLayout::layout_subtree(index_t node)
+{
+    auto &layout = layouts[node];
+    const auto half_width = layout.width / 2;
+    layout.height = 0;
+    layout.left_extreme = node;
+    layout.right_extreme = node;
+    layout.left_extreme_x = 0;
+    layout.right_extreme_x = 0;
+    layout.leftmost = -half_width;
+
+    const auto first_child = document.get_first_child(node);
+    if(first_child == TreeDocument::no_node)
+    {
+        return;
+    }
+
+    // Children are packed left to right, each pushed as close to the already placed ones as their
+    // contours allow on every common level. Positions are relative to the first child. The forest of
+    // placed children is described by the last child (the top of its right contour) and its deepest
+    // nodes, the ends of its left and right contour.
+    const auto &first = layouts[first_child];
+    clear_threads(first);
+    child_positions.assign(1, 0);
+    auto forest_height = first.height;
+    auto forest_left = first.left_extreme;
+    auto forest_left_x = first.left_extreme_x;
+    auto forest_right = first.right_extreme;
+    auto forest_right_x = first.right_extreme_x;
+    auto leftmost = first.leftmost;
+    auto previous = first_child;
+    for(auto child = document.get_next_sibling(first_child); child != TreeDocument::no_node;
+        child = document.get_next_sibling(child))
+    {
+        const auto &child_layout = layouts[child];
+        clear_threads(child_layout);
+        // Right contour of the forest against the left contour of the child, level by level.
+        auto right = previous;
+        auto right_x = child_positions.back();
+        auto left = child;
+        int32_t left_x = 0;
+        auto position = std::numeric_limits<int32_t>::min();
+        ContourStep next_right;
+        ContourStep next_left;
+        while(true)
+        {
+            const auto &right_layout = layouts[right];
+            const auto right_edge = right_x + right_layout.width - right_layout.width / 2;
+            position = std::max(position, right_edge - (left_x - layouts[left].width / 2) + settings.sibling_gap);
+            next_right = get_next_right(right);
+            next_left = get_next_left(left);
+            if(next_right.node == TreeDocument::no_node || next_left.node == TreeDocument::no_node)
+            {
+                break;
+            }
+            right = next_right.node;
+            right_x += next_right.x;
+            left = next_left.node;
+            left_x += next_left.x;
+        }
+        child_positions.push_back(position);
+
+        // Shorter side is continued by the deeper one.
+        if(next_right.node != TreeDocument::no_node)
+        {
+            auto &extreme = layouts[child_layout.right_extreme];
+            extreme.right_thread = next_right.node;
+            extreme.right_thread_x = right_x + next_right.x - (position + child_layout.right_extreme_x);
+        }
+        else if(next_left.node != TreeDocument::no_node)
+        {
+            auto &extreme = layouts[forest_left];
+            extreme.left_thread = next_left.node;
+            extreme.left_thread_x = position + left_x + next_left.x - forest_left_x;
+        }
+
+        if(child_layout.height > forest_height)
+        {
+            forest_height = child_layout.height;
+            forest_left = child_layout.left_extreme;
+            forest_left_x = position + child_layout.left_extreme_x;
+        }
+        if(child_layout.height >= forest_height)
+        {
+            forest_right = child_layout.right_extreme;
+            forest_right_x = position + child_layout.right_extreme_x;
+        }
+        leftmost = std::min(leftmost, position + child_layout.leftmost);
+        previous = child;
+    }
+
+    // Parent is centred above its first and last child.
+    const auto centre = (child_positions.front() + child_positions.back()) / 2;
+    auto position = child_positions.begin();
+    for(auto child = first_child; child != TreeDocument::no_node; child = document.get_next_sibling(child))
+    {
+        layouts[child].offset = *position++ - centre;
+    }
+    layout.height = forest_height + 1;
+    layout.left_extreme = forest_left;
+    layout.left_extreme_x = forest_left_x - centre;
+    layout.right_extreme = forest_right;
+    layout.right_extreme_x = forest_right_x - centre;
+    layout.leftmost = std::min(layout.leftmost, leftmost - centre);
+}
+
+void TreeLayout::place(index_t root)
+{
+    auto &root_layout = layouts[root];
+    // Root only ever moves right, so growing the tree to the right never shifts the whole drawing.
+    const auto wanted_x = std::max(root_centre_x, settings.margin - root_layout.leftmost);
+    const auto root_moved = wanted_x != root_centre_x || !root_layout.placed;
+    root_centre_x = wanted_x;
+
+    // Walk down only where something changed: through dirty nodes (their children may have new
+    // offsets) and through subtrees whose origin moved. Untouched subtrees are skipped entirely.
+    pending.clear();
+    if(root_moved || root_layout.dirty)
+    {
+        root_layout.depth = 0;
+        if(root_moved || !root_layout.placed || root_layout.centre_x != root_centre_x)
+        {
+            root_layout.centre_x = root_centre_x;
+            root_layout.placed = true;
+            root_layout.resized = false;
+            changed.push_back(root);
+        }
+        pending.push_back(root);
+    }
+    while(!pending.empty())
+    {
+        const auto node = pending.back();
+        pending.pop_back();
+        const auto &layout = layouts[node];
+        for(auto child = document.get_first_child(node); child != TreeDocument::no_node;
+            child = document.get_next_sibling(child))
+        {
+            auto &child_layout = layouts[child];
+            const auto centre_x = layout.centre_x + child_layout.offset;
+            const auto depth = layout.depth + 1;
+            const auto moved = !child_layout.placed || child_layout.centre_x != centre_x || child_layout.depth != depth;
+            if(moved)
+            {
+                child_layout.centre_x = centre_x;
+                child_layout.depth = depth;
+                child_layout.placed = true;
+                child_layout.resized = false;
+                changed.push_back(child);
+            }
+            if(moved || child_layout.dirty)
+            {
+                pending.push_back(child);
+            }
+        }
+    }
+}
@@ -0,0 +1,132 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include "../model/TreeDocument.hpp"
+#include "../view/Rect.hpp"
+
+#include <cstdint>
+#include <vector>
+
+struct TreeLayoutSettings
+{
+    int32_t node_height = 36;
+    int32_t level_gap = 40;
+    int32_t sibling_gap = 16;
+    int32_t margin = 20;
+};
+
+// Tidy tree layout (Reingold-Tilford style) computed incrementally.
+// Contours are threaded as in Walker's algorithm with Buchheim's improvements: instead of a copy of
+// its contour, each node keeps the deepest nodes at both ends of its subtree and leaves on a contour
+// keep a thread to where the contour goes on, so the memory is a constant per node. Each node also
+// keeps its offset from the parent. After an edit only the invalidated nodes and their ancestor spine
+// are laid out again - every other subtree is reused as it is - and absolute positions are recomputed
+// only for subtrees which actually moved.
+class TreeLayout
+{
+public:
+    using index_t = TreeDocument::index_t;
+    using Settings = TreeLayoutSettings;
+
+    explicit TreeLayout(const TreeDocument &tree, Settings layout_settings = Settings{});
+
+    // Node was added or its width changed.
+    void set_width(index_t node, int32_t width);
+    // Children of the node were added, removed or reordered.
+    void invalidate(index_t node);
+    // Node was removed from the document.
+    void forget(index_t node);
+    void clear();
+    // Takes over everything another instance computed for an identical document - one laid out on a
+    // worker thread and then moved into the document of this layout. Settings are taken over too.
+    void adopt(TreeLayout &&other);
+
+    // Lays out everything invalidated since the last update.
+    // Returns nodes whose bounds changed; valid until the next call.
+    const std::vector<index_t> &update();
+
+    Rect get_bounds(index_t node) const;
+    const Settings &get_settings() const;
+
+private:
+    struct NodeLayout
+    {
+        int32_t width = 0;
+        // Horizontal distance between centre of the node and centre of its parent.
+        int32_t offset = 0;
+        int32_t centre_x = 0;
+        int32_t depth = 0;
+        // Levels of the subtree below the node; first and last node on the deepest of them and their
+        // distances from the node.
+        int32_t height = 0;
+        index_t left_extreme = TreeDocument::no_node;
+        index_t right_extreme = TreeDocument::no_node;
+        int32_t left_extreme_x = 0;
+        int32_t right_extreme_x = 0;
+        // Left edge of the whole subtree, relative to centre of the node.
+        int32_t leftmost = 0;
+        // Where the left and right contour go on below a leaf, and how far from the leaf; set by the
+        // ancestor whose children have deeper subtrees next to the leaf.
+        index_t left_thread = TreeDocument::no_node;
+        index_t right_thread = TreeDocument::no_node;
+        int32_t left_thread_x = 0;
+        int32_t right_thread_x = 0;
+        // Dirty children not laid out yet during an update.
+        uint32_t dirty_children = 0;
+        bool dirty = false;
+        bool placed = false;
+        // Width changed since the node was placed.
+        bool resized = false;
+    };
+
+    // Next node of a contour and its distance from the current one; no_node at the bottom.
+    struct ContourStep
+    {
+        index_t node;
+        int32_t x;
+    };
+
+    NodeLayout &get_layout(index_t node);
+    void mark_dirty(index_t node);
+    ContourStep get_next_left(index_t node) const;
+    ContourStep get_next_right(index_t node) const;
+    void clear_threads(const NodeLayout &layout);
+    void layout_subtree(index_t node);
+    void place(index_t root);
+
+    const TreeDocument &document;
+    Settings settings;
+    std::vector<NodeLayout> layouts;
+    std::vector<index_t> dirty_nodes;
+    std::vector<index_t> changed;
+    int32_t root_centre_x = 0;
+
+    // Scratch space reused between updates.
+    std::vector<int32_t> child_positions;
+    std::vector<index_t> pending;
+};
+
+
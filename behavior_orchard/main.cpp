@@ -23,6 +23,20 @@
 */
 
 #include "BehaviorOrchard.hpp"
+#include "batch/BatchCommand.hpp"
 #include <wx/app.h>
 
-IMPLEMENT_APP(BehaviorOrchard)
\ No newline at end of file
+#include <cstring>
+#include <iostream>
+
+IMPLEMENT_APP_NO_MAIN(BehaviorOrchard)
+
+int main(int argc, char **argv)
+{
+    // Batch mode runs on build machines without a display, so it must not touch wxWidgets at all.
+    if(argc > 1 && std::strcmp(argv[1], "batch") == 0)
+    {
+        return run_batch_command({argv + 2, argv + argc}, std::cout, std::cerr);
+    }
+    return wxEntry(argc, argv);
+}
@@ -0,0 +1,200 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "BehaviorTreeBridge.hpp"
+
+#include "composite/BehaviorSelector.hpp"
+#include "composite/BehaviorSequence.hpp"
+#include "decorator/DecoratorInvert.hpp"
+#include "decorator/DecoratorLink.hpp"
+#include "decorator/DecoratorLoop.hpp"
+#include "decorator/DecoratorMaxNTries.hpp"
+#include "primitive/BehaviorAction.hpp"
+#include "primitive/BehaviorCondition.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+    using index_t = TreeDocument::index_t;
+
+    template<typename Callback>
+    const Callback &find_callback(const std::unordered_map<std::string, Callback> &callbacks, std::string_view label)
+    {
+        const auto callback = callbacks.find(std::string{label});
+        if(callback == callbacks.end())
+        {
+            throw std::invalid_argument("build_behavior_tree: no callback for '" + std::string{label} + "'");
+        }
+        return callback->second;
+    }
+
+    NodeKind get_kind(IBehavior::ptr node)
+    {
+        if(dynamic_cast<BehaviorSelector *>(node) != nullptr)
+        {
+            return NodeKind::selector;
+        }
+        if(dynamic_cast<BehaviorSequence *>(node) != nullptr)
+        {
+            return NodeKind::sequence;
+        }
+        if(dynamic_cast<BehaviorAction *>(node) != nullptr)
+        {
+            return NodeKind::action;
+        }
+        if(dynamic_cast<BehaviorCondition *>(node) != nullptr)
+        {
+            return NodeKind::condition;
+        }
+        if(dynamic_cast<DecoratorLink *>(node) != nullptr)
+        {
+            return NodeKind::link;
+        }
+        if(dynamic_cast<DecoratorInvert *>(node) != nullptr)
+        {
+            return NodeKind::invert;
+        }
+        if(dynamic_cast<DecoratorLoop *>(node) != nullptr)
+        {
+            return NodeKind::loop;
+        }
+        if(dynamic_cast<DecoratorMaxNTries *>(node) != nullptr)
+        {
+            return NodeKind::max_n_tries;
+        }
+        throw std::invalid_argument("import_behavior_tree: unsupported node type");
+    }
+}
+
+std::vector<IBehavior::id_t> build_behavior_tree(const TreeDocument &document, const BehaviorCallbacks &callbacks,
+                                                 BehaviorTree &tree)
+{
+    std::vector<IBehavior::id_t> built(document.get_capacity(), TreeDocument::no_id);
+    if(document.is_empty())
+    {
+        return built;
+    }
+
+    IBehavior::id_t next_id = 0;
+    std::vector<index_t> pending{document.get_root()};
+    while(!pending.empty())
+    {
+        const auto node = pending.back();
+        pending.pop_back();
+
+        const auto parent = document.get_parent(node);
+        const auto label = document.get_label(node);
+        if(parent != TreeDocument::no_node && !tree.set_at_id(built[parent]))
+        {
+            throw std::invalid_argument("build_behavior_tree: BehaviorTree has no parent for '" + std::string{label} +
+                                        "'");
+        }
+
+        const auto parameter = document.get_parameter(node);
+        bool added = false;
+        switch(document.get_kind(node))
+        {
+            case NodeKind::selector:
+                added = tree.add_selector();
+                break;
+            case NodeKind::sequence:
+                added = tree.add_sequence();
+                break;
+            case NodeKind::action:
+                added = tree.add_action(find_callback(callbacks.actions, label));
+                break;
+            case NodeKind::condition:
+                added = tree.add_condition(find_callback(callbacks.conditions, label));
+                break;
+            case NodeKind::link:
+            {
+                const auto target = document.find_by_id(parameter);
+                if(target == TreeDocument::no_node || built[target] == TreeDocument::no_id)
+                {
+                    throw std::invalid_argument("build_behavior_tree: link '" + std::string{label} +
+                                                "' has to point to a node placed before it");
+                }
+                added = tree.add_link(tree.get_node(built[target]));
+                break;
+            }
+            case NodeKind::invert:
+                added = tree.add_invert();
+                break;
+            case NodeKind::loop:
+                added = tree.add_loop(parameter);
+                break;
+            case NodeKind::max_n_tries:
+                added = tree.add_max_n_tries(parameter);
+                break;
+        }
+        if(!added)
+        {
+            throw std::invalid_argument("build_behavior_tree: BehaviorTree rejected '" + std::string{label} + "'");
+        }
+        built[node] = next_id++;
+
+        // Pushed in reverse, so children are popped - and numbered - left to right.
+        for(auto child = document.get_last_child(node); child != TreeDocument::no_node;
+            child = document.get_previous_sibling(child))
+        {
+            pending.push_back(child);
+        }
+    }
+    return built;
+}
+
+void import_behavior_tree(IBehavior::ptr root, TreeDocument &document)
+{
+    if(!document.is_empty())
+    {
+        throw std::logic_error("import_behavior_tree: document is not empty");
+    }
+    if(root == nullptr)
+    {
+        return;
+    }
+
+    std::vector<std::pair<IBehavior::ptr, index_t>> pending{{root, TreeDocument::no_node}};
+    while(!pending.empty())
+    {
+        const auto [behavior, parent] = pending.back();
+        pending.pop_back();
+
+        const auto kind = get_kind(behavior);
+        const auto label = std::string{get_node_kind_name(kind)} + " " + std::to_string(behavior->get_id());
+        const auto node = document.add_node(parent, kind, label, get_default_parameter(kind));
+        if(kind == NodeKind::link)
+        {
+            // Linked node belongs to whatever tree it came from; it is not copied into the document.
+            continue;
+        }
+        const auto children = behavior->get_children_number();
+        for(auto child = children; child > 0; --child)
+        {
+            pending.emplace_back(behavior->get_child(child - 1), node);
+        }
+    }
+}
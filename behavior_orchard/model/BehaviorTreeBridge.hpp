@@ -0,0 +1,55 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include "TreeDocument.hpp"
+
+#include "BehaviorTree.hpp"
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Callbacks for primitives, bound to document nodes by label.
+struct BehaviorCallbacks
+{
+    std::unordered_map<std::string, std::function<BehaviorState()>> actions;
+    std::unordered_map<std::string, std::function<bool()>> conditions;
+};
+
+// Builds the document into an empty BehaviorTree, adding nodes in pre-order - the order in which
+// BehaviorTree assigns its IDs. Returns the BehaviorTree ID for every document index (no_id for
+// unused indices). Throws std::invalid_argument when a primitive has no callback or a link points
+// to a node which is not built before it.
+std::vector<IBehavior::id_t> build_behavior_tree(const TreeDocument &document, const BehaviorCallbacks &callbacks,
+                                                 BehaviorTree &tree);
+
+// Reads the structure of a built tree into an empty document. Labels are generated from kind and
+// BehaviorTree ID, since the library does not keep names for its nodes; loop and try counts are not
+// exposed by the decorators either, so every node gets the default parameter of its kind.
+void import_behavior_tree(IBehavior::ptr root, TreeDocument &document);
+
+
@@ -0,0 +1,301 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#include "EditHistory.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+    using index_t = TreeDocument::index_t;
+    using id_t = TreeDocument::id_t;
+
+    index_t find(const TreeDocument &document, id_t id)
+    {
+        const auto node = document.find_by_id(id);
+        if(node == TreeDocument::no_node)
+        {
+            throw std::logic_error("EditHistory: document does not match the history, node " + std::to_string(id) +
+                                   " is missing");
+        }
+        return node;
+    }
+
+    void check(const TreeDocument &document, index_t node)
+    {
+        if(!document.contains(node))
+        {
+            throw std::out_of_range("EditHistory: no node at index " + std::to_string(node));
+        }
+    }
+
+    id_t get_id_or_none(const TreeDocument &document, index_t node)
+    {
+        return node == TreeDocument::no_node ? TreeDocument::no_id : document.get_id(node);
+    }
+}
+
+void EditChange::clear()
+{
+    added.clear();
+    removed.clear();
+    modified = TreeDocument::no_node;
+    parent = TreeDocument::no_node;
+    focus = TreeDocument::no_node;
+}
+
+size_t EditHistory::Operation::get_memory_usage() const
+{
+    // Short labels live inside the string object itself.
+    const auto label_bytes = labels.capacity() > std::string{}.capacity() ? labels.capacity() + 1 : 0;
+    return sizeof(Operation) + label_bytes + nodes.capacity() * sizeof(SubtreeNode);
+}
+
+EditHistory::EditHistory(size_t memory_budget_bytes):
+        memory_budget{memory_budget_bytes},
+        memory_usage{0}
+{
+}
+
+TreeDocument::index_t EditHistory::add_node(TreeDocument &document, index_t parent, NodeKind kind,
+                                            std::string_view label, uint32_t parameter)
+{
+    const auto node = document.add_node(parent, kind, label, parameter);
+    if(node == TreeDocument::no_node)
+    {
+        return node;
+    }
+    clear_redo();
+    push_undo(Operation{Operation::Type::remove, document.get_id(node), TreeDocument::no_id, TreeDocument::no_id, 0, {},
+                        {}});
+    return node;
+}
+
+void EditHistory::remove_subtree(TreeDocument &document, index_t node, std::vector<index_t> &removed)
+{
+    check(document, node);
+    auto inverse = capture_subtree(document, node);
+    document.remove_subtree(node, removed);
+    clear_redo();
+    push_undo(std::move(inverse));
+}
+
+void EditHistory::modify_node(TreeDocument &document, index_t node, std::string_view label, uint32_t parameter)
+{
+    check(document, node);
+    Operation inverse{Operation::Type::modify, document.get_id(node), TreeDocument::no_id, TreeDocument::no_id,
+                      document.get_parameter(node), std::string{document.get_label(node)}, {}};
+    document.set_label(node, label);
+    document.set_parameter(node, parameter);
+    clear_redo();
+    push_undo(std::move(inverse));
+}
+
+bool EditHistory::undo(TreeDocument &document, EditChange &change)
+{
+    change.clear();
+    if(undo_steps.empty())
+    {
+        return false;
+    }
+    auto operation = std::move(undo_steps.back());
+    undo_steps.pop_back();
+    memory_usage -= operation.get_memory_usage();
+
+    auto inverse = apply(document, std::move(operation), change);
+    memory_usage += inverse.get_memory_usage();
+    redo_steps.push_back(std::move(inverse));
+    trim(true);
+    return true;
+}
+
+bool EditHistory::redo(TreeDocument &document, EditChange &change)
+{
+    change.clear();
+    if(redo_steps.empty())
+    {
+        return false;
+    }
+    auto operation = std::move(redo_steps.back());
+    redo_steps.pop_back();
+    memory_usage -= operation.get_memory_usage();
+
+    push_undo(apply(document, std::move(operation), change));
+    return true;
+}
+
+void EditHistory::clear()
+{
+    undo_steps.clear();
+    redo_steps.clear();
+    memory_usage = 0;
+}
+
+size_t EditHistory::get_undo_count() const
+{
+    return undo_steps.size();
+}
+
+size_t EditHistory::get_redo_count() const
+{
+    return redo_steps.size();
+}
+
+size_t EditHistory::get_memory_usage() const
+{
+    return memory_usage;
+}
+
+size_t EditHistory::get_memory_budget() const
+{
+    return memory_budget;
+}
+
+EditHistory::Operation EditHistory::apply(TreeDocument &document, Operation &&operation, EditChange &change)
+{
+    switch(operation.type)
+    {
+        case Operation::Type::insert:
+        {
+            const auto parent = operation.parent == TreeDocument::no_id ? TreeDocument::no_node
+                                                                        : find(document, operation.parent);
+            const auto before = operation.before == TreeDocument::no_id ? TreeDocument::no_node
+                                                                        : find(document, operation.before);
+            // Pre-order with child counts: the open ancestors and how many children each still expects.
+            std::vector<std::pair<index_t, uint32_t>> path;
+            const std::string_view labels{operation.labels};
+            size_t label_offset = 0;
+            for(const auto &record: operation.nodes)
+            {
+                const auto label = labels.substr(label_offset, record.label_length);
+                label_offset += record.label_length;
+                index_t node;
+                if(path.empty())
+                {
+                    node = document.insert_node(parent, before, record.kind, label, record.parameter, record.id);
+                }
+                else
+                {
+                    node = document.add_node(path.back().first, record.kind, label, record.parameter, record.id);
+                    if(--path.back().second == 0)
+                    {
+                        path.pop_back();
+                    }
+                }
+                change.added.push_back(node);
+                if(record.child_count > 0)
+                {
+                    path.emplace_back(node, record.child_count);
+                }
+            }
+            change.parent = parent;
+            change.focus = change.added.front();
+            return Operation{Operation::Type::remove, operation.node, TreeDocument::no_id, TreeDocument::no_id, 0, {},
+                             {}};
+        }
+        case Operation::Type::remove:
+        {
+            const auto node = find(document, operation.node);
+            auto inverse = capture_subtree(document, node);
+            change.parent = document.get_parent(node);
+            change.focus = change.parent;
+            document.remove_subtree(node, change.removed);
+            return inverse;
+        }
+        case Operation::Type::modify:
+        {
+            const auto node = find(document, operation.node);
+            Operation inverse{Operation::Type::modify, operation.node, TreeDocument::no_id, TreeDocument::no_id,
+                              document.get_parameter(node), std::string{document.get_label(node)}, {}};
+            document.set_label(node, operation.labels);
+            document.set_parameter(node, operation.parameter);
+            change.modified = node;
+            change.focus = node;
+            return inverse;
+        }
+    }
+    throw std::logic_error("EditHistory: unknown operation");
+}
+
+EditHistory::Operation EditHistory::capture_subtree(const TreeDocument &document, index_t node)
+{
+    Operation operation{Operation::Type::insert, document.get_id(node),
+                        get_id_or_none(document, document.get_parent(node)),
+                        get_id_or_none(document, document.get_next_sibling(node)), 0, {}, {}};
+    std::vector<index_t> pending{node};
+    while(!pending.empty())
+    {
+        const auto current = pending.back();
+        pending.pop_back();
+        const auto label = document.get_label(current);
+        operation.nodes.push_back(SubtreeNode{document.get_kind(current), document.get_id(current),
+                                              document.get_parameter(current), static_cast<uint32_t>(label.size()),
+                                              document.get_child_count(current)});
+        operation.labels.append(label);
+        for(auto child = document.get_last_child(current); child != TreeDocument::no_node;
+            child = document.get_previous_sibling(child))
+        {
+            pending.push_back(child);
+        }
+    }
+    // Kept for as long as the step is, so no slack.
+    operation.nodes.shrink_to_fit();
+    operation.labels.shrink_to_fit();
+    return operation;
+}
+
+void EditHistory::push_undo(Operation &&operation)
+{
+    memory_usage += operation.get_memory_usage();
+    undo_steps.push_back(std::move(operation));
+    trim(false);
+}
+
+void EditHistory::clear_redo()
+{
+    for(const auto &operation: redo_steps)
+    {
+        memory_usage -= operation.get_memory_usage();
+    }
+    redo_steps.clear();
+}
+
+void EditHistory::trim(bool newest_is_redo)
+{
+    // Oldest undo steps go first, then the redo steps furthest away; the newest step stays.
+    const size_t undo_kept = newest_is_redo ? 0 : 1;
+    const size_t redo_kept = newest_is_redo ? 1 : 0;
+    while(memory_usage > memory_budget)
+    {
+        auto &steps = undo_steps.size() > undo_kept ? undo_steps : redo_steps;
+        if(&steps == &redo_steps && redo_steps.size() <= redo_kept)
+        {
+            return;
+        }
+        memory_usage -= steps.front().get_memory_usage();
+        steps.pop_front();
+    }
+}
@@ -0,0 +1,134 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "TreeDocument.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// What an undo or redo did to the document, for the views to follow.
+struct EditChange
+{
+    // Parents before children.
+    std::vector<TreeDocument::index_t> added;
+    std::vector<TreeDocument::index_t> removed;
+    // Node whose label or parameter changed.
+    TreeDocument::index_t modified = TreeDocument::no_node;
+    // Node whose list of children changed.
+    TreeDocument::index_t parent = TreeDocument::no_node;
+    // Node the edit was about, to make current.
+    TreeDocument::index_t focus = TreeDocument::no_node;
+
+    void clear();
+};
+
+// Undo / redo of document edits, kept as compact inverse operations instead of snapshots: undoing an
+// added node only needs its ID, undoing a modification the old label and parameter, and undoing a
+// removal the removed subtree - so a step costs memory and time in proportion to what the edit
+// touched, whatever the size of the tree. Operations refer to nodes by ID, which (unlike indices)
+// survive removing and putting nodes back.
+// Undo and redo steps share one memory budget; once it is exceeded the oldest undo steps are
+// forgotten. The newest step is kept even on its own over the budget, so the last edit can always be
+// undone.
+class EditHistory
+{
+public:
+    explicit EditHistory(size_t memory_budget_bytes = size_t{8} << 20);
+
+    // Edits go through the history, which applies them to the document and records how to revert them.
+    // Each forgets the redo steps. Same contracts as the TreeDocument functions they call.
+    TreeDocument::index_t add_node(TreeDocument &document, TreeDocument::index_t parent, NodeKind kind,
+                                   std::string_view label, uint32_t parameter);
+    void remove_subtree(TreeDocument &document, TreeDocument::index_t node,
+                        std::vector<TreeDocument::index_t> &removed);
+    void modify_node(TreeDocument &document, TreeDocument::index_t node, std::string_view label, uint32_t parameter);
+
+    // Both return false and leave the change empty when there is nothing to undo / redo. The document
+    // has to be in the state the history left it in.
+    bool undo(TreeDocument &document, EditChange &change);
+    bool redo(TreeDocument &document, EditChange &change);
+    // For a document replaced as a whole (opened, cleared).
+    void clear();
+
+    size_t get_undo_count() const;
+    size_t get_redo_count() const;
+    size_t get_memory_usage() const;
+    size_t get_memory_budget() const;
+
+private:
+    struct SubtreeNode
+    {
+        NodeKind kind;
+        TreeDocument::id_t id;
+        uint32_t parameter;
+        uint32_t label_length;
+        uint32_t child_count;
+    };
+
+    struct Operation
+    {
+        enum class Type: uint8_t
+        {
+            insert,
+            remove,
+            modify
+        };
+
+        Type type;
+        // Root of the subtree to insert, node to remove or to modify.
+        TreeDocument::id_t node;
+        // Insert: where the subtree goes - before no_id means as the last child.
+        TreeDocument::id_t parent;
+        TreeDocument::id_t before;
+        // Modify: the parameter to set.
+        uint32_t parameter;
+        // Modify: the label to set; insert: labels of the subtree back to back, in pre-order.
+        std::string labels;
+        // Insert: the subtree in pre-order.
+        std::vector<SubtreeNode> nodes;
+
+        size_t get_memory_usage() const;
+    };
+
+    // Applies the operation and returns its inverse.
+    static Operation apply(TreeDocument &document, Operation &&operation, EditChange &change);
+    static Operation capture_subtree(const TreeDocument &document, TreeDocument::index_t node);
+    void push_undo(Operation &&operation);
+    void clear_redo();
+    void trim(bool newest_is_redo);
+
+    size_t memory_budget;
+    size_t memory_usage;
+    std::deque<Operation> undo_steps;
+    std::deque<Operation> redo_steps;
+};
+
+
@@ -0,0 +1,69 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "LabelPool.hpp"
+
+#include <stdexcept>
+
+LabelPool::Handle LabelPool::add(std::string_view label)
+{
+    if(buffer.size() + label.size() > UINT32_MAX)
+    {
+        throw std::length_error("LabelPool: labels exceed 4 GiB");
+    }
+    const Handle handle{static_cast<uint32_t>(buffer.size()), static_cast<uint32_t>(label.size())};
+    buffer.append(label);
+    return handle;
+}
+
+void LabelPool::release(Handle handle)
+{
+    garbage += handle.length;
+}
+
+std::string_view LabelPool::get(Handle handle) const
+{
+    return std::string_view{buffer}.substr(handle.offset, handle.length);
+}
+
+void LabelPool::clear()
+{
+    buffer.clear();
+    garbage = 0;
+}
+
+void LabelPool::reserve(size_t size)
+{
+    buffer.reserve(size);
+}
+
+bool LabelPool::needs_compaction() const
+{
+    return garbage > 4096 && garbage * 2 > buffer.size();
+}
+
+size_t LabelPool::get_memory_usage() const
+{
+    return buffer.capacity();
+}
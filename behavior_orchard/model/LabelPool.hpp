@@ -0,0 +1,74 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Stores node labels back to back in one buffer, so a node holds two integers instead of its own
+// heap-allocated string. Replaced labels leave garbage behind, which is compacted away once it
+// outweighs the live text.
+class LabelPool
+{
+public:
+    struct Handle
+    {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+    };
+
+    Handle add(std::string_view label);
+    void release(Handle handle);
+    std::string_view get(Handle handle) const;
+    void clear();
+    void reserve(size_t size);
+
+    bool needs_compaction() const;
+    // Copies live labels to a fresh buffer; for_each_handle has to call its argument with a reference
+    // to every live handle, which gets rewritten in place.
+    template<typename ForEachHandle>
+    void compact(ForEachHandle for_each_handle)
+    {
+        std::string compacted;
+        compacted.reserve(buffer.size() - garbage);
+        for_each_handle([&](Handle &handle)
+                        {
+                            const auto offset = static_cast<uint32_t>(compacted.size());
+                            compacted.append(buffer, handle.offset, handle.length);
+                            handle.offset = offset;
+                        });
+        buffer = std::move(compacted);
+        garbage = 0;
+    }
+
+    size_t get_memory_usage() const;
+
+private:
+    std::string buffer;
+    size_t garbage = 0;
+};
+
+
@@ -0,0 +1,159 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#include "LatencyHistogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+uint64_t LatencyHistogram::get_bucket_low(uint32_t bucket)
+{
+    if(bucket < sub_bucket_count)
+    {
+        return bucket;
+    }
+    const auto exponent = bucket / sub_bucket_count + sub_bucket_bits - 1;
+    const auto sub_bucket = bucket % sub_bucket_count;
+    return uint64_t{sub_bucket_count + sub_bucket} << (exponent - sub_bucket_bits);
+}
+
+uint64_t LatencyHistogram::get_bucket_high(uint32_t bucket)
+{
+    if(bucket < sub_bucket_count)
+    {
+        return bucket;
+    }
+    if(bucket == bucket_count - 1)
+    {
+        return UINT64_MAX;
+    }
+    return get_bucket_low(bucket + 1) - 1;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    for(uint32_t bucket = 0; bucket < bucket_count; ++bucket)
+    {
+        counts[bucket] += other.counts[bucket];
+    }
+    count += other.count;
+    sum += other.sum;
+    minimum = std::min(minimum, other.minimum);
+    maximum = std::max(maximum, other.maximum);
+}
+
+void LatencyHistogram::clear()
+{
+    *this = LatencyHistogram{};
+}
+
+void LatencyHistogram::add_to_bucket(uint32_t bucket, uint64_t bucket_count_to_add)
+{
+    counts.at(bucket) += bucket_count_to_add;
+    count += bucket_count_to_add;
+}
+
+void LatencyHistogram::set_totals(uint64_t total_nanoseconds, uint64_t minimum_nanoseconds,
+                                  uint64_t maximum_nanoseconds)
+{
+    sum = total_nanoseconds;
+    minimum = minimum_nanoseconds;
+    maximum = maximum_nanoseconds;
+}
+
+uint64_t LatencyHistogram::get_count() const
+{
+    return count;
+}
+
+uint64_t LatencyHistogram::get_bucket_count(uint32_t bucket) const
+{
+    return counts.at(bucket);
+}
+
+uint64_t LatencyHistogram::get_sum() const
+{
+    return sum;
+}
+
+uint64_t LatencyHistogram::get_min() const
+{
+    return count > 0 ? minimum : 0;
+}
+
+uint64_t LatencyHistogram::get_max() const
+{
+    return maximum;
+}
+
+double LatencyHistogram::get_mean() const
+{
+    return count > 0 ? static_cast<double>(sum) / static_cast<double>(count) : 0.0;
+}
+
+uint64_t LatencyHistogram::get_percentile(double fraction) const
+{
+    if(count == 0)
+    {
+        return 0;
+    }
+    const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) *
+                                                                            static_cast<double>(count))));
+    uint64_t seen = 0;
+    for(uint32_t bucket = 0; bucket < bucket_count; ++bucket)
+    {
+        seen += counts[bucket];
+        if(seen >= rank)
+        {
+            return std::max(get_min(), std::min(get_bucket_high(bucket), maximum));
+        }
+    }
+    return maximum;
+}
+
+std::string format_latency(uint64_t nanoseconds)
+{
+    // Thresholds leave room for rounding, so 999999 ns reads "1 ms" and not "1e+03 us".
+    const auto value = static_cast<double>(nanoseconds);
+    char text[32];
+    if(nanoseconds < 1000)
+    {
+        std::snprintf(text, sizeof(text), "%u ns", static_cast<unsigned>(nanoseconds));
+    }
+    else if(nanoseconds < 999500)
+    {
+        std::snprintf(text, sizeof(text), "%.3g us", value / 1e3);
+    }
+    else if(nanoseconds < 999500000)
+    {
+        std::snprintf(text, sizeof(text), "%.3g ms", value / 1e6);
+    }
+    else
+    {
+        std::snprintf(text, sizeof(text), "%.3g s", value / 1e9);
+    }
+    return text;
+}
@@ -0,0 +1,123 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Latency distribution in nanoseconds, in HDR-style logarithmic buckets: values below 16 have a
+// bucket each, every power of two above is split into 16 equal sub-buckets. Any recorded value is
+// known to within 1/16 of itself, the buckets are a fixed array, and recording is a few shifts and an
+// increment - nothing allocates.
+class LatencyHistogram
+{
+public:
+    static constexpr uint32_t sub_bucket_bits = 4;
+    static constexpr uint32_t sub_bucket_count = 1u << sub_bucket_bits;
+    // Values from 2^37 ns (over two minutes) on share the last bucket.
+    static constexpr uint32_t max_exponent = 36;
+    static constexpr uint32_t bucket_count = (max_exponent - sub_bucket_bits + 2) * sub_bucket_count;
+
+    void record(uint64_t nanoseconds) noexcept
+    {
+        ++counts[get_bucket(nanoseconds)];
+        ++count;
+        sum += nanoseconds;
+        minimum = nanoseconds < minimum ? nanoseconds : minimum;
+        maximum = nanoseconds > maximum ? nanoseconds : maximum;
+    }
+
+    static uint32_t get_bucket(uint64_t nanoseconds) noexcept
+    {
+        if(nanoseconds < sub_bucket_count)
+        {
+            return static_cast<uint32_t>(nanoseconds);
+        }
+        const auto exponent = get_exponent(nanoseconds);
+        if(exponent > max_exponent)
+        {
+            return bucket_count - 1;
+        }
+        const auto sub_bucket = static_cast<uint32_t>(nanoseconds >> (exponent - sub_bucket_bits)) & (sub_bucket_count - 1);
+        return (exponent - sub_bucket_bits + 1) * sub_bucket_count + sub_bucket;
+    }
+
+    // Range of values the bucket stands for, both ends included.
+    static uint64_t get_bucket_low(uint32_t bucket);
+    static uint64_t get_bucket_high(uint32_t bucket);
+
+    void merge(const LatencyHistogram &other);
+    void clear();
+    // For loaders: buckets are restored one by one, then the exact totals.
+    void add_to_bucket(uint32_t bucket, uint64_t bucket_count_to_add);
+    void set_totals(uint64_t total_nanoseconds, uint64_t minimum_nanoseconds, uint64_t maximum_nanoseconds);
+
+    uint64_t get_count() const;
+    uint64_t get_bucket_count(uint32_t bucket) const;
+    uint64_t get_sum() const;
+    // Zero while empty.
+    uint64_t get_min() const;
+    uint64_t get_max() const;
+    double get_mean() const;
+    // Highest value of the bucket holding the given fraction (0.5 for the median) of the recorded
+    // values, never above the maximum.
+    uint64_t get_percentile(double fraction) const;
+
+private:
+    static uint32_t get_exponent(uint64_t value) noexcept
+    {
+#if defined(__GNUC__)
+        return 63u - static_cast<uint32_t>(__builtin_clzll(value));
+#else
+        uint32_t exponent = 0;
+        while(value >>= 1)
+        {
+            ++exponent;
+        }
+        return exponent;
+#endif
+    }
+
+    std::array<uint64_t, bucket_count> counts{};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t minimum = UINT64_MAX;
+    uint64_t maximum = 0;
+};
+
+// Histogram of one node, by node ID.
+struct NodeLatency
+{
+    uint32_t node;
+    LatencyHistogram histogram;
+};
+
+// Three significant digits in the most fitting unit: "850 ns", "12.3 us", "4.56 ms".
+std::string format_latency(uint64_t nanoseconds);
+
+
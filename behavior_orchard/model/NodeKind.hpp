@@ -0,0 +1,90 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Kinds of nodes the bt library can build - one per class behind BehaviorTree::add_*.
+enum class NodeKind: uint8_t
+{
+    selector,
+    sequence,
+    action,
+    condition,
+    link,
+    invert,
+    loop,
+    max_n_tries
+};
+
+constexpr size_t node_kind_count = 8;
+
+inline const char *get_node_kind_name(NodeKind kind)
+{
+    switch(kind)
+    {
+        case NodeKind::selector:
+            return "Selector";
+        case NodeKind::sequence:
+            return "Sequence";
+        case NodeKind::action:
+            return "Action";
+        case NodeKind::condition:
+            return "Condition";
+        case NodeKind::link:
+            return "Link";
+        case NodeKind::invert:
+            return "Invert";
+        case NodeKind::loop:
+            return "Loop";
+        case NodeKind::max_n_tries:
+            return "MaxNTries";
+    }
+    return "Unknown";
+}
+
+// Composites take any number of children, decorators wrap exactly one, primitives are leaves.
+// DecoratorLink refers to another node instead of owning a child, so in the editor it is a leaf too.
+inline size_t get_max_children(NodeKind kind)
+{
+    switch(kind)
+    {
+        case NodeKind::selector:
+        case NodeKind::sequence:
+            return SIZE_MAX;
+        case NodeKind::invert:
+        case NodeKind::loop:
+        case NodeKind::max_n_tries:
+            return 1;
+        case NodeKind::action:
+        case NodeKind::condition:
+        case NodeKind::link:
+            return 0;
+    }
+    return 0;
+}
+
+
@@ -0,0 +1,298 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "NodeSearchIndex.hpp"
+
+#include <algorithm>
+#include <charconv>
+
+namespace
+{
+    using index_t = TreeDocument::index_t;
+
+    constexpr size_t trigram_size = 3;
+    // Below this many stale entries rebuilding is not worth it, whatever their share.
+    constexpr size_t minimal_stale_entries = 4096;
+
+    unsigned char to_lower(char character)
+    {
+        const auto byte = static_cast<unsigned char>(character);
+        return byte >= 'A' && byte <= 'Z' ? static_cast<unsigned char>(byte - 'A' + 'a') : byte;
+    }
+
+    // Distinct trigrams of the lowered text, sorted.
+    void get_trigrams(std::string_view text, std::vector<uint32_t> &trigrams)
+    {
+        trigrams.clear();
+        for(size_t start = 0; start + trigram_size <= text.size(); ++start)
+        {
+            trigrams.push_back(uint32_t{to_lower(text[start])} << 16 | uint32_t{to_lower(text[start + 1])} << 8 |
+                               uint32_t{to_lower(text[start + 2])});
+        }
+        std::sort(trigrams.begin(), trigrams.end());
+        trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    }
+
+    bool contains_text(std::string_view label, std::string_view text)
+    {
+        return std::search(label.begin(), label.end(), text.begin(), text.end(),
+                           [](char first, char second) { return to_lower(first) == to_lower(second); }) != label.end();
+    }
+
+    bool parse_id(std::string_view text, TreeDocument::id_t &id)
+    {
+        if(text.size() < 2 || text.front() != '#')
+        {
+            return false;
+        }
+        const auto end = text.data() + text.size();
+        const auto [parsed_end, error] = std::from_chars(text.data() + 1, end, id);
+        return error == std::errc{} && parsed_end == end;
+    }
+}
+
+NodeSearchIndex::NodeSearchIndex(const TreeDocument &tree):
+        document{tree}
+{
+}
+
+void NodeSearchIndex::update(index_t node)
+{
+    if(node >= generations.size())
+    {
+        generations.resize(document.get_capacity());
+        entry_counts.resize(document.get_capacity());
+    }
+    retire(node);
+    add_entries(node);
+    compact_if_needed();
+}
+
+void NodeSearchIndex::forget(index_t node)
+{
+    if(node < generations.size())
+    {
+        retire(node);
+        compact_if_needed();
+    }
+}
+
+void NodeSearchIndex::clear()
+{
+    postings.clear();
+    generations.clear();
+    entry_counts.clear();
+    live_entries = 0;
+    stale_entries = 0;
+}
+
+void NodeSearchIndex::rebuild()
+{
+    clear();
+    generations.resize(document.get_capacity());
+    entry_counts.resize(document.get_capacity());
+    for(index_t node = 0; node < document.get_capacity(); ++node)
+    {
+        if(document.contains(node))
+        {
+            add_entries(node);
+        }
+    }
+}
+
+NodeMatch NodeSearchIndex::search(const NodeQuery &query, std::vector<index_t> &results) const
+{
+    results.clear();
+    if(query.max_results == 0)
+    {
+        return NodeMatch::none;
+    }
+
+    TreeDocument::id_t id;
+    if(parse_id(query.text, id))
+    {
+        const auto node = document.find_by_id(id);
+        if(node != TreeDocument::no_node && query.kinds[static_cast<size_t>(document.get_kind(node))])
+        {
+            results.push_back(node);
+            return NodeMatch::id;
+        }
+        return NodeMatch::none;
+    }
+
+    if(query.text.size() < trigram_size)
+    {
+        scan(query, results);
+    }
+    else
+    {
+        // Every match has all trigrams of the text, so the shortest list holds them all.
+        get_trigrams(query.text, trigrams);
+        const std::vector<Entry> *rarest = nullptr;
+        for(const auto trigram: trigrams)
+        {
+            const auto found = postings.find(trigram);
+            if(found == postings.end())
+            {
+                rarest = nullptr;
+                break;
+            }
+            if(rarest == nullptr || found->second.size() < rarest->size())
+            {
+                rarest = &found->second;
+            }
+        }
+        if(rarest != nullptr)
+        {
+            for(const auto &entry: *rarest)
+            {
+                if(is_live(entry) && query.kinds[static_cast<size_t>(document.get_kind(entry.node))] &&
+                   contains_text(document.get_label(entry.node), query.text))
+                {
+                    results.push_back(entry.node);
+                }
+            }
+        }
+    }
+
+    if(results.empty())
+    {
+        if(query.text.size() >= trigram_size)
+        {
+            find_similar(query, trigrams, results);
+        }
+        return results.empty() ? NodeMatch::none : NodeMatch::similar;
+    }
+    std::sort(results.begin(), results.end(),
+              [this](index_t first, index_t second) { return document.get_id(first) < document.get_id(second); });
+    results.resize(std::min(results.size(), query.max_results));
+    return NodeMatch::substring;
+}
+
+size_t NodeSearchIndex::get_memory_usage() const
+{
+    // Each list also costs a hash node with its key and the bucket pointing at it.
+    auto usage = postings.bucket_count() * sizeof(void *) +
+                 postings.size() * (sizeof(void *) + sizeof(uint32_t) + sizeof(std::vector<Entry>));
+    for(const auto &posting: postings)
+    {
+        usage += posting.second.capacity() * sizeof(Entry);
+    }
+    return usage + generations.capacity() * sizeof(uint32_t) + entry_counts.capacity() * sizeof(uint32_t);
+}
+
+void NodeSearchIndex::add_entries(index_t node)
+{
+    get_trigrams(document.get_label(node), trigrams);
+    for(const auto trigram: trigrams)
+    {
+        postings[trigram].push_back({node, generations[node]});
+    }
+    entry_counts[node] = static_cast<uint32_t>(trigrams.size());
+    live_entries += trigrams.size();
+}
+
+void NodeSearchIndex::retire(index_t node)
+{
+    ++generations[node];
+    stale_entries += entry_counts[node];
+    live_entries -= entry_counts[node];
+    entry_counts[node] = 0;
+}
+
+void NodeSearchIndex::compact_if_needed()
+{
+    if(stale_entries > minimal_stale_entries && stale_entries > live_entries)
+    {
+        rebuild();
+    }
+}
+
+bool NodeSearchIndex::is_live(const Entry &entry) const
+{
+    return entry.generation == generations[entry.node];
+}
+
+void NodeSearchIndex::scan(const NodeQuery &query, std::vector<index_t> &results) const
+{
+    for(index_t node = 0; node < document.get_capacity() && results.size() < query.max_results; ++node)
+    {
+        if(document.contains(node) && query.kinds[static_cast<size_t>(document.get_kind(node))] &&
+           contains_text(document.get_label(node), query.text))
+        {
+            results.push_back(node);
+        }
+    }
+}
+
+void NodeSearchIndex::find_similar(const NodeQuery &query, const std::vector<uint32_t> &query_trigrams,
+                                   std::vector<index_t> &results) const
+{
+    // A single trigram is either there or not - nothing to be similar to.
+    if(query_trigrams.size() < 2)
+    {
+        return;
+    }
+    // Counted in a table indexed by node, cleared through the list of nodes it touched.
+    shared_counts.resize(document.get_capacity());
+    touched.clear();
+    for(const auto trigram: query_trigrams)
+    {
+        const auto found = postings.find(trigram);
+        if(found == postings.end())
+        {
+            continue;
+        }
+        for(const auto &entry: found->second)
+        {
+            if(is_live(entry) && shared_counts[entry.node]++ == 0)
+            {
+                touched.push_back(entry.node);
+            }
+        }
+    }
+
+    const auto required = static_cast<uint32_t>((query_trigrams.size() + 1) / 2);
+    std::vector<std::pair<uint32_t, index_t>> candidates;
+    for(const auto node: touched)
+    {
+        if(shared_counts[node] >= required && query.kinds[static_cast<size_t>(document.get_kind(node))])
+        {
+            candidates.emplace_back(shared_counts[node], node);
+        }
+        shared_counts[node] = 0;
+    }
+    std::sort(candidates.begin(), candidates.end(), [this](const auto &first, const auto &second)
+    {
+        if(first.first != second.first)
+        {
+            return first.first > second.first;
+        }
+        return document.get_id(first.second) < document.get_id(second.second);
+    });
+    for(size_t candidate = 0; candidate < std::min(candidates.size(), query.max_results); ++candidate)
+    {
+        results.push_back(candidates[candidate].second);
+    }
+}
@@ -0,0 +1,111 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include "TreeDocument.hpp"
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct NodeQuery
+{
+    // Part of a label (ASCII letters match either case), or "#" and a node ID.
+    std::string_view text;
+    // Kinds to look for, indexed by NodeKind.
+    std::bitset<node_kind_count> kinds = std::bitset<node_kind_count>{}.set();
+    size_t max_results = 100;
+};
+
+enum class NodeMatch
+{
+    none,
+    id,
+    substring,
+    // No label contains the text; results share at least half of its trigrams, best first.
+    similar
+};
+
+// Finds nodes as the user types, without walking the whole tree for each keystroke.
+// IDs are looked up through the document, which maps them to indices directly. Labels go through a
+// trigram index: every distinct three-byte sequence of a lowered label lists the nodes having it, and
+// a query only checks the nodes of its rarest trigram. Texts shorter than a trigram are matched by a
+// scan which stops at the result limit.
+// Edits leave stale entries behind instead of searching long lists for them: each node carries a
+// generation, entries of an older one are skipped, and the lists are rebuilt once stale entries
+// outnumber the live ones.
+class NodeSearchIndex
+{
+public:
+    using index_t = TreeDocument::index_t;
+
+    explicit NodeSearchIndex(const TreeDocument &tree);
+
+    // Node was added or its label changed.
+    void update(index_t node);
+    // Node was removed from the document.
+    void forget(index_t node);
+    void clear();
+    // Indexes everything again - for a document replaced as a whole.
+    void rebuild();
+
+    // Matching nodes (at most max_results) replace the content of results; substring matches come in
+    // order of node ID.
+    NodeMatch search(const NodeQuery &query, std::vector<index_t> &results) const;
+    size_t get_memory_usage() const;
+
+private:
+    struct Entry
+    {
+        index_t node;
+        uint32_t generation;
+    };
+
+    void add_entries(index_t node);
+    // Makes the entries of the node stale.
+    void retire(index_t node);
+    void compact_if_needed();
+    bool is_live(const Entry &entry) const;
+    void scan(const NodeQuery &query, std::vector<index_t> &results) const;
+    void find_similar(const NodeQuery &query, const std::vector<uint32_t> &trigrams,
+                      std::vector<index_t> &results) const;
+
+    const TreeDocument &document;
+    std::unordered_map<uint32_t, std::vector<Entry>> postings;
+    std::vector<uint32_t> generations;
+    // Live entries of each node, to know how many go stale when it changes.
+    std::vector<uint32_t> entry_counts;
+    size_t live_entries = 0;
+    size_t stale_entries = 0;
+    // Scratch space reused between calls.
+    mutable std::vector<uint32_t> trigrams;
+    mutable std::vector<uint32_t> shared_counts;
+    mutable std::vector<index_t> touched;
+};
+
+
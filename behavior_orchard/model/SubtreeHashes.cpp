@@ -0,0 +1,345 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "SubtreeHashes.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace
+{
+    using index_t = TreeDocument::index_t;
+
+    // Finalizer of splitmix64: every input bit affects every output bit, so combining child hashes
+    // one after another keeps their order in the result.
+    uint64_t mix(uint64_t value)
+    {
+        value ^= value >> 30;
+        value *= 0xbf58476d1ce4e5b9;
+        value ^= value >> 27;
+        value *= 0x94d049bb133111eb;
+        value ^= value >> 31;
+        return value;
+    }
+
+    bool are_same_node(const TreeDocument &document, index_t first, index_t second)
+    {
+        return document.get_kind(first) == document.get_kind(second) &&
+               document.get_parameter(first) == document.get_parameter(second) &&
+               document.get_child_count(first) == document.get_child_count(second) &&
+               document.get_label(first) == document.get_label(second);
+    }
+
+    // Calls visit(first_node, second_node) for matching nodes of both subtrees in pre-order until it
+    // returns false; returns false if it did or the subtrees differ in shape.
+    template<typename Visit>
+    bool walk_in_parallel(const TreeDocument &document, index_t first, index_t second, Visit visit)
+    {
+        std::vector<std::pair<index_t, index_t>> pending{{first, second}};
+        while(!pending.empty())
+        {
+            const auto [first_node, second_node] = pending.back();
+            pending.pop_back();
+            if(!visit(first_node, second_node))
+            {
+                return false;
+            }
+            auto second_child = document.get_last_child(second_node);
+            for(auto first_child = document.get_last_child(first_node); first_child != TreeDocument::no_node;
+                first_child = document.get_previous_sibling(first_child))
+            {
+                if(second_child == TreeDocument::no_node)
+                {
+                    return false;
+                }
+                pending.emplace_back(first_child, second_child);
+                second_child = document.get_previous_sibling(second_child);
+            }
+            if(second_child != TreeDocument::no_node)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool are_identical(const TreeDocument &document, index_t first, index_t second)
+    {
+        return walk_in_parallel(document, first, second, [&](index_t first_node, index_t second_node)
+        {
+            return are_same_node(document, first_node, second_node);
+        });
+    }
+}
+
+SubtreeHashes::SubtreeHashes(const TreeDocument &tree):
+        document{tree}
+{
+}
+
+void SubtreeHashes::invalidate(index_t node)
+{
+    if(node == TreeDocument::no_node)
+    {
+        return;
+    }
+    mark_dirty(node);
+}
+
+void SubtreeHashes::forget(index_t node)
+{
+    if(node < hashes.size())
+    {
+        hashes[node] = NodeHash{};
+    }
+}
+
+void SubtreeHashes::clear()
+{
+    hashes.clear();
+    dirty_nodes.clear();
+}
+
+void SubtreeHashes::rebuild()
+{
+    clear();
+    if(document.is_empty())
+    {
+        return;
+    }
+    hashes.resize(document.get_capacity());
+
+    // Parents come before their children in this order, so going through it backwards hashes every
+    // child before its parent.
+    std::vector<index_t> order;
+    order.reserve(document.size());
+    pending.assign(1, document.get_root());
+    while(!pending.empty())
+    {
+        const auto node = pending.back();
+        pending.pop_back();
+        order.push_back(node);
+        for(auto child = document.get_first_child(node); child != TreeDocument::no_node;
+            child = document.get_next_sibling(child))
+        {
+            pending.push_back(child);
+        }
+    }
+    for(auto node = order.rbegin(); node != order.rend(); ++node)
+    {
+        hash_node(*node);
+    }
+}
+
+void SubtreeHashes::update()
+{
+    if(document.is_empty())
+    {
+        dirty_nodes.clear();
+        return;
+    }
+
+    // Nodes removed and added again before this update may be queued twice; each is kept only once.
+    auto kept = dirty_nodes.begin();
+    for(const auto node: dirty_nodes)
+    {
+        if(document.contains(node) && hashes[node].dirty)
+        {
+            hashes[node].dirty = false;
+            *kept++ = node;
+        }
+    }
+    dirty_nodes.erase(kept, dirty_nodes.end());
+
+    // Dirty set is closed upwards. Hashing each node once all its dirty children are guarantees every
+    // child hash is current by the time its parent is hashed.
+    for(const auto node: dirty_nodes)
+    {
+        hashes[node].dirty = true;
+        const auto parent = document.get_parent(node);
+        if(parent != TreeDocument::no_node)
+        {
+            ++hashes[parent].dirty_children;
+        }
+    }
+    pending.clear();
+    for(const auto node: dirty_nodes)
+    {
+        if(hashes[node].dirty_children == 0)
+        {
+            pending.push_back(node);
+        }
+    }
+    while(!pending.empty())
+    {
+        const auto node = pending.back();
+        pending.pop_back();
+        hash_node(node);
+        const auto parent = document.get_parent(node);
+        if(parent != TreeDocument::no_node && --hashes[parent].dirty_children == 0)
+        {
+            pending.push_back(parent);
+        }
+    }
+    for(const auto node: dirty_nodes)
+    {
+        hashes[node].dirty = false;
+    }
+    dirty_nodes.clear();
+}
+
+uint64_t SubtreeHashes::get_hash(index_t node) const
+{
+    return hashes.at(node).hash;
+}
+
+uint32_t SubtreeHashes::get_size(index_t node) const
+{
+    return hashes.at(node).size;
+}
+
+void SubtreeHashes::mark_dirty(index_t node)
+{
+    if(document.get_capacity() > hashes.size())
+    {
+        hashes.resize(document.get_capacity());
+    }
+    // Stops at the first dirty ancestor - the rest of the spine is already queued.
+    while(node != TreeDocument::no_node && !hashes[node].dirty)
+    {
+        hashes[node].dirty = true;
+        dirty_nodes.push_back(node);
+        node = document.get_parent(node);
+    }
+}
+
+void SubtreeHashes::hash_node(index_t node)
+{
+    auto hash = mix(static_cast<uint64_t>(document.get_kind(node)) + 1);
+    hash = mix(hash ^ std::hash<std::string_view>{}(document.get_label(node)));
+    hash = mix(hash ^ document.get_parameter(node));
+    uint32_t size = 1;
+    for(auto child = document.get_first_child(node); child != TreeDocument::no_node;
+        child = document.get_next_sibling(child))
+    {
+        hash = mix(hash + hashes[child].hash);
+        size += hashes[child].size;
+    }
+    hashes[node].hash = hash;
+    hashes[node].size = size;
+}
+
+std::vector<SubtreeFold> find_foldable_subtrees(const TreeDocument &document, const SubtreeHashes &hashes,
+                                                uint32_t min_size)
+{
+    std::vector<SubtreeFold> folds;
+    if(document.is_empty())
+    {
+        return folds;
+    }
+
+    // First subtree met with each hash; different subtrees sharing a hash get an entry each.
+    std::unordered_multimap<uint64_t, index_t> definitions;
+    std::vector<index_t> pending{document.get_root()};
+    while(!pending.empty())
+    {
+        const auto node = pending.back();
+        pending.pop_back();
+        const auto size = hashes.get_size(node);
+        if(size >= min_size)
+        {
+            const auto hash = hashes.get_hash(node);
+            const auto [first, last] = definitions.equal_range(hash);
+            const auto definition = std::find_if(first, last, [&](const auto &entry)
+            {
+                return are_identical(document, entry.second, node);
+            });
+            if(definition != last)
+            {
+                // Its subtree goes away with it; nothing in there gets folded or becomes a definition.
+                folds.push_back({node, definition->second, size});
+                continue;
+            }
+            definitions.emplace(hash, node);
+        }
+        for(auto child = document.get_last_child(node); child != TreeDocument::no_node;
+            child = document.get_previous_sibling(child))
+        {
+            pending.push_back(child);
+        }
+    }
+    return folds;
+}
+
+void fold_subtrees(TreeDocument &document, const std::vector<SubtreeFold> &folds)
+{
+    // Mapped before anything is removed, while every copy still matches its definition node by node.
+    std::unordered_map<TreeDocument::id_t, TreeDocument::id_t> redirects;
+    for(const auto &fold: folds)
+    {
+        walk_in_parallel(document, fold.copy, fold.definition, [&](index_t copy_node, index_t definition_node)
+        {
+            redirects.emplace(document.get_id(copy_node), document.get_id(definition_node));
+            return true;
+        });
+    }
+    // A definition may itself hold a copy folded elsewhere; every step leads to a node earlier in
+    // pre-order, so following the chain ends on a node which stays.
+    const auto resolve = [&](TreeDocument::id_t id)
+    {
+        for(auto redirect = redirects.find(id); redirect != redirects.end(); redirect = redirects.find(id))
+        {
+            id = redirect->second;
+        }
+        return id;
+    };
+
+    std::vector<index_t> removed;
+    for(const auto &fold: folds)
+    {
+        const auto parent = document.get_parent(fold.copy);
+        const auto before = document.get_next_sibling(fold.copy);
+        const std::string label{document.get_label(fold.copy)};
+        const auto target = document.get_id(fold.definition);
+        removed.clear();
+        document.remove_subtree(fold.copy, removed);
+        document.insert_node(parent, before, NodeKind::link, label, target, document.get_next_id());
+    }
+
+    for(index_t node = 0; node < document.get_capacity(); ++node)
+    {
+        if(document.contains(node) && document.get_kind(node) == NodeKind::link)
+        {
+            const auto target = resolve(document.get_parameter(node));
+            if(target != document.get_parameter(node))
+            {
+                document.set_parameter(node, target);
+            }
+        }
+    }
+}
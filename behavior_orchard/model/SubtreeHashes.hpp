@@ -0,0 +1,99 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include "TreeDocument.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Structural hash of every subtree - kind, label and parameter of the node combined with the hashes
+// of its children in order - so identical subtrees are found by comparing one number per node.
+// Kept up to date the way TreeLayout is: an edit marks the node and its ancestor spine, and the next
+// update rehashes only those, children before parents, reusing the hashes of every untouched subtree.
+class SubtreeHashes
+{
+public:
+    using index_t = TreeDocument::index_t;
+
+    explicit SubtreeHashes(const TreeDocument &tree);
+
+    // Node was added, its label or parameter changed, or its children were added, removed or reordered.
+    void invalidate(index_t node);
+    // Node was removed from the document.
+    void forget(index_t node);
+    void clear();
+    // Hashes everything again - for a document replaced as a whole.
+    void rebuild();
+    // Rehashes everything invalidated since the last update.
+    void update();
+
+    // Both valid after an update.
+    uint64_t get_hash(index_t node) const;
+    uint32_t get_size(index_t node) const;
+
+private:
+    struct NodeHash
+    {
+        uint64_t hash = 0;
+        uint32_t size = 0;
+        // Dirty children not hashed yet during an update.
+        uint32_t dirty_children = 0;
+        bool dirty = false;
+    };
+
+    void mark_dirty(index_t node);
+    void hash_node(index_t node);
+
+    const TreeDocument &document;
+    std::vector<NodeHash> hashes;
+    std::vector<index_t> dirty_nodes;
+    // Scratch space reused between updates.
+    std::vector<index_t> pending;
+};
+
+// Later copy of a subtree which can be replaced by a link to an identical subtree coming before it in
+// pre-order. The definition stays, and it is never inside the copy or another folded copy.
+struct SubtreeFold
+{
+    TreeDocument::index_t copy;
+    TreeDocument::index_t definition;
+    // Nodes in the copy.
+    uint32_t size;
+};
+
+// Walks the tree in pre-order and pairs every subtree of at least min_size nodes with the first
+// identical subtree met before it; subtrees inside a copy are not looked at, as they go away with it.
+// Hash matches are confirmed node by node, so collisions cannot fold different subtrees. Linear in the
+// size of the tree; the hashes have to be updated.
+std::vector<SubtreeFold> find_foldable_subtrees(const TreeDocument &document, const SubtreeHashes &hashes,
+                                                uint32_t min_size);
+// Replaces every copy by a link (keeping the label of the copy) to its definition, in the same place
+// among its siblings. Links which pointed into a copy are redirected to the matching node of the
+// definition. A link evaluates the very nodes it points to, so folded copies share the running state
+// of their definition - a copy left running resumes where the definition is, not where it was.
+void fold_subtrees(TreeDocument &document, const std::vector<SubtreeFold> &folds);
+
+
@@ -0,0 +1,66 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+
+enum class TraceEventType: uint8_t
+{
+    enter,
+    exit
+};
+
+// Same values as BehaviorState, so the model does not depend on the bt library; TreeProgram.hpp,
+// which converts one to the other, checks that they match.
+enum class TraceResult: uint8_t
+{
+    undefined,
+    success,
+    failure,
+    running
+};
+
+// One step of a traced tick. Eight bytes, so a ring of them is cheap to fill and a dump of millions of
+// them is still a plain array.
+struct TraceEvent
+{
+    // Node ID, as in TreeDocument and BehaviorTree.
+    uint32_t node;
+    TraceEventType type;
+    // Meaningful for exit events only.
+    TraceResult result;
+    // Index of the ring (thread) which recorded the event.
+    uint16_t thread;
+
+    bool operator==(const TraceEvent &other) const
+    {
+        return node == other.node && type == other.type && result == other.result && thread == other.thread;
+    }
+};
+
+static_assert(sizeof(TraceEvent) == 8, "TraceEvent is stored as an 8-byte record");
+
+
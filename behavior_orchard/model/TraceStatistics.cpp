@@ -0,0 +1,98 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#include "TraceStatistics.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    const TraceStatistics::Node untraced{};
+}
+
+void TraceStatistics::add(const TraceEvent *events, size_t count)
+{
+    for(size_t i = 0; i < count; ++i)
+    {
+        const auto &event = events[i];
+        if(event.node >= nodes.size())
+        {
+            nodes.resize(size_t{event.node} + 1);
+        }
+        auto &node = nodes[event.node];
+        if(event.type == TraceEventType::enter)
+        {
+            max_hits = std::max(max_hits, ++node.hits);
+            continue;
+        }
+        switch(event.result)
+        {
+            case TraceResult::success:
+                ++node.successes;
+                break;
+            case TraceResult::failure:
+                ++node.failures;
+                break;
+            case TraceResult::running:
+                ++node.running;
+                break;
+            case TraceResult::undefined:
+                break;
+        }
+    }
+    event_count += count;
+}
+
+void TraceStatistics::add(const std::vector<TraceEvent> &events)
+{
+    add(events.data(), events.size());
+}
+
+void TraceStatistics::clear()
+{
+    nodes.clear();
+    max_hits = 0;
+    event_count = 0;
+}
+
+bool TraceStatistics::is_empty() const
+{
+    return event_count == 0;
+}
+
+const TraceStatistics::Node &TraceStatistics::get(uint32_t id) const
+{
+    return id < nodes.size() ? nodes[id] : untraced;
+}
+
+uint64_t TraceStatistics::get_max_hits() const
+{
+    return max_hits;
+}
+
+uint64_t TraceStatistics::get_event_count() const
+{
+    return event_count;
+}
@@ -0,0 +1,62 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "TraceEvent.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Per-node totals of a trace - what the workspace overlays on the tree.
+class TraceStatistics
+{
+public:
+    struct Node
+    {
+        uint64_t hits = 0;
+        uint64_t successes = 0;
+        uint64_t failures = 0;
+        uint64_t running = 0;
+    };
+
+    void add(const TraceEvent *events, size_t count);
+    void add(const std::vector<TraceEvent> &events);
+    void clear();
+
+    bool is_empty() const;
+    // Node IDs are dense, so the totals are a plain table indexed by ID; IDs never traced read as zero.
+    const Node &get(uint32_t id) const;
+    uint64_t get_max_hits() const;
+    uint64_t get_event_count() const;
+
+private:
+    std::vector<Node> nodes;
+    uint64_t max_hits = 0;
+    uint64_t event_count = 0;
+};
+
+
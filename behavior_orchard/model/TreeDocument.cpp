@@ -0,0 +1,342 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "TreeDocument.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+TreeDocument::index_t TreeDocument::add_node(index_t parent, NodeKind kind, std::string_view label, uint32_t parameter)
+{
+    // Loaded nodes may take IDs up to max_id; numbering never goes past it.
+    if(next_id > max_id)
+    {
+        return no_node;
+    }
+    return allocate(parent, no_node, kind, label, parameter, next_id);
+}
+
+TreeDocument::index_t TreeDocument::add_node(index_t parent, NodeKind kind, std::string_view label, uint32_t parameter,
+                                             id_t id)
+{
+    check_id(id);
+    return allocate(parent, no_node, kind, label, parameter, id);
+}
+
+TreeDocument::index_t TreeDocument::insert_node(index_t parent, index_t before, NodeKind kind, std::string_view label,
+                                                uint32_t parameter, id_t id)
+{
+    check_id(id);
+    if(before != no_node && (!contains(before) || parents[before] != parent))
+    {
+        throw std::invalid_argument("TreeDocument: node " + std::to_string(before) + " is not a child of the parent");
+    }
+    return allocate(parent, before, kind, label, parameter, id);
+}
+
+TreeDocument::index_t TreeDocument::allocate(index_t parent, index_t before, NodeKind kind, std::string_view label,
+                                             uint32_t parameter, id_t id)
+{
+    if(parent == no_node)
+    {
+        if(!is_empty())
+        {
+            throw std::logic_error("TreeDocument: tree already has a root");
+        }
+    }
+    else if(!can_add_child(parent))
+    {
+        return no_node;
+    }
+
+    index_t node;
+    if(free_indices.empty())
+    {
+        node = static_cast<index_t>(ids.size());
+        parents.push_back(no_node);
+        first_children.push_back(no_node);
+        last_children.push_back(no_node);
+        next_siblings.push_back(no_node);
+        previous_siblings.push_back(no_node);
+        child_counts.push_back(0);
+        kinds.push_back(kind);
+        ids.push_back(no_id);
+        parameters.push_back(0);
+        labels.emplace_back();
+    }
+    else
+    {
+        node = free_indices.back();
+        free_indices.pop_back();
+    }
+
+    parents[node] = parent;
+    first_children[node] = no_node;
+    last_children[node] = no_node;
+    next_siblings[node] = no_node;
+    previous_siblings[node] = no_node;
+    child_counts[node] = 0;
+    kinds[node] = kind;
+    ids[node] = id;
+    parameters[node] = parameter;
+    labels[node] = label_pool.add(label);
+    set_index_by_id(id, node);
+    next_id = std::max(next_id, id + 1);
+    ++alive_count;
+    newest = node;
+
+    if(parent == no_node)
+    {
+        root = node;
+        return node;
+    }
+    const auto previous = before == no_node ? last_children[parent] : previous_siblings[before];
+    previous_siblings[node] = previous;
+    next_siblings[node] = before;
+    (previous == no_node ? first_children[parent] : next_siblings[previous]) = node;
+    (before == no_node ? last_children[parent] : previous_siblings[before]) = node;
+    ++child_counts[parent];
+    return node;
+}
+
+void TreeDocument::remove_subtree(index_t node, std::vector<index_t> &removed)
+{
+    check(node);
+    const auto parent = parents[node];
+    if(parent == no_node)
+    {
+        root = no_node;
+    }
+    else
+    {
+        const auto previous = previous_siblings[node];
+        const auto next = next_siblings[node];
+        (previous == no_node ? first_children[parent] : next_siblings[previous]) = next;
+        (next == no_node ? last_children[parent] : previous_siblings[next]) = previous;
+        --child_counts[parent];
+    }
+
+    // Removed list doubles as the queue of the breadth-first walk over the subtree.
+    const auto first_removed = removed.size();
+    removed.push_back(node);
+    for(auto position = first_removed; position < removed.size(); ++position)
+    {
+        const auto current = removed[position];
+        for(auto child = first_children[current]; child != no_node; child = next_siblings[child])
+        {
+            removed.push_back(child);
+        }
+        label_pool.release(labels[current]);
+        labels[current] = {};
+        set_index_by_id(ids[current], no_node);
+        ids[current] = no_id;
+        if(current == newest)
+        {
+            newest = no_node;
+        }
+        free_indices.push_back(current);
+        --alive_count;
+    }
+    compact_labels();
+}
+
+void TreeDocument::clear()
+{
+    parents.clear();
+    first_children.clear();
+    last_children.clear();
+    next_siblings.clear();
+    previous_siblings.clear();
+    child_counts.clear();
+    kinds.clear();
+    ids.clear();
+    parameters.clear();
+    labels.clear();
+    label_pool.clear();
+    index_by_id.clear();
+    sparse_index_by_id.clear();
+    free_indices.clear();
+    root = no_node;
+    newest = no_node;
+    next_id = 0;
+    alive_count = 0;
+}
+
+void TreeDocument::reserve(size_t node_count, size_t label_bytes)
+{
+    parents.reserve(node_count);
+    first_children.reserve(node_count);
+    last_children.reserve(node_count);
+    next_siblings.reserve(node_count);
+    previous_siblings.reserve(node_count);
+    child_counts.reserve(node_count);
+    kinds.reserve(node_count);
+    ids.reserve(node_count);
+    parameters.reserve(node_count);
+    labels.reserve(node_count);
+    label_pool.reserve(label_bytes);
+    index_by_id.reserve(node_count);
+}
+
+void TreeDocument::set_label(index_t node, std::string_view label)
+{
+    check(node);
+    label_pool.release(labels[node]);
+    labels[node] = label_pool.add(label);
+    compact_labels();
+}
+
+void TreeDocument::set_parameter(index_t node, uint32_t parameter)
+{
+    check(node);
+    parameters[node] = parameter;
+}
+
+bool TreeDocument::is_empty() const
+{
+    return root == no_node;
+}
+
+size_t TreeDocument::size() const
+{
+    return alive_count;
+}
+
+TreeDocument::index_t TreeDocument::get_capacity() const
+{
+    return static_cast<index_t>(ids.size());
+}
+
+bool TreeDocument::contains(index_t node) const
+{
+    return node < ids.size() && ids[node] != no_id;
+}
+
+bool TreeDocument::can_add_child(index_t node) const
+{
+    check(node);
+    return child_counts[node] < get_max_children(kinds[node]);
+}
+
+TreeDocument::index_t TreeDocument::find_by_id(id_t id) const
+{
+    if(id < index_by_id.size())
+    {
+        return index_by_id[id];
+    }
+    if(sparse_index_by_id.empty())
+    {
+        return no_node;
+    }
+    const auto found = sparse_index_by_id.find(id);
+    return found == sparse_index_by_id.end() ? no_node : found->second;
+}
+
+TreeDocument::id_t TreeDocument::get_next_id() const
+{
+    return next_id;
+}
+
+size_t TreeDocument::get_memory_usage() const
+{
+    const auto index_bytes = sizeof(index_t) * (parents.capacity() + first_children.capacity() +
+                                                last_children.capacity() + next_siblings.capacity() +
+                                                previous_siblings.capacity() + index_by_id.capacity() +
+                                                free_indices.capacity());
+    return index_bytes + sizeof(uint32_t) * (child_counts.capacity() + parameters.capacity()) +
+           sizeof(id_t) * ids.capacity() + sizeof(NodeKind) * kinds.capacity() +
+           sizeof(LabelPool::Handle) * labels.capacity() + label_pool.get_memory_usage() +
+           sizeof(std::pair<id_t, index_t>) * sparse_index_by_id.size();
+}
+
+void TreeDocument::check(index_t node) const
+{
+    if(!contains(node))
+    {
+        throw std::out_of_range("TreeDocument: no node at index " + std::to_string(node));
+    }
+}
+
+void TreeDocument::check_id(id_t id) const
+{
+    if(id > max_id || find_by_id(id) != no_node)
+    {
+        throw std::invalid_argument("TreeDocument: ID " + std::to_string(id) + " is not available");
+    }
+}
+
+void TreeDocument::set_index_by_id(id_t id, index_t node)
+{
+    if(id < index_by_id.size())
+    {
+        index_by_id[id] = node;
+        return;
+    }
+    if(node == no_node)
+    {
+        sparse_index_by_id.erase(id);
+        return;
+    }
+    // Table grows with the document, never past what the document could fill.
+    const auto table_limit = 2 * size_t{alive_count} + 1024;
+    if(id >= table_limit)
+    {
+        sparse_index_by_id[id] = node;
+        return;
+    }
+    index_by_id.resize(std::max(size_t{id} + 1, std::min(2 * index_by_id.size(), table_limit)), no_node);
+    index_by_id[id] = node;
+    // IDs set aside before may fit in the table now.
+    for(auto entry = sparse_index_by_id.begin(); entry != sparse_index_by_id.end();)
+    {
+        if(entry->first < index_by_id.size())
+        {
+            index_by_id[entry->first] = entry->second;
+            entry = sparse_index_by_id.erase(entry);
+        }
+        else
+        {
+            ++entry;
+        }
+    }
+}
+
+void TreeDocument::compact_labels()
+{
+    if(!label_pool.needs_compaction())
+    {
+        return;
+    }
+    label_pool.compact([this](auto &&visit)
+                       {
+                           for(index_t node = 0; node < ids.size(); ++node)
+                           {
+                               if(ids[node] != no_id)
+                               {
+                                   visit(labels[node]);
+                               }
+                           }
+                       });
+}
@@ -0,0 +1,193 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include "LabelPool.hpp"
+#include "NodeKind.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Tree edited in the workspace.
+// Stored as parallel columns indexed by node index (structure of arrays): links to parent, first and
+// last child and both siblings, plus kind, ID, parameter and label columns. Every navigation step is
+// a single array read, walking the tree touches only the columns it needs, and adding a node does not
+// allocate anything on its own - labels live in a shared LabelPool.
+// Indices of removed nodes are reused by later insertions. Every node gets an ID the same way
+// BehaviorTree numbers its nodes - in order of creation.
+class TreeDocument
+{
+public:
+    using index_t = uint32_t;
+    using id_t = uint32_t;
+
+    static constexpr index_t no_node = std::numeric_limits<index_t>::max();
+    static constexpr id_t no_id = std::numeric_limits<id_t>::max();
+    // Highest ID a node can get; loaders reject files with anything above it.
+    static constexpr id_t max_id = std::numeric_limits<int32_t>::max();
+
+    // Appends a child to the parent (or creates the root when parent is no_node).
+    // Returns no_node if the parent cannot take another child or every ID up to max_id is taken.
+    index_t add_node(index_t parent, NodeKind kind, std::string_view label, uint32_t parameter = 0);
+    // Same, but keeps the given ID instead of numbering the node - for loading saved trees, where
+    // links refer to nodes by ID. Throws if the ID is already used or above max_id.
+    index_t add_node(index_t parent, NodeKind kind, std::string_view label, uint32_t parameter, id_t id);
+    // Same, but places the node right before the given child of the parent (no_node appends) - for
+    // putting back a removed subtree where it was.
+    index_t insert_node(index_t parent, index_t before, NodeKind kind, std::string_view label, uint32_t parameter,
+                        id_t id);
+    // Removes node with its whole subtree; removed indices are appended to the output, parents first.
+    void remove_subtree(index_t node, std::vector<index_t> &removed);
+    void clear();
+    // Label bytes are only a hint, for loaders which know the size of the labels up front.
+    void reserve(size_t node_count, size_t label_bytes = 0);
+
+    void set_label(index_t node, std::string_view label);
+    void set_parameter(index_t node, uint32_t parameter);
+
+    bool is_empty() const;
+    size_t size() const;
+    // One past the highest index in use - size for per-node side tables.
+    index_t get_capacity() const;
+    bool contains(index_t node) const;
+    bool can_add_child(index_t node) const;
+    index_t find_by_id(id_t id) const;
+    // ID the next add_node without an explicit ID will get.
+    id_t get_next_id() const;
+    size_t get_memory_usage() const;
+
+    // Navigation - constant time; the index has to refer to a node of this document.
+    index_t get_root() const
+    {
+        return root;
+    }
+
+    // Most recently added node, as long as it was not removed since.
+    index_t get_newest() const
+    {
+        return newest;
+    }
+
+    index_t get_parent(index_t node) const
+    {
+        return parents[node];
+    }
+
+    index_t get_first_child(index_t node) const
+    {
+        return first_children[node];
+    }
+
+    index_t get_last_child(index_t node) const
+    {
+        return last_children[node];
+    }
+
+    index_t get_next_sibling(index_t node) const
+    {
+        return next_siblings[node];
+    }
+
+    index_t get_previous_sibling(index_t node) const
+    {
+        return previous_siblings[node];
+    }
+
+    uint32_t get_child_count(index_t node) const
+    {
+        return child_counts[node];
+    }
+
+    NodeKind get_kind(index_t node) const
+    {
+        return kinds[node];
+    }
+
+    id_t get_id(index_t node) const
+    {
+        return ids[node];
+    }
+
+    // Loop count for loops, number of tries for MaxNTries, ID of the linked node for links.
+    uint32_t get_parameter(index_t node) const
+    {
+        return parameters[node];
+    }
+
+    std::string_view get_label(index_t node) const
+    {
+        return label_pool.get(labels[node]);
+    }
+
+private:
+    index_t allocate(index_t parent, index_t before, NodeKind kind, std::string_view label, uint32_t parameter, id_t id);
+    void check(index_t node) const;
+    void check_id(id_t id) const;
+    void set_index_by_id(id_t id, index_t node);
+    void compact_labels();
+
+    std::vector<index_t> parents;
+    std::vector<index_t> first_children;
+    std::vector<index_t> last_children;
+    std::vector<index_t> next_siblings;
+    std::vector<index_t> previous_siblings;
+    std::vector<uint32_t> child_counts;
+    std::vector<NodeKind> kinds;
+    // no_id marks a free slot.
+    std::vector<id_t> ids;
+    std::vector<uint32_t> parameters;
+    std::vector<LabelPool::Handle> labels;
+    LabelPool label_pool;
+
+    std::vector<index_t> index_by_id;
+    // IDs far above the number of nodes, as only a damaged or hand-edited file has them; kept aside,
+    // so a single such ID does not blow up the table above.
+    std::unordered_map<id_t, index_t> sparse_index_by_id;
+    std::vector<index_t> free_indices;
+    index_t root = no_node;
+    index_t newest = no_node;
+    id_t next_id = 0;
+    size_t alive_count = 0;
+};
+
+// Parameter of a node created without one: a single run for loops and tries, no target for links.
+inline uint32_t get_default_parameter(NodeKind kind)
+{
+    switch(kind)
+    {
+        case NodeKind::loop:
+        case NodeKind::max_n_tries:
+            return 1;
+        case NodeKind::link:
+            return TreeDocument::no_id;
+        default:
+            return 0;
+    }
+}
+
+
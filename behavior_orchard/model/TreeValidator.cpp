@@ -0,0 +1,236 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#include "TreeValidator.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace
+{
+    using index_t = TreeDocument::index_t;
+
+    std::string describe(const TreeDocument &document, index_t node)
+    {
+        return std::string{get_node_kind_name(document.get_kind(node))} + " '" + std::string{document.get_label(node)} +
+               "'";
+    }
+}
+
+void validate_node(const TreeDocument &document, index_t node, std::vector<ValidationIssue> &issues)
+{
+    const auto kind = document.get_kind(node);
+    if(get_max_children(kind) == 1 && document.get_child_count(node) != 1)
+    {
+        issues.push_back({node, describe(document, node) + " has " + std::to_string(document.get_child_count(node)) +
+                                " children instead of one"});
+    }
+    if(kind == NodeKind::link && document.find_by_id(document.get_parameter(node)) == TreeDocument::no_node)
+    {
+        issues.push_back({node, describe(document, node) + " points to missing node #" +
+                                std::to_string(document.get_parameter(node))});
+    }
+}
+
+void validate_subtree(const TreeDocument &document, index_t root, std::vector<ValidationIssue> &issues)
+{
+    std::vector<index_t> pending{root};
+    while(!pending.empty())
+    {
+        const auto node = pending.back();
+        pending.pop_back();
+        validate_node(document, node, issues);
+        for(auto child = document.get_first_child(node); child != TreeDocument::no_node;
+            child = document.get_next_sibling(child))
+        {
+            pending.push_back(child);
+        }
+    }
+}
+
+void validate_links(const TreeDocument &document, std::vector<ValidationIssue> &issues)
+{
+    if(document.is_empty())
+    {
+        return;
+    }
+
+    // Pre-order positions and subtree ends: links inside the subtree of a target are then the links
+    // with positions in [target, end), one contiguous range of the sorted link list.
+    std::vector<uint32_t> positions(document.get_capacity(), UINT32_MAX);
+    std::vector<index_t> order;
+    order.reserve(document.size());
+    std::vector<index_t> pending{document.get_root()};
+    while(!pending.empty())
+    {
+        const auto node = pending.back();
+        pending.pop_back();
+        positions[node] = static_cast<uint32_t>(order.size());
+        order.push_back(node);
+        for(auto child = document.get_last_child(node); child != TreeDocument::no_node;
+            child = document.get_previous_sibling(child))
+        {
+            pending.push_back(child);
+        }
+    }
+    std::vector<uint32_t> ends(order.size(), 0);
+    for(auto position = static_cast<uint32_t>(order.size()); position-- > 0;)
+    {
+        ends[position] = std::max(ends[position], position + 1);
+        if(position > 0)
+        {
+            auto &parent_end = ends[positions[document.get_parent(order[position])]];
+            parent_end = std::max(parent_end, ends[position]);
+        }
+    }
+
+    // Links in pre-order, with the range of links each of them runs when evaluated.
+    std::vector<uint32_t> links;
+    for(uint32_t position = 0; position < order.size(); ++position)
+    {
+        if(document.get_kind(order[position]) == NodeKind::link)
+        {
+            links.push_back(position);
+        }
+    }
+    struct Reach
+    {
+        uint32_t first;
+        uint32_t last;
+    };
+    std::vector<Reach> reaches(links.size(), Reach{0, 0});
+    for(size_t link = 0; link < links.size(); ++link)
+    {
+        const auto target = document.find_by_id(document.get_parameter(order[links[link]]));
+        if(target == TreeDocument::no_node)
+        {
+            continue;
+        }
+        const auto begin = positions[target];
+        reaches[link].first = static_cast<uint32_t>(std::lower_bound(links.begin(), links.end(), begin) - links.begin());
+        reaches[link].last = static_cast<uint32_t>(std::lower_bound(links.begin(), links.end(), ends[begin]) -
+                                                   links.begin());
+    }
+
+    // Strongly connected components of the "runs" relation (Tarjan, with an explicit stack). Every
+    // link of a component with more than one link, or running itself, is on a cycle.
+    constexpr uint32_t unvisited = UINT32_MAX;
+    std::vector<uint32_t> indices(links.size(), unvisited);
+    std::vector<uint32_t> lowest(links.size(), 0);
+    std::vector<bool> on_stack(links.size(), false);
+    std::vector<bool> in_cycle(links.size(), false);
+    std::vector<uint32_t> component;
+    struct Frame
+    {
+        uint32_t link;
+        uint32_t next;
+    };
+    std::vector<Frame> frames;
+    uint32_t next_index = 0;
+    const auto visit = [&](uint32_t link)
+    {
+        indices[link] = lowest[link] = next_index++;
+        component.push_back(link);
+        on_stack[link] = true;
+        frames.push_back({link, reaches[link].first});
+    };
+    for(uint32_t start = 0; start < links.size(); ++start)
+    {
+        if(indices[start] != unvisited)
+        {
+            continue;
+        }
+        visit(start);
+        while(!frames.empty())
+        {
+            auto &frame = frames.back();
+            const auto link = frame.link;
+            if(frame.next != reaches[link].last)
+            {
+                const auto next = frame.next++;
+                if(indices[next] == unvisited)
+                {
+                    visit(next);
+                }
+                else if(on_stack[next])
+                {
+                    lowest[link] = std::min(lowest[link], indices[next]);
+                }
+                continue;
+            }
+            frames.pop_back();
+            if(!frames.empty())
+            {
+                auto &parent_lowest = lowest[frames.back().link];
+                parent_lowest = std::min(parent_lowest, lowest[link]);
+            }
+            if(lowest[link] != indices[link])
+            {
+                continue;
+            }
+            const auto runs_itself = reaches[link].first <= link && link < reaches[link].last;
+            const auto cycle = component.back() != link || runs_itself;
+            uint32_t member = 0;
+            do
+            {
+                member = component.back();
+                component.pop_back();
+                on_stack[member] = false;
+                in_cycle[member] = cycle;
+            }
+            while(member != link);
+        }
+    }
+
+    for(size_t link = 0; link < links.size(); ++link)
+    {
+        if(in_cycle[link])
+        {
+            const auto node = order[links[link]];
+            issues.push_back({node, describe(document, node) + " leads back to itself through #" +
+                                    std::to_string(document.get_parameter(node))});
+        }
+    }
+}
+
+std::vector<ValidationIssue> validate_tree(const TreeDocument &document)
+{
+    std::vector<ValidationIssue> issues;
+    if(!document.is_empty())
+    {
+        validate_subtree(document, document.get_root(), issues);
+        validate_links(document, issues);
+    }
+    sort_issues(document, issues);
+    return issues;
+}
+
+void sort_issues(const TreeDocument &document, std::vector<ValidationIssue> &issues)
+{
+    std::stable_sort(issues.begin(), issues.end(), [&document](const ValidationIssue &left, const ValidationIssue &right)
+    {
+        return document.get_id(left.node) < document.get_id(right.node);
+    });
+}
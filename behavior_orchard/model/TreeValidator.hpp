@@ -0,0 +1,55 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "TreeDocument.hpp"
+
+#include <string>
+#include <vector>
+
+// Problem which would make the bt library refuse the tree or misbehave at run time. The editor still
+// opens such trees - they may be half-built - but points at the problems.
+struct ValidationIssue
+{
+    TreeDocument::index_t node;
+    std::string message;
+};
+
+// Checks the node on its own: decorators need exactly one child and links a node to point to.
+void validate_node(const TreeDocument &document, TreeDocument::index_t node, std::vector<ValidationIssue> &issues);
+// validate_node for the whole subtree. Reads the document only, so disjoint subtrees can be checked
+// on several threads at once.
+void validate_subtree(const TreeDocument &document, TreeDocument::index_t root, std::vector<ValidationIssue> &issues);
+// Reports links which end up evaluating themselves: a link runs the subtree of its target, so a link
+// inside that subtree leading (directly or through more links) back to it makes DecoratorLink recurse
+// forever. Needs the whole tree.
+void validate_links(const TreeDocument &document, std::vector<ValidationIssue> &issues);
+// All of the above on the calling thread; issues ordered by node ID.
+std::vector<ValidationIssue> validate_tree(const TreeDocument &document);
+// Orders issues by node ID, so results do not depend on how the checks were split between threads.
+void sort_issues(const TreeDocument &document, std::vector<ValidationIssue> &issues);
+
+
@@ -0,0 +1,278 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "AgentBatch.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    template<typename Callback>
+    std::vector<Callback> bind_callbacks(const std::pmr::vector<std::pmr::string> &labels,
+                                         const std::unordered_map<std::string, Callback> &callbacks)
+    {
+        std::vector<Callback> bound;
+        bound.reserve(labels.size());
+        for(const auto &label: labels)
+        {
+            const std::string key{label};
+            const auto callback = callbacks.find(key);
+            if(callback == callbacks.end())
+            {
+                throw std::invalid_argument("AgentBatch: no callback for '" + key + "'");
+            }
+            bound.push_back(callback->second);
+        }
+        return bound;
+    }
+}
+
+struct AgentBatch::Primitives
+{
+    BehaviorState run_action(uint32_t index)
+    {
+        return batch.actions[index](agent);
+    }
+
+    bool check_condition(uint32_t index)
+    {
+        return batch.conditions[index](agent);
+    }
+
+    bool is_tracked(uint32_t index) const
+    {
+        return batch.tracked[index] != 0;
+    }
+
+    const AgentBatch &batch;
+    size_t agent;
+};
+
+AgentBatch::AgentBatch(const TreeDocument &document, const AgentCallbacks &callbacks, size_t initial_agents):
+        program{document},
+        actions{bind_callbacks(program.get_action_labels(), callbacks.actions)},
+        conditions{bind_callbacks(program.get_condition_labels(), callbacks.conditions)},
+        plan{program.make_reactive_plan()},
+        tracked(conditions.size(), 0),
+        reactive{false},
+        agent_count{0},
+        slot_count{program.get_slot_count()},
+        scratches(1)
+{
+    const auto &labels = program.get_condition_labels();
+    const auto &instructions = program.get_instructions();
+    for(const auto &[label, names]: callbacks.condition_keys)
+    {
+        std::vector<uint32_t> readers;
+        for(uint32_t position = 0; position < instructions.size(); ++position)
+        {
+            const auto &instruction = instructions[position];
+            if(instruction.kind == NodeKind::condition && std::string_view{labels[instruction.operand]} == label)
+            {
+                tracked[instruction.operand] = 1;
+                readers.push_back(position);
+            }
+        }
+        for(const auto &name: names)
+        {
+            const auto [key, added] = keys.emplace(name, static_cast<uint32_t>(key_readers.size()));
+            if(added)
+            {
+                key_readers.emplace_back();
+            }
+            auto &positions = key_readers[key->second];
+            positions.insert(positions.end(), readers.begin(), readers.end());
+        }
+    }
+    // In order, mark_changed walks a row of memos from front to back.
+    for(auto &positions: key_readers)
+    {
+        std::sort(positions.begin(), positions.end());
+        positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+    }
+    resize(initial_agents);
+}
+
+void AgentBatch::resize(size_t count)
+{
+    slots.resize(count * slot_count, 0);
+    results.resize(count, BehaviorState::undefined);
+    if(count > agent_count)
+    {
+        std::fill(slots.begin() + static_cast<std::ptrdiff_t>(agent_count * slot_count), slots.end(), 0);
+        std::fill(results.begin() + static_cast<std::ptrdiff_t>(agent_count), results.end(), BehaviorState::undefined);
+    }
+    if(reactive)
+    {
+        memos.resize(count * plan.parents.size(), BehaviorState::undefined);
+    }
+    agent_count = count;
+}
+
+size_t AgentBatch::get_agent_count() const
+{
+    return agent_count;
+}
+
+void AgentBatch::reset(size_t agent)
+{
+    if(agent >= agent_count)
+    {
+        throw std::out_of_range("AgentBatch: no agent " + std::to_string(agent));
+    }
+    const auto row = slots.begin() + static_cast<std::ptrdiff_t>(agent * slot_count);
+    std::fill(row, row + static_cast<std::ptrdiff_t>(slot_count), 0);
+    results[agent] = BehaviorState::undefined;
+    if(reactive)
+    {
+        std::fill(get_memo(agent), get_memo(agent) + plan.parents.size(), BehaviorState::undefined);
+    }
+}
+
+BehaviorState AgentBatch::tick(size_t agent)
+{
+    if(agent >= agent_count)
+    {
+        throw std::out_of_range("AgentBatch: no agent " + std::to_string(agent));
+    }
+    return tick(agent, scratches.front());
+}
+
+void AgentBatch::tick_all(WorkStealingPool &pool, size_t grain)
+{
+    if(scratches.size() < pool.get_thread_count())
+    {
+        scratches.resize(pool.get_thread_count());
+    }
+    pool.parallel_for(agent_count, grain, [this](size_t begin, size_t end, size_t worker)
+    {
+        auto &scratch = scratches[worker];
+        for(auto agent = begin; agent < end; ++agent)
+        {
+            tick(agent, scratch);
+        }
+    });
+}
+
+BehaviorState AgentBatch::get_result(size_t agent) const
+{
+    return results.at(agent);
+}
+
+void AgentBatch::set_reactive(bool enabled)
+{
+    reactive = enabled;
+    memos.clear();
+    if(reactive)
+    {
+        memos.resize(agent_count * plan.parents.size(), BehaviorState::undefined);
+    }
+    else
+    {
+        memos.shrink_to_fit();
+    }
+}
+
+bool AgentBatch::is_reactive() const
+{
+    return reactive;
+}
+
+uint32_t AgentBatch::get_key(const std::string &name) const
+{
+    const auto key = keys.find(name);
+    if(key == keys.end())
+    {
+        throw std::invalid_argument("AgentBatch: no condition reads '" + name + "'");
+    }
+    return key->second;
+}
+
+void AgentBatch::mark_changed(size_t agent, uint32_t key)
+{
+    if(agent >= agent_count)
+    {
+        throw std::out_of_range("AgentBatch: no agent " + std::to_string(agent));
+    }
+    if(key >= key_readers.size())
+    {
+        throw std::out_of_range("AgentBatch: no key " + std::to_string(key));
+    }
+    if(!reactive)
+    {
+        return;
+    }
+    auto *const memo = get_memo(agent);
+    for(const auto reader: key_readers[key])
+    {
+        // A node is only remembered together with the nodes below it which it evaluated, so where
+        // nothing is remembered there is nothing above to forget either.
+        for(auto position = reader; position != TreeProgram::no_position; position = plan.parents[position])
+        {
+            if(memo[position] == BehaviorState::undefined)
+            {
+                break;
+            }
+            memo[position] = BehaviorState::undefined;
+        }
+    }
+}
+
+void AgentBatch::mark_changed(uint32_t key)
+{
+    for(size_t agent = 0; agent < agent_count; ++agent)
+    {
+        mark_changed(agent, key);
+    }
+}
+
+size_t AgentBatch::get_bytes_per_agent() const
+{
+    const auto memo_size = reactive ? plan.parents.size() * sizeof(BehaviorState) : 0;
+    return slot_count * sizeof(uint32_t) + sizeof(BehaviorState) + memo_size;
+}
+
+const TreeProgram &AgentBatch::get_program() const
+{
+    return program;
+}
+
+BehaviorState AgentBatch::tick(size_t agent, Scratch &scratch)
+{
+    Primitives primitives{*this, agent};
+    // Stateless trees have no slots at all; data() of an empty vector must not be offset.
+    const auto row = slot_count == 0 ? slots.data() : slots.data() + agent * slot_count;
+    if(reactive)
+    {
+        return results[agent] = program.evaluate_reactive(row, get_memo(agent), plan, scratch.stack, primitives);
+    }
+    return results[agent] = program.evaluate(row, scratch.stack, primitives);
+}
+
+BehaviorState *AgentBatch::get_memo(size_t agent)
+{
+    // Empty programs have no positions, see slots above.
+    return plan.parents.empty() ? memos.data() : memos.data() + agent * plan.parents.size();
+}
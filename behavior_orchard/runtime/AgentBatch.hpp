@@ -0,0 +1,121 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include "TreeProgram.hpp"
+#include "WorkStealingPool.hpp"
+
+#include <functional>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Callbacks for primitives, bound to document nodes by label; they get the index of the agent being
+// ticked. In AgentBatch::tick_all they are called from several threads at once.
+struct AgentCallbacks
+{
+    std::unordered_map<std::string, std::function<BehaviorState(size_t agent)>> actions;
+    std::unordered_map<std::string, std::function<bool(size_t agent)>> conditions;
+    // Blackboard keys each condition reads, by label. A condition listed here promises the same answer
+    // for an agent as long as none of its keys changed for that agent; reactive ticks rely on it.
+    // Conditions not listed are checked whenever a tick reaches them.
+    std::unordered_map<std::string, std::vector<std::string>> condition_keys;
+};
+
+// Many agents running the same tree. The tree is compiled once into a TreeProgram; what each agent
+// owns is its row of state slots (running children and counters) and its last result, so an agent
+// costs get_bytes_per_agent bytes instead of a tree of objects. Rows are contiguous, which keeps a
+// batch tick streaming through memory.
+// Reactive mode is for agents which mostly wait for something to change: each agent also keeps the
+// result of every subtree which only checked conditions (TreeProgram::evaluate_reactive), and a tick
+// walks only to what changed and to actions. Results and action calls stay those of full ticks as
+// long as every change of a key is reported by mark_changed.
+class AgentBatch
+{
+public:
+    // Throws std::invalid_argument like TreeProgram, or for a missing callback.
+    AgentBatch(const TreeDocument &document, const AgentCallbacks &callbacks, size_t initial_agents = 0);
+
+    // Agents added start with fresh state; removed ones are dropped from the end.
+    void resize(size_t count);
+    size_t get_agent_count() const;
+    void reset(size_t agent);
+
+    // Ticks one agent on the calling thread.
+    BehaviorState tick(size_t agent);
+    // Ticks every agent once, in chunks of grain agents spread over the pool.
+    void tick_all(WorkStealingPool &pool, size_t grain = 256);
+    BehaviorState get_result(size_t agent) const;
+
+    // Switching the mode forgets the remembered results.
+    void set_reactive(bool enabled);
+    bool is_reactive() const;
+    // Index of a key named in AgentCallbacks::condition_keys; throws std::invalid_argument for others.
+    uint32_t get_key(const std::string &name) const;
+    // Conditions reading the key are checked again on the agent's next tick; costs a look at each of
+    // them in the agent's memos. Callbacks may report changes of the agent they are called for, also in
+    // tick_all; otherwise not during a tick.
+    void mark_changed(size_t agent, uint32_t key);
+    // The same for every agent.
+    void mark_changed(uint32_t key);
+
+    size_t get_bytes_per_agent() const;
+    const TreeProgram &get_program() const;
+
+private:
+    struct Primitives;
+
+    // One per pool thread, padded so that threads do not share cache lines.
+    struct alignas(64) Scratch
+    {
+        std::pmr::vector<uint32_t> stack;
+    };
+
+    BehaviorState tick(size_t agent, Scratch &scratch);
+    BehaviorState *get_memo(size_t agent);
+
+    TreeProgram program;
+    std::vector<std::function<BehaviorState(size_t)>> actions;
+    std::vector<std::function<bool(size_t)>> conditions;
+
+    TreeProgram::ReactivePlan plan;
+    // By condition index: whether the condition listed its keys.
+    std::vector<uint8_t> tracked;
+    std::unordered_map<std::string, uint32_t> keys;
+    // By key: positions of the conditions reading it.
+    std::vector<std::vector<uint32_t>> key_readers;
+    bool reactive;
+    // Rows of one result per position, only in reactive mode.
+    std::vector<BehaviorState> memos;
+
+    size_t agent_count;
+    size_t slot_count;
+    std::vector<uint32_t> slots;
+    std::vector<BehaviorState> results;
+    std::vector<Scratch> scratches;
+};
+
+
@@ -0,0 +1,97 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "CompiledTree.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    template<typename Callback>
+    std::pmr::vector<Callback> bind_callbacks(const std::pmr::vector<std::pmr::string> &labels,
+                                              const std::unordered_map<std::string, Callback> &callbacks,
+                                              std::pmr::memory_resource *resource)
+    {
+        std::pmr::vector<Callback> bound{resource};
+        bound.reserve(labels.size());
+        for(const auto &label: labels)
+        {
+            const std::string key{label};
+            const auto callback = callbacks.find(key);
+            if(callback == callbacks.end())
+            {
+                throw std::invalid_argument("CompiledTree: no callback for '" + key + "'");
+            }
+            bound.push_back(callback->second);
+        }
+        return bound;
+    }
+}
+
+CompiledTree::CompiledTree(const TreeDocument &document, const BehaviorCallbacks &callbacks,
+                           std::pmr::memory_resource *resource):
+        program{document, resource},
+        actions{bind_callbacks(program.get_action_labels(), callbacks.actions, resource)},
+        conditions{bind_callbacks(program.get_condition_labels(), callbacks.conditions, resource)},
+        slots(program.get_slot_count(), 0, resource),
+        stack{resource}
+{
+}
+
+BehaviorState CompiledTree::evaluate()
+{
+    const auto timed = profiler != nullptr && profiler->begin_tick();
+    return program.evaluate(slots.data(), stack, *this, timed ? profiler : nullptr);
+}
+
+void CompiledTree::reset()
+{
+    std::fill(slots.begin(), slots.end(), 0);
+}
+
+void CompiledTree::set_profiler(TreeProfiler *tree_profiler)
+{
+    if(tree_profiler != nullptr && tree_profiler->get_node_count() != program.get_instructions().size())
+    {
+        throw std::invalid_argument("CompiledTree: profiler was made for another tree");
+    }
+    profiler = tree_profiler;
+}
+
+const TreeProgram &CompiledTree::get_program() const
+{
+    return program;
+}
+
+BehaviorState CompiledTree::run_action(uint32_t index)
+{
+    return actions[index]();
+}
+
+bool CompiledTree::check_condition(uint32_t index)
+{
+    return conditions[index]();
+}
@@ -0,0 +1,74 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include "TreeProgram.hpp"
+#include "../model/BehaviorTreeBridge.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <vector>
+
+// Single tree ticked over its TreeProgram by a switch over node kinds, instead of walking separately
+// allocated IBehavior objects through virtual calls. Takes the same document and callbacks as
+// build_behavior_tree and gives the same results.
+// Everything the tree allocates comes from the memory resource given on construction (see
+// TreeProgram), except for what callbacks too large for std::function's small buffer allocate
+// themselves.
+class CompiledTree
+{
+public:
+    // Throws std::invalid_argument for a missing callback, a decorator without child or a link
+    // pointing nowhere. The resource has to outlive the tree.
+    CompiledTree(const TreeDocument &document, const BehaviorCallbacks &callbacks,
+                 std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+    BehaviorState evaluate();
+    // Forgets running children and zeroes counters.
+    void reset();
+    // Sampled ticks from now on are timed by the profiler (made for get_program()); nullptr stops
+    // profiling. The profiler has to outlive its use here. Throws std::invalid_argument for a profiler
+    // of a different program.
+    void set_profiler(TreeProfiler *tree_profiler);
+
+    const TreeProgram &get_program() const;
+
+private:
+    BehaviorState run_action(uint32_t index);
+    bool check_condition(uint32_t index);
+
+    TreeProgram program;
+    std::pmr::vector<std::function<BehaviorState()>> actions;
+    std::pmr::vector<std::function<bool()>> conditions;
+
+    std::pmr::vector<uint32_t> slots;
+    std::pmr::vector<uint32_t> stack;
+    TreeProfiler *profiler = nullptr;
+
+    friend class TreeProgram;
+};
+
+
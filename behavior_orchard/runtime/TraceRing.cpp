@@ -0,0 +1,134 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#include "TraceRing.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+    size_t round_up_to_power_of_two(size_t value)
+    {
+        size_t result = 1;
+        while(result < value)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+}
+
+TraceRing::TraceRing(size_t capacity, uint16_t thread_index):
+        events(round_up_to_power_of_two(std::max<size_t>(capacity, 1))),
+        mask{events.size() - 1},
+        thread{thread_index},
+        head{0},
+        cached_tail{0},
+        dropped{0},
+        tail{0}
+{
+}
+
+size_t TraceRing::drain(std::vector<TraceEvent> &output)
+{
+    const auto last = head.load(std::memory_order_acquire);
+    const auto first = tail.load(std::memory_order_relaxed);
+    output.reserve(output.size() + (last - first));
+    for(auto position = first; position != last; ++position)
+    {
+        output.push_back(events[position & mask]);
+    }
+    tail.store(last, std::memory_order_release);
+    return last - first;
+}
+
+size_t TraceRing::get_capacity() const
+{
+    return events.size();
+}
+
+uint64_t TraceRing::get_dropped() const
+{
+    return dropped.load(std::memory_order_relaxed);
+}
+
+TraceRecorder::TraceRecorder(size_t ring_capacity_per_thread):
+        ring_capacity{ring_capacity_per_thread}
+{
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    const std::lock_guard<std::mutex> lock{mutex};
+    for(const auto &ring: rings)
+    {
+        if(thread_ring == ring.get())
+        {
+            thread_ring = nullptr;
+        }
+    }
+}
+
+void TraceRecorder::attach()
+{
+    if(thread_ring != nullptr)
+    {
+        throw std::logic_error("TraceRecorder: thread is already traced");
+    }
+    const std::lock_guard<std::mutex> lock{mutex};
+    if(rings.size() > std::numeric_limits<uint16_t>::max())
+    {
+        throw std::length_error("TraceRecorder: too many traced threads");
+    }
+    rings.push_back(std::make_unique<TraceRing>(ring_capacity, static_cast<uint16_t>(rings.size())));
+    thread_ring = rings.back().get();
+}
+
+void TraceRecorder::detach()
+{
+    thread_ring = nullptr;
+}
+
+void TraceRecorder::collect(std::vector<TraceEvent> &events)
+{
+    const std::lock_guard<std::mutex> lock{mutex};
+    for(const auto &ring: rings)
+    {
+        ring->drain(events);
+    }
+}
+
+uint64_t TraceRecorder::get_dropped() const
+{
+    const std::lock_guard<std::mutex> lock{mutex};
+    uint64_t total = 0;
+    for(const auto &ring: rings)
+    {
+        total += ring->get_dropped();
+    }
+    return total;
+}
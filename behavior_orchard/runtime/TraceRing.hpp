@@ -0,0 +1,127 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "../model/TraceEvent.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Build with ORCHARD_TRACING=0 to compile tracing out of the engines entirely.
+#ifndef ORCHARD_TRACING
+#define ORCHARD_TRACING 1
+#endif
+
+// Fixed-size single-producer single-consumer queue of trace events. The thread which ticks pushes,
+// whoever collects the trace drains; neither ever waits for the other. A full ring drops the new
+// event and counts it instead of blocking the tick.
+class TraceRing
+{
+public:
+    // Capacity is rounded up to a power of two.
+    TraceRing(size_t capacity, uint16_t thread_index);
+
+    TraceRing(const TraceRing &) = delete;
+    TraceRing &operator=(const TraceRing &) = delete;
+
+    // Producer side.
+    void push(uint32_t node, TraceEventType type, TraceResult result) noexcept
+    {
+        const auto position = head.load(std::memory_order_relaxed);
+        if(position - cached_tail > mask)
+        {
+            // Looks full - see how far the consumer got before giving up on the event.
+            cached_tail = tail.load(std::memory_order_acquire);
+            if(position - cached_tail > mask)
+            {
+                dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        events[position & mask] = TraceEvent{node, type, result, thread};
+        head.store(position + 1, std::memory_order_release);
+    }
+
+    // Consumer side; appends everything pushed so far and returns how many events that was.
+    size_t drain(std::vector<TraceEvent> &output);
+
+    size_t get_capacity() const;
+    uint64_t get_dropped() const;
+
+private:
+    std::vector<TraceEvent> events;
+    uint64_t mask;
+    uint16_t thread;
+
+    // Producer and consumer positions live on separate cache lines, so pushing does not bounce the
+    // line the consumer writes (and the other way round).
+    alignas(64) std::atomic<uint64_t> head;
+    uint64_t cached_tail;
+    std::atomic<uint64_t> dropped;
+    alignas(64) std::atomic<uint64_t> tail;
+};
+
+// Owns one ring per traced thread. A thread is traced once it attaches: engines look the ring of the
+// current thread up once per tick, and with no ring attached every trace point is a single branch on a
+// null pointer. Collected events saved with save_trace (io/TraceFile.hpp) open in the editor as a
+// heatmap over the tree.
+class TraceRecorder
+{
+public:
+    explicit TraceRecorder(size_t ring_capacity = size_t{1} << 16);
+    // Threads still attached have to detach before the recorder goes away.
+    ~TraceRecorder();
+
+    TraceRecorder(const TraceRecorder &) = delete;
+    TraceRecorder &operator=(const TraceRecorder &) = delete;
+
+    // Gives the calling thread a ring of its own; throws std::logic_error if it already has one.
+    void attach();
+    // Stops tracing the calling thread. Its ring stays with the recorder until collected.
+    static void detach();
+
+    // Drains every ring, ring by ring; events of one thread keep their order.
+    void collect(std::vector<TraceEvent> &events);
+    uint64_t get_dropped() const;
+
+    static TraceRing *get_thread_ring()
+    {
+        return thread_ring;
+    }
+
+private:
+    static inline thread_local TraceRing *thread_ring = nullptr;
+
+    size_t ring_capacity;
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<TraceRing>> rings;
+};
+
+
@@ -0,0 +1,209 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#include "TreeProfiler.hpp"
+#include "TreeProgram.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace
+{
+    void write_json_string(std::ostream &output, std::string_view text)
+    {
+        output << '"';
+        for(const auto character: text)
+        {
+            switch(character)
+            {
+                case '"':
+                    output << "\\\"";
+                    break;
+                case '\\':
+                    output << "\\\\";
+                    break;
+                case '\n':
+                    output << "\\n";
+                    break;
+                case '\t':
+                    output << "\\t";
+                    break;
+                default:
+                    if(static_cast<unsigned char>(character) < 0x20)
+                    {
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(character));
+                        output << escaped;
+                    }
+                    else
+                    {
+                        output << character;
+                    }
+            }
+        }
+        output << '"';
+    }
+
+    std::string_view get_label(const TreeDocument &document, TreeDocument::id_t id)
+    {
+        const auto node = document.find_by_id(id);
+        return node != TreeDocument::no_node ? document.get_label(node) : std::string_view{};
+    }
+
+    // Microseconds with nanosecond precision, the unit of Chrome trace timestamps.
+    void write_microseconds(std::ostream &output, int64_t nanoseconds)
+    {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%lld.%03lld", static_cast<long long>(nanoseconds / 1000),
+                      static_cast<long long>(nanoseconds % 1000));
+        output << text;
+    }
+}
+
+TreeProfiler::TreeProfiler(const TreeProgram &program, uint32_t sample_every, size_t span_capacity):
+        node_ids(program.get_node_ids().begin(), program.get_node_ids().end()),
+        histograms(program.get_instructions().size()),
+        dropped_spans{0},
+        sample_period{sample_every},
+        ticks{0},
+        origin{std::chrono::steady_clock::now()}
+{
+    if(sample_period == 0)
+    {
+        throw std::invalid_argument("TreeProfiler: sample period has to be at least 1");
+    }
+    node_kinds.reserve(node_ids.size());
+    for(const auto &instruction: program.get_instructions())
+    {
+        node_kinds.push_back(instruction.kind);
+    }
+    // Without cycles no node is entered twice before it exits, so the tree cannot nest deeper.
+    starts.reserve(node_ids.size() + 1);
+    spans.reserve(span_capacity);
+}
+
+size_t TreeProfiler::get_node_count() const
+{
+    return histograms.size();
+}
+
+uint64_t TreeProfiler::get_tick_count() const
+{
+    return ticks;
+}
+
+const LatencyHistogram &TreeProfiler::get_histogram(uint32_t position) const
+{
+    return histograms.at(position);
+}
+
+std::vector<NodeLatency> TreeProfiler::get_latencies() const
+{
+    std::vector<NodeLatency> latencies;
+    for(size_t position = 0; position < histograms.size(); ++position)
+    {
+        if(histograms[position].get_count() > 0)
+        {
+            latencies.push_back(NodeLatency{node_ids[position], histograms[position]});
+        }
+    }
+    return latencies;
+}
+
+const std::vector<TreeProfiler::Span> &TreeProfiler::get_spans() const
+{
+    return spans;
+}
+
+uint64_t TreeProfiler::get_dropped_spans() const
+{
+    return dropped_spans;
+}
+
+void TreeProfiler::clear()
+{
+    for(auto &histogram: histograms)
+    {
+        histogram.clear();
+    }
+    spans.clear();
+    dropped_spans = 0;
+}
+
+void TreeProfiler::write_chrome_trace(std::ostream &output, const TreeDocument &document) const
+{
+    output << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    for(size_t i = 0; i < spans.size(); ++i)
+    {
+        const auto &span = spans[i];
+        output << (i == 0 ? "\n" : ",\n") << "{\"name\":";
+        write_json_string(output, get_label(document, node_ids[span.position]));
+        output << ",\"cat\":\"" << get_node_kind_name(node_kinds[span.position]) << "\",\"ph\":\"X\",\"ts\":";
+        write_microseconds(output, span.start);
+        output << ",\"dur\":";
+        write_microseconds(output, span.duration);
+        output << ",\"pid\":1,\"tid\":1,\"args\":{\"id\":" << node_ids[span.position] << ",\"depth\":" << span.depth
+               << "}}";
+    }
+    output << "\n]}\n";
+}
+
+void TreeProfiler::write_summary(std::ostream &output, const TreeDocument &document) const
+{
+    // Slowest tail first; p99 of every node computed once, not in every comparison.
+    std::vector<std::pair<uint64_t, uint32_t>> timed;
+    for(uint32_t position = 0; position < histograms.size(); ++position)
+    {
+        if(histograms[position].get_count() > 0)
+        {
+            timed.emplace_back(histograms[position].get_percentile(0.99), position);
+        }
+    }
+    std::stable_sort(timed.begin(), timed.end(), [](const auto &left, const auto &right)
+    {
+        return left.first > right.first;
+    });
+
+    char row[160];
+    std::snprintf(row, sizeof(row), "%8s  %-11s  %10s  %10s  %10s  %10s  %10s  %s\n", "id", "kind", "count", "p50", "p99",
+                  "max", "mean", "label");
+    output << row;
+    for(const auto &[p99, position]: timed)
+    {
+        const auto &histogram = histograms[position];
+        std::snprintf(row, sizeof(row), "%8u  %-11s  %10llu  %10s  %10s  %10s  %10s  ", node_ids[position],
+                      get_node_kind_name(node_kinds[position]), static_cast<unsigned long long>(histogram.get_count()),
+                      format_latency(histogram.get_percentile(0.5)).c_str(),
+                      format_latency(p99).c_str(),
+                      format_latency(histogram.get_max()).c_str(),
+                      format_latency(static_cast<uint64_t>(histogram.get_mean())).c_str());
+        output << row << get_label(document, node_ids[position]) << '\n';
+    }
+}
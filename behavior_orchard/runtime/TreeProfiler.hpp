@@ -0,0 +1,120 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "../model/LatencyHistogram.hpp"
+#include "../model/TreeDocument.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+class TreeProgram;
+
+// Times node evaluations of one TreeProgram with the monotonic clock. Every node gets a latency
+// histogram (inclusive of its children) and the first span_capacity evaluations are also kept as
+// spans for a Chrome trace. Everything is allocated up front - a timed tick only reads the clock and
+// writes into existing arrays.
+// Only every sample_period-th tick is timed; the others run as if there were no profiler.
+class TreeProfiler
+{
+public:
+    struct Span
+    {
+        uint32_t position;
+        uint32_t depth;
+        // Nanoseconds since the profiler was created.
+        int64_t start;
+        int64_t duration;
+    };
+
+    // Throws std::invalid_argument for a zero sample period.
+    explicit TreeProfiler(const TreeProgram &program, uint32_t sample_every = 1, size_t span_capacity = 1u << 16);
+
+    // Engines ask once per tick, and time the tick only if the answer is yes.
+    bool begin_tick()
+    {
+        return ticks++ % sample_period == 0;
+    }
+
+    void enter(uint32_t /*position*/) noexcept
+    {
+        starts.push_back(now());
+    }
+
+    void exit(uint32_t position) noexcept
+    {
+        const auto start = starts.back();
+        starts.pop_back();
+        const auto duration = now() - start;
+        histograms[position].record(static_cast<uint64_t>(duration));
+        if(spans.size() < spans.capacity())
+        {
+            spans.push_back(Span{position, static_cast<uint32_t>(starts.size()), start, duration});
+        }
+        else
+        {
+            ++dropped_spans;
+        }
+    }
+
+    size_t get_node_count() const;
+    uint64_t get_tick_count() const;
+    const LatencyHistogram &get_histogram(uint32_t position) const;
+    // Histograms of the nodes timed at least once, by node ID.
+    std::vector<NodeLatency> get_latencies() const;
+    const std::vector<Span> &get_spans() const;
+    uint64_t get_dropped_spans() const;
+    // Forgets histograms and spans; the tick count keeps going.
+    void clear();
+
+    // Chrome trace event format (chrome://tracing, Perfetto): one complete event per span, named after
+    // the node label of the document the program was built from.
+    void write_chrome_trace(std::ostream &output, const TreeDocument &document) const;
+    // Plain text table of the timed nodes, slowest p99 first.
+    void write_summary(std::ostream &output, const TreeDocument &document) const;
+
+private:
+    int64_t now() const noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+    }
+
+    std::vector<TreeDocument::id_t> node_ids;
+    std::vector<NodeKind> node_kinds;
+    std::vector<LatencyHistogram> histograms;
+    // Start times of the nodes being evaluated, outermost first.
+    std::vector<int64_t> starts;
+    std::vector<Span> spans;
+    uint64_t dropped_spans;
+    uint32_t sample_period;
+    uint64_t ticks;
+    std::chrono::steady_clock::time_point origin;
+};
+
+
@@ -0,0 +1,199 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "TreeProgram.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace
+{
+    using index_t = TreeDocument::index_t;
+
+    uint32_t intern_label(std::string_view label, std::unordered_map<std::string_view, uint32_t> &interned,
+                          std::pmr::vector<std::pmr::string> &labels)
+    {
+        const auto known = interned.find(label);
+        if(known != interned.end())
+        {
+            return known->second;
+        }
+        const auto index = static_cast<uint32_t>(labels.size());
+        labels.emplace_back(label);
+        interned.emplace(label, index);
+        return index;
+    }
+
+    bool has_state(NodeKind kind)
+    {
+        return kind == NodeKind::selector || kind == NodeKind::sequence || kind == NodeKind::loop ||
+               kind == NodeKind::max_n_tries;
+    }
+}
+
+TreeProgram::TreeProgram(const TreeDocument &document, std::pmr::memory_resource *resource):
+        instructions{resource},
+        node_ids{resource},
+        slot_count{0},
+        action_labels{resource},
+        condition_labels{resource}
+{
+    if(document.is_empty())
+    {
+        return;
+    }
+
+    // Pre-order positions first; links need the position of any node, not only earlier ones. This
+    // scratch space is freed right away, so it stays on the heap instead of taking up the resource.
+    std::vector<index_t> order;
+    std::vector<uint32_t> positions(document.get_capacity(), UINT32_MAX);
+    order.reserve(document.size());
+    std::vector<index_t> pending{document.get_root()};
+    while(!pending.empty())
+    {
+        const auto node = pending.back();
+        pending.pop_back();
+        positions[node] = static_cast<uint32_t>(order.size());
+        order.push_back(node);
+        for(auto child = document.get_last_child(node); child != TreeDocument::no_node;
+            child = document.get_previous_sibling(child))
+        {
+            pending.push_back(child);
+        }
+    }
+
+    std::unordered_map<std::string_view, uint32_t> interned_actions;
+    std::unordered_map<std::string_view, uint32_t> interned_conditions;
+    instructions.resize(order.size());
+    node_ids.resize(order.size());
+    for(uint32_t position = 0; position < order.size(); ++position)
+    {
+        const auto node = order[position];
+        const auto kind = document.get_kind(node);
+        auto &instruction = instructions[position];
+        instruction.kind = kind;
+        instruction.end = position + 1;
+        instruction.operand = document.get_parameter(node);
+        instruction.slot = has_state(kind) ? static_cast<uint32_t>(slot_count++) : no_slot;
+        node_ids[position] = document.get_id(node);
+
+        const auto label = document.get_label(node);
+        if(get_max_children(kind) == 1 && document.get_child_count(node) == 0)
+        {
+            throw std::invalid_argument("TreeProgram: '" + std::string{label} + "' has no child");
+        }
+        if(kind == NodeKind::action)
+        {
+            instruction.operand = intern_label(label, interned_actions, action_labels);
+        }
+        else if(kind == NodeKind::condition)
+        {
+            instruction.operand = intern_label(label, interned_conditions, condition_labels);
+        }
+        else if(kind == NodeKind::link)
+        {
+            const auto target = document.find_by_id(instruction.operand);
+            if(target == TreeDocument::no_node)
+            {
+                throw std::invalid_argument("TreeProgram: link '" + std::string{label} + "' points to a missing node");
+            }
+            instruction.operand = positions[target];
+        }
+    }
+    // Subtree ends, children before parents.
+    for(auto position = static_cast<uint32_t>(order.size()); position-- > 1;)
+    {
+        const auto parent = positions[document.get_parent(order[position])];
+        instructions[parent].end = std::max(instructions[parent].end, instructions[position].end);
+    }
+}
+
+const std::pmr::vector<TreeProgram::Instruction> &TreeProgram::get_instructions() const
+{
+    return instructions;
+}
+
+size_t TreeProgram::get_slot_count() const
+{
+    return slot_count;
+}
+
+const std::pmr::vector<std::pmr::string> &TreeProgram::get_action_labels() const
+{
+    return action_labels;
+}
+
+const std::pmr::vector<std::pmr::string> &TreeProgram::get_condition_labels() const
+{
+    return condition_labels;
+}
+
+const std::pmr::vector<TreeDocument::id_t> &TreeProgram::get_node_ids() const
+{
+    return node_ids;
+}
+
+TreeProgram::ReactivePlan TreeProgram::make_reactive_plan() const
+{
+    const auto size = static_cast<uint32_t>(instructions.size());
+    ReactivePlan plan;
+    plan.parents.resize(size, no_position);
+    plan.memoizable.resize(size, 1);
+
+    std::vector<uint32_t> open;
+    for(uint32_t position = 0; position < size; ++position)
+    {
+        while(!open.empty() && instructions[open.back()].end <= position)
+        {
+            open.pop_back();
+        }
+        plan.parents[position] = open.empty() ? no_position : open.back();
+        open.push_back(position);
+    }
+
+    const auto exclude_with_ancestors = [&plan](uint32_t position)
+    {
+        for(; position != no_position; position = plan.parents[position])
+        {
+            plan.memoizable[position] = 0;
+        }
+    };
+    for(uint32_t position = 0; position < size; ++position)
+    {
+        const auto &instruction = instructions[position];
+        if(instruction.kind == NodeKind::action)
+        {
+            plan.memoizable[position] = 0;
+        }
+        else if(instruction.kind == NodeKind::link)
+        {
+            // The target and what it contains are entered through themselves either way, and find
+            // their memo there.
+            exclude_with_ancestors(position);
+            exclude_with_ancestors(plan.parents[instruction.operand]);
+        }
+    }
+    return plan;
+}
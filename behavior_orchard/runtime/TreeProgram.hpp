@@ -0,0 +1,543 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include "../model/TreeDocument.hpp"
+#include "TraceRing.hpp"
+#include "TreeProfiler.hpp"
+
+#include "IBehavior.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+// Tracing stores BehaviorState as TraceResult by value.
+static_assert(static_cast<int>(TraceResult::undefined) == static_cast<int>(BehaviorState::undefined),
+              "TraceResult has to keep the values of BehaviorState");
+static_assert(static_cast<int>(TraceResult::success) == static_cast<int>(BehaviorState::success),
+              "TraceResult has to keep the values of BehaviorState");
+static_assert(static_cast<int>(TraceResult::failure) == static_cast<int>(BehaviorState::failure),
+              "TraceResult has to keep the values of BehaviorState");
+static_assert(static_cast<int>(TraceResult::running) == static_cast<int>(BehaviorState::running),
+              "TraceResult has to keep the values of BehaviorState");
+
+// Tree flattened into one array in pre-order, the immutable part shared by every engine and every
+// agent which ticks the tree. A node's subtree is the range [position, end) of the array, so children
+// are found by skipping: first child right after the parent, next sibling at the end of the previous
+// one. Actions and conditions are referred to by index; callers bind the indices to callbacks by
+// label.
+// Evaluation matches the bt classes:
+//   Selector / Sequence - children in order until one succeeds / fails or runs; a running child is
+//                         remembered and the next tick resumes from it
+//   Invert              - swaps success and failure
+//   Loop                - every finished evaluation of the child counts; running until the count is
+//                         reached, then the child's last result (and the count starts over)
+//   MaxNTries           - counts failures of the child; once there were count of them, fails without
+//                         evaluating the child
+//   Link                - evaluates the linked node, sharing its state
+// Running children and counters are the only mutable state; each stateful node owns one slot of it,
+// so the whole state of one tick is a small array of slots owned by the caller.
+// Ticks on a thread attached to a TraceRecorder record entering and leaving every node; ticks given a
+// TreeProfiler time every node.
+// The arrays and labels come from the memory resource given on construction. Trees built together,
+// e.g. for a level, can share a std::pmr::monotonic_buffer_resource: each one is then a few
+// allocations carved next to the previous tree, and releasing the resource frees all of them at once.
+class TreeProgram
+{
+public:
+    static constexpr uint32_t no_slot = UINT32_MAX;
+    static constexpr uint32_t no_position = UINT32_MAX;
+
+    struct Instruction
+    {
+        NodeKind kind;
+        // Position right after the subtree of this node.
+        uint32_t end;
+        // Loop or try count, link target position, or index of the action or condition.
+        uint32_t operand;
+        uint32_t slot;
+    };
+
+    // What reactive evaluation needs to know about the program, made by make_reactive_plan.
+    struct ReactivePlan
+    {
+        // Position of the parent of each node, no_position for the root; links are not parents.
+        std::vector<uint32_t> parents;
+        // Non-zero where the result of a node may be kept from one tick to the next. Not for actions,
+        // nor for what a link could change behind its back: links and whatever contains a link or the
+        // target of one.
+        std::vector<uint8_t> memoizable;
+    };
+
+    // Throws std::invalid_argument for a decorator without child or a link pointing nowhere.
+    // The resource has to outlive the program.
+    explicit TreeProgram(const TreeDocument &document,
+                         std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+    const std::pmr::vector<Instruction> &get_instructions() const;
+    size_t get_slot_count() const;
+    // Distinct labels, by the index instructions use.
+    const std::pmr::vector<std::pmr::string> &get_action_labels() const;
+    const std::pmr::vector<std::pmr::string> &get_condition_labels() const;
+    // Document ID of the node at each position.
+    const std::pmr::vector<TreeDocument::id_t> &get_node_ids() const;
+    ReactivePlan make_reactive_plan() const;
+
+    // Ticks once over the given slots (get_slot_count of them, zeroed before the first tick). Stack is
+    // scratch space, kept by the caller to avoid allocating. Primitives provides
+    //     BehaviorState run_action(uint32_t index);
+    //     bool check_condition(uint32_t index);
+    // Profiler, when given, has to be made for this program and times the tick whatever its sampling.
+    template<typename Primitives>
+    BehaviorState evaluate(uint32_t *slots, std::pmr::vector<uint32_t> &stack, Primitives &primitives,
+                           TreeProfiler *profiler = nullptr) const;
+
+    // Ticks once like evaluate, but gives the same result without walking subtrees whose result is
+    // known. Memo holds a result per position (undefined for none, as before the first tick): a
+    // subtree is remembered when its evaluation ran no action, changed no slot and checked only
+    // tracked conditions - those promising the same answer until the caller clears the memo of every
+    // position from them up to the root (see ReactivePlan::parents). Evaluating such a subtree again
+    // would call the same conditions and come to the same result, so it is skipped; everything
+    // reaching an action or a counter is walked as evaluate walks it. Primitives provides, on top of
+    // what evaluate needs,
+    //     bool is_tracked(uint32_t condition_index);
+    // Skipped subtrees leave no trace events.
+    template<typename Primitives>
+    BehaviorState evaluate_reactive(uint32_t *slots, BehaviorState *memo, const ReactivePlan &plan,
+                                    std::pmr::vector<uint32_t> &stack, Primitives &primitives) const;
+
+private:
+    void enter(TraceRing *ring, TreeProfiler *profiler, uint32_t position) const
+    {
+        if(ring != nullptr)
+        {
+            ring->push(node_ids[position], TraceEventType::enter, TraceResult::undefined);
+        }
+        if(profiler != nullptr)
+        {
+            profiler->enter(position);
+        }
+    }
+
+    void exit(TraceRing *ring, TreeProfiler *profiler, uint32_t position, BehaviorState result) const
+    {
+        if(profiler != nullptr)
+        {
+            profiler->exit(position);
+        }
+        if(ring != nullptr)
+        {
+            ring->push(node_ids[position], TraceEventType::exit, static_cast<TraceResult>(result));
+        }
+    }
+
+    std::pmr::vector<Instruction> instructions;
+    std::pmr::vector<TreeDocument::id_t> node_ids;
+    size_t slot_count;
+    std::pmr::vector<std::pmr::string> action_labels;
+    std::pmr::vector<std::pmr::string> condition_labels;
+};
+
+template<typename Primitives>
+BehaviorState TreeProgram::evaluate(uint32_t *slots, std::pmr::vector<uint32_t> &stack, Primitives &primitives,
+                                    TreeProfiler *profiler) const
+{
+    if(instructions.empty())
+    {
+        return BehaviorState::undefined;
+    }
+
+#if ORCHARD_TRACING
+    TraceRing *const ring = TraceRecorder::get_thread_ring();
+#else
+    constexpr TraceRing *ring = nullptr;
+#endif
+
+    stack.clear();
+    uint32_t position = 0;
+    auto result = BehaviorState::undefined;
+    bool returning = false;
+    while(true)
+    {
+        if(!returning)
+        {
+            // Entering the node at position: either descend into a child or produce a result.
+            const auto &instruction = instructions[position];
+            enter(ring, profiler, position);
+            returning = true;
+            switch(instruction.kind)
+            {
+                case NodeKind::selector:
+                case NodeKind::sequence:
+                {
+                    // Slot holds the position of the running child; zero (the root) means none.
+                    const auto resume = slots[instruction.slot];
+                    const auto child = resume != 0 ? resume : position + 1;
+                    if(child == instruction.end)
+                    {
+                        result = instruction.kind == NodeKind::selector ? BehaviorState::failure : BehaviorState::success;
+                        break;
+                    }
+                    stack.push_back(position);
+                    position = child;
+                    returning = false;
+                    break;
+                }
+                case NodeKind::action:
+                    result = primitives.run_action(instruction.operand);
+                    break;
+                case NodeKind::condition:
+                    result = primitives.check_condition(instruction.operand) ? BehaviorState::success : BehaviorState::failure;
+                    break;
+                case NodeKind::link:
+                    stack.push_back(position);
+                    position = instruction.operand;
+                    returning = false;
+                    break;
+                case NodeKind::max_n_tries:
+                    if(slots[instruction.slot] >= instruction.operand)
+                    {
+                        result = BehaviorState::failure;
+                        break;
+                    }
+                    [[fallthrough]];
+                case NodeKind::invert:
+                case NodeKind::loop:
+                    stack.push_back(position);
+                    position = position + 1;
+                    returning = false;
+                    break;
+            }
+            continue;
+        }
+
+        // Returning the result of the node at position to its parent on the stack.
+        exit(ring, profiler, position, result);
+        if(stack.empty())
+        {
+            return result;
+        }
+        const auto parent = stack.back();
+        const auto &instruction = instructions[parent];
+        switch(instruction.kind)
+        {
+            case NodeKind::selector:
+            case NodeKind::sequence:
+            {
+                const auto go_on = instruction.kind == NodeKind::selector ? BehaviorState::failure : BehaviorState::success;
+                // Primitive children are evaluated right here; only inner nodes go round the loop.
+                auto next = instructions[position].end;
+                while(result == go_on && next != instruction.end)
+                {
+                    const auto &child = instructions[next];
+                    if(child.kind == NodeKind::action)
+                    {
+                        enter(ring, profiler, next);
+                        result = primitives.run_action(child.operand);
+                    }
+                    else if(child.kind == NodeKind::condition)
+                    {
+                        enter(ring, profiler, next);
+                        result = primitives.check_condition(child.operand) ? BehaviorState::success : BehaviorState::failure;
+                    }
+                    else
+                    {
+                        break;
+                    }
+                    exit(ring, profiler, next, result);
+                    position = next;
+                    next = child.end;
+                }
+                if(result == go_on && next != instruction.end)
+                {
+                    position = next;
+                    returning = false;
+                    continue;
+                }
+                slots[instruction.slot] = result == BehaviorState::running ? position : 0;
+                break;
+            }
+            case NodeKind::invert:
+                if(result == BehaviorState::success)
+                {
+                    result = BehaviorState::failure;
+                }
+                else if(result == BehaviorState::failure)
+                {
+                    result = BehaviorState::success;
+                }
+                break;
+            case NodeKind::loop:
+                if(result != BehaviorState::running)
+                {
+                    auto &iterations = slots[instruction.slot];
+                    if(++iterations < instruction.operand)
+                    {
+                        result = BehaviorState::running;
+                    }
+                    else
+                    {
+                        iterations = 0;
+                    }
+                }
+                break;
+            case NodeKind::max_n_tries:
+                if(result == BehaviorState::failure)
+                {
+                    ++slots[instruction.slot];
+                }
+                break;
+            default:
+                // Link passes the result through; primitives are never parents.
+                break;
+        }
+        stack.pop_back();
+        position = parent;
+    }
+}
+
+template<typename Primitives>
+BehaviorState TreeProgram::evaluate_reactive(uint32_t *slots, BehaviorState *memo, const ReactivePlan &plan,
+                                             std::pmr::vector<uint32_t> &stack, Primitives &primitives) const
+{
+    if(instructions.empty())
+    {
+        return BehaviorState::undefined;
+    }
+
+#if ORCHARD_TRACING
+    TraceRing *const ring = TraceRecorder::get_thread_ring();
+#else
+    constexpr TraceRing *ring = nullptr;
+#endif
+
+    stack.clear();
+    uint32_t position = 0;
+    auto result = BehaviorState::undefined;
+    bool returning = false;
+    // Result of the node at position is already final: remembered, or a primitive done on entry.
+    bool settled = false;
+    // Whether the evaluation of the node at position so far had effects, and how many nodes on the
+    // stack had them - an effect taints every node evaluating at the time, which is the stack.
+    bool tainted = false;
+    size_t tainted_depth = 0;
+
+    // Primitive at the given position, whose parent is on top of the stack (or which is the root).
+    const auto run_primitive = [&](uint32_t at)
+    {
+        const auto &primitive = instructions[at];
+        enter(ring, nullptr, at);
+        BehaviorState state;
+        bool pure;
+        if(primitive.kind == NodeKind::action)
+        {
+            state = primitives.run_action(primitive.operand);
+            pure = false;
+        }
+        else
+        {
+            state = primitives.check_condition(primitive.operand) ? BehaviorState::success : BehaviorState::failure;
+            pure = primitives.is_tracked(primitive.operand);
+        }
+        exit(ring, nullptr, at, state);
+        if(!pure)
+        {
+            tainted_depth = stack.size();
+        }
+        else if(plan.memoizable[at] != 0)
+        {
+            memo[at] = state;
+        }
+        return state;
+    };
+
+    while(true)
+    {
+        if(!returning)
+        {
+            returning = true;
+            tainted = false;
+            settled = memo[position] != BehaviorState::undefined;
+            if(settled)
+            {
+                result = memo[position];
+                continue;
+            }
+            const auto &instruction = instructions[position];
+            switch(instruction.kind)
+            {
+                case NodeKind::selector:
+                case NodeKind::sequence:
+                {
+                    enter(ring, nullptr, position);
+                    const auto resume = slots[instruction.slot];
+                    const auto child = resume != 0 ? resume : position + 1;
+                    if(child == instruction.end)
+                    {
+                        result = instruction.kind == NodeKind::selector ? BehaviorState::failure : BehaviorState::success;
+                        break;
+                    }
+                    stack.push_back(position);
+                    position = child;
+                    returning = false;
+                    break;
+                }
+                case NodeKind::action:
+                case NodeKind::condition:
+                    result = run_primitive(position);
+                    settled = true;
+                    break;
+                case NodeKind::link:
+                    enter(ring, nullptr, position);
+                    stack.push_back(position);
+                    position = instruction.operand;
+                    returning = false;
+                    break;
+                case NodeKind::max_n_tries:
+                    enter(ring, nullptr, position);
+                    if(slots[instruction.slot] >= instruction.operand)
+                    {
+                        result = BehaviorState::failure;
+                        break;
+                    }
+                    stack.push_back(position);
+                    position = position + 1;
+                    returning = false;
+                    break;
+                case NodeKind::invert:
+                case NodeKind::loop:
+                    enter(ring, nullptr, position);
+                    stack.push_back(position);
+                    position = position + 1;
+                    returning = false;
+                    break;
+            }
+            continue;
+        }
+
+        if(!settled)
+        {
+            exit(ring, nullptr, position, result);
+            if(!tainted && plan.memoizable[position] != 0)
+            {
+                memo[position] = result;
+            }
+        }
+        if(stack.empty())
+        {
+            return result;
+        }
+        const auto parent = stack.back();
+        const auto &instruction = instructions[parent];
+        // Changing a slot is an effect of the parent, and so of everything on the stack.
+        const auto set_slot = [&](uint32_t value)
+        {
+            auto &slot = slots[instruction.slot];
+            if(slot != value)
+            {
+                slot = value;
+                tainted_depth = stack.size();
+            }
+        };
+        switch(instruction.kind)
+        {
+            case NodeKind::selector:
+            case NodeKind::sequence:
+            {
+                const auto go_on = instruction.kind == NodeKind::selector ? BehaviorState::failure : BehaviorState::success;
+                auto next = instructions[position].end;
+                while(result == go_on && next != instruction.end)
+                {
+                    const auto &child = instructions[next];
+                    if(memo[next] != BehaviorState::undefined)
+                    {
+                        result = memo[next];
+                    }
+                    else if(child.kind == NodeKind::action || child.kind == NodeKind::condition)
+                    {
+                        result = run_primitive(next);
+                    }
+                    else
+                    {
+                        break;
+                    }
+                    position = next;
+                    next = child.end;
+                }
+                if(result == go_on && next != instruction.end)
+                {
+                    position = next;
+                    returning = false;
+                    continue;
+                }
+                set_slot(result == BehaviorState::running ? position : 0);
+                break;
+            }
+            case NodeKind::invert:
+                if(result == BehaviorState::success)
+                {
+                    result = BehaviorState::failure;
+                }
+                else if(result == BehaviorState::failure)
+                {
+                    result = BehaviorState::success;
+                }
+                break;
+            case NodeKind::loop:
+                if(result != BehaviorState::running)
+                {
+                    const auto iterations = slots[instruction.slot] + 1;
+                    if(iterations < instruction.operand)
+                    {
+                        result = BehaviorState::running;
+                        set_slot(iterations);
+                    }
+                    else
+                    {
+                        set_slot(0);
+                    }
+                }
+                break;
+            case NodeKind::max_n_tries:
+                if(result == BehaviorState::failure)
+                {
+                    set_slot(slots[instruction.slot] + 1);
+                }
+                break;
+            default:
+                break;
+        }
+        stack.pop_back();
+        position = parent;
+        settled = false;
+        tainted = stack.size() < tainted_depth;
+        tainted_depth = std::min(tainted_depth, stack.size());
+    }
+}
+
+
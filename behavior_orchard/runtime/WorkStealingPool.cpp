@@ -0,0 +1,178 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "WorkStealingPool.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+WorkStealingPool::WorkStealingPool(size_t thread_count):
+        generation{0},
+        chunks_left{0},
+        stopping{false}
+{
+    if(thread_count == 0)
+    {
+        thread_count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    for(size_t worker = 0; worker < thread_count; ++worker)
+    {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for(size_t worker = 1; worker < thread_count; ++worker)
+    {
+        threads.emplace_back([this, worker]
+                             {
+                                 uint64_t seen = 0;
+                                 while(true)
+                                 {
+                                     {
+                                         std::unique_lock<std::mutex> lock{state_mutex};
+                                         work_ready.wait(lock, [&] { return stopping || generation != seen; });
+                                         if(stopping)
+                                         {
+                                             return;
+                                         }
+                                         seen = generation;
+                                     }
+                                     work(worker);
+                                 }
+                             });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock{state_mutex};
+        stopping = true;
+    }
+    work_ready.notify_all();
+    for(auto &thread: threads)
+    {
+        thread.join();
+    }
+}
+
+size_t WorkStealingPool::get_thread_count() const
+{
+    return queues.size();
+}
+
+void WorkStealingPool::parallel_for(size_t count, size_t grain, const Body &body)
+{
+    if(count == 0)
+    {
+        return;
+    }
+    if(grain == 0)
+    {
+        throw std::invalid_argument("WorkStealingPool: grain has to be positive");
+    }
+    const auto chunk_count = (count + grain - 1) / grain;
+    if(chunk_count == 1 || queues.size() == 1)
+    {
+        body(0, count, 0);
+        return;
+    }
+
+    // Counted before any chunk is visible, so workers can never finish more than were announced.
+    {
+        std::lock_guard<std::mutex> lock{state_mutex};
+        chunks_left = chunk_count;
+    }
+    // Contiguous runs of chunks per worker keep neighbouring indices - and their memory - together.
+    const auto per_worker = (chunk_count + queues.size() - 1) / queues.size();
+    for(size_t chunk = 0; chunk < chunk_count; ++chunk)
+    {
+        const auto begin = chunk * grain;
+        auto &queue = *queues[chunk / per_worker];
+        std::lock_guard<std::mutex> lock{queue.mutex};
+        queue.chunks.push_back({&body, begin, std::min(begin + grain, count)});
+    }
+    {
+        std::lock_guard<std::mutex> lock{state_mutex};
+        ++generation;
+    }
+    work_ready.notify_all();
+
+    work(0);
+    std::unique_lock<std::mutex> lock{state_mutex};
+    work_done.wait(lock, [this] { return chunks_left == 0; });
+}
+
+void WorkStealingPool::work(size_t worker)
+{
+    size_t done = 0;
+    Chunk chunk{};
+    while(take(worker, chunk) || steal(worker, chunk))
+    {
+        (*chunk.body)(chunk.begin, chunk.end, worker);
+        ++done;
+    }
+    finish(done);
+}
+
+bool WorkStealingPool::take(size_t worker, Chunk &chunk)
+{
+    auto &queue = *queues[worker];
+    std::lock_guard<std::mutex> lock{queue.mutex};
+    if(queue.chunks.empty())
+    {
+        return false;
+    }
+    chunk = queue.chunks.back();
+    queue.chunks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(size_t thief, Chunk &chunk)
+{
+    for(size_t offset = 1; offset < queues.size(); ++offset)
+    {
+        auto &queue = *queues[(thief + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock{queue.mutex};
+        if(!queue.chunks.empty())
+        {
+            chunk = queue.chunks.front();
+            queue.chunks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::finish(size_t chunk_count)
+{
+    if(chunk_count == 0)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock{state_mutex};
+    chunks_left -= chunk_count;
+    if(chunks_left == 0)
+    {
+        work_done.notify_all();
+    }
+}
@@ -0,0 +1,91 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data-parallel loops. A loop is cut into chunks which are dealt
+// round-robin to per-worker deques; a worker takes chunks from the back of its own deque and, once
+// that is empty, steals from the front of the others - so uneven chunks (agents running deep
+// branches next to idle ones) still keep every core busy. The calling thread works as worker 0.
+class WorkStealingPool
+{
+public:
+    // Body gets the range of indices of one chunk and the worker which runs it (below get_thread_count).
+    using Body = std::function<void(size_t begin, size_t end, size_t worker)>;
+
+    // Zero means one thread per core.
+    explicit WorkStealingPool(size_t thread_count = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    size_t get_thread_count() const;
+
+    // Runs body over [0, count) in chunks of at most grain indices and returns when all are done.
+    // Not reentrant: body must not call parallel_for of the same pool, and must not throw.
+    void parallel_for(size_t count, size_t grain, const Body &body);
+
+private:
+    // Carries its body: a worker which wakes up late may already be taking chunks of the next loop.
+    struct Chunk
+    {
+        const Body *body;
+        size_t begin;
+        size_t end;
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Chunk> chunks;
+    };
+
+    void work(size_t worker);
+    bool take(size_t worker, Chunk &chunk);
+    bool steal(size_t thief, Chunk &chunk);
+    void finish(size_t chunk_count);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex state_mutex;
+    std::condition_variable work_ready;
+    std::condition_variable work_done;
+    uint64_t generation;
+    size_t chunks_left;
+    bool stopping;
+};
+
+
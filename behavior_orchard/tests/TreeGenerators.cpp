@@ -0,0 +1,212 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#include "TreeGenerators.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using index_t = TreeDocument::index_t;
+
+    class Generator
+    {
+    public:
+        Generator(TreeDocument &target, uint32_t seed):
+                document{target},
+                random{seed}
+        {
+            document.clear();
+        }
+
+        index_t add_root(NodeKind kind)
+        {
+            return document.add_node(TreeDocument::no_node, kind, "root");
+        }
+
+        index_t add_composite(index_t parent)
+        {
+            return document.add_node(parent, pick(2) == 0 ? NodeKind::selector : NodeKind::sequence,
+                                     "composite " + std::to_string(document.get_next_id()));
+        }
+
+        index_t add_primitive(index_t parent, NodeKind kind)
+        {
+            const auto name = kind == NodeKind::action ? "action " : "condition ";
+            return document.add_node(parent, kind, name + std::to_string(pick(generated_callback_count)));
+        }
+
+        index_t add_primitive(index_t parent)
+        {
+            return add_primitive(parent, pick(2) == 0 ? NodeKind::action : NodeKind::condition);
+        }
+
+        // Decorator with its child already in place; returns the decorator.
+        index_t add_decorated(index_t parent)
+        {
+            static constexpr NodeKind decorators[] = {NodeKind::invert, NodeKind::loop, NodeKind::max_n_tries};
+            const auto kind = decorators[pick(3)];
+            const auto parameter = kind == NodeKind::invert ? 0 : pick(3) + 1;
+            const auto decorator = document.add_node(parent, kind, get_node_kind_name(kind), parameter);
+            add_primitive(decorator);
+            return decorator;
+        }
+
+        // Link to one of the finished branches, or a primitive while there is none yet.
+        index_t add_link(index_t parent)
+        {
+            if(finished.empty())
+            {
+                return add_primitive(parent);
+            }
+            const auto target = finished[pick(static_cast<uint32_t>(finished.size()))];
+            return document.add_node(parent, NodeKind::link, "link", document.get_id(target));
+        }
+
+        void finish(index_t branch)
+        {
+            finished.push_back(branch);
+        }
+
+        uint32_t pick(uint32_t count)
+        {
+            return static_cast<uint32_t>(random() % count);
+        }
+
+        TreeDocument &document;
+
+    private:
+        std::mt19937 random;
+        // Completed subtrees: never an ancestor of what is built later, so safe targets for links.
+        std::vector<index_t> finished;
+    };
+
+    void grow_branch(Generator &generator, index_t parent, uint32_t depth, size_t node_count)
+    {
+        constexpr uint32_t max_depth = 12;
+        auto &document = generator.document;
+        const auto branch = document.add_node(parent, NodeKind::sequence, "branch");
+        for(auto guard = generator.pick(3) + 1; guard > 0; --guard)
+        {
+            generator.add_primitive(branch, NodeKind::condition);
+        }
+
+        const auto choice = generator.pick(10);
+        if(choice < 4 && depth < max_depth && document.size() < node_count)
+        {
+            const auto selector = document.add_node(branch, NodeKind::selector, "options");
+            for(auto option = generator.pick(5) + 2; option > 0 && document.size() < node_count; --option)
+            {
+                grow_branch(generator, selector, depth + 1, node_count);
+            }
+            generator.add_primitive(selector, NodeKind::action);
+        }
+        else if(choice < 7)
+        {
+            generator.add_primitive(branch, NodeKind::action);
+        }
+        else if(choice < 9)
+        {
+            generator.add_decorated(branch);
+        }
+        else
+        {
+            generator.add_link(branch);
+        }
+        generator.finish(branch);
+    }
+}
+
+void generate_deep_tree(TreeDocument &document, size_t node_count, uint32_t seed)
+{
+    Generator generator{document, seed};
+    auto parent = generator.add_root(NodeKind::sequence);
+    while(document.size() + 2 < node_count)
+    {
+        if(generator.pick(2) == 0)
+        {
+            static constexpr NodeKind decorators[] = {NodeKind::invert, NodeKind::loop, NodeKind::max_n_tries};
+            const auto kind = decorators[generator.pick(3)];
+            parent = document.add_node(parent, kind, get_node_kind_name(kind), kind == NodeKind::invert ? 0u : 1u);
+        }
+        else
+        {
+            parent = document.add_node(parent, NodeKind::sequence, "sequence");
+            generator.add_primitive(parent, NodeKind::condition);
+        }
+    }
+    generator.add_primitive(parent, NodeKind::action);
+}
+
+void generate_wide_tree(TreeDocument &document, size_t node_count, uint32_t seed)
+{
+    Generator generator{document, seed};
+    const auto root = generator.add_root(NodeKind::selector);
+    const auto fan_out = std::max<size_t>(1, static_cast<size_t>(std::sqrt(static_cast<double>(node_count))));
+    while(document.size() < node_count)
+    {
+        const auto group = generator.add_composite(root);
+        for(size_t child = 0; child < fan_out && document.size() < node_count; ++child)
+        {
+            generator.add_primitive(group);
+        }
+    }
+}
+
+void generate_realistic_tree(TreeDocument &document, size_t node_count, uint32_t seed)
+{
+    Generator generator{document, seed};
+    const auto root = generator.add_root(NodeKind::selector);
+    while(document.size() < node_count)
+    {
+        grow_branch(generator, root, 1, node_count);
+    }
+}
+
+BehaviorCallbacks make_generated_callbacks()
+{
+    // Per-callback call counters, shared by the copies of the callbacks.
+    const auto calls = std::make_shared<std::vector<uint32_t>>(2 * generated_callback_count, 0);
+    BehaviorCallbacks callbacks;
+    for(uint32_t callback = 0; callback < generated_callback_count; ++callback)
+    {
+        callbacks.actions["action " + std::to_string(callback)] = [calls, callback]
+        {
+            static constexpr BehaviorState results[] = {BehaviorState::success, BehaviorState::failure,
+                                                        BehaviorState::running};
+            return results[((*calls)[callback]++ + callback) % 3];
+        };
+        callbacks.conditions["condition " + std::to_string(callback)] = [calls, callback]
+        {
+            return ((*calls)[generated_callback_count + callback]++ + callback) % 4 != 0;
+        };
+    }
+    return callbacks;
+}
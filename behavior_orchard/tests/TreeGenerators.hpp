@@ -0,0 +1,56 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "../model/BehaviorTreeBridge.hpp"
+#include "../model/TreeDocument.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+// Seeded synthetic trees for tests and benchmarks; the same seed always gives the same tree. Every
+// tree is valid - decorators have their child, links point to a finished subtree built before them -
+// so it runs on BehaviorTree, CompiledTree and AgentBatch alike. Primitives are labelled
+// "action N" / "condition N" with N below generated_callback_count. Generators replace the content
+// of the document and stop at (or a few nodes past) the requested size.
+
+constexpr uint32_t generated_callback_count = 8;
+
+// One long chain: decorators stacked on sequences which start with a condition; depth is about two
+// thirds of the size.
+void generate_deep_tree(TreeDocument &document, size_t node_count, uint32_t seed);
+// Three levels: a root selector over about sqrt(size) sequences of about sqrt(size) primitives.
+void generate_wide_tree(TreeDocument &document, size_t node_count, uint32_t seed);
+// Shaped like game AI: a root selector over branches of guard conditions followed by an action, a
+// nested selector, a decorated primitive or a link to a shared branch; fan-out 2-6, depth up to 12.
+void generate_realistic_tree(TreeDocument &document, size_t node_count, uint32_t seed);
+
+// Callbacks for the labels above. Answers follow a fixed per-callback pattern - actions cycle through
+// success, failure and running, conditions hold three times out of four - so every engine fed from
+// a fresh copy sees the same answers for the same calls.
+BehaviorCallbacks make_generated_callbacks();
+
+
@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+# This file is distributed under MIT License.
+#
+# Copyright (c) 2020 draghan
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Compares two benchmark runs of the tests executable written by the Catch2 XML reporter:
+
+    tests "[benchmarks]" --reporter xml --out current.xml
+    compare_benchmarks.py baseline.xml current.xml --threshold 10
+
+A benchmark regresses when its mean grew by more than the threshold (in percent) and the
+confidence intervals of the two runs do not overlap, so that noise alone does not fail the check.
+Exits with 1 if anything regressed; benchmarks present in only one of the files are listed but do
+not fail. With --update, a missing baseline is created from the current run."""
+
+import argparse
+import shutil
+import sys
+import xml.etree.ElementTree as ElementTree
+
+
+def read_results(path):
+    """Maps "test case / benchmark" to (mean, lower bound, upper bound) in nanoseconds."""
+    results = {}
+    for test_case in ElementTree.parse(path).getroot().iter('TestCase'):
+        for benchmark in test_case.iter('BenchmarkResults'):
+            mean = benchmark.find('mean')
+            key = test_case.get('name') + ' / ' + benchmark.get('name')
+            results[key] = (float(mean.get('value')), float(mean.get('lowerBound')), float(mean.get('upperBound')))
+    return results
+
+
+def format_time(nanoseconds):
+    for unit, scale in (('s', 1e9), ('ms', 1e6), ('us', 1e3)):
+        if nanoseconds >= scale:
+            return '%.2f %s' % (nanoseconds / scale, unit)
+    return '%.1f ns' % nanoseconds
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('baseline', help='XML report of the reference run')
+    parser.add_argument('current', help='XML report of the run to check')
+    parser.add_argument('--threshold', type=float, default=10.0, help='allowed slowdown in percent (default 10)')
+    parser.add_argument('--update', action='store_true', help='create the baseline from the current run if missing')
+    arguments = parser.parse_args()
+
+    current = read_results(arguments.current)
+    try:
+        baseline = read_results(arguments.baseline)
+    except FileNotFoundError:
+        if not arguments.update:
+            raise
+        shutil.copyfile(arguments.current, arguments.baseline)
+        print('baseline %s created with %d benchmarks' % (arguments.baseline, len(current)))
+        return 0
+
+    regressions = 0
+    width = max((len(key) for key in current), default=0)
+    for key in sorted(current.keys() & baseline.keys()):
+        old_mean, old_lower, old_upper = baseline[key]
+        new_mean, new_lower, new_upper = current[key]
+        change = (new_mean - old_mean) / old_mean * 100.0 if old_mean > 0 else 0.0
+        regressed = change > arguments.threshold and new_lower > old_upper
+        regressions += regressed
+        print('%-*s  %10s -> %10s  %+7.1f%%%s' % (width, key, format_time(old_mean), format_time(new_mean), change,
+                                                  '  REGRESSION' if regressed else ''))
+    for key in sorted(current.keys() - baseline.keys()):
+        print('%-*s  new, %s' % (width, key, format_time(current[key][0])))
+    for key in sorted(baseline.keys() - current.keys()):
+        print('%-*s  missing from the current run' % (width, key))
+
+    if regressions:
+        print('%d benchmarks slower by more than %.0f%%' % (regressions, arguments.threshold))
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
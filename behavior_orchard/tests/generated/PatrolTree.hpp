@@ -0,0 +1,56 @@
+// Generated by Behavior Orchard from a tree of 11 nodes.
+// Do not edit - change the tree and use Generate Code again.
+
+#pragma once
+
+#include "StaticTree.hpp"
+
+// Agent has to provide:
+//     BehaviorState attack();
+//     BehaviorState patrol();
+//     bool see_enemy();
+//     bool tired();
+
+template<typename Agent>
+class PatrolTree
+{
+public:
+    BehaviorState evaluate(Agent &agent)
+    {
+        return Root::evaluate(agent, counters);
+    }
+
+    // Forgets running children and zeroes counters.
+    void reset()
+    {
+        counters.fill(0);
+    }
+
+private:
+    using Counters = static_tree::Counters<5>;
+
+    static BehaviorState node_1(Agent &agent, Counters &state);
+
+    using Node1 =
+        static_tree::Sequence<0,
+            static_tree::Condition<&Agent::see_enemy>,
+            static_tree::MaxNTries<1, 5,
+                static_tree::Action<&Agent::attack>>>;
+    using Root =
+        static_tree::Selector<2,
+            Node1,
+            static_tree::Loop<3, 2,
+                static_tree::Invert<
+                    static_tree::Action<&Agent::patrol>>>,
+            static_tree::Sequence<4,
+                static_tree::Condition<&Agent::tired>,
+                static_tree::Link<&PatrolTree::node_1>>>;
+
+    Counters counters{};
+};
+
+template<typename Agent>
+BehaviorState PatrolTree<Agent>::node_1(Agent &agent, Counters &state)
+{
+    return Node1::evaluate(agent, state);
+}
@@ -0,0 +1,447 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "catch.hpp"
+
+#include "TreeGenerators.hpp"
+#include "../runtime/AgentBatch.hpp"
+#include "../runtime/CompiledTree.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    TreeDocument make_guard_tree()
+    {
+        TreeDocument document;
+        const auto root = document.add_node(TreeDocument::no_node, NodeKind::selector, "root");
+        const auto fight = document.add_node(root, NodeKind::sequence, "fight");
+        document.add_node(fight, NodeKind::condition, "enemy near");
+        const auto tries = document.add_node(fight, NodeKind::max_n_tries, "tries", 3);
+        document.add_node(tries, NodeKind::action, "attack");
+        const auto patrol = document.add_node(root, NodeKind::loop, "patrol", 4);
+        document.add_node(patrol, NodeKind::action, "walk");
+        const auto rest = document.add_node(root, NodeKind::sequence, "rest");
+        document.add_node(rest, NodeKind::condition, "tired");
+        document.add_node(rest, NodeKind::link, "fight again", document.get_id(fight));
+        return document;
+    }
+
+    // Answers of agent's callbacks depend on the agent and on how often it was asked.
+    struct AgentScript
+    {
+        BehaviorState attack(size_t agent)
+        {
+            return (++calls + agent) % 3 == 0 ? BehaviorState::success : BehaviorState::running;
+        }
+
+        BehaviorState walk(size_t agent)
+        {
+            return (++calls * 7 + agent) % 5 == 0 ? BehaviorState::failure : BehaviorState::success;
+        }
+
+        bool enemy_near(size_t agent)
+        {
+            return (++calls + agent) % 4 < 2;
+        }
+
+        bool tired(size_t agent)
+        {
+            return (++calls * 3 + agent) % 2 == 0;
+        }
+
+        uint32_t calls = 0;
+    };
+
+    AgentCallbacks bind_agent_callbacks(std::vector<AgentScript> &scripts)
+    {
+        AgentCallbacks callbacks;
+        callbacks.actions["attack"] = [&scripts](size_t agent) { return scripts[agent].attack(agent); };
+        callbacks.actions["walk"] = [&scripts](size_t agent) { return scripts[agent].walk(agent); };
+        callbacks.conditions["enemy near"] = [&scripts](size_t agent) { return scripts[agent].enemy_near(agent); };
+        callbacks.conditions["tired"] = [&scripts](size_t agent) { return scripts[agent].tired(agent); };
+        return callbacks;
+    }
+
+    BehaviorCallbacks bind_single_callbacks(AgentScript &script, size_t agent)
+    {
+        BehaviorCallbacks callbacks;
+        callbacks.actions["attack"] = [&script, agent] { return script.attack(agent); };
+        callbacks.actions["walk"] = [&script, agent] { return script.walk(agent); };
+        callbacks.conditions["enemy near"] = [&script, agent] { return script.enemy_near(agent); };
+        callbacks.conditions["tired"] = [&script, agent] { return script.tired(agent); };
+        return callbacks;
+    }
+
+    // Blackboard of every agent: key values, which conditions read and actions and the test change,
+    // and what each agent did - the actions and the conditions without keys it called, in order.
+    struct KeyWorld
+    {
+        KeyWorld(size_t agent_count, uint32_t key_count):
+                values(agent_count, std::vector<uint32_t>(key_count, 0)),
+                calls(agent_count)
+        {
+        }
+
+        void change(size_t agent, uint32_t key)
+        {
+            ++values[agent][key];
+            batch->mark_changed(agent, batch->get_key("key " + std::to_string(key)));
+        }
+
+        std::vector<std::vector<uint32_t>> values;
+        std::vector<std::vector<uint32_t>> calls;
+        AgentBatch *batch = nullptr;
+        // Work of a condition with keys, standing in for a spatial query or a path lookup.
+        uint32_t query_rounds = 0;
+    };
+
+    // Condition N reads keys N and N + 1 (modulo the key count) and holds one time in four, except
+    // that every fourth one reads no keys unless all are tracked and answers by its calls instead.
+    // Actions cycle through their results by their calls, and now and then change a key.
+    AgentCallbacks bind_world_callbacks(KeyWorld &world, const std::vector<std::string> &actions,
+                                        const std::vector<std::string> &conditions, bool track_all)
+    {
+        const auto key_count = static_cast<uint32_t>(world.values.front().size());
+        AgentCallbacks callbacks;
+        for(uint32_t action = 0; action < actions.size(); ++action)
+        {
+            callbacks.actions[actions[action]] = [&world, action, key_count](size_t agent)
+            {
+                auto &calls = world.calls[agent];
+                calls.push_back(action);
+                if((calls.size() + action) % 4 == 0)
+                {
+                    world.change(agent, action % key_count);
+                }
+                static constexpr BehaviorState results[] = {BehaviorState::success, BehaviorState::failure,
+                                                            BehaviorState::running};
+                return results[(calls.size() * (action + 1) + agent) % 3];
+            };
+        }
+        for(uint32_t condition = 0; condition < conditions.size(); ++condition)
+        {
+            if(!track_all && condition % 4 == 3)
+            {
+                callbacks.conditions[conditions[condition]] = [&world, condition](size_t agent)
+                {
+                    auto &calls = world.calls[agent];
+                    calls.push_back(100 + condition);
+                    return (calls.size() + condition + agent) % 4 != 0;
+                };
+                continue;
+            }
+            const auto first = condition % key_count;
+            const auto second = (condition + 1) % key_count;
+            callbacks.conditions[conditions[condition]] = [&world, condition, first, second](size_t agent)
+            {
+                const auto &values = world.values[agent];
+                auto answer = values[first] * 7 + values[second] * 13 + condition * 5 + static_cast<uint32_t>(agent);
+                for(uint32_t round = 0; round < world.query_rounds; ++round)
+                {
+                    answer = answer * 2654435761u + values[first];
+                }
+                return answer % 4 == 0;
+            };
+            callbacks.condition_keys[conditions[condition]] = {"key " + std::to_string(first),
+                                                               "key " + std::to_string(second)};
+        }
+        return callbacks;
+    }
+
+    std::vector<std::string> get_generated_labels(const std::string &kind)
+    {
+        std::vector<std::string> labels;
+        for(uint32_t callback = 0; callback < generated_callback_count; ++callback)
+        {
+            labels.push_back(kind + " " + std::to_string(callback));
+        }
+        return labels;
+    }
+}
+
+TEST_CASE("Work stealing pool runs every index once", "[agent_batch]")
+{
+    WorkStealingPool pool{4};
+    REQUIRE(pool.get_thread_count() == 4);
+
+    for(const auto grain: {size_t{1}, size_t{7}, size_t{64}, size_t{5000}})
+    {
+        std::vector<std::atomic<uint32_t>> visits(3001);
+        for(int round = 0; round < 20; ++round)
+        {
+            pool.parallel_for(visits.size(), grain, [&visits](size_t begin, size_t end, size_t worker)
+            {
+                REQUIRE(worker < 4);
+                for(auto index = begin; index < end; ++index)
+                {
+                    // Uneven work, so that stealing actually happens.
+                    for(volatile size_t spin = 0; spin < index % 97; spin = spin + 1)
+                    {
+                    }
+                    ++visits[index];
+                }
+            });
+        }
+        for(const auto &count: visits)
+        {
+            REQUIRE(count == 20);
+        }
+    }
+    REQUIRE_THROWS_AS(pool.parallel_for(10, 0, [](size_t, size_t, size_t) {}), std::invalid_argument);
+}
+
+TEST_CASE("Agent batch matches one compiled tree per agent", "[agent_batch]")
+{
+    constexpr size_t agent_count = 1000;
+    const auto document = make_guard_tree();
+
+    std::vector<AgentScript> batch_scripts(agent_count);
+    AgentBatch batch{document, bind_agent_callbacks(batch_scripts), agent_count};
+
+    std::vector<AgentScript> single_scripts(agent_count);
+    std::vector<std::unique_ptr<CompiledTree>> single_trees;
+    for(size_t agent = 0; agent < agent_count; ++agent)
+    {
+        single_trees.push_back(std::make_unique<CompiledTree>(document, bind_single_callbacks(single_scripts[agent], agent)));
+    }
+
+    WorkStealingPool pool{4};
+    for(int tick = 0; tick < 25; ++tick)
+    {
+        batch.tick_all(pool, 16);
+        for(size_t agent = 0; agent < agent_count; ++agent)
+        {
+            CAPTURE(tick, agent);
+            REQUIRE(batch.get_result(agent) == single_trees[agent]->evaluate());
+            REQUIRE(batch_scripts[agent].calls == single_scripts[agent].calls);
+        }
+    }
+}
+
+TEST_CASE("Agent batch keeps agents apart", "[agent_batch]")
+{
+    std::vector<AgentScript> scripts(3);
+    AgentBatch batch{make_guard_tree(), bind_agent_callbacks(scripts), 2};
+    // Selectors and sequences remember a running child, loops and MaxNTries count.
+    REQUIRE(batch.get_bytes_per_agent() == 5 * sizeof(uint32_t) + sizeof(BehaviorState));
+
+    batch.tick(0);
+    batch.tick(0);
+    REQUIRE(scripts[1].calls == 0);
+
+    batch.resize(3);
+    REQUIRE(batch.get_agent_count() == 3);
+    REQUIRE(batch.get_result(2) == BehaviorState::undefined);
+    batch.reset(0);
+    REQUIRE(batch.get_result(0) == BehaviorState::undefined);
+    REQUIRE_THROWS_AS(batch.tick(3), std::out_of_range);
+}
+
+TEST_CASE("Reactive ticks skip conditions whose keys did not change", "[agent_batch]")
+{
+    TreeDocument document;
+    const auto root = document.add_node(TreeDocument::no_node, NodeKind::selector, "root");
+    document.add_node(root, NodeKind::condition, "enemy near");
+    document.add_node(root, NodeKind::condition, "tired");
+    std::vector<uint32_t> checks(2, 0);
+    AgentCallbacks callbacks;
+    callbacks.conditions["enemy near"] = [&checks](size_t) { return ++checks[0] == 0; };
+    callbacks.conditions["tired"] = [&checks](size_t) { return ++checks[1] == 0; };
+    callbacks.condition_keys["enemy near"] = {"enemies"};
+    callbacks.condition_keys["tired"] = {"stamina"};
+    AgentBatch batch{document, callbacks, 2};
+    const auto enemies = batch.get_key("enemies");
+    const auto stamina = batch.get_key("stamina");
+    REQUIRE_THROWS_AS(batch.get_key("gold"), std::invalid_argument);
+    REQUIRE_THROWS_AS(batch.mark_changed(0, 2), std::out_of_range);
+
+    // Full ticks check everything every time.
+    batch.tick(0);
+    batch.tick(0);
+    REQUIRE(checks == std::vector<uint32_t>{2, 2});
+
+    batch.set_reactive(true);
+    REQUIRE(batch.get_bytes_per_agent() == 1 * sizeof(uint32_t) + 4 * sizeof(BehaviorState));
+    REQUIRE(batch.tick(0) == BehaviorState::failure);
+    REQUIRE(batch.tick(0) == BehaviorState::failure);
+    REQUIRE(checks == std::vector<uint32_t>{3, 3});
+    batch.mark_changed(0, stamina);
+    REQUIRE(batch.tick(0) == BehaviorState::failure);
+    REQUIRE(checks == std::vector<uint32_t>{3, 4});
+    // Agents remember for themselves.
+    batch.mark_changed(enemies);
+    batch.tick(0);
+    batch.tick(1);
+    REQUIRE(checks == std::vector<uint32_t>{5, 5});
+    batch.reset(1);
+    batch.tick(1);
+    REQUIRE(checks == std::vector<uint32_t>{6, 6});
+}
+
+TEST_CASE("Reactive ticks match full ticks", "[agent_batch]")
+{
+    struct Setup
+    {
+        std::string name;
+        TreeDocument document;
+        std::vector<std::string> actions;
+        std::vector<std::string> conditions;
+        uint32_t key_count;
+    };
+    std::vector<Setup> setups;
+    setups.push_back({"guard", make_guard_tree(), {"attack", "walk"}, {"enemy near", "tired"}, 2});
+    for(uint32_t seed = 0; seed < 4; ++seed)
+    {
+        setups.push_back({"realistic " + std::to_string(seed), {}, get_generated_labels("action"),
+                          get_generated_labels("condition"), 4});
+        generate_realistic_tree(setups.back().document, 400, seed);
+    }
+
+    constexpr size_t agent_count = 200;
+    WorkStealingPool pool{4};
+    for(const auto &setup: setups)
+    {
+        for(const auto change_rate: {0.0, 0.05, 0.5})
+        {
+            KeyWorld full_world{agent_count, setup.key_count};
+            KeyWorld reactive_world{agent_count, setup.key_count};
+            AgentBatch full{setup.document, bind_world_callbacks(full_world, setup.actions, setup.conditions, false),
+                            agent_count};
+            AgentBatch reactive{setup.document,
+                                bind_world_callbacks(reactive_world, setup.actions, setup.conditions, false),
+                                agent_count};
+            full_world.batch = &full;
+            reactive_world.batch = &reactive;
+            reactive.set_reactive(true);
+
+            std::mt19937 random{2020};
+            std::bernoulli_distribution changes{change_rate};
+            std::uniform_int_distribution<uint32_t> keys{0, setup.key_count - 1};
+            for(int tick = 0; tick < 60; ++tick)
+            {
+                for(size_t agent = 0; agent < agent_count; ++agent)
+                {
+                    if(changes(random))
+                    {
+                        const auto key = keys(random);
+                        full_world.change(agent, key);
+                        reactive_world.change(agent, key);
+                    }
+                }
+                if(tick == 30)
+                {
+                    full.reset(7);
+                    reactive.reset(7);
+                }
+                full.tick_all(pool, 16);
+                reactive.tick_all(pool, 16);
+                for(size_t agent = 0; agent < agent_count; ++agent)
+                {
+                    CAPTURE(setup.name, change_rate, tick, agent);
+                    REQUIRE(reactive.get_result(agent) == full.get_result(agent));
+                    REQUIRE(reactive_world.calls[agent] == full_world.calls[agent]);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Agent batch throughput", "[agent_batch][benchmarks][!benchmark]")
+{
+    constexpr size_t agent_count = 20000;
+    std::vector<AgentScript> scripts(agent_count);
+    AgentBatch batch{make_guard_tree(), bind_agent_callbacks(scripts), agent_count};
+
+    WorkStealingPool single{1};
+    WorkStealingPool all_cores;
+    BENCHMARK("20000 agents, 1 thread")
+    {
+        batch.tick_all(single);
+    };
+    BENCHMARK("20000 agents, all cores")
+    {
+        batch.tick_all(all_cores);
+    };
+}
+
+TEST_CASE("Reactive tick throughput", "[agent_batch][benchmarks][!benchmark]")
+{
+    // Agents mostly waiting: guards read keys, seldom hold and cost about as much as a small query; a
+    // tick changes one key of the given share of agents, and actions now and then change one.
+    constexpr size_t agent_count = 2000;
+    constexpr uint32_t key_count = 4;
+    TreeDocument document;
+    generate_realistic_tree(document, 1000, 2020);
+    KeyWorld world{agent_count, key_count};
+    world.query_rounds = 64;
+    const auto callbacks = bind_world_callbacks(world, get_generated_labels("action"),
+                                                get_generated_labels("condition"), true);
+    AgentBatch batch{document, callbacks, agent_count};
+    world.batch = &batch;
+    WorkStealingPool pool{1};
+
+    constexpr int ticks_per_round = 8;
+    constexpr int rounds = 20;
+    const auto measure = [&](bool reactive, double change_rate)
+    {
+        batch.set_reactive(reactive);
+        std::mt19937 random{2020};
+        std::bernoulli_distribution changes{change_rate};
+        std::uniform_int_distribution<uint32_t> keys{0, key_count - 1};
+        auto best = std::chrono::steady_clock::duration::max();
+        for(int round = 0; round < rounds; ++round)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for(int tick = 0; tick < ticks_per_round; ++tick)
+            {
+                for(size_t agent = 0; agent < agent_count; ++agent)
+                {
+                    if(changes(random))
+                    {
+                        world.change(agent, keys(random));
+                    }
+                }
+                batch.tick_all(pool);
+            }
+            best = std::min(best, std::chrono::steady_clock::now() - start);
+        }
+        return std::chrono::duration<double, std::micro>(best).count() / ticks_per_round;
+    };
+
+    for(const auto change_rate: {0.0, 0.01, 0.1, 1.0})
+    {
+        const auto full = measure(false, change_rate);
+        const auto reactive = measure(true, change_rate);
+        WARN(agent_count << " agents, " << document.size() << " nodes, " << change_rate * 100.0
+                         << "% changing per tick: " << full << " us full, " << reactive << " us reactive - "
+                         << full / reactive << "x");
+    }
+}
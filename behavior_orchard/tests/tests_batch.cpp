@@ -0,0 +1,315 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "catch.hpp"
+
+#include "TreeGenerators.hpp"
+#include "../batch/BatchCommand.hpp"
+#include "../batch/BatchProcessor.hpp"
+#include "../codegen/StaticTreeGenerator.hpp"
+#include "../io/TreeFile.hpp"
+#include "../io/TreeTextFormat.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr uint32_t seed = 2020;
+
+    std::string to_text(const TreeDocument &document)
+    {
+        std::ostringstream output;
+        save_tree_text(document, output);
+        return output.str();
+    }
+
+    std::string read_file(const std::filesystem::path &path)
+    {
+        std::ifstream input{path, std::ios::binary};
+        std::ostringstream content;
+        content << input.rdbuf();
+        return content.str();
+    }
+
+    // Empty directory for the test, removed with everything in it at the end.
+    class TemporaryDirectory
+    {
+    public:
+        explicit TemporaryDirectory(const std::string &name):
+                path{std::filesystem::temp_directory_path() / name}
+        {
+            std::filesystem::remove_all(path);
+            std::filesystem::create_directories(path);
+        }
+
+        ~TemporaryDirectory()
+        {
+            std::filesystem::remove_all(path);
+        }
+
+        TemporaryDirectory(const TemporaryDirectory &) = delete;
+        TemporaryDirectory &operator=(const TemporaryDirectory &) = delete;
+
+        const std::filesystem::path path;
+    };
+
+    // Three valid trees, one whose loop has no child and one file which is not a tree at all.
+    std::vector<std::filesystem::path> write_trees(const std::filesystem::path &directory)
+    {
+        std::vector<std::filesystem::path> paths;
+        for(uint32_t tree = 0; tree < 3; ++tree)
+        {
+            TreeDocument document;
+            generate_realistic_tree(document, 300, seed + tree);
+            paths.push_back(directory / ("tree_" + std::to_string(tree) + tree_text_extension));
+            save_tree(document, paths.back());
+        }
+
+        TreeDocument broken;
+        const auto root = broken.add_node(TreeDocument::no_node, NodeKind::selector, "root");
+        broken.add_node(root, NodeKind::loop, "loop", 2);
+        paths.push_back(directory / ("broken" + std::string{tree_text_extension}));
+        save_tree(broken, paths.back());
+
+        paths.push_back(directory / ("notes" + std::string{tree_text_extension}));
+        std::ofstream{paths.back()} << "not a tree\n";
+        return paths;
+    }
+
+    std::vector<BatchStatus> get_statuses(const std::vector<BatchFileResult> &results)
+    {
+        std::vector<BatchStatus> statuses;
+        for(const auto &result: results)
+        {
+            statuses.push_back(result.status);
+        }
+        return statuses;
+    }
+}
+
+TEST_CASE("Batch mode validates, converts and generates code", "[batch]")
+{
+    const TemporaryDirectory directory{"orchard_batch_test"};
+    const auto paths = write_trees(directory.path);
+    BatchOptions options;
+    options.convert = BatchOptions::Conversion::binary;
+    options.generate = true;
+    options.output_directory = directory.path / "out";
+    WorkStealingPool pool{4};
+
+    const auto results = process_tree_files(paths, options, pool);
+    REQUIRE(get_statuses(results) == std::vector<BatchStatus>{BatchStatus::done, BatchStatus::done,
+                                                             BatchStatus::done, BatchStatus::invalid,
+                                                             BatchStatus::failed});
+    REQUIRE(results[3].messages.size() == 1);
+    REQUIRE(results[3].messages[0].find("#1: ") == 0);
+    REQUIRE(results[4].messages.size() == 1);
+    for(size_t tree = 0; tree < 3; ++tree)
+    {
+        REQUIRE(results[tree].path == paths[tree]);
+        REQUIRE(results[tree].node_count >= 300);
+        REQUIRE(results[tree].messages.empty());
+
+        TreeDocument original;
+        TreeDocument converted;
+        load_tree(paths[tree], original);
+        const auto stem = paths[tree].stem().string();
+        load_tree(options.output_directory / (stem + tree_binary_extension), converted);
+        REQUIRE(to_text(converted) == to_text(original));
+        REQUIRE(read_file(options.output_directory / (stem + ".hpp")) == generate_static_tree(original, stem));
+    }
+    // Nothing is written for files which did not pass.
+    REQUIRE(!std::filesystem::exists(options.output_directory / "broken.btree"));
+    REQUIRE(!std::filesystem::exists(options.output_directory / "broken.hpp"));
+
+    // Same stem in two directories, one output directory: neither wins, whichever comes first.
+    std::filesystem::create_directories(directory.path / "other");
+    const auto twin = directory.path / "other" / paths[0].filename();
+    std::filesystem::copy_file(paths[0], twin);
+    for(const auto &clashing: {process_tree_files({paths[0], twin}, options, pool),
+                               process_tree_files({twin, paths[0]}, options, pool)})
+    {
+        REQUIRE(get_statuses(clashing) == std::vector<BatchStatus>{BatchStatus::failed, BatchStatus::failed});
+    }
+}
+
+TEST_CASE("Batch conversion leaves trees already in the format alone", "[batch]")
+{
+    const TemporaryDirectory directory{"orchard_batch_convert_test"};
+    const auto paths = write_trees(directory.path);
+    const auto text = read_file(paths[0]);
+    BatchOptions options;
+    options.convert = BatchOptions::Conversion::text;
+    options.generate = true;
+    WorkStealingPool pool{2};
+
+    // Validated and generated, but not saved over itself.
+    const auto in_place = process_tree_files({paths[0]}, options, pool);
+    REQUIRE(in_place[0].status == BatchStatus::done);
+    REQUIRE(in_place[0].converting == 0.0);
+    REQUIRE(read_file(paths[0]) == text);
+    REQUIRE(std::filesystem::exists(directory.path / "tree_0.hpp"));
+
+    // A binary tree next to a text one with the same stem is what converting the text one writes; it
+    // is left to that conversion in any order, while a binary tree without a twin is processed.
+    options.convert = BatchOptions::Conversion::binary;
+    options.generate = false;
+    REQUIRE(process_tree_files({paths[1]}, options, pool)[0].status == BatchStatus::done);
+    const auto binary = directory.path / ("tree_1" + std::string{tree_binary_extension});
+    const auto alone = directory.path / ("alone" + std::string{tree_binary_extension});
+    std::filesystem::copy_file(binary, alone);
+    for(const auto &order: {std::vector{paths[1], binary, alone}, std::vector{alone, binary, paths[1]}})
+    {
+        const auto results = process_tree_files(order, options, pool);
+        for(size_t file = 0; file < order.size(); ++file)
+        {
+            CAPTURE(order[file]);
+            REQUIRE(results[file].status == (order[file] == binary ? BatchStatus::skipped : BatchStatus::done));
+        }
+    }
+
+    options.convert = BatchOptions::Conversion::text;
+    const auto results = process_tree_files({paths[1], binary}, options, pool);
+    REQUIRE(get_statuses(results) == std::vector<BatchStatus>{BatchStatus::skipped, BatchStatus::done});
+    REQUIRE(results[0].messages == std::vector<std::string>{"converted from " + binary.string()});
+}
+
+TEST_CASE("Converting a directory twice gives the same result", "[batch]")
+{
+    const TemporaryDirectory directory{"orchard_batch_twice_test"};
+    write_trees(directory.path);
+    BatchOptions options;
+    options.convert = BatchOptions::Conversion::binary;
+    options.generate = true;
+    WorkStealingPool pool{2};
+    const auto cache_path = directory.path / "batch.cache";
+
+    const auto run = [&](bool cached)
+    {
+        BatchCache cache;
+        cache.load(cache_path);
+        const auto results = process_tree_files(find_tree_files(directory.path), options, pool,
+                                                cached ? &cache : nullptr);
+        cache.save(cache_path);
+        std::vector<std::pair<std::string, BatchStatus>> statuses;
+        for(const auto &result: results)
+        {
+            statuses.emplace_back(result.path.filename().string(), result.status);
+        }
+        return statuses;
+    };
+    using Statuses = std::vector<std::pair<std::string, BatchStatus>>;
+    REQUIRE(run(false) == Statuses{{"broken.tree", BatchStatus::invalid}, {"notes.tree", BatchStatus::failed},
+                                   {"tree_0.tree", BatchStatus::done}, {"tree_1.tree", BatchStatus::done},
+                                   {"tree_2.tree", BatchStatus::done}});
+    const auto converted = read_file(directory.path / "tree_0.btree");
+    const auto header = read_file(directory.path / "tree_0.hpp");
+
+    // Trees converted by the first run are found now, and left to their sources.
+    const Statuses again = {{"broken.tree", BatchStatus::invalid}, {"notes.tree", BatchStatus::failed},
+                            {"tree_0.btree", BatchStatus::skipped}, {"tree_0.tree", BatchStatus::done},
+                            {"tree_1.btree", BatchStatus::skipped}, {"tree_1.tree", BatchStatus::done},
+                            {"tree_2.btree", BatchStatus::skipped}, {"tree_2.tree", BatchStatus::done}};
+    REQUIRE(run(false) == again);
+    REQUIRE(run(true) == again);
+    auto cached = again;
+    for(auto &[name, status]: cached)
+    {
+        status = status == BatchStatus::done ? BatchStatus::skipped : status;
+    }
+    REQUIRE(run(true) == cached);
+    REQUIRE(read_file(directory.path / "tree_0.btree") == converted);
+    REQUIRE(read_file(directory.path / "tree_0.hpp") == header);
+}
+
+TEST_CASE("Batch mode skips files which did not change", "[batch]")
+{
+    const TemporaryDirectory directory{"orchard_batch_cache_test"};
+    const auto paths = write_trees(directory.path);
+    const auto cache_path = directory.path / "batch.cache";
+    BatchOptions options;
+    options.generate = true;
+    WorkStealingPool pool{4};
+    const auto run = [&]
+    {
+        BatchCache cache;
+        cache.load(cache_path);
+        const auto results = process_tree_files(paths, options, pool, &cache);
+        cache.save(cache_path);
+        return get_statuses(results);
+    };
+
+    using Statuses = std::vector<BatchStatus>;
+    const Statuses all_done = {BatchStatus::done, BatchStatus::done, BatchStatus::done, BatchStatus::invalid,
+                               BatchStatus::failed};
+    REQUIRE(run() == all_done);
+    // Files which did not pass are tried every time.
+    REQUIRE(run() == Statuses{BatchStatus::skipped, BatchStatus::skipped, BatchStatus::skipped,
+                              BatchStatus::invalid, BatchStatus::failed});
+
+    TreeDocument document;
+    load_tree(paths[1], document);
+    document.set_label(document.get_root(), "changed");
+    save_tree(document, paths[1]);
+    std::filesystem::remove(directory.path / "tree_2.hpp");
+    REQUIRE(run() == Statuses{BatchStatus::skipped, BatchStatus::done, BatchStatus::done, BatchStatus::invalid,
+                              BatchStatus::failed});
+
+    // Other options make other outputs.
+    options.convert = BatchOptions::Conversion::binary;
+    REQUIRE(run() == all_done);
+
+    // A damaged cache is as good as none.
+    std::ofstream{cache_path, std::ios::app} << "garbage\n";
+    REQUIRE(run() == all_done);
+}
+
+TEST_CASE("Batch command reports every file", "[batch]")
+{
+    const TemporaryDirectory directory{"orchard_batch_command_test"};
+    const auto paths = write_trees(directory.path);
+    std::ostringstream output;
+    std::ostringstream errors;
+
+    REQUIRE(run_batch_command({}, output, errors) == 2);
+    REQUIRE(run_batch_command({"--convert", "xml", paths[0].string()}, output, errors) == 2);
+    REQUIRE(run_batch_command({"--threads"}, output, errors) == 2);
+    REQUIRE(run_batch_command({"--bogus", paths[0].string()}, output, errors) == 2);
+    REQUIRE(run_batch_command({"--help"}, output, errors) == 0);
+
+    output.str("");
+    REQUIRE(run_batch_command({"--threads", "2", paths[0].string(), paths[2].string()}, output, errors) == 0);
+    REQUIRE(output.str().find("done") == 0);
+    REQUIRE(output.str().find("2 files: 2 done, 0 skipped, 0 invalid, 0 failed") != std::string::npos);
+
+    // Directories are searched for trees.
+    output.str("");
+    REQUIRE(run_batch_command({directory.path.string()}, output, errors) == 1);
+    REQUIRE(output.str().find("5 files: 3 done, 0 skipped, 1 invalid, 1 failed") != std::string::npos);
+    REQUIRE(output.str().find("    #1: ") != std::string::npos);
+}
@@ -0,0 +1,573 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#include "catch.hpp"
+
+#include "TreeGenerators.hpp"
+#include "../io/TreeBinaryFormat.hpp"
+#include "../io/TreeTextFormat.hpp"
+#include "../layout/TreeLayout.hpp"
+#include "../model/TreeValidator.hpp"
+#include "../runtime/CompiledTree.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <memory_resource>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Suite guarding the performance of the bt library and of the editor. Run it with
+//
+//   tests "[benchmarks]" --reporter xml --out benchmarks.xml
+//
+// (the benchmarks target of CMake does the same) and compare two such files with
+// compare_benchmarks.py; see its help for the regression threshold.
+
+namespace
+{
+    using index_t = TreeDocument::index_t;
+
+    constexpr uint32_t seed = 2020;
+
+    size_t get_depth(const TreeDocument &document)
+    {
+        size_t deepest = 0;
+        for(index_t node = 0; node < document.get_capacity(); ++node)
+        {
+            if(!document.contains(node) || document.get_first_child(node) != TreeDocument::no_node)
+            {
+                continue;
+            }
+            size_t depth = 0;
+            for(auto parent = document.get_parent(node); parent != TreeDocument::no_node; parent = document.get_parent(parent))
+            {
+                ++depth;
+            }
+            deepest = std::max(deepest, depth);
+        }
+        return deepest;
+    }
+
+    std::string to_text(const TreeDocument &document)
+    {
+        std::ostringstream output;
+        save_tree_text(document, output);
+        return output.str();
+    }
+
+    std::string to_binary(const TreeDocument &document)
+    {
+        std::ostringstream output;
+        save_tree_binary(document, output);
+        return output.str();
+    }
+
+    // Sequence root over units in which the given kind makes up about half of the nodes or more;
+    // everything succeeds, so every tick visits every node.
+    TreeDocument make_kind_tree(NodeKind kind, size_t node_count)
+    {
+        TreeDocument document;
+        const auto root = document.add_node(TreeDocument::no_node, NodeKind::sequence, "root");
+        const auto target = document.add_node(root, NodeKind::condition, "pass");
+        while(document.size() < node_count)
+        {
+            switch(kind)
+            {
+                case NodeKind::action:
+                    document.add_node(root, NodeKind::action, "succeed");
+                    break;
+                case NodeKind::condition:
+                    document.add_node(root, NodeKind::condition, "pass");
+                    break;
+                case NodeKind::link:
+                    document.add_node(root, NodeKind::link, "link", document.get_id(target));
+                    break;
+                case NodeKind::invert:
+                {
+                    const auto outer = document.add_node(root, NodeKind::invert, "invert");
+                    const auto inner = document.add_node(outer, NodeKind::invert, "invert");
+                    document.add_node(inner, NodeKind::condition, "pass");
+                    break;
+                }
+                default:
+                {
+                    const auto parameter = kind == NodeKind::selector || kind == NodeKind::sequence ? 0u : 1u;
+                    const auto unit = document.add_node(root, kind, get_node_kind_name(kind), parameter);
+                    document.add_node(unit, NodeKind::condition, "pass");
+                    break;
+                }
+            }
+        }
+        return document;
+    }
+
+    BehaviorCallbacks make_passing_callbacks()
+    {
+        BehaviorCallbacks callbacks;
+        callbacks.actions["succeed"] = [] { return BehaviorState::success; };
+        callbacks.conditions["pass"] = [] { return true; };
+        return callbacks;
+    }
+
+    // Builds every tree while other allocations of random sizes come and go, like on a heap which
+    // served the rest of a level load; trees taken from that heap end up scattered over it.
+    template<typename Build>
+    void build_among_other_allocations(size_t tree_count, Build build)
+    {
+        std::mt19937 random{seed};
+        std::vector<std::unique_ptr<char[]>> others;
+        for(size_t tree = 0; tree < tree_count; ++tree)
+        {
+            for(int other = 0; other < 16; ++other)
+            {
+                others.push_back(std::make_unique<char[]>(16 + random() % 512));
+            }
+            build(tree);
+            for(size_t other = tree % 2; other < others.size(); other += 2)
+            {
+                others[other].reset();
+            }
+        }
+    }
+
+    void lay_out(TreeLayout &layout, const TreeDocument &document)
+    {
+        layout.clear();
+        for(index_t node = 0; node < document.get_capacity(); ++node)
+        {
+            if(document.contains(node))
+            {
+                layout.set_width(node, static_cast<int32_t>(60 + document.get_label(node).size() * 7));
+            }
+        }
+        layout.update();
+    }
+}
+
+TEST_CASE("Generated trees are valid and repeatable", "[benchmarks]")
+{
+    using Generate = void (*)(TreeDocument &, size_t, uint32_t);
+    for(const auto generate: {Generate{generate_deep_tree}, Generate{generate_wide_tree},
+                              Generate{generate_realistic_tree}})
+    {
+        TreeDocument first;
+        TreeDocument second;
+        generate(first, 5000, seed);
+        generate(second, 5000, seed);
+        REQUIRE(first.size() >= 5000);
+        REQUIRE(first.size() < 5100);
+        REQUIRE(to_text(first) == to_text(second));
+        REQUIRE(validate_tree(first).empty());
+        generate(second, 5000, seed + 1);
+        REQUIRE(to_text(first) != to_text(second));
+
+        // Runs the same way on both engines.
+        BehaviorTree runtime_tree;
+        build_behavior_tree(first, make_generated_callbacks(), runtime_tree);
+        CompiledTree compiled_tree{first, make_generated_callbacks()};
+        for(int tick = 0; tick < 20; ++tick)
+        {
+            REQUIRE(runtime_tree.evaluate() == compiled_tree.evaluate());
+        }
+    }
+
+    TreeDocument document;
+    generate_deep_tree(document, 5000, seed);
+    REQUIRE(get_depth(document) > 3000);
+    generate_wide_tree(document, 5000, seed);
+    REQUIRE(get_depth(document) == 2);
+    REQUIRE(document.get_child_count(document.get_root()) >= 70);
+    generate_realistic_tree(document, 5000, seed);
+    REQUIRE(get_depth(document) > 4);
+    REQUIRE(get_depth(document) < 40);
+}
+
+TEST_CASE("Tick throughput per node kind", "[benchmarks][!benchmark]")
+{
+    constexpr size_t node_count = 1000;
+    const auto callbacks = make_passing_callbacks();
+    for(size_t kind_index = 0; kind_index < node_kind_count; ++kind_index)
+    {
+        const auto kind = static_cast<NodeKind>(kind_index);
+        const auto document = make_kind_tree(kind, node_count);
+        BehaviorTree runtime_tree;
+        build_behavior_tree(document, callbacks, runtime_tree);
+        CompiledTree compiled_tree{document, callbacks};
+        REQUIRE(runtime_tree.evaluate() == BehaviorState::success);
+        REQUIRE(compiled_tree.evaluate() == BehaviorState::success);
+
+        const std::string name = get_node_kind_name(kind);
+        BENCHMARK("BehaviorTree tick, " + name)
+        {
+            return runtime_tree.evaluate();
+        };
+        BENCHMARK("Compiled tree tick, " + name)
+        {
+            return compiled_tree.evaluate();
+        };
+    }
+}
+
+TEST_CASE("Tick throughput per tree shape", "[benchmarks][!benchmark]")
+{
+    using Generate = void (*)(TreeDocument &, size_t, uint32_t);
+    const std::pair<const char *, Generate> shapes[] = {{"deep", generate_deep_tree},
+                                                        {"wide", generate_wide_tree},
+                                                        {"realistic", generate_realistic_tree}};
+    for(const auto &[shape, generate]: shapes)
+    {
+        TreeDocument document;
+        generate(document, 2000, seed);
+        BehaviorTree runtime_tree;
+        build_behavior_tree(document, make_generated_callbacks(), runtime_tree);
+        CompiledTree compiled_tree{document, make_generated_callbacks()};
+
+        BENCHMARK(std::string{"BehaviorTree tick, "} + shape)
+        {
+            return runtime_tree.evaluate();
+        };
+        BENCHMARK(std::string{"Compiled tree tick, "} + shape)
+        {
+            return compiled_tree.evaluate();
+        };
+    }
+}
+
+TEST_CASE("Tree construction and teardown", "[benchmarks][!benchmark]")
+{
+    constexpr size_t node_count = 20000;
+    TreeDocument document;
+    const auto callbacks = make_generated_callbacks();
+
+    BENCHMARK("Generate document, realistic")
+    {
+        generate_realistic_tree(document, node_count, seed);
+        return document.size();
+    };
+    // Trees live in slots prepared up front, so that building does not time destruction and the
+    // other way round.
+    BENCHMARK_ADVANCED("Build BehaviorTree, realistic")(Catch::Benchmark::Chronometer meter)
+    {
+        std::vector<std::unique_ptr<BehaviorTree>> trees(static_cast<size_t>(meter.runs()));
+        meter.measure([&](int run)
+        {
+            auto &tree = trees[static_cast<size_t>(run)];
+            tree = std::make_unique<BehaviorTree>();
+            return build_behavior_tree(document, callbacks, *tree).size();
+        });
+    };
+    BENCHMARK_ADVANCED("Destroy BehaviorTree, realistic")(Catch::Benchmark::Chronometer meter)
+    {
+        std::vector<std::unique_ptr<BehaviorTree>> trees(static_cast<size_t>(meter.runs()));
+        for(auto &tree: trees)
+        {
+            tree = std::make_unique<BehaviorTree>();
+            build_behavior_tree(document, callbacks, *tree);
+        }
+        meter.measure([&](int run) { trees[static_cast<size_t>(run)].reset(); });
+    };
+    BENCHMARK("Compile tree, realistic")
+    {
+        return TreeProgram{document}.get_instructions().size();
+    };
+}
+
+TEST_CASE("Many trees on the heap and in an arena", "[benchmarks][!benchmark]")
+{
+    // A level's worth of small trees. BehaviorTree allocates every node on its own, CompiledTree
+    // takes a few blocks per tree either from the heap or from one arena shared by all the trees.
+    // Tick times of all trees in turn stand in for cache misses, which take hardware counters to
+    // count: run this case under perf stat -e cache-misses for those.
+    constexpr size_t tree_count = 1000;
+    constexpr size_t node_count = 200;
+    std::vector<TreeDocument> documents(tree_count);
+    for(size_t tree = 0; tree < tree_count; ++tree)
+    {
+        generate_realistic_tree(documents[tree], node_count, seed + static_cast<uint32_t>(tree));
+    }
+    const auto callbacks = make_generated_callbacks();
+
+    using RuntimeTrees = std::vector<std::unique_ptr<BehaviorTree>>;
+    using CompiledTrees = std::pmr::vector<CompiledTree>;
+    const auto build_runtime = [&](RuntimeTrees &trees, size_t tree)
+    {
+        trees.push_back(std::make_unique<BehaviorTree>());
+        build_behavior_tree(documents[tree], callbacks, *trees.back());
+    };
+    const auto build_compiled = [&](CompiledTrees &trees, size_t tree)
+    {
+        trees.emplace_back(documents[tree], callbacks, trees.get_allocator().resource());
+    };
+
+    // Sets of trees prepared up front, so that building does not time destruction and the other way
+    // round.
+    BENCHMARK_ADVANCED("Build 1000 BehaviorTrees")(Catch::Benchmark::Chronometer meter)
+    {
+        std::vector<RuntimeTrees> levels(static_cast<size_t>(meter.runs()));
+        meter.measure([&](int run)
+        {
+            auto &trees = levels[static_cast<size_t>(run)];
+            trees.reserve(tree_count);
+            for(size_t tree = 0; tree < tree_count; ++tree)
+            {
+                build_runtime(trees, tree);
+            }
+            return trees.size();
+        });
+    };
+    BENCHMARK_ADVANCED("Destroy 1000 BehaviorTrees")(Catch::Benchmark::Chronometer meter)
+    {
+        std::vector<RuntimeTrees> levels(static_cast<size_t>(meter.runs()));
+        for(auto &trees: levels)
+        {
+            for(size_t tree = 0; tree < tree_count; ++tree)
+            {
+                build_runtime(trees, tree);
+            }
+        }
+        meter.measure([&](int run) { levels[static_cast<size_t>(run)].clear(); });
+    };
+    BENCHMARK_ADVANCED("Build 1000 compiled trees, heap")(Catch::Benchmark::Chronometer meter)
+    {
+        std::vector<CompiledTrees> levels(static_cast<size_t>(meter.runs()));
+        meter.measure([&](int run)
+        {
+            auto &trees = levels[static_cast<size_t>(run)];
+            trees.reserve(tree_count);
+            for(size_t tree = 0; tree < tree_count; ++tree)
+            {
+                build_compiled(trees, tree);
+            }
+            return trees.size();
+        });
+    };
+    BENCHMARK_ADVANCED("Destroy 1000 compiled trees, heap")(Catch::Benchmark::Chronometer meter)
+    {
+        std::vector<CompiledTrees> levels(static_cast<size_t>(meter.runs()));
+        for(auto &trees: levels)
+        {
+            trees.reserve(tree_count);
+            for(size_t tree = 0; tree < tree_count; ++tree)
+            {
+                build_compiled(trees, tree);
+            }
+        }
+        meter.measure([&](int run) { CompiledTrees{}.swap(levels[static_cast<size_t>(run)]); });
+    };
+    BENCHMARK_ADVANCED("Build 1000 compiled trees, arena")(Catch::Benchmark::Chronometer meter)
+    {
+        std::vector<std::unique_ptr<std::pmr::monotonic_buffer_resource>> arenas;
+        std::vector<CompiledTrees> levels;
+        levels.reserve(static_cast<size_t>(meter.runs()));
+        for(int run = 0; run < meter.runs(); ++run)
+        {
+            arenas.push_back(std::make_unique<std::pmr::monotonic_buffer_resource>());
+            levels.emplace_back(arenas.back().get());
+        }
+        meter.measure([&](int run)
+        {
+            auto &trees = levels[static_cast<size_t>(run)];
+            trees.reserve(tree_count);
+            for(size_t tree = 0; tree < tree_count; ++tree)
+            {
+                build_compiled(trees, tree);
+            }
+            return trees.size();
+        });
+    };
+    BENCHMARK_ADVANCED("Destroy 1000 compiled trees, arena")(Catch::Benchmark::Chronometer meter)
+    {
+        std::vector<std::unique_ptr<std::pmr::monotonic_buffer_resource>> arenas;
+        std::vector<CompiledTrees> levels;
+        levels.reserve(static_cast<size_t>(meter.runs()));
+        for(int run = 0; run < meter.runs(); ++run)
+        {
+            arenas.push_back(std::make_unique<std::pmr::monotonic_buffer_resource>());
+            auto &trees = levels.emplace_back(arenas.back().get());
+            trees.reserve(tree_count);
+            for(size_t tree = 0; tree < tree_count; ++tree)
+            {
+                build_compiled(trees, tree);
+            }
+        }
+        meter.measure([&](int run)
+        {
+            levels[static_cast<size_t>(run)].clear();
+            arenas[static_cast<size_t>(run)]->release();
+        });
+    };
+
+    RuntimeTrees runtime_trees;
+    CompiledTrees heap_trees;
+    std::pmr::monotonic_buffer_resource arena;
+    CompiledTrees arena_trees{&arena};
+    runtime_trees.reserve(tree_count);
+    heap_trees.reserve(tree_count);
+    arena_trees.reserve(tree_count);
+    build_among_other_allocations(tree_count, [&](size_t tree) { build_runtime(runtime_trees, tree); });
+    build_among_other_allocations(tree_count, [&](size_t tree) { build_compiled(heap_trees, tree); });
+    build_among_other_allocations(tree_count, [&](size_t tree) { build_compiled(arena_trees, tree); });
+    BENCHMARK("Tick 1000 BehaviorTrees")
+    {
+        size_t succeeded = 0;
+        for(const auto &tree: runtime_trees)
+        {
+            succeeded += tree->evaluate() == BehaviorState::success;
+        }
+        return succeeded;
+    };
+    BENCHMARK("Tick 1000 compiled trees, heap")
+    {
+        size_t succeeded = 0;
+        for(auto &tree: heap_trees)
+        {
+            succeeded += tree.evaluate() == BehaviorState::success;
+        }
+        return succeeded;
+    };
+    BENCHMARK("Tick 1000 compiled trees, arena")
+    {
+        size_t succeeded = 0;
+        for(auto &tree: arena_trees)
+        {
+            succeeded += tree.evaluate() == BehaviorState::success;
+        }
+        return succeeded;
+    };
+}
+
+TEST_CASE("Layout throughput", "[benchmarks][!benchmark]")
+{
+    TreeDocument realistic;
+    generate_realistic_tree(realistic, 100000, seed);
+    TreeDocument wide;
+    generate_wide_tree(wide, 100000, seed);
+    TreeDocument deep;
+    generate_deep_tree(deep, 5000, seed);
+
+    TreeLayout realistic_layout{realistic};
+    TreeLayout wide_layout{wide};
+    TreeLayout deep_layout{deep};
+    BENCHMARK("Full layout, realistic")
+    {
+        lay_out(realistic_layout, realistic);
+    };
+    BENCHMARK("Full layout, wide")
+    {
+        lay_out(wide_layout, wide);
+    };
+    BENCHMARK("Full layout, deep")
+    {
+        lay_out(deep_layout, deep);
+    };
+
+    // One label edited: only its spine is laid out again. Every node right of the spine moves, which
+    // for the last node added is the whole tree once the root is centred anew.
+    lay_out(realistic_layout, realistic);
+    const auto edited = realistic.get_capacity() - 1;
+    int32_t width = 100;
+    BENCHMARK("Relayout after one edit, realistic")
+    {
+        width = width == 100 ? 140 : 100;
+        realistic_layout.set_width(edited, width);
+        return realistic_layout.update().size();
+    };
+    auto inner = realistic.get_capacity() / 4;
+    while(realistic.get_first_child(inner) != TreeDocument::no_node)
+    {
+        inner = realistic.get_first_child(inner);
+    }
+    BENCHMARK("Relayout after one edit, realistic inner leaf")
+    {
+        width = width == 100 ? 140 : 100;
+        realistic_layout.set_width(inner, width);
+        return realistic_layout.update().size();
+    };
+
+    // One child of a sequence of 100000 edited: the parent merges every child again, and the
+    // siblings move.
+    TreeDocument flat;
+    const auto sequence = flat.add_node(TreeDocument::no_node, NodeKind::sequence, "root");
+    for(int child = 0; child < 100000; ++child)
+    {
+        flat.add_node(sequence, NodeKind::condition, "condition");
+    }
+    TreeLayout flat_layout{flat};
+    lay_out(flat_layout, flat);
+    const auto middle = flat.get_capacity() / 2;
+    BENCHMARK("Relayout after one edit, 100000 children")
+    {
+        width = width == 100 ? 140 : 100;
+        flat_layout.set_width(middle, width);
+        return flat_layout.update().size();
+    };
+
+    // Bottom of a chain of 20000 decorators edited: the whole spine is laid out again.
+    TreeDocument chain;
+    auto link = chain.add_node(TreeDocument::no_node, NodeKind::sequence, "root");
+    for(int level = 0; level < 20000; ++level)
+    {
+        link = chain.add_node(link, NodeKind::invert, "invert");
+    }
+    TreeLayout chain_layout{chain};
+    lay_out(chain_layout, chain);
+    BENCHMARK("Relayout after one edit, chain of 20000")
+    {
+        width = width == 100 ? 140 : 100;
+        chain_layout.set_width(link, width);
+        return chain_layout.update().size();
+    };
+}
+
+TEST_CASE("Serialization throughput", "[benchmarks][!benchmark]")
+{
+    TreeDocument document;
+    generate_realistic_tree(document, 100000, seed);
+    const auto text = to_text(document);
+    const auto binary = to_binary(document);
+
+    BENCHMARK("Save text, realistic")
+    {
+        return to_text(document).size();
+    };
+    BENCHMARK("Save binary, realistic")
+    {
+        return to_binary(document).size();
+    };
+
+    TreeDocument loaded;
+    BENCHMARK("Load text, realistic")
+    {
+        parse_tree_text(text, loaded);
+        return loaded.size();
+    };
+    BENCHMARK("Load binary, realistic")
+    {
+        load_tree_binary(BinaryTreeView{reinterpret_cast<const unsigned char *>(binary.data()), binary.size()}, loaded);
+        return loaded.size();
+    };
+}
@@ -0,0 +1,331 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "catch.hpp"
+
+#include "../runtime/CompiledTree.hpp"
+
+#include <cstddef>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using index_t = TreeDocument::index_t;
+
+    constexpr uint32_t callback_count = 6;
+
+    // Callbacks answer from a fixed pseudo-random script, so two engines fed from two copies of the
+    // same script see the same answers as long as they make the same calls. The log records calls.
+    class Script
+    {
+    public:
+        explicit Script(uint32_t script_seed):
+                seed{script_seed},
+                calls(2 * callback_count, 0)
+        {
+        }
+
+        BehaviorCallbacks bind()
+        {
+            BehaviorCallbacks callbacks;
+            for(uint32_t callback = 0; callback < callback_count; ++callback)
+            {
+                callbacks.actions["action " + std::to_string(callback)] = [this, callback]
+                {
+                    static constexpr BehaviorState results[] = {BehaviorState::success, BehaviorState::failure,
+                                                                BehaviorState::running};
+                    return results[next(callback) % 3];
+                };
+                callbacks.conditions["condition " + std::to_string(callback)] = [this, callback]
+                {
+                    return next(callback_count + callback) % 2 == 0;
+                };
+            }
+            return callbacks;
+        }
+
+        std::string log;
+
+    private:
+        uint32_t next(uint32_t callback)
+        {
+            log += std::to_string(callback);
+            log += ' ';
+            auto value = seed ^ (callback * 0x9E3779B9u) ^ (calls[callback]++ * 0x85EBCA6Bu);
+            value ^= value >> 15u;
+            value *= 0x2C1B3C6Du;
+            value ^= value >> 12u;
+            return value;
+        }
+
+        uint32_t seed;
+        std::vector<uint32_t> calls;
+    };
+
+    // Replaces the default memory resource until the end of the scope.
+    class DefaultResourceScope
+    {
+    public:
+        explicit DefaultResourceScope(std::pmr::memory_resource *resource):
+                previous{std::pmr::set_default_resource(resource)}
+        {
+        }
+
+        ~DefaultResourceScope()
+        {
+            std::pmr::set_default_resource(previous);
+        }
+
+        DefaultResourceScope(const DefaultResourceScope &) = delete;
+        DefaultResourceScope &operator=(const DefaultResourceScope &) = delete;
+
+        std::pmr::memory_resource *const previous;
+    };
+
+    bool is_ancestor(const TreeDocument &document, index_t ancestor, index_t node)
+    {
+        for(; node != TreeDocument::no_node; node = document.get_parent(node))
+        {
+            if(node == ancestor)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Nodes are added in pre-order, so a link can point to any earlier node except its ancestors -
+    // what BehaviorTree accepts, and never a cycle.
+    TreeDocument make_random_tree(std::mt19937 &random, size_t node_limit)
+    {
+        TreeDocument document;
+        std::vector<std::pair<index_t, uint32_t>> path;
+        const auto add = [&](index_t parent, NodeKind kind)
+        {
+            std::string label;
+            uint32_t parameter = 0;
+            switch(kind)
+            {
+                case NodeKind::action:
+                    label = "action " + std::to_string(random() % callback_count);
+                    break;
+                case NodeKind::condition:
+                    label = "condition " + std::to_string(random() % callback_count);
+                    break;
+                case NodeKind::link:
+                {
+                    const auto target = static_cast<index_t>(random() % document.size());
+                    if(is_ancestor(document, target, parent))
+                    {
+                        label = "action 0";
+                        kind = NodeKind::action;
+                    }
+                    parameter = document.get_id(target);
+                    break;
+                }
+                case NodeKind::loop:
+                case NodeKind::max_n_tries:
+                    parameter = static_cast<uint32_t>(random() % 4 + 1);
+                    break;
+                default:
+                    break;
+            }
+            const auto node = document.add_node(parent, kind, label, parameter);
+            const auto children = get_max_children(kind) == 1 ? 1u : kind == NodeKind::selector ||
+                                                                   kind == NodeKind::sequence ? random() % 5 : 0u;
+            if(children > 0)
+            {
+                path.emplace_back(node, static_cast<uint32_t>(children));
+            }
+        };
+
+        add(TreeDocument::no_node, random() % 2 == 0 ? NodeKind::selector : NodeKind::sequence);
+        while(!path.empty())
+        {
+            auto &[parent, remaining] = path.back();
+            if(remaining == 0)
+            {
+                path.pop_back();
+                continue;
+            }
+            --remaining;
+            const auto owner = parent;
+            if(document.size() >= node_limit)
+            {
+                // Out of nodes: decorators still need their child, composites may stay short.
+                if(get_max_children(document.get_kind(owner)) == 1)
+                {
+                    add(owner, NodeKind::action);
+                }
+                continue;
+            }
+            add(owner, static_cast<NodeKind>(random() % node_kind_count));
+        }
+        return document;
+    }
+}
+
+TEST_CASE("Compiled tree lays nodes out in pre-order", "[compiled_tree]")
+{
+    TreeDocument document;
+    const auto root = document.add_node(TreeDocument::no_node, NodeKind::sequence, "root");
+    const auto invert = document.add_node(root, NodeKind::invert, "invert");
+    document.add_node(invert, NodeKind::condition, "ready");
+    document.add_node(root, NodeKind::link, "again", document.get_id(invert));
+    document.add_node(root, NodeKind::action, "run");
+
+    BehaviorCallbacks callbacks;
+    callbacks.conditions["ready"] = [] { return false; };
+    callbacks.actions["run"] = [] { return BehaviorState::running; };
+    CompiledTree tree{document, callbacks};
+
+    const auto &instructions = tree.get_program().get_instructions();
+    REQUIRE(instructions.size() == 5);
+    REQUIRE(instructions[0].kind == NodeKind::sequence);
+    REQUIRE(instructions[0].end == 5);
+    REQUIRE(instructions[1].end == 3);
+    REQUIRE(instructions[3].kind == NodeKind::link);
+    REQUIRE(instructions[3].operand == 1);
+    REQUIRE(tree.get_program().get_slot_count() == 1);
+
+    REQUIRE(tree.evaluate() == BehaviorState::running);
+}
+
+TEST_CASE("Compiled tree rejects trees it cannot run", "[compiled_tree]")
+{
+    TreeDocument document;
+    const auto root = document.add_node(TreeDocument::no_node, NodeKind::selector, "root");
+    const auto loop = document.add_node(root, NodeKind::loop, "loop", 2);
+    REQUIRE_THROWS_AS(CompiledTree(document, {}), std::invalid_argument);
+
+    document.add_node(loop, NodeKind::action, "unknown");
+    REQUIRE_THROWS_AS(CompiledTree(document, {}), std::invalid_argument);
+}
+
+TEST_CASE("Compiled tree behaves like BehaviorTree", "[compiled_tree]")
+{
+    std::mt19937 random{2020};
+    for(uint32_t round = 0; round < 200; ++round)
+    {
+        const auto document = make_random_tree(random, 2 + random() % 60);
+
+        Script runtime_script{round};
+        BehaviorTree runtime_tree;
+        build_behavior_tree(document, runtime_script.bind(), runtime_tree);
+
+        Script compiled_script{round};
+        CompiledTree compiled_tree{document, compiled_script.bind()};
+
+        for(int tick = 0; tick < 30; ++tick)
+        {
+            CAPTURE(round, tick);
+            REQUIRE(compiled_tree.evaluate() == runtime_tree.evaluate());
+            REQUIRE(compiled_script.log == runtime_script.log);
+        }
+    }
+}
+
+TEST_CASE("Compiled trees allocate from the given resource", "[compiled_tree]")
+{
+    // Nothing may come from the default resource: the arena has a fixed buffer and nothing upstream.
+    std::vector<std::byte> buffer(1 << 20);
+    std::pmr::monotonic_buffer_resource arena{buffer.data(), buffer.size(), std::pmr::null_memory_resource()};
+    const DefaultResourceScope no_default{std::pmr::null_memory_resource()};
+
+    std::mt19937 random{2020};
+    std::vector<TreeDocument> documents;
+    std::vector<Script> heap_scripts;
+    std::vector<Script> arena_scripts;
+    for(uint32_t round = 0; round < 50; ++round)
+    {
+        documents.push_back(make_random_tree(random, 2 + random() % 60));
+        heap_scripts.emplace_back(round);
+        arena_scripts.emplace_back(round);
+    }
+    std::pmr::vector<CompiledTree> arena_trees{&arena};
+    arena_trees.reserve(documents.size());
+    for(size_t tree = 0; tree < documents.size(); ++tree)
+    {
+        arena_trees.emplace_back(documents[tree], arena_scripts[tree].bind(), &arena);
+    }
+    std::vector<CompiledTree> heap_trees;
+    for(size_t tree = 0; tree < documents.size(); ++tree)
+    {
+        heap_trees.emplace_back(documents[tree], heap_scripts[tree].bind(), no_default.previous);
+    }
+
+    for(int tick = 0; tick < 30; ++tick)
+    {
+        for(size_t tree = 0; tree < documents.size(); ++tree)
+        {
+            CAPTURE(tree, tick);
+            REQUIRE(arena_trees[tree].evaluate() == heap_trees[tree].evaluate());
+            REQUIRE(arena_scripts[tree].log == heap_scripts[tree].log);
+        }
+    }
+}
+
+TEST_CASE("Compiled tree throughput", "[compiled_tree][benchmarks][!benchmark]")
+{
+    // Every tick visits every node: each selector tries all its failing conditions before the
+    // action, and the sequence goes through all selectors.
+    TreeDocument document;
+    const auto root = document.add_node(TreeDocument::no_node, NodeKind::sequence, "root");
+    for(int branch = 0; branch < 50; ++branch)
+    {
+        const auto selector = document.add_node(root, NodeKind::selector, "branch");
+        for(int condition = 0; condition < 18; ++condition)
+        {
+            document.add_node(selector, NodeKind::condition, "blocked");
+        }
+        const auto invert = document.add_node(selector, NodeKind::invert, "invert");
+        document.add_node(invert, NodeKind::action, "fail");
+    }
+
+    uint64_t calls = 0;
+    BehaviorCallbacks callbacks;
+    callbacks.conditions["blocked"] = [&calls] { return ++calls == 0; };
+    callbacks.actions["fail"] = [&calls]
+    {
+        ++calls;
+        return BehaviorState::failure;
+    };
+
+    BehaviorTree runtime_tree;
+    build_behavior_tree(document, callbacks, runtime_tree);
+    CompiledTree compiled_tree{document, callbacks};
+    REQUIRE(runtime_tree.evaluate() == compiled_tree.evaluate());
+
+    BENCHMARK("BehaviorTree tick, 1000 nodes")
+    {
+        return runtime_tree.evaluate();
+    };
+    BENCHMARK("Compiled tree tick, 1000 nodes")
+    {
+        return compiled_tree.evaluate();
+    };
+}
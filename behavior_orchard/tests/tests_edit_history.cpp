@@ -0,0 +1,281 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#include "catch.hpp"
+
+#include "../io/TreeTextFormat.hpp"
+#include "../model/EditHistory.hpp"
+
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using index_t = TreeDocument::index_t;
+
+    std::string to_text(const TreeDocument &document)
+    {
+        std::ostringstream output;
+        save_tree_text(document, output);
+        return output.str();
+    }
+
+    std::vector<index_t> get_nodes(const TreeDocument &document)
+    {
+        std::vector<index_t> nodes;
+        for(index_t node = 0; node < document.get_capacity(); ++node)
+        {
+            if(document.contains(node))
+            {
+                nodes.push_back(node);
+            }
+        }
+        return nodes;
+    }
+
+    // One random edit: mostly additions, so the tree grows while it is being cut and relabelled.
+    void edit_randomly(std::mt19937 &random, EditHistory &history, TreeDocument &document)
+    {
+        const auto nodes = get_nodes(document);
+        const auto node = nodes[random() % nodes.size()];
+        switch(random() % 6)
+        {
+            case 0:
+                if(node != document.get_root())
+                {
+                    std::vector<index_t> removed;
+                    history.remove_subtree(document, node, removed);
+                    return;
+                }
+                [[fallthrough]];
+            case 1:
+                history.modify_node(document, node, "edit " + std::to_string(random() % 1000),
+                                    static_cast<uint32_t>(random() % 5));
+                return;
+            default:
+            {
+                const auto kind = static_cast<NodeKind>(random() % node_kind_count);
+                if(history.add_node(document, node, kind, get_node_kind_name(kind), 1) == TreeDocument::no_node)
+                {
+                    history.modify_node(document, node, "full", 0);
+                }
+                return;
+            }
+        }
+    }
+
+    // Root selector, thousand sequences of 99 actions each.
+    TreeDocument make_large_tree()
+    {
+        TreeDocument document;
+        const auto root = document.add_node(TreeDocument::no_node, NodeKind::selector, "root");
+        for(int branch = 0; branch < 1000; ++branch)
+        {
+            const auto sequence = document.add_node(root, NodeKind::sequence, "branch " + std::to_string(branch));
+            for(int step = 0; step < 99; ++step)
+            {
+                document.add_node(sequence, NodeKind::action, "step " + std::to_string(step));
+            }
+        }
+        return document;
+    }
+}
+
+TEST_CASE("Nodes can be put back between siblings", "[edit_history]")
+{
+    TreeDocument document;
+    const auto root = document.add_node(TreeDocument::no_node, NodeKind::sequence, "root");
+    const auto first = document.add_node(root, NodeKind::action, "first");
+    const auto last = document.add_node(root, NodeKind::action, "last");
+    const auto middle = document.insert_node(root, last, NodeKind::action, "middle", 0, 10);
+    const auto front = document.insert_node(root, first, NodeKind::action, "front", 0, 11);
+
+    REQUIRE(document.get_first_child(root) == front);
+    REQUIRE(document.get_next_sibling(front) == first);
+    REQUIRE(document.get_next_sibling(first) == middle);
+    REQUIRE(document.get_next_sibling(middle) == last);
+    REQUIRE(document.get_previous_sibling(last) == middle);
+    REQUIRE(document.get_child_count(root) == 4);
+    REQUIRE(document.get_next_id() == 12);
+    REQUIRE_THROWS_AS(document.insert_node(root, root, NodeKind::action, "nowhere", 0, 12), std::invalid_argument);
+    REQUIRE_THROWS_AS(document.insert_node(root, last, NodeKind::action, "taken", 0, 10), std::invalid_argument);
+}
+
+TEST_CASE("Undo and redo walk through every state", "[edit_history]")
+{
+    std::mt19937 random{1010};
+    for(int round = 0; round < 20; ++round)
+    {
+        TreeDocument document;
+        document.add_node(TreeDocument::no_node, NodeKind::selector, "root");
+        EditHistory history;
+        std::vector<std::string> states{to_text(document)};
+        for(int edit = 0; edit < 150; ++edit)
+        {
+            edit_randomly(random, history, document);
+            states.push_back(to_text(document));
+        }
+        REQUIRE(history.get_undo_count() == 150);
+
+        // Back half way, forward a little, then all the way back and all the way forward.
+        EditChange change;
+        for(auto state = states.size() - 1; state-- > 75;)
+        {
+            REQUIRE(history.undo(document, change));
+            REQUIRE(to_text(document) == states[state]);
+        }
+        for(size_t state = 76; state <= 100; ++state)
+        {
+            REQUIRE(history.redo(document, change));
+            REQUIRE(to_text(document) == states[state]);
+        }
+        for(auto state = size_t{100}; state-- > 0;)
+        {
+            REQUIRE(history.undo(document, change));
+            REQUIRE(to_text(document) == states[state]);
+        }
+        REQUIRE_FALSE(history.undo(document, change));
+        for(size_t state = 1; state < states.size(); ++state)
+        {
+            REQUIRE(history.redo(document, change));
+            REQUIRE(to_text(document) == states[state]);
+        }
+        REQUIRE_FALSE(history.redo(document, change));
+    }
+}
+
+TEST_CASE("Undo reports what changed", "[edit_history]")
+{
+    TreeDocument document;
+    EditHistory history;
+    const auto root = history.add_node(document, TreeDocument::no_node, NodeKind::sequence, "root", 0);
+    const auto loop = history.add_node(document, root, NodeKind::loop, "loop", 3);
+    history.add_node(document, loop, NodeKind::action, "act", 0);
+    const auto last = history.add_node(document, root, NodeKind::action, "last", 0);
+    EditChange change;
+
+    std::vector<index_t> removed;
+    history.remove_subtree(document, loop, removed);
+    REQUIRE(removed.size() == 2);
+    REQUIRE(history.undo(document, change));
+    REQUIRE(change.added.size() == 2);
+    REQUIRE(document.get_kind(change.added[0]) == NodeKind::loop);
+    REQUIRE(document.get_parameter(change.added[0]) == 3);
+    REQUIRE(document.get_parent(change.added[1]) == change.added[0]);
+    REQUIRE(document.get_next_sibling(change.added[0]) == last);
+    REQUIRE(change.parent == root);
+    REQUIRE(change.focus == change.added[0]);
+
+    history.modify_node(document, last, "renamed", 7);
+    REQUIRE(history.get_redo_count() == 0);
+    REQUIRE(history.undo(document, change));
+    REQUIRE(change.modified == last);
+    REQUIRE(document.get_label(last) == "last");
+    REQUIRE(document.get_parameter(last) == 0);
+
+    REQUIRE(history.undo(document, change));
+    REQUIRE(change.removed == std::vector<index_t>{last});
+    REQUIRE(change.parent == root);
+    REQUIRE(change.focus == root);
+}
+
+TEST_CASE("History stays within its memory budget", "[edit_history]")
+{
+    auto document = make_large_tree();
+    EditHistory history{64 * 1024};
+    const auto root = document.get_root();
+
+    for(int edit = 0; edit < 10000; ++edit)
+    {
+        history.modify_node(document, root, "a label long enough to need its own allocation", 0);
+        REQUIRE(history.get_memory_usage() <= history.get_memory_budget());
+    }
+    REQUIRE(history.get_undo_count() > 100);
+    REQUIRE(history.get_undo_count() < 10000);
+
+    // Removing a whole branch alone outweighs the budget; it is still the one step left to undo.
+    std::vector<index_t> removed;
+    history.remove_subtree(document, root, removed);
+    REQUIRE(history.get_undo_count() == 1);
+    REQUIRE(history.get_memory_usage() > history.get_memory_budget());
+    EditChange change;
+    REQUIRE(history.undo(document, change));
+    REQUIRE(document.size() == 100001);
+    REQUIRE(history.redo(document, change));
+    REQUIRE(document.is_empty());
+}
+
+TEST_CASE("Edit history cost per edit", "[edit_history][benchmarks][!benchmark]")
+{
+    auto document = make_large_tree();
+    const auto node_count = document.size();
+    const auto snapshot_bytes = document.get_memory_usage();
+    const auto branch = document.get_first_child(document.get_root());
+    const auto leaf = document.get_first_child(branch);
+
+    // Memory each kind of step takes, against a snapshot of the whole document per edit.
+    const auto measure = [&](const char *edit_name, int edits, auto edit)
+    {
+        EditHistory history{size_t{1} << 30};
+        for(int i = 0; i < edits; ++i)
+        {
+            edit(history);
+        }
+        WARN(edit_name << ": " << history.get_memory_usage() / static_cast<size_t>(edits)
+                       << " bytes per step, snapshot of " << node_count << " nodes: " << snapshot_bytes << " bytes");
+        EditChange change;
+        while(history.undo(document, change))
+        {
+        }
+    };
+    measure("modify node", 1000, [&](EditHistory &history) { history.modify_node(document, leaf, "a new label", 2); });
+    measure("add node", 1000, [&](EditHistory &history)
+    {
+        history.add_node(document, branch, NodeKind::action, "added", 0);
+    });
+    measure("delete 100-node branch", 999, [&](EditHistory &history)
+    {
+        std::vector<index_t> removed;
+        history.remove_subtree(document, document.get_last_child(document.get_root()), removed);
+    });
+    REQUIRE(document.size() == 100001);
+
+    EditHistory history;
+    EditChange change;
+    std::vector<index_t> removed;
+    BENCHMARK("Modify node and undo, 100k nodes")
+    {
+        history.modify_node(document, leaf, "a new label", 2);
+        return history.undo(document, change);
+    };
+    BENCHMARK("Delete 100-node branch and undo, 100k nodes")
+    {
+        removed.clear();
+        history.remove_subtree(document, document.get_last_child(document.get_root()), removed);
+        return history.undo(document, change);
+    };
+}
@@ -0,0 +1,239 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "catch.hpp"
+
+#include "TreeGenerators.hpp"
+#include "../model/NodeSearchIndex.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using index_t = TreeDocument::index_t;
+
+    constexpr uint32_t seed = 2020;
+
+    const std::vector<std::string> words = {"Patrol", "attack", "Flee", "reload", "heal", "take cover", "Wander",
+                                            "is enemy visible", "has ammo", "is wounded"};
+
+    std::string make_label(std::mt19937 &random)
+    {
+        return words[random() % words.size()] + " " + std::to_string(random() % 500);
+    }
+
+    std::vector<index_t> get_nodes(const TreeDocument &document)
+    {
+        std::vector<index_t> nodes;
+        for(index_t node = 0; node < document.get_capacity(); ++node)
+        {
+            if(document.contains(node))
+            {
+                nodes.push_back(node);
+            }
+        }
+        return nodes;
+    }
+
+    std::string to_lower(std::string_view text)
+    {
+        std::string lowered{text};
+        std::transform(lowered.begin(), lowered.end(), lowered.begin(),
+                       [](char character) { return static_cast<char>(std::tolower(static_cast<unsigned char>(character))); });
+        return lowered;
+    }
+
+    // Every node whose label contains the text, by ID - what the index has to find.
+    std::vector<index_t> find_by_scanning(const TreeDocument &document, std::string_view text)
+    {
+        std::vector<index_t> found;
+        for(const auto node: get_nodes(document))
+        {
+            if(to_lower(document.get_label(node)).find(to_lower(text)) != std::string::npos)
+            {
+                found.push_back(node);
+            }
+        }
+        std::sort(found.begin(), found.end(),
+                  [&](index_t first, index_t second) { return document.get_id(first) < document.get_id(second); });
+        return found;
+    }
+
+    NodeQuery make_query(std::string_view text, size_t max_results = SIZE_MAX)
+    {
+        NodeQuery query;
+        query.text = text;
+        query.max_results = max_results;
+        return query;
+    }
+}
+
+TEST_CASE("Nodes are found by label, ID and kind", "[node_search]")
+{
+    TreeDocument document;
+    const auto root = document.add_node(TreeDocument::no_node, NodeKind::selector, "Combat");
+    const auto attack = document.add_node(root, NodeKind::action, "Attack the enemy");
+    const auto visible = document.add_node(root, NodeKind::condition, "is enemy visible");
+    const auto loop = document.add_node(root, NodeKind::loop, "attack again", 3);
+    const auto short_label = document.add_node(root, NodeKind::action, "go");
+    NodeSearchIndex index{document};
+    index.rebuild();
+    std::vector<index_t> results;
+
+    REQUIRE(index.search(make_query("ENEMY"), results) == NodeMatch::substring);
+    REQUIRE(results == std::vector<index_t>{attack, visible});
+    REQUIRE(index.search(make_query("attack"), results) == NodeMatch::substring);
+    REQUIRE(results == std::vector<index_t>{attack, loop});
+    REQUIRE(index.search(make_query("attack", 1), results) == NodeMatch::substring);
+    REQUIRE(results == std::vector<index_t>{attack});
+
+    auto query = make_query("attack");
+    query.kinds.reset();
+    query.kinds.set(static_cast<size_t>(NodeKind::loop));
+    REQUIRE(index.search(query, results) == NodeMatch::substring);
+    REQUIRE(results == std::vector<index_t>{loop});
+    query.text = "";
+    REQUIRE(index.search(query, results) == NodeMatch::substring);
+    REQUIRE(results == std::vector<index_t>{loop});
+
+    REQUIRE(index.search(make_query("#2"), results) == NodeMatch::id);
+    REQUIRE(results == std::vector<index_t>{visible});
+    REQUIRE(index.search(make_query("#99"), results) == NodeMatch::none);
+    REQUIRE(index.search(make_query("go"), results) == NodeMatch::substring);
+    REQUIRE(results == std::vector<index_t>{short_label});
+
+    // Typos still find something, best match first.
+    REQUIRE(index.search(make_query("is enemy visibel"), results) == NodeMatch::similar);
+    REQUIRE(results.front() == visible);
+    REQUIRE(index.search(make_query("xyzzy"), results) == NodeMatch::none);
+    REQUIRE(results.empty());
+}
+
+TEST_CASE("Node search follows edits", "[node_search]")
+{
+    TreeDocument document;
+    generate_realistic_tree(document, 3000, seed);
+    std::mt19937 random{seed};
+    for(const auto node: get_nodes(document))
+    {
+        document.set_label(node, make_label(random));
+    }
+    NodeSearchIndex index{document};
+    index.rebuild();
+
+    std::vector<index_t> results;
+    for(int round = 0; round < 40; ++round)
+    {
+        // Enough relabelling to compact the index a few times over.
+        for(int edit = 0; edit < 200; ++edit)
+        {
+            const auto nodes = get_nodes(document);
+            const auto node = nodes[random() % nodes.size()];
+            switch(random() % 4)
+            {
+                case 0:
+                    if(node != document.get_root())
+                    {
+                        std::vector<index_t> removed;
+                        document.remove_subtree(node, removed);
+                        for(const auto removed_node: removed)
+                        {
+                            index.forget(removed_node);
+                        }
+                        break;
+                    }
+                    [[fallthrough]];
+                case 1:
+                    document.set_label(node, make_label(random));
+                    index.update(node);
+                    break;
+                default:
+                {
+                    const auto added = document.add_node(node, NodeKind::action, make_label(random));
+                    if(added != TreeDocument::no_node)
+                    {
+                        index.update(added);
+                    }
+                    break;
+                }
+            }
+        }
+
+        for(const auto &text: {std::string{"attack"}, std::string{"is e"}, std::string{"ER 1"}, std::string{"er"},
+                               words[random() % words.size()] + " " + std::to_string(random() % 50)})
+        {
+            const auto expected = find_by_scanning(document, text);
+            const auto match = index.search(make_query(text), results);
+            if(!expected.empty())
+            {
+                REQUIRE(match == NodeMatch::substring);
+                REQUIRE(results == expected);
+            }
+            else
+            {
+                REQUIRE(match != NodeMatch::substring);
+            }
+        }
+    }
+}
+
+TEST_CASE("Node search cost", "[node_search][benchmarks][!benchmark]")
+{
+    constexpr size_t node_count = 100000;
+    TreeDocument document;
+    generate_realistic_tree(document, node_count, seed);
+    std::mt19937 random{seed};
+    for(const auto node: get_nodes(document))
+    {
+        document.set_label(node, make_label(random));
+    }
+    NodeSearchIndex index{document};
+    BENCHMARK("Index 100000 labels")
+    {
+        index.rebuild();
+        return index.get_memory_usage();
+    };
+    WARN("index of " << document.size() << " nodes: " << index.get_memory_usage() / 1024 << " kB, labels "
+                     << document.get_memory_usage() / 1024 << " kB");
+
+    std::vector<index_t> results;
+    for(const auto text: {"#73021", "ta", "take cover 42", "is enemy", "take covre 42"})
+    {
+        BENCHMARK(std::string{"Search \""} + text + "\", 100 results")
+        {
+            return index.search(make_query(text, 100), results);
+        };
+    }
+    const auto node = get_nodes(document)[node_count / 2];
+    BENCHMARK("Relabel a node")
+    {
+        document.set_label(node, make_label(random));
+        index.update(node);
+        return node;
+    };
+}
@@ -0,0 +1,251 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#include "catch.hpp"
+
+#include "../io/ProfileFile.hpp"
+#include "../runtime/CompiledTree.hpp"
+#include "../runtime/TreeProfiler.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // IDs: 0 root, 1 guard, 2 ready, 3 slow, 4 idle.
+    TreeDocument make_sample_tree()
+    {
+        TreeDocument document;
+        const auto root = document.add_node(TreeDocument::no_node, NodeKind::selector, "root");
+        const auto guard = document.add_node(root, NodeKind::sequence, "guard");
+        document.add_node(guard, NodeKind::condition, "ready");
+        document.add_node(guard, NodeKind::action, "slow \"work\"");
+        document.add_node(root, NodeKind::action, "idle");
+        return document;
+    }
+
+    BehaviorCallbacks make_sample_callbacks()
+    {
+        BehaviorCallbacks callbacks;
+        callbacks.conditions["ready"] = [] { return true; };
+        callbacks.actions["slow \"work\""] = []
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            return BehaviorState::failure;
+        };
+        callbacks.actions["idle"] = [] { return BehaviorState::success; };
+        return callbacks;
+    }
+}
+
+TEST_CASE("Latency histogram buckets", "[profiler]")
+{
+    SECTION("Every value falls into a bucket covering it, within 1/16 of it")
+    {
+        std::mt19937_64 random{16};
+        for(int i = 0; i < 100000; ++i)
+        {
+            const auto value = random() >> (random() % 64);
+            const auto bucket = LatencyHistogram::get_bucket(value);
+            REQUIRE(bucket < LatencyHistogram::bucket_count);
+            REQUIRE(LatencyHistogram::get_bucket_low(bucket) <= value);
+            REQUIRE(value <= LatencyHistogram::get_bucket_high(bucket));
+            if(bucket + 1 < LatencyHistogram::bucket_count)
+            {
+                const auto width = LatencyHistogram::get_bucket_high(bucket) - LatencyHistogram::get_bucket_low(bucket);
+                REQUIRE(width * LatencyHistogram::sub_bucket_count <= value);
+            }
+        }
+    }
+    SECTION("Buckets are contiguous")
+    {
+        for(uint32_t bucket = 1; bucket < LatencyHistogram::bucket_count; ++bucket)
+        {
+            REQUIRE(LatencyHistogram::get_bucket_low(bucket) == LatencyHistogram::get_bucket_high(bucket - 1) + 1);
+            REQUIRE(LatencyHistogram::get_bucket(LatencyHistogram::get_bucket_low(bucket)) == bucket);
+        }
+    }
+    SECTION("Percentiles")
+    {
+        LatencyHistogram histogram;
+        REQUIRE(histogram.get_percentile(0.5) == 0);
+        for(uint64_t value = 1; value <= 1000; ++value)
+        {
+            histogram.record(value * 1000);
+        }
+        REQUIRE(histogram.get_count() == 1000);
+        REQUIRE(histogram.get_min() == 1000);
+        REQUIRE(histogram.get_max() == 1000000);
+        REQUIRE(histogram.get_mean() == Approx(500500.0));
+        for(const auto fraction: {0.01, 0.5, 0.9, 0.99, 0.999})
+        {
+            const auto exact = fraction * 1000.0 * 1000.0;
+            REQUIRE(static_cast<double>(histogram.get_percentile(fraction)) >= exact);
+            REQUIRE(static_cast<double>(histogram.get_percentile(fraction)) <= exact * 17.0 / 16.0);
+        }
+        REQUIRE(histogram.get_percentile(1.0) == 1000000);
+    }
+}
+
+TEST_CASE("Profiler times nodes of sampled ticks", "[profiler]")
+{
+    const auto document = make_sample_tree();
+    CompiledTree tree{document, make_sample_callbacks()};
+    TreeProfiler profiler{tree.get_program(), 3, 8};
+    tree.set_profiler(&profiler);
+
+    for(int tick = 0; tick < 9; ++tick)
+    {
+        REQUIRE(tree.evaluate() == BehaviorState::success);
+    }
+    REQUIRE(profiler.get_tick_count() == 9);
+    // Positions are pre-order, the same as IDs here.
+    for(uint32_t position = 0; position < 5; ++position)
+    {
+        REQUIRE(profiler.get_histogram(position).get_count() == 3);
+    }
+    const auto &slow = profiler.get_histogram(3);
+    REQUIRE(slow.get_min() >= 200000);
+    REQUIRE(profiler.get_histogram(1).get_min() >= slow.get_min());
+    REQUIRE(profiler.get_histogram(0).get_percentile(0.5) >= profiler.get_histogram(1).get_percentile(0.5));
+
+    // Five spans a timed tick, children close first; only eight of fifteen are kept.
+    const auto &spans = profiler.get_spans();
+    REQUIRE(spans.size() == 8);
+    REQUIRE(profiler.get_dropped_spans() == 7);
+    REQUIRE(spans[0].position == 2);
+    REQUIRE(spans[0].depth == 2);
+    REQUIRE(spans[4].position == 0);
+    REQUIRE(spans[4].depth == 0);
+    for(uint32_t child = 0; child < 4; ++child)
+    {
+        REQUIRE(spans[child].start >= spans[4].start);
+        REQUIRE(spans[child].start + spans[child].duration <= spans[4].start + spans[4].duration);
+    }
+
+    SECTION("Exports")
+    {
+        std::ostringstream trace;
+        profiler.write_chrome_trace(trace, document);
+        const auto json = trace.str();
+        REQUIRE(json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0) == 0);
+        REQUIRE(json.find("{\"name\":\"slow \\\"work\\\"\",\"cat\":\"Action\",\"ph\":\"X\",\"ts\":") != std::string::npos);
+        REQUIRE(json.find("\"args\":{\"id\":0,\"depth\":0}},\n") != std::string::npos);
+        REQUIRE(std::count(json.begin(), json.end(), '\n') == 10);
+        REQUIRE(json.compare(json.size() - 5, 5, "}\n]}\n") == 0);
+
+        std::ostringstream summary;
+        profiler.write_summary(summary, document);
+        // Header and one row per timed node, the idle action (a bare callback) last.
+        const auto table = summary.str();
+        REQUIRE(table.rfind("      id  kind", 0) == 0);
+        REQUIRE(std::count(table.begin(), table.end(), '\n') == 6);
+        REQUIRE(table.find("slow \"work\"\n") != std::string::npos);
+        REQUIRE(table.find("idle\n") == table.size() - 5);
+    }
+    SECTION("Profile file round trip")
+    {
+        const auto latencies = profiler.get_latencies();
+        REQUIRE(latencies.size() == 5);
+        const auto path = std::filesystem::temp_directory_path() / "orchard_profile_test.btprof";
+        save_profile(latencies, path);
+        std::vector<NodeLatency> loaded;
+        load_profile(path, loaded);
+        REQUIRE(loaded.size() == 5);
+        for(size_t i = 0; i < loaded.size(); ++i)
+        {
+            REQUIRE(loaded[i].node == latencies[i].node);
+            REQUIRE(loaded[i].histogram.get_count() == latencies[i].histogram.get_count());
+            REQUIRE(loaded[i].histogram.get_percentile(0.99) == latencies[i].histogram.get_percentile(0.99));
+            REQUIRE(loaded[i].histogram.get_max() == latencies[i].histogram.get_max());
+            REQUIRE(loaded[i].histogram.get_sum() == latencies[i].histogram.get_sum());
+        }
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+        REQUIRE_THROWS_AS(load_profile(path, loaded), std::runtime_error);
+        REQUIRE(loaded.size() == 5);
+        std::filesystem::remove(path);
+    }
+    SECTION("Profiling stops")
+    {
+        tree.set_profiler(nullptr);
+        tree.evaluate();
+        REQUIRE(profiler.get_tick_count() == 9);
+    }
+}
+
+TEST_CASE("Profiler has to match the tree", "[profiler]")
+{
+    const auto document = make_sample_tree();
+    CompiledTree tree{document, make_sample_callbacks()};
+    REQUIRE_THROWS_AS(TreeProfiler(tree.get_program(), 0), std::invalid_argument);
+
+    TreeDocument other;
+    other.add_node(TreeDocument::no_node, NodeKind::action, "idle");
+    CompiledTree other_tree{other, make_sample_callbacks()};
+    TreeProfiler profiler{other_tree.get_program()};
+    REQUIRE_THROWS_AS(tree.set_profiler(&profiler), std::invalid_argument);
+}
+
+TEST_CASE("Profiling overhead", "[profiler][benchmarks][!benchmark]")
+{
+    TreeDocument document;
+    const auto root = document.add_node(TreeDocument::no_node, NodeKind::sequence, "root");
+    for(int branch = 0; branch < 50; ++branch)
+    {
+        const auto selector = document.add_node(root, NodeKind::selector, "branch");
+        for(int condition = 0; condition < 18; ++condition)
+        {
+            document.add_node(selector, NodeKind::condition, "blocked");
+        }
+        const auto invert = document.add_node(selector, NodeKind::invert, "invert");
+        document.add_node(invert, NodeKind::action, "fail");
+    }
+    BehaviorCallbacks callbacks;
+    callbacks.conditions["blocked"] = [] { return false; };
+    callbacks.actions["fail"] = [] { return BehaviorState::failure; };
+    CompiledTree tree{document, callbacks};
+    TreeProfiler every_tick{tree.get_program(), 1, 0};
+    TreeProfiler every_64th_tick{tree.get_program(), 64, 0};
+
+    BENCHMARK("Compiled tree tick, 1000 nodes, not profiled")
+    {
+        return tree.evaluate();
+    };
+    tree.set_profiler(&every_tick);
+    BENCHMARK("Compiled tree tick, 1000 nodes, every tick profiled")
+    {
+        return tree.evaluate();
+    };
+    tree.set_profiler(&every_64th_tick);
+    BENCHMARK("Compiled tree tick, 1000 nodes, every 64th tick profiled")
+    {
+        return tree.evaluate();
+    };
+}
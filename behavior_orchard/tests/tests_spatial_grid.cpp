@@ -0,0 +1,182 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "catch.hpp"
+
+#include "../view/SpatialGrid.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using Items = std::vector<SpatialGrid::item_t>;
+
+    Items query_sorted(const SpatialGrid &grid, const Rect &area)
+    {
+        Items items;
+        grid.query(area, items);
+        std::sort(items.begin(), items.end());
+        return items;
+    }
+}
+
+TEST_CASE("Rect intersects, unites and inflates", "[spatial_grid]")
+{
+    const Rect rect{10, 20, 30, 40};
+    REQUIRE(rect.right() == 40);
+    REQUIRE(rect.bottom() == 60);
+    REQUIRE(rect.intersects(Rect{39, 59, 5, 5}));
+    // Edges are exclusive.
+    REQUIRE(!rect.intersects(Rect{40, 20, 5, 5}));
+    REQUIRE(Rect{}.is_empty());
+    REQUIRE(rect.united(Rect{}) == rect);
+    REQUIRE(Rect{}.united(rect) == rect);
+    REQUIRE(rect.united(Rect{0, 0, 5, 5}) == Rect{0, 0, 40, 60});
+    REQUIRE(rect.inflated(2) == Rect{8, 18, 34, 44});
+}
+
+TEST_CASE("Spatial grid inserts, moves, removes and queries", "[spatial_grid]")
+{
+    SpatialGrid grid{100};
+    REQUIRE_THROWS_AS(SpatialGrid{0}, std::invalid_argument);
+
+    grid.insert(0, Rect{10, 10, 20, 20});
+    // Spans four cells, reported once.
+    grid.insert(1, Rect{90, 90, 20, 20});
+    // Negative coordinates, left of and above the origin.
+    grid.insert(5, Rect{-150, -150, 10, 10});
+    REQUIRE(grid.size() == 3);
+    REQUIRE(grid.contains(5));
+    REQUIRE(!grid.contains(2));
+    REQUIRE(grid.get_bounds(1) == Rect{90, 90, 20, 20});
+
+    REQUIRE(query_sorted(grid, Rect{0, 0, 200, 200}) == Items{0, 1});
+    REQUIRE(query_sorted(grid, Rect{105, 105, 10, 10}) == Items{1});
+    REQUIRE(query_sorted(grid, Rect{-200, -200, 100, 100}) == Items{5});
+    REQUIRE(query_sorted(grid, Rect{500, 500, 10, 10}).empty());
+    REQUIRE(query_sorted(grid, Rect{0, 0, 0, 0}).empty());
+    // Bigger than everything populated.
+    REQUIRE(query_sorted(grid, Rect{-10000, -10000, 20000, 20000}) == Items{0, 1, 5});
+
+    // Within the same cells and across them.
+    grid.move(0, Rect{15, 15, 20, 20});
+    REQUIRE(grid.get_bounds(0) == Rect{15, 15, 20, 20});
+    REQUIRE(query_sorted(grid, Rect{10, 10, 6, 6}) == Items{0});
+    grid.move(0, Rect{410, 410, 20, 20});
+    REQUIRE(query_sorted(grid, Rect{0, 0, 50, 50}).empty());
+    REQUIRE(query_sorted(grid, Rect{400, 400, 50, 50}) == Items{0});
+    // Moving what is not there inserts it, inserting what is there moves it.
+    grid.move(2, Rect{0, 0, 5, 5});
+    grid.insert(2, Rect{300, 0, 5, 5});
+    REQUIRE(grid.size() == 4);
+    REQUIRE(query_sorted(grid, Rect{0, 0, 50, 50}).empty());
+
+    grid.remove(1);
+    grid.remove(1);
+    REQUIRE(grid.size() == 3);
+    REQUIRE(!grid.contains(1));
+    REQUIRE(query_sorted(grid, Rect{0, 0, 200, 200}).empty());
+
+    grid.clear();
+    REQUIRE(grid.size() == 0);
+    REQUIRE(query_sorted(grid, Rect{-10000, -10000, 20000, 20000}).empty());
+}
+
+TEST_CASE("Spatial grid follows an edge to a new parent", "[spatial_grid]")
+{
+    // What the renderer keeps for an edge: the box between the parent's bottom centre and the child's
+    // top centre, keyed by the child. The child keeps its bounds; the parent changes.
+    const Rect child{400, 300, 100, 40};
+    const Rect old_parent{0, 0, 100, 40};
+    const Rect new_parent{800, 0, 100, 40};
+    const auto edge_between = [](const Rect &from, const Rect &to)
+    {
+        const auto from_x = from.x + from.width / 2;
+        const auto to_x = to.x + to.width / 2;
+        const auto left = std::min(from_x, to_x);
+        return Rect{left, from.bottom(), std::max(from_x, to_x) - left, to.y - from.bottom()}.inflated(1);
+    };
+
+    SpatialGrid edges{64};
+    constexpr SpatialGrid::item_t edge = 7;
+    edges.insert(edge, edge_between(old_parent, child));
+    REQUIRE(query_sorted(edges, Rect{0, 40, 100, 100}) == Items{edge});
+
+    edges.move(edge, edge_between(new_parent, child));
+    REQUIRE(query_sorted(edges, Rect{0, 40, 100, 100}).empty());
+    REQUIRE(query_sorted(edges, Rect{800, 40, 100, 100}) == Items{edge});
+    REQUIRE(edges.size() == 1);
+}
+
+TEST_CASE("Spatial grid queries match a scan of every item", "[spatial_grid]")
+{
+    constexpr SpatialGrid::item_t item_count = 300;
+    std::mt19937 random{2020};
+    std::uniform_int_distribution<int32_t> coordinate{-2000, 2000};
+    std::uniform_int_distribution<int32_t> extent{0, 400};
+    const auto random_rect = [&]
+    {
+        return Rect{coordinate(random), coordinate(random), extent(random), extent(random)};
+    };
+
+    SpatialGrid grid{128};
+    std::vector<Rect> bounds(item_count);
+    std::vector<bool> present(item_count, false);
+    for(int step = 0; step < 5000; ++step)
+    {
+        const auto item = static_cast<SpatialGrid::item_t>(random() % item_count);
+        if(random() % 4 == 0)
+        {
+            grid.remove(item);
+            present[item] = false;
+        }
+        else
+        {
+            bounds[item] = random_rect();
+            grid.move(item, bounds[item]);
+            present[item] = true;
+        }
+
+        if(step % 50 == 0)
+        {
+            const auto area = random_rect();
+            Items expected;
+            for(SpatialGrid::item_t other = 0; other < item_count; ++other)
+            {
+                // Lines (zero width or height) count as one unit thick.
+                const auto &rect = bounds[other];
+                const Rect probe{rect.x, rect.y, std::max(rect.width, 1), std::max(rect.height, 1)};
+                if(present[other] && probe.intersects(area))
+                {
+                    expected.push_back(other);
+                }
+            }
+            const auto found = query_sorted(grid, area);
+            CAPTURE(step);
+            REQUIRE(found == expected);
+        }
+    }
+}
@@ -0,0 +1,198 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "catch.hpp"
+
+#include "generated/PatrolTree.hpp"
+#include "../codegen/StaticTreeGenerator.hpp"
+#include "../model/BehaviorTreeBridge.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace
+{
+    // Tree behind generated/PatrolTree.hpp.
+    TreeDocument make_patrol_tree()
+    {
+        TreeDocument document;
+        const auto root = document.add_node(TreeDocument::no_node, NodeKind::selector, "root");
+        const auto guard = document.add_node(root, NodeKind::sequence, "guard");
+        document.add_node(guard, NodeKind::condition, "see enemy?");
+        const auto tries = document.add_node(guard, NodeKind::max_n_tries, "tries", 5);
+        document.add_node(tries, NodeKind::action, "attack");
+        const auto loop = document.add_node(root, NodeKind::loop, "loop", 2);
+        const auto invert = document.add_node(loop, NodeKind::invert, "invert");
+        document.add_node(invert, NodeKind::action, "patrol");
+        const auto rest = document.add_node(root, NodeKind::sequence, "rest");
+        document.add_node(rest, NodeKind::condition, "tired");
+        document.add_node(rest, NodeKind::link, "guard again", document.get_id(guard));
+        return document;
+    }
+
+    // Scripted agent; records every callback, so both trees can be compared call by call.
+    struct PatrolAgent
+    {
+        BehaviorState attack()
+        {
+            log += 'a';
+            return ++attacks % 3 == 0 ? BehaviorState::success : BehaviorState::running;
+        }
+
+        BehaviorState patrol()
+        {
+            log += 'p';
+            return ++patrols % 4 == 0 ? BehaviorState::success : BehaviorState::failure;
+        }
+
+        bool see_enemy()
+        {
+            log += 's';
+            return ++sightings % 5 < 2;
+        }
+
+        bool tired()
+        {
+            log += 't';
+            return ++rests % 2 == 0;
+        }
+
+        std::string log;
+        uint32_t attacks = 0;
+        uint32_t patrols = 0;
+        uint32_t sightings = 0;
+        uint32_t rests = 0;
+    };
+
+    BehaviorCallbacks bind_callbacks(PatrolAgent &agent)
+    {
+        BehaviorCallbacks callbacks;
+        callbacks.actions["attack"] = [&agent] { return agent.attack(); };
+        callbacks.actions["patrol"] = [&agent] { return agent.patrol(); };
+        callbacks.conditions["see enemy?"] = [&agent] { return agent.see_enemy(); };
+        callbacks.conditions["tired"] = [&agent] { return agent.tired(); };
+        return callbacks;
+    }
+}
+
+TEST_CASE("Generated header is up to date", "[static_tree]")
+{
+    const auto path = std::filesystem::path{__FILE__}.parent_path() / "generated" / "PatrolTree.hpp";
+    std::ifstream input{path};
+    std::stringstream checked_in;
+    checked_in << input.rdbuf();
+    REQUIRE(generate_static_tree(make_patrol_tree(), "PatrolTree") == checked_in.str());
+}
+
+TEST_CASE("Generated tree behaves like BehaviorTree", "[static_tree]")
+{
+    PatrolAgent runtime_agent;
+    BehaviorTree runtime_tree;
+    build_behavior_tree(make_patrol_tree(), bind_callbacks(runtime_agent), runtime_tree);
+
+    PatrolAgent static_agent;
+    PatrolTree<PatrolAgent> static_tree;
+
+    for(int tick = 0; tick < 200; ++tick)
+    {
+        REQUIRE(static_tree.evaluate(static_agent) == runtime_tree.evaluate());
+        REQUIRE(static_agent.log == runtime_agent.log);
+    }
+}
+
+TEST_CASE("Generator rejects trees it cannot express", "[static_tree]")
+{
+    TreeDocument document;
+    REQUIRE_THROWS_AS(generate_static_tree(document, "Empty"), std::invalid_argument);
+
+    const auto root = document.add_node(TreeDocument::no_node, NodeKind::sequence, "root");
+    REQUIRE_THROWS_AS(generate_static_tree(document, "not a name"), std::invalid_argument);
+
+    const auto invert = document.add_node(root, NodeKind::invert, "lonely");
+    REQUIRE_THROWS_AS(generate_static_tree(document, "Lonely"), std::invalid_argument);
+
+    document.add_node(invert, NodeKind::link, "nowhere", 1000);
+    REQUIRE_THROWS_AS(generate_static_tree(document, "Nowhere"), std::invalid_argument);
+
+    REQUIRE(make_callback_name("see enemy?") == "see_enemy");
+    REQUIRE(make_callback_name("2nd try") == "on_2nd_try");
+    REQUIRE(make_callback_name("?!").empty());
+    REQUIRE(make_callback_name("class") == "class_");
+    REQUIRE(make_callback_name("return!") == "return_");
+    REQUIRE_THROWS_AS(generate_static_tree(make_patrol_tree(), "struct"), std::invalid_argument);
+}
+
+TEST_CASE("Generator rejects labels which would share a callback", "[static_tree]")
+{
+    TreeDocument document;
+    const auto root = document.add_node(TreeDocument::no_node, NodeKind::sequence, "root");
+    document.add_node(root, NodeKind::condition, "enemy near");
+    document.add_node(root, NodeKind::action, "attack");
+    // Same label, same callback.
+    document.add_node(root, NodeKind::action, "attack");
+    REQUIRE_NOTHROW(generate_static_tree(document, "Shared"));
+
+    SECTION("Different labels, one name")
+    {
+        document.add_node(root, NodeKind::condition, "enemy-near");
+        REQUIRE_THROWS_WITH(generate_static_tree(document, "Clash"),
+                            Catch::Contains("Condition #1 and Condition #4 would both call enemy_near"));
+    }
+    SECTION("Action and condition with one label")
+    {
+        document.add_node(root, NodeKind::action, "enemy near");
+        REQUIRE_THROWS_WITH(generate_static_tree(document, "Clash"),
+                            Catch::Contains("Condition #1 and Action #4 would both call enemy_near"));
+    }
+    SECTION("Keyword and its escaped form")
+    {
+        document.add_node(root, NodeKind::action, "return");
+        document.add_node(root, NodeKind::action, "return_");
+        REQUIRE_THROWS_WITH(generate_static_tree(document, "Clash"), Catch::Contains("would both call return_"));
+    }
+}
+
+TEST_CASE("Generated tree throughput", "[static_tree][benchmarks][!benchmark]")
+{
+    PatrolAgent runtime_agent;
+    BehaviorTree runtime_tree;
+    build_behavior_tree(make_patrol_tree(), bind_callbacks(runtime_agent), runtime_tree);
+
+    PatrolAgent static_agent;
+    PatrolTree<PatrolAgent> static_tree;
+
+    // Logs would grow without bound over thousands of ticks.
+    BENCHMARK("BehaviorTree tick")
+    {
+        runtime_agent.log.clear();
+        return runtime_tree.evaluate();
+    };
+    BENCHMARK("Generated tree tick")
+    {
+        static_agent.log.clear();
+        return static_tree.evaluate(static_agent);
+    };
+}
@@ -0,0 +1,307 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "catch.hpp"
+
+#include "TreeGenerators.hpp"
+#include "../io/TreeBinaryFormat.hpp"
+#include "../model/SubtreeHashes.hpp"
+#include "../model/TreeValidator.hpp"
+#include "../runtime/CompiledTree.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using index_t = TreeDocument::index_t;
+
+    constexpr uint32_t seed = 2020;
+
+    index_t copy_subtree(TreeDocument &document, index_t source, index_t parent)
+    {
+        const auto copy = document.add_node(parent, document.get_kind(source), std::string{document.get_label(source)},
+                                            document.get_parameter(source));
+        for(auto child = document.get_first_child(source); child != TreeDocument::no_node;
+            child = document.get_next_sibling(child))
+        {
+            copy_subtree(document, child, copy);
+        }
+        return copy;
+    }
+
+    // Generated tree with every tenth branch of the root pasted again at the end, plus a link into
+    // the last pasted branch.
+    index_t make_tree_with_copies(TreeDocument &document, size_t node_count)
+    {
+        generate_realistic_tree(document, node_count, seed);
+        const auto root = document.get_root();
+        std::vector<index_t> branches;
+        for(auto branch = document.get_first_child(root); branch != TreeDocument::no_node;
+            branch = document.get_next_sibling(branch))
+        {
+            branches.push_back(branch);
+        }
+        index_t last_copy = TreeDocument::no_node;
+        for(size_t branch = 0; branch < branches.size(); branch += 10)
+        {
+            last_copy = copy_subtree(document, branches[branch], root);
+        }
+        return document.add_node(root, NodeKind::link, "into a copy", document.get_id(last_copy));
+    }
+
+    std::vector<index_t> get_nodes(const TreeDocument &document)
+    {
+        std::vector<index_t> nodes;
+        for(index_t node = 0; node < document.get_capacity(); ++node)
+        {
+            if(document.contains(node))
+            {
+                nodes.push_back(node);
+            }
+        }
+        return nodes;
+    }
+
+    // Callbacks which write down every call and never answer running, so a tree never keeps state
+    // between ticks through them.
+    BehaviorCallbacks make_logging_callbacks(std::vector<std::string> &calls)
+    {
+        BehaviorCallbacks callbacks;
+        for(uint32_t i = 0; i < generated_callback_count; ++i)
+        {
+            const auto action = "action " + std::to_string(i);
+            const auto condition = "condition " + std::to_string(i);
+            callbacks.actions[action] = [&calls, action, i]
+            {
+                calls.push_back(action);
+                return i % 2 == 0 ? BehaviorState::success : BehaviorState::failure;
+            };
+            callbacks.conditions[condition] = [&calls, condition, i]
+            {
+                calls.push_back(condition);
+                return i % 3 != 0;
+            };
+        }
+        return callbacks;
+    }
+
+    size_t get_binary_size(const TreeDocument &document)
+    {
+        std::ostringstream output;
+        save_tree_binary(document, output);
+        return output.str().size();
+    }
+}
+
+TEST_CASE("Identical subtrees hash alike", "[subtree_hashes]")
+{
+    TreeDocument document;
+    const auto root = document.add_node(TreeDocument::no_node, NodeKind::selector, "root");
+    const auto add_branch = [&](const char *first, const char *second, uint32_t loop_count)
+    {
+        const auto branch = document.add_node(root, NodeKind::loop, "loop", loop_count);
+        const auto sequence = document.add_node(branch, NodeKind::sequence, "sequence");
+        document.add_node(sequence, NodeKind::condition, first);
+        document.add_node(sequence, NodeKind::action, second);
+        return branch;
+    };
+    const auto original = add_branch("a", "b", 2);
+    const auto same = add_branch("a", "b", 2);
+    const auto swapped = add_branch("b", "a", 2);
+    const auto relabelled = add_branch("a", "c", 2);
+    const auto other_count = add_branch("a", "b", 3);
+
+    SubtreeHashes hashes{document};
+    hashes.rebuild();
+    REQUIRE(hashes.get_size(root) == 21);
+    REQUIRE(hashes.get_size(original) == 4);
+    REQUIRE(hashes.get_hash(original) == hashes.get_hash(same));
+    for(const auto different: {swapped, relabelled, other_count})
+    {
+        REQUIRE(hashes.get_hash(original) != hashes.get_hash(different));
+    }
+
+    // The later copy folds as a whole - smaller subtrees inside it go away with it - and the sequence
+    // under the other loop count on its own.
+    const auto folds = find_foldable_subtrees(document, hashes, 2);
+    REQUIRE(folds.size() == 2);
+    REQUIRE(folds[0].copy == same);
+    REQUIRE(folds[0].definition == original);
+    REQUIRE(folds[0].size == 4);
+    REQUIRE(folds[1].copy == document.get_first_child(other_count));
+    REQUIRE(folds[1].definition == document.get_first_child(original));
+    REQUIRE(folds[1].size == 3);
+    REQUIRE(find_foldable_subtrees(document, hashes, 4).size() == 1);
+    REQUIRE(find_foldable_subtrees(document, hashes, 5).empty());
+}
+
+TEST_CASE("Subtree hashes follow edits", "[subtree_hashes]")
+{
+    TreeDocument document;
+    generate_realistic_tree(document, 3000, seed);
+    SubtreeHashes hashes{document};
+    hashes.rebuild();
+
+    std::mt19937 random{seed};
+    for(int round = 0; round < 50; ++round)
+    {
+        for(int edit = 0; edit < 20; ++edit)
+        {
+            const auto nodes = get_nodes(document);
+            const auto node = nodes[random() % nodes.size()];
+            switch(random() % 3)
+            {
+                case 0:
+                    if(node != document.get_root())
+                    {
+                        const auto parent = document.get_parent(node);
+                        std::vector<index_t> removed;
+                        document.remove_subtree(node, removed);
+                        for(const auto removed_node: removed)
+                        {
+                            hashes.forget(removed_node);
+                        }
+                        hashes.invalidate(parent);
+                        break;
+                    }
+                    [[fallthrough]];
+                case 1:
+                    document.set_label(node, "edit " + std::to_string(random() % 4));
+                    hashes.invalidate(node);
+                    break;
+                default:
+                    hashes.invalidate(document.add_node(node, NodeKind::action, "action 1"));
+                    break;
+            }
+        }
+        hashes.update();
+
+        SubtreeHashes fresh{document};
+        fresh.rebuild();
+        for(const auto node: get_nodes(document))
+        {
+            REQUIRE(hashes.get_hash(node) == fresh.get_hash(node));
+            REQUIRE(hashes.get_size(node) == fresh.get_size(node));
+        }
+    }
+}
+
+TEST_CASE("Repeated subtrees fold into links", "[subtree_hashes]")
+{
+    TreeDocument original;
+    const auto link_into_copy = make_tree_with_copies(original, 3000);
+    REQUIRE(validate_tree(original).empty());
+
+    TreeDocument folded;
+    folded = original;
+    SubtreeHashes hashes{folded};
+    hashes.rebuild();
+    constexpr uint32_t min_size = 4;
+    const auto folds = find_foldable_subtrees(folded, hashes, min_size);
+    REQUIRE(folds.size() >= 5);
+    size_t saved_nodes = 0;
+    for(const auto &fold: folds)
+    {
+        REQUIRE(fold.size >= min_size);
+        REQUIRE(fold.definition < fold.copy);
+        saved_nodes += fold.size - 1;
+    }
+    const auto definition_of_linked = std::find_if(folds.begin(), folds.end(), [&](const SubtreeFold &fold)
+    {
+        return original.get_id(fold.copy) == original.get_parameter(link_into_copy);
+    });
+    REQUIRE(definition_of_linked != folds.end());
+    const auto definition_id = folded.get_id(definition_of_linked->definition);
+
+    fold_subtrees(folded, folds);
+    REQUIRE(folded.size() == original.size() - saved_nodes);
+    REQUIRE(validate_tree(folded).empty());
+    REQUIRE(folded.get_parameter(folded.find_by_id(original.get_id(link_into_copy))) == definition_id);
+    hashes.rebuild();
+    REQUIRE(find_foldable_subtrees(folded, hashes, min_size).empty());
+
+    // Running from the start, both trees make the same calls and come to the same result.
+    std::vector<std::string> original_calls;
+    std::vector<std::string> folded_calls;
+    CompiledTree original_tree{original, make_logging_callbacks(original_calls)};
+    CompiledTree folded_tree{folded, make_logging_callbacks(folded_calls)};
+    REQUIRE(original_tree.evaluate() == folded_tree.evaluate());
+    REQUIRE(!original_calls.empty());
+    REQUIRE(original_calls == folded_calls);
+}
+
+TEST_CASE("Subtree hashing and folding cost", "[subtree_hashes][benchmarks][!benchmark]")
+{
+    TreeDocument original;
+    make_tree_with_copies(original, 20000);
+    TreeDocument folded;
+    folded = original;
+    SubtreeHashes hashes{folded};
+    hashes.rebuild();
+    fold_subtrees(folded, find_foldable_subtrees(folded, hashes, 4));
+
+    // What folding saves in memory (copies drop the capacity left over from folding) and in time to
+    // build the runtime tree.
+    const auto callbacks = make_generated_callbacks();
+    const auto measure_build = [&](const TreeDocument &document)
+    {
+        constexpr int repeats = 20;
+        const auto start = std::chrono::steady_clock::now();
+        for(int repeat = 0; repeat < repeats; ++repeat)
+        {
+            BehaviorTree tree;
+            build_behavior_tree(document, callbacks, tree);
+        }
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repeats;
+    };
+    WARN("nodes: " << original.size() << " -> " << folded.size()
+                   << ", document: " << TreeDocument{original}.get_memory_usage() << " -> "
+                   << TreeDocument{folded}.get_memory_usage() << " bytes"
+                   << ", binary file: " << get_binary_size(original) << " -> " << get_binary_size(folded) << " bytes"
+                   << ", BehaviorTree build: " << measure_build(original) << " -> " << measure_build(folded) << " ms");
+
+    BENCHMARK("Hash every subtree, 20000 nodes")
+    {
+        hashes.rebuild();
+        return hashes.get_hash(folded.get_root());
+    };
+    SubtreeHashes original_hashes{original};
+    original_hashes.rebuild();
+    BENCHMARK("Find foldable subtrees, 20000 nodes")
+    {
+        return find_foldable_subtrees(original, original_hashes, 4).size();
+    };
+    const auto leaf = original.get_last_child(original.get_first_child(original.get_root()));
+    BENCHMARK("Rehash after relabelling a leaf")
+    {
+        original_hashes.invalidate(leaf);
+        original_hashes.update();
+        return original_hashes.get_hash(original.get_root());
+    };
+}
@@ -0,0 +1,283 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#include "catch.hpp"
+
+#include "../io/TraceFile.hpp"
+#include "../model/TraceStatistics.hpp"
+#include "../runtime/CompiledTree.hpp"
+#include "../runtime/TraceRing.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Detaches on the way out, so a failed check does not leave the thread traced for later tests.
+    struct AttachedThread
+    {
+        explicit AttachedThread(TraceRecorder &recorder)
+        {
+            recorder.attach();
+        }
+
+        ~AttachedThread()
+        {
+            TraceRecorder::detach();
+        }
+    };
+
+    TraceEvent enter(uint32_t node)
+    {
+        return TraceEvent{node, TraceEventType::enter, TraceResult::undefined, 0};
+    }
+
+    TraceEvent leave(uint32_t node, TraceResult result)
+    {
+        return TraceEvent{node, TraceEventType::exit, result, 0};
+    }
+
+    // Same tree as the compiled tree layout test: IDs 0 root, 1 invert, 2 ready, 3 link to the
+    // invert, 4 run.
+    TreeDocument make_linked_tree()
+    {
+        TreeDocument document;
+        const auto root = document.add_node(TreeDocument::no_node, NodeKind::sequence, "root");
+        const auto invert = document.add_node(root, NodeKind::invert, "invert");
+        document.add_node(invert, NodeKind::condition, "ready");
+        document.add_node(root, NodeKind::link, "again", document.get_id(invert));
+        document.add_node(root, NodeKind::action, "run");
+        return document;
+    }
+
+    BehaviorCallbacks make_linked_callbacks()
+    {
+        BehaviorCallbacks callbacks;
+        callbacks.conditions["ready"] = [] { return false; };
+        callbacks.actions["run"] = [] { return BehaviorState::running; };
+        return callbacks;
+    }
+}
+
+TEST_CASE("Trace ring keeps order and drops what does not fit", "[trace]")
+{
+    TraceRing ring{5, 3};
+    REQUIRE(ring.get_capacity() == 8);
+
+    std::vector<TraceEvent> drained;
+    for(uint32_t round = 0; round < 3; ++round)
+    {
+        for(uint32_t node = 0; node < 10; ++node)
+        {
+            ring.push(node, TraceEventType::enter, TraceResult::undefined);
+        }
+        drained.clear();
+        REQUIRE(ring.drain(drained) == 8);
+        for(uint32_t node = 0; node < 8; ++node)
+        {
+            REQUIRE(drained[node].node == node);
+            REQUIRE(drained[node].thread == 3);
+        }
+        REQUIRE(ring.get_dropped() == 2 * (round + 1));
+    }
+    drained.clear();
+    REQUIRE(ring.drain(drained) == 0);
+}
+
+TEST_CASE("Trace ring hands events between threads", "[trace]")
+{
+    constexpr uint32_t event_count = 200000;
+    TraceRing ring{1024, 0};
+    std::thread producer{[&ring]
+                         {
+                             for(uint32_t node = 0; node < event_count; ++node)
+                             {
+                                 ring.push(node, TraceEventType::exit, TraceResult::success);
+                             }
+                         }};
+    std::vector<TraceEvent> drained;
+    while(drained.size() + ring.get_dropped() < event_count)
+    {
+        ring.drain(drained);
+    }
+    producer.join();
+    ring.drain(drained);
+
+    REQUIRE(drained.size() + ring.get_dropped() == event_count);
+    for(size_t i = 1; i < drained.size(); ++i)
+    {
+        REQUIRE(drained[i - 1].node < drained[i].node);
+    }
+}
+
+TEST_CASE("Traced tick records every node it visits", "[trace]")
+{
+    const auto document = make_linked_tree();
+    CompiledTree tree{document, make_linked_callbacks()};
+    TraceRecorder recorder{64};
+    std::vector<TraceEvent> events;
+
+    SECTION("Attached thread")
+    {
+        {
+            AttachedThread attached{recorder};
+            REQUIRE(tree.evaluate() == BehaviorState::running);
+        }
+        recorder.collect(events);
+        const std::vector<TraceEvent> expected{
+                enter(0),
+                enter(1), enter(2), leave(2, TraceResult::failure), leave(1, TraceResult::success),
+                enter(3), enter(1), enter(2), leave(2, TraceResult::failure), leave(1, TraceResult::success),
+                leave(3, TraceResult::success),
+                enter(4), leave(4, TraceResult::running),
+                leave(0, TraceResult::running)};
+        REQUIRE(events == expected);
+        REQUIRE(recorder.get_dropped() == 0);
+
+        TraceStatistics statistics;
+        statistics.add(events);
+        REQUIRE(statistics.get(1).hits == 2);
+        REQUIRE(statistics.get(1).successes == 2);
+        REQUIRE(statistics.get(2).failures == 2);
+        REQUIRE(statistics.get(0).running == 1);
+        REQUIRE(statistics.get(4).running == 1);
+        REQUIRE(statistics.get(100).hits == 0);
+        REQUIRE(statistics.get_max_hits() == 2);
+    }
+    SECTION("Detached thread")
+    {
+        {
+            AttachedThread attached{recorder};
+        }
+        REQUIRE(tree.evaluate() == BehaviorState::running);
+        recorder.collect(events);
+        REQUIRE(events.empty());
+    }
+    SECTION("Attaching twice")
+    {
+        AttachedThread attached{recorder};
+        REQUIRE_THROWS_AS(recorder.attach(), std::logic_error);
+    }
+}
+
+TEST_CASE("Trace file round trip", "[trace]")
+{
+    const std::vector<TraceEvent> events{enter(7), leave(7, TraceResult::running),
+                                         TraceEvent{123456, TraceEventType::exit, TraceResult::failure, 9}};
+    const auto path = std::filesystem::temp_directory_path() / "orchard_trace_test.bttrace";
+    save_trace(events, path);
+
+    std::vector<TraceEvent> loaded{enter(1)};
+    load_trace(path, loaded);
+    REQUIRE(loaded.size() == 4);
+    REQUIRE(std::equal(events.begin(), events.end(), loaded.begin() + 1));
+
+    SECTION("Truncated")
+    {
+        std::filesystem::resize_file(path, trace_file_format::header_size + trace_file_format::event_size + 3);
+        REQUIRE_THROWS_AS(load_trace(path, loaded), std::runtime_error);
+    }
+    SECTION("Not a trace")
+    {
+        std::ofstream{path, std::ios::binary | std::ios::trunc} << "BOTREE\r\n and then some";
+        REQUIRE_THROWS_AS(load_trace(path, loaded), std::runtime_error);
+    }
+    SECTION("Unknown result")
+    {
+        {
+            std::fstream file{path, std::ios::binary | std::ios::in | std::ios::out};
+            file.seekp(trace_file_format::header_size + 5);
+            file.put(9);
+        }
+        REQUIRE_THROWS_AS(load_trace(path, loaded), std::runtime_error);
+        REQUIRE(loaded.size() == 4);
+    }
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Tracing overhead", "[trace][benchmarks][!benchmark]")
+{
+    // Same shape as the compiled tree benchmark: every tick visits all 1000 nodes.
+    TreeDocument document;
+    const auto root = document.add_node(TreeDocument::no_node, NodeKind::sequence, "root");
+    for(int branch = 0; branch < 50; ++branch)
+    {
+        const auto selector = document.add_node(root, NodeKind::selector, "branch");
+        for(int condition = 0; condition < 18; ++condition)
+        {
+            document.add_node(selector, NodeKind::condition, "blocked");
+        }
+        const auto invert = document.add_node(selector, NodeKind::invert, "invert");
+        document.add_node(invert, NodeKind::action, "fail");
+    }
+    uint64_t calls = 0;
+    BehaviorCallbacks callbacks;
+    callbacks.conditions["blocked"] = [&calls] { return ++calls == 0; };
+    callbacks.actions["fail"] = [&calls]
+    {
+        ++calls;
+        return BehaviorState::failure;
+    };
+    CompiledTree tree{document, callbacks};
+
+    // A tick is two events per node; a round of ticks fills at most half of the ring, which is drained
+    // between rounds, outside of the measured time - in production another thread drains it.
+    constexpr int ticks_per_round = 16;
+    constexpr int rounds = 200;
+    TraceRecorder recorder{size_t{1} << 16};
+    std::vector<TraceEvent> events;
+    const auto measure = [&](bool traced)
+    {
+        if(traced)
+        {
+            recorder.attach();
+        }
+        auto best = std::chrono::steady_clock::duration::max();
+        for(int round = 0; round < rounds; ++round)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for(int tick = 0; tick < ticks_per_round; ++tick)
+            {
+                tree.evaluate();
+            }
+            best = std::min(best, std::chrono::steady_clock::now() - start);
+            events.clear();
+            recorder.collect(events);
+        }
+        TraceRecorder::detach();
+        return std::chrono::duration<double, std::nano>(best).count() / ticks_per_round;
+    };
+
+    const auto untraced = measure(false);
+    const auto traced = measure(true);
+    REQUIRE(events.size() == size_t{ticks_per_round} * 2 * document.size());
+    REQUIRE(recorder.get_dropped() == 0);
+    WARN("tick, 1000 nodes: " << untraced << " ns untraced, " << traced << " ns traced - tracing overhead "
+                              << (traced - untraced) / untraced * 100.0 << "% of tick time");
+}
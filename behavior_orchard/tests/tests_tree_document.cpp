@@ -0,0 +1,196 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "catch.hpp"
+
+#include "TreeGenerators.hpp"
+#include "../model/BehaviorTreeBridge.hpp"
+#include "../model/TreeDocument.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using index_t = TreeDocument::index_t;
+
+    std::vector<index_t> get_nodes(const TreeDocument &document)
+    {
+        std::vector<index_t> nodes;
+        for(index_t node = 0; node < document.get_capacity(); ++node)
+        {
+            if(document.contains(node))
+            {
+                nodes.push_back(node);
+            }
+        }
+        return nodes;
+    }
+}
+
+TEST_CASE("Removed indices are reused, IDs are not", "[tree_document]")
+{
+    TreeDocument document;
+    const auto root = document.add_node(TreeDocument::no_node, NodeKind::selector, "root");
+    const auto branch = document.add_node(root, NodeKind::sequence, "branch");
+    const auto first = document.add_node(branch, NodeKind::action, "first");
+    const auto second = document.add_node(branch, NodeKind::condition, "second");
+    const auto kept = document.add_node(root, NodeKind::action, "kept");
+    REQUIRE(document.size() == 5);
+    REQUIRE(document.get_capacity() == 5);
+
+    std::vector<index_t> removed;
+    document.remove_subtree(branch, removed);
+    REQUIRE(removed == std::vector<index_t>{branch, first, second});
+    REQUIRE(document.size() == 2);
+    REQUIRE_FALSE(document.contains(branch));
+    REQUIRE(document.get_first_child(root) == kept);
+    REQUIRE(document.get_child_count(root) == 1);
+    REQUIRE(document.find_by_id(1) == TreeDocument::no_node);
+
+    // Freed slots are filled before the columns grow; IDs keep counting.
+    std::vector<index_t> added;
+    for(int node = 0; node < 4; ++node)
+    {
+        added.push_back(document.add_node(root, NodeKind::action, "added " + std::to_string(node)));
+    }
+    REQUIRE(document.get_capacity() == 6);
+    REQUIRE(std::vector<index_t>{added.begin(), added.begin() + 3} == std::vector<index_t>{second, first, branch});
+    REQUIRE(added.back() == 5);
+    for(size_t node = 0; node < added.size(); ++node)
+    {
+        REQUIRE(document.get_id(added[node]) == 5 + node);
+        REQUIRE(document.find_by_id(static_cast<TreeDocument::id_t>(5 + node)) == added[node]);
+        REQUIRE(document.get_label(added[node]) == "added " + std::to_string(node));
+        REQUIRE(document.get_first_child(added[node]) == TreeDocument::no_node);
+    }
+    REQUIRE(document.get_last_child(root) == added.back());
+    REQUIRE(document.get_child_count(root) == 5);
+}
+
+TEST_CASE("Nodes are found by their ID", "[tree_document]")
+{
+    TreeDocument document;
+    const auto root = document.add_node(TreeDocument::no_node, NodeKind::selector, "root", 0, 10);
+    const auto child = document.add_node(root, NodeKind::action, "child", 0, 3);
+    REQUIRE(document.find_by_id(10) == root);
+    REQUIRE(document.find_by_id(3) == child);
+    REQUIRE(document.find_by_id(4) == TreeDocument::no_node);
+    REQUIRE(document.find_by_id(1000) == TreeDocument::no_node);
+    REQUIRE(document.find_by_id(TreeDocument::no_id) == TreeDocument::no_node);
+    // Numbering goes on past the highest ID given so far.
+    REQUIRE(document.get_next_id() == 11);
+    REQUIRE(document.get_id(document.add_node(root, NodeKind::action, "numbered")) == 11);
+
+    REQUIRE_THROWS_AS(document.add_node(root, NodeKind::action, "taken", 0, 3), std::invalid_argument);
+    REQUIRE_THROWS_AS(document.add_node(root, NodeKind::action, "none", 0, TreeDocument::no_id),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(document.insert_node(root, root, NodeKind::action, "misplaced", 0, 20), std::invalid_argument);
+
+    // Removed node gives its ID back, so a removal can be undone under the same ID.
+    std::vector<index_t> removed;
+    document.remove_subtree(child, removed);
+    REQUIRE(document.find_by_id(3) == TreeDocument::no_node);
+    const auto restored = document.insert_node(root, document.get_first_child(root), NodeKind::action, "child", 0, 3);
+    REQUIRE(document.find_by_id(3) == restored);
+    REQUIRE(document.get_first_child(root) == restored);
+
+    // Numbering stops at the highest ID a loader accepts.
+    document.add_node(root, NodeKind::action, "last", 0, TreeDocument::max_id);
+    REQUIRE(document.get_next_id() == TreeDocument::max_id + 1);
+    const auto size = document.size();
+    REQUIRE(document.add_node(root, NodeKind::action, "beyond") == TreeDocument::no_node);
+    REQUIRE(document.size() == size);
+}
+
+TEST_CASE("Replaced labels are compacted away", "[tree_document]")
+{
+    TreeDocument document;
+    const auto root = document.add_node(TreeDocument::no_node, NodeKind::selector, "root");
+    for(int node = 0; node < 10; ++node)
+    {
+        document.add_node(root, NodeKind::action, "action " + std::to_string(node));
+    }
+    const auto initial_usage = document.get_memory_usage();
+    const auto padding = std::string(100, '.');
+    for(int round = 0; round < 2000; ++round)
+    {
+        const auto node = static_cast<index_t>(1 + round % 10);
+        document.set_label(node, "action " + std::to_string(round) + padding);
+    }
+    // Without compaction the pool would hold every label ever set - some 200 KB.
+    REQUIRE(document.get_memory_usage() < initial_usage + 16 * 1024);
+    for(index_t node = 1; node <= 10; ++node)
+    {
+        REQUIRE(document.get_label(node) == "action " + std::to_string(1990 + node - 1) + padding);
+    }
+
+    // Removed subtrees release their labels too.
+    std::vector<index_t> removed;
+    for(int round = 0; round < 200; ++round)
+    {
+        const auto branch = document.add_node(root, NodeKind::sequence, "branch" + padding);
+        for(int node = 0; node < 5; ++node)
+        {
+            document.add_node(branch, NodeKind::action, "leaf " + std::to_string(round) + padding);
+        }
+        removed.clear();
+        document.remove_subtree(branch, removed);
+    }
+    REQUIRE(document.get_memory_usage() < initial_usage + 16 * 1024);
+    REQUIRE(document.get_label(root) == "root");
+}
+
+TEST_CASE("Documents round-trip through BehaviorTree", "[tree_document]")
+{
+    TreeDocument document;
+    generate_realistic_tree(document, 2000, 2020);
+    BehaviorTree tree;
+    const auto built = build_behavior_tree(document, make_generated_callbacks(), tree);
+
+    TreeDocument imported;
+    import_behavior_tree(tree.get_node(0), imported);
+    REQUIRE(imported.size() == document.size());
+    // BehaviorTree numbers nodes in pre-order and so does the import, so IDs of the built tree
+    // identify the imported nodes.
+    for(const auto node: get_nodes(document))
+    {
+        CAPTURE(node);
+        REQUIRE(built[node] != TreeDocument::no_id);
+        const auto copy = imported.find_by_id(built[node]);
+        REQUIRE(copy != TreeDocument::no_node);
+        REQUIRE(imported.get_kind(copy) == document.get_kind(node));
+        REQUIRE(imported.get_child_count(copy) == document.get_child_count(node));
+        REQUIRE(imported.get_parameter(copy) == get_default_parameter(document.get_kind(node)));
+        const auto parent = document.get_parent(node);
+        REQUIRE(imported.get_parent(copy) ==
+                (parent == TreeDocument::no_node ? TreeDocument::no_node : imported.find_by_id(built[parent])));
+    }
+
+    BehaviorTree unbound;
+    auto callbacks = make_generated_callbacks();
+    callbacks.actions.erase("action 0");
+    REQUIRE_THROWS_AS(build_behavior_tree(document, callbacks, unbound), std::invalid_argument);
+}
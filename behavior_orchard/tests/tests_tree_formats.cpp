@@ -0,0 +1,365 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "catch.hpp"
+
+#include "../io/TreeBinaryFormat.hpp"
+#include "../io/TreeFile.hpp"
+#include "../io/TreeTextFormat.hpp"
+
+#include <filesystem>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using index_t = TreeDocument::index_t;
+
+    void build_random_tree(TreeDocument &document, size_t node_count, uint32_t seed)
+    {
+        std::mt19937 random{seed};
+        std::vector<index_t> open;
+        open.push_back(document.add_node(TreeDocument::no_node, NodeKind::selector, "root"));
+        while(document.size() < node_count)
+        {
+            std::uniform_int_distribution<size_t> pick{0, open.size() - 1};
+            const auto slot = pick(random);
+            const auto parent = open[slot];
+            const auto kind = static_cast<NodeKind>(random() % node_kind_count);
+            const auto parameter = kind == NodeKind::loop || kind == NodeKind::max_n_tries ? static_cast<uint32_t>(random() % 10 + 1) : 0u;
+            const auto node = document.add_node(parent, kind, "node " + std::to_string(random() % 1000), parameter);
+            if(!document.can_add_child(parent))
+            {
+                open[slot] = open.back();
+                open.pop_back();
+            }
+            if(document.can_add_child(node))
+            {
+                open.push_back(node);
+            }
+            if(open.empty())
+            {
+                break;
+            }
+        }
+    }
+
+    void require_same_tree(const TreeDocument &expected, const TreeDocument &actual)
+    {
+        REQUIRE(expected.size() == actual.size());
+        if(expected.is_empty())
+        {
+            return;
+        }
+        std::vector<std::pair<index_t, index_t>> pending{{expected.get_root(), actual.get_root()}};
+        while(!pending.empty())
+        {
+            const auto [left, right] = pending.back();
+            pending.pop_back();
+            REQUIRE(expected.get_kind(left) == actual.get_kind(right));
+            REQUIRE(expected.get_id(left) == actual.get_id(right));
+            REQUIRE(expected.get_label(left) == actual.get_label(right));
+            REQUIRE(expected.get_parameter(left) == actual.get_parameter(right));
+            REQUIRE(expected.get_child_count(left) == actual.get_child_count(right));
+            auto right_child = actual.get_first_child(right);
+            for(auto left_child = expected.get_first_child(left); left_child != TreeDocument::no_node;
+                left_child = expected.get_next_sibling(left_child))
+            {
+                pending.emplace_back(left_child, right_child);
+                right_child = actual.get_next_sibling(right_child);
+            }
+        }
+    }
+
+    std::string save_binary(const TreeDocument &document)
+    {
+        std::stringstream output;
+        save_tree_binary(document, output);
+        return output.str();
+    }
+
+    void load_binary(const std::string &image, TreeDocument &document)
+    {
+        const auto bytes = reinterpret_cast<const unsigned char *>(image.data());
+        load_tree_binary(BinaryTreeView{bytes, image.size()}, document);
+    }
+
+    std::string save_text(const TreeDocument &document)
+    {
+        std::ostringstream output;
+        save_tree_text(document, output);
+        return output.str();
+    }
+
+    TreeDocument make_sample_tree()
+    {
+        TreeDocument document;
+        const auto root = document.add_node(TreeDocument::no_node, NodeKind::sequence, "Sequence 0");
+        const auto loop = document.add_node(root, NodeKind::loop, "Loop 1", 3);
+        document.add_node(loop, NodeKind::action, "say \"hello\"\tand\\or\nbye");
+        document.add_node(root, NodeKind::condition, "");
+        const auto invert = document.add_node(root, NodeKind::invert, "Sequence 0");
+        document.add_node(invert, NodeKind::link, "Link to root", document.get_id(root));
+        return document;
+    }
+}
+
+TEST_CASE("Binary format round trip", "[tree_formats]")
+{
+    SECTION("Empty tree")
+    {
+        TreeDocument loaded;
+        load_binary(save_binary(TreeDocument{}), loaded);
+        REQUIRE(loaded.is_empty());
+    }
+    SECTION("Special labels and parameters")
+    {
+        const auto original = make_sample_tree();
+        TreeDocument loaded;
+        load_binary(save_binary(original), loaded);
+        require_same_tree(original, loaded);
+    }
+    SECTION("Repeated labels are stored once")
+    {
+        const auto original = make_sample_tree();
+        const auto image = save_binary(original);
+        const auto repeated = std::string{"Sequence 0"};
+        REQUIRE(image.find(repeated) == image.rfind(repeated));
+    }
+    SECTION("IDs with gaps are kept")
+    {
+        auto original = make_sample_tree();
+        std::vector<index_t> removed;
+        original.remove_subtree(original.get_first_child(original.get_root()), removed);
+        original.add_node(original.get_root(), NodeKind::action, "late");
+        TreeDocument loaded;
+        load_binary(save_binary(original), loaded);
+        require_same_tree(original, loaded);
+    }
+    SECTION("Large random tree")
+    {
+        TreeDocument original;
+        build_random_tree(original, 20000, 7);
+        TreeDocument loaded;
+        load_binary(save_binary(original), loaded);
+        require_same_tree(original, loaded);
+    }
+}
+
+TEST_CASE("Binary format rejects corrupt files", "[tree_formats]")
+{
+    const auto image = save_binary(make_sample_tree());
+    TreeDocument loaded;
+
+    SECTION("Wrong magic")
+    {
+        auto corrupt = image;
+        corrupt[0] = 'X';
+        REQUIRE_THROWS_AS(load_binary(corrupt, loaded), std::runtime_error);
+    }
+    SECTION("Truncated")
+    {
+        REQUIRE_THROWS_AS(load_binary(image.substr(0, image.size() - 1), loaded), std::runtime_error);
+        REQUIRE_THROWS_AS(load_binary(image.substr(0, 20), loaded), std::runtime_error);
+    }
+    SECTION("Unknown version")
+    {
+        auto corrupt = image;
+        corrupt[8] = 2;
+        REQUIRE_THROWS_AS(load_binary(corrupt, loaded), std::runtime_error);
+    }
+    SECTION("Child range out of the table")
+    {
+        auto corrupt = image;
+        // Child count of the root.
+        corrupt[tree_binary_format::header_size + 28] = 100;
+        REQUIRE_THROWS_AS(load_binary(corrupt, loaded), std::runtime_error);
+    }
+    SECTION("Unknown node kind")
+    {
+        auto corrupt = image;
+        corrupt[tree_binary_format::header_size] = static_cast<char>(node_kind_count);
+        REQUIRE_THROWS_AS(load_binary(corrupt, loaded), std::runtime_error);
+    }
+    SECTION("ID out of range")
+    {
+        // ID of the second record; the document would size its ID table after it.
+        auto corrupt = image;
+        corrupt[tree_binary_format::header_size + tree_binary_format::record_size + 7] = '\xff';
+        REQUIRE_THROWS_WITH(load_binary(corrupt, loaded), Catch::Contains("bad id at 1"));
+    }
+    SECTION("Duplicate ID")
+    {
+        auto corrupt = image;
+        const auto first_id = tree_binary_format::header_size + 4;
+        corrupt[first_id + tree_binary_format::record_size] = image[first_id];
+        REQUIRE_THROWS_WITH(load_binary(corrupt, loaded), Catch::Contains("bad id at 1"));
+    }
+}
+
+TEST_CASE("Text format round trip", "[tree_formats]")
+{
+    SECTION("Empty tree")
+    {
+        TreeDocument loaded;
+        parse_tree_text(save_text(TreeDocument{}), loaded);
+        REQUIRE(loaded.is_empty());
+    }
+    SECTION("Special labels and parameters")
+    {
+        const auto original = make_sample_tree();
+        TreeDocument loaded;
+        parse_tree_text(save_text(original), loaded);
+        require_same_tree(original, loaded);
+    }
+    SECTION("Output is readable")
+    {
+        const auto text = save_text(make_sample_tree());
+        REQUIRE(text.find("sequence #0 \"Sequence 0\"\n    loop #1 \"Loop 1\" 3\n") != std::string::npos);
+    }
+    SECTION("Large random tree")
+    {
+        TreeDocument original;
+        build_random_tree(original, 20000, 11);
+        TreeDocument loaded;
+        parse_tree_text(save_text(original), loaded);
+        require_same_tree(original, loaded);
+    }
+}
+
+TEST_CASE("Text format reports errors with line numbers", "[tree_formats]")
+{
+    TreeDocument loaded;
+    const std::string header{tree_text_format::header};
+
+    REQUIRE_THROWS_WITH(parse_tree_text("selector #0 \"a\"\n", loaded), Catch::Contains("line 1"));
+    REQUIRE_THROWS_WITH(parse_tree_text(header + "\nselector #0 \"a\"\n        action #1 \"b\"\n", loaded),
+                        Catch::Contains("line 3"));
+    REQUIRE_THROWS_WITH(parse_tree_text(header + "\nselector #0 \"a\n", loaded), Catch::Contains("unterminated"));
+    REQUIRE_THROWS_WITH(parse_tree_text(header + "\nbanana #0 \"a\"\n", loaded), Catch::Contains("banana"));
+    REQUIRE_THROWS_WITH(parse_tree_text(header + "\nselector #0 \"a\"\n    action #0 \"b\"\n", loaded),
+                        Catch::Contains("line 3"));
+    REQUIRE_THROWS_WITH(parse_tree_text(header + "\naction #0 \"a\"\n    action #1 \"b\"\n", loaded),
+                        Catch::Contains("more children"));
+    REQUIRE_THROWS_WITH(parse_tree_text(header + "\nselector #0 \"a\"\n    action #4294967294 \"b\"\n", loaded),
+                        Catch::Contains("line 3: bad id"));
+}
+
+TEST_CASE("IDs far above the node count do not blow up the document", "[tree_formats]")
+{
+    const std::string header{tree_text_format::header};
+    TreeDocument loaded;
+    parse_tree_text(header + "\nselector #2000000000 \"a\"\n    action #7 \"b\"\n"
+                             "    link #1999999999 \"c\" 7\n", loaded);
+    REQUIRE(loaded.size() == 3);
+    REQUIRE(loaded.find_by_id(2000000000) == loaded.get_root());
+    REQUIRE(loaded.get_label(loaded.find_by_id(1999999999)) == "c");
+    REQUIRE(loaded.find_by_id(1999999998) == TreeDocument::no_node);
+    REQUIRE(loaded.get_memory_usage() < 64 * 1024);
+
+    TreeDocument reloaded;
+    load_binary(save_binary(loaded), reloaded);
+    require_same_tree(loaded, reloaded);
+    REQUIRE(reloaded.get_memory_usage() < 64 * 1024);
+}
+
+TEST_CASE("Saving replaces the file only once the tree is written", "[tree_formats]")
+{
+    const auto original = make_sample_tree();
+    const auto directory = std::filesystem::temp_directory_path();
+    for(const auto &name: {"orchard_tests_atomic.btree", "orchard_tests_atomic.tree"})
+    {
+        const auto path = directory / name;
+        auto temporary = path;
+        temporary += ".tmp";
+        TreeDocument smaller;
+        smaller.add_node(TreeDocument::no_node, NodeKind::action, "only");
+        save_tree(smaller, path);
+        REQUIRE_FALSE(std::filesystem::exists(temporary));
+
+        // Temporary file cannot be created, so the save fails before touching the target.
+        std::filesystem::create_directory(temporary);
+        REQUIRE_THROWS_AS(save_tree(original, path), std::runtime_error);
+        TreeDocument loaded;
+        load_tree(path, loaded);
+        require_same_tree(smaller, loaded);
+
+        std::filesystem::remove(temporary);
+        save_tree(original, path);
+        load_tree(path, loaded);
+        require_same_tree(original, loaded);
+        REQUIRE_FALSE(std::filesystem::exists(temporary));
+        std::filesystem::remove(path);
+    }
+}
+
+TEST_CASE("Tree files are recognised by content", "[tree_formats]")
+{
+    const auto original = make_sample_tree();
+    const auto directory = std::filesystem::temp_directory_path();
+    const auto binary_path = directory / "orchard_tests_sample.btree";
+    const auto text_path = directory / "orchard_tests_sample.tree";
+    save_tree(original, binary_path);
+    save_tree(original, text_path);
+
+    TreeDocument loaded;
+    load_tree(binary_path, loaded);
+    require_same_tree(original, loaded);
+    load_tree(text_path, loaded);
+    require_same_tree(original, loaded);
+
+    std::filesystem::remove(binary_path);
+    std::filesystem::remove(text_path);
+}
+
+TEST_CASE("Tree format throughput", "[tree_formats][benchmarks][!benchmark]")
+{
+    TreeDocument original;
+    build_random_tree(original, 300000, 3);
+    const auto binary_image = save_binary(original);
+    const auto text_image = save_text(original);
+
+    BENCHMARK("Save binary")
+    {
+        return save_binary(original).size();
+    };
+    BENCHMARK("Save text")
+    {
+        return save_text(original).size();
+    };
+
+    TreeDocument loaded;
+    BENCHMARK("Load binary")
+    {
+        load_binary(binary_image, loaded);
+        return loaded.size();
+    };
+    BENCHMARK("Load text")
+    {
+        parse_tree_text(text_image, loaded);
+        return loaded.size();
+    };
+}
@@ -0,0 +1,251 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "catch.hpp"
+
+#include "TreeGenerators.hpp"
+#include "../layout/TreeLayout.hpp"
+
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using index_t = TreeDocument::index_t;
+
+    // Widths by node index, as the editor measures labels.
+    using Widths = std::vector<int32_t>;
+
+    void set_width(TreeLayout &layout, Widths &widths, index_t node, int32_t width)
+    {
+        if(node >= widths.size())
+        {
+            widths.resize(node + 1);
+        }
+        widths[node] = width;
+        layout.set_width(node, width);
+    }
+
+    Widths lay_out(TreeLayout &layout, const TreeDocument &document)
+    {
+        Widths widths;
+        layout.clear();
+        for(index_t node = 0; node < document.get_capacity(); ++node)
+        {
+            if(document.contains(node))
+            {
+                set_width(layout, widths, node, static_cast<int32_t>(60 + document.get_label(node).size() * 7));
+            }
+        }
+        layout.update();
+        return widths;
+    }
+
+    // What a renderer fed only with the nodes update reports as changed would show.
+    void apply_changes(const TreeLayout &layout, const std::vector<index_t> &changed, std::vector<Rect> &shown)
+    {
+        for(const auto node: changed)
+        {
+            if(node >= shown.size())
+            {
+                shown.resize(node + 1);
+            }
+            shown[node] = layout.get_bounds(node);
+        }
+    }
+
+    // Incremental layout may keep the root further right than a fresh one (it never moves the
+    // drawing left); apart from that the two have to agree, and so does what the renderer shows.
+    void require_same_layout(const TreeDocument &document, const TreeLayout &incremental, const Widths &widths,
+                             const std::vector<Rect> &shown)
+    {
+        TreeLayout fresh{document};
+        for(index_t node = 0; node < document.get_capacity(); ++node)
+        {
+            if(document.contains(node))
+            {
+                fresh.set_width(node, widths[node]);
+            }
+        }
+        fresh.update();
+        const auto root = document.get_root();
+        const auto shift = incremental.get_bounds(root).x - fresh.get_bounds(root).x;
+        REQUIRE(shift >= 0);
+        for(index_t node = 0; node < document.get_capacity(); ++node)
+        {
+            if(!document.contains(node))
+            {
+                continue;
+            }
+            CAPTURE(node);
+            auto expected = fresh.get_bounds(node);
+            expected.x += shift;
+            REQUIRE(incremental.get_bounds(node) == expected);
+            REQUIRE(shown.at(node) == expected);
+        }
+    }
+
+    index_t pick_node(const TreeDocument &document, std::mt19937 &random)
+    {
+        while(true)
+        {
+            const auto node = static_cast<index_t>(random() % document.get_capacity());
+            if(document.contains(node))
+            {
+                return node;
+            }
+        }
+    }
+
+    // Adds, inserts and removes nodes and changes widths at random, relaying out after each edit the
+    // way the editor does.
+    void edit_randomly(TreeDocument &document, TreeLayout &layout, uint32_t seed, int edits)
+    {
+        std::mt19937 random{seed};
+        std::vector<Rect> shown;
+        auto widths = lay_out(layout, document);
+        for(index_t node = 0; node < document.get_capacity(); ++node)
+        {
+            if(document.contains(node))
+            {
+                apply_changes(layout, {node}, shown);
+            }
+        }
+        std::vector<index_t> removed;
+        for(int edit = 0; edit < edits; ++edit)
+        {
+            CAPTURE(edit);
+            const auto node = pick_node(document, random);
+            const auto choice = random() % 4;
+            if(choice == 0 && node != document.get_root())
+            {
+                const auto parent = document.get_parent(node);
+                removed.clear();
+                document.remove_subtree(node, removed);
+                for(const auto gone: removed)
+                {
+                    layout.forget(gone);
+                }
+                layout.invalidate(parent);
+            }
+            else if(choice == 1)
+            {
+                set_width(layout, widths, node, 40 + static_cast<int32_t>(random() % 200));
+            }
+            else if(document.can_add_child(node))
+            {
+                const auto first = document.get_first_child(node);
+                const auto added = choice == 2 || first == TreeDocument::no_node
+                                   ? document.add_node(node, NodeKind::sequence, "added")
+                                   : document.insert_node(node, first, NodeKind::selector, "inserted node", 0,
+                                                          document.get_next_id());
+                set_width(layout, widths, added, 100);
+                layout.invalidate(node);
+            }
+            apply_changes(layout, layout.update(), shown);
+            if(edit % 10 == 0)
+            {
+                require_same_layout(document, layout, widths, shown);
+            }
+        }
+        require_same_layout(document, layout, widths, shown);
+    }
+}
+
+TEST_CASE("Tree layout centres parents and keeps siblings apart", "[tree_layout]")
+{
+    TreeDocument document;
+    const auto root = document.add_node(TreeDocument::no_node, NodeKind::selector, "root");
+    const auto left = document.add_node(root, NodeKind::sequence, "left");
+    const auto right = document.add_node(root, NodeKind::sequence, "right");
+    for(int child = 0; child < 3; ++child)
+    {
+        document.add_node(left, NodeKind::action, "deep");
+    }
+    const auto settings = TreeLayoutSettings{};
+    TreeLayout layout{document, settings};
+    lay_out(layout, document);
+
+    const auto centre = [&](index_t node)
+    {
+        const auto bounds = layout.get_bounds(node);
+        return bounds.x + bounds.width / 2;
+    };
+    const auto root_bounds = layout.get_bounds(root);
+    REQUIRE(root_bounds.y == settings.margin);
+    REQUIRE(layout.get_bounds(left).y == settings.margin + settings.node_height + settings.level_gap);
+    // Parent over the middle of its first and last child.
+    REQUIRE(std::abs(centre(root) - (centre(left) + centre(right)) / 2) <= 1);
+    const auto last = document.get_last_child(left);
+    REQUIRE(std::abs(centre(left) - (centre(document.get_first_child(left)) + centre(last)) / 2) <= 1);
+    // Siblings (and their subtrees) a gap apart, nothing left of the margin.
+    REQUIRE(layout.get_bounds(right).x - layout.get_bounds(left).right() >= settings.sibling_gap);
+    REQUIRE(layout.get_bounds(right).x - layout.get_bounds(last).right() < settings.sibling_gap + 100);
+    REQUIRE(layout.get_bounds(document.get_first_child(left)).x == settings.margin);
+}
+
+TEST_CASE("Incremental layout matches a fresh one after random edits", "[tree_layout]")
+{
+    SECTION("realistic")
+    {
+        TreeDocument document;
+        generate_realistic_tree(document, 1500, 2020);
+        TreeLayout layout{document};
+        edit_randomly(document, layout, 1, 400);
+    }
+    SECTION("wide")
+    {
+        TreeDocument document;
+        generate_wide_tree(document, 1500, 2020);
+        TreeLayout layout{document};
+        edit_randomly(document, layout, 2, 400);
+    }
+    SECTION("deep")
+    {
+        TreeDocument document;
+        generate_deep_tree(document, 600, 2020);
+        TreeLayout layout{document};
+        edit_randomly(document, layout, 3, 300);
+    }
+}
+
+TEST_CASE("Tree layout of a deep chain stays linear", "[tree_layout]")
+{
+    // Contours are threaded, so a chain lays out in time and memory linear in its length.
+    TreeDocument document;
+    auto node = document.add_node(TreeDocument::no_node, NodeKind::sequence, "root");
+    for(int level = 0; level < 20000; ++level)
+    {
+        node = document.add_node(node, NodeKind::invert, "invert");
+    }
+    TreeLayout layout{document};
+    lay_out(layout, document);
+    REQUIRE(layout.get_bounds(node).y == layout.get_settings().margin + 20000 * (36 + 40));
+
+    layout.set_width(node, 500);
+    // Wider at the bottom, so the root moves right and everything with it.
+    REQUIRE(layout.update().size() == document.size());
+    REQUIRE(layout.get_bounds(node).width == 500);
+}
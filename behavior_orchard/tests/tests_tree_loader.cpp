@@ -0,0 +1,284 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+
+#include "catch.hpp"
+
+#include "../io/TreeFile.hpp"
+#include "../io/TreeLoader.hpp"
+#include "../io/TreeTextFormat.hpp"
+#include "../model/TreeValidator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using index_t = TreeDocument::index_t;
+
+    // Wide and deep enough to be split between threads; every decorator gets its child, links point
+    // to leaves, so the tree is valid.
+    void build_valid_tree(TreeDocument &document, size_t node_count, uint32_t seed)
+    {
+        std::mt19937 random{seed};
+        std::vector<index_t> composites{document.add_node(TreeDocument::no_node, NodeKind::selector, "root")};
+        std::vector<index_t> leaves;
+        while(document.size() < node_count)
+        {
+            auto parent = composites[random() % composites.size()];
+            switch(random() % 4)
+            {
+                case 0:
+                    composites.push_back(document.add_node(parent, random() % 2 ? NodeKind::selector : NodeKind::sequence,
+                                                           "composite"));
+                    break;
+                case 1:
+                    parent = document.add_node(parent, NodeKind::invert, "invert");
+                    leaves.push_back(document.add_node(parent, NodeKind::action, "wrapped"));
+                    break;
+                case 2:
+                    if(!leaves.empty())
+                    {
+                        document.add_node(parent, NodeKind::link, "link", document.get_id(leaves[random() % leaves.size()]));
+                        break;
+                    }
+                    [[fallthrough]];
+                default:
+                    leaves.push_back(document.add_node(parent, NodeKind::condition, "leaf " + std::to_string(random() % 100)));
+                    break;
+            }
+        }
+    }
+
+    std::string to_text(const TreeDocument &document)
+    {
+        std::ostringstream output;
+        save_tree_text(document, output);
+        return output.str();
+    }
+
+    std::vector<std::string> get_messages(const std::vector<ValidationIssue> &issues)
+    {
+        std::vector<std::string> messages;
+        for(const auto &issue: issues)
+        {
+            messages.push_back(issue.message);
+        }
+        return messages;
+    }
+
+    LabelMetrics make_metrics()
+    {
+        LabelMetrics metrics{24, 60};
+        for(unsigned byte = 0; byte < 256; ++byte)
+        {
+            metrics.set_advance(static_cast<unsigned char>(byte), static_cast<int32_t>(byte % 7 + 4));
+        }
+        return metrics;
+    }
+
+    TreeLoader::Stage wait_until_done(TreeLoader &loader)
+    {
+        while(loader.is_running())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        return loader.get_progress().stage;
+    }
+}
+
+TEST_CASE("Validator finds decorators without a child and dangling links", "[tree_loader]")
+{
+    TreeDocument document;
+    const auto root = document.add_node(TreeDocument::no_node, NodeKind::sequence, "root");
+    document.add_node(root, NodeKind::invert, "lonely");
+    const auto loop = document.add_node(root, NodeKind::loop, "loop", 2);
+    document.add_node(loop, NodeKind::action, "act");
+    document.add_node(root, NodeKind::link, "nowhere", 77);
+
+    REQUIRE(get_messages(validate_tree(document)) ==
+            std::vector<std::string>{"Invert 'lonely' has 0 children instead of one",
+                                     "Link 'nowhere' points to missing node #77"});
+}
+
+TEST_CASE("Validator finds links which run themselves", "[tree_loader]")
+{
+    TreeDocument document;
+    const auto root = document.add_node(TreeDocument::no_node, NodeKind::selector, "root");
+    const auto first = document.add_node(root, NodeKind::sequence, "first");
+    const auto second = document.add_node(root, NodeKind::sequence, "second");
+    const auto third = document.add_node(root, NodeKind::sequence, "third");
+    document.add_node(first, NodeKind::action, "act");
+
+    SECTION("link to a leaf is fine")
+    {
+        document.add_node(second, NodeKind::link, "to act", document.get_id(document.get_first_child(first)));
+        REQUIRE(validate_tree(document).empty());
+    }
+
+    SECTION("link to its own ancestor")
+    {
+        document.add_node(first, NodeKind::link, "up", document.get_id(root));
+        REQUIRE(get_messages(validate_tree(document)) ==
+                std::vector<std::string>{"Link 'up' leads back to itself through #0"});
+    }
+
+    SECTION("cycle through several links, including one reached by a cross edge")
+    {
+        // first -> second -> first, plus first -> third -> second, which the search reaches through a
+        // link it has already finished with.
+        document.add_node(first, NodeKind::link, "to second", document.get_id(second));
+        document.add_node(second, NodeKind::link, "to first", document.get_id(first));
+        document.add_node(first, NodeKind::link, "to third", document.get_id(third));
+        document.add_node(third, NodeKind::link, "third to second", document.get_id(second));
+        REQUIRE(get_messages(validate_tree(document)) ==
+                std::vector<std::string>{"Link 'to second' leads back to itself through #2",
+                                         "Link 'to first' leads back to itself through #1",
+                                         "Link 'to third' leads back to itself through #3",
+                                         "Link 'third to second' leads back to itself through #2"});
+    }
+
+    SECTION("links running the same subtree without a cycle")
+    {
+        document.add_node(second, NodeKind::link, "a", document.get_id(first));
+        document.add_node(third, NodeKind::link, "b", document.get_id(second));
+        document.add_node(third, NodeKind::link, "c", document.get_id(first));
+        REQUIRE(validate_tree(document).empty());
+    }
+}
+
+TEST_CASE("Loader matches a load on the calling thread", "[tree_loader]")
+{
+    TreeDocument original;
+    build_valid_tree(original, 50000, 3);
+    // A problem deep inside, found by the parallel part of validation.
+    auto deep = original.get_newest();
+    while(original.get_kind(deep) != NodeKind::selector && original.get_kind(deep) != NodeKind::sequence)
+    {
+        deep = original.get_parent(deep);
+    }
+    const auto broken = original.add_node(deep, NodeKind::link, "broken", 999999);
+    const auto path = std::filesystem::temp_directory_path() / "orchard_loader_test.btree";
+    save_tree(original, path);
+
+    WorkStealingPool pool{4};
+    const auto metrics = make_metrics();
+    constexpr size_t preview_size = 500;
+    TreeLoader loader{pool, metrics, TreeLayoutSettings{}, preview_size};
+    loader.start(path);
+    REQUIRE_THROWS_AS(loader.start(path), std::logic_error);
+    REQUIRE(wait_until_done(loader) == TreeLoader::Stage::finished);
+
+    TreeDocument preview;
+    TreeLayout preview_layout{preview};
+    REQUIRE(loader.take_preview(preview, preview_layout));
+    REQUIRE_FALSE(loader.take_preview(preview, preview_layout));
+    REQUIRE(!preview.is_empty());
+    REQUIRE(preview.size() <= preview_size);
+    REQUIRE(preview.get_id(preview.get_root()) == original.get_id(original.get_root()));
+    REQUIRE(preview.get_child_count(preview.get_root()) == original.get_child_count(original.get_root()));
+    REQUIRE(preview_layout.get_bounds(preview.get_root()).width ==
+            metrics.measure(preview.get_label(preview.get_root())));
+
+    TreeDocument loaded;
+    TreeLayout layout{loaded};
+    std::vector<ValidationIssue> issues;
+    REQUIRE(loader.take_result(loaded, layout, issues));
+    REQUIRE_FALSE(loader.take_result(loaded, layout, issues));
+    REQUIRE(to_text(loaded) == to_text(original));
+    REQUIRE(get_messages(issues) == get_messages(validate_tree(original)));
+    REQUIRE(issues.size() == 1);
+    REQUIRE(loaded.get_id(issues.front().node) == original.get_id(broken));
+
+    // Same geometry as a layout computed here.
+    TreeLayout expected{loaded};
+    for(index_t node = 0; node < loaded.get_capacity(); ++node)
+    {
+        if(loaded.contains(node))
+        {
+            expected.set_width(node, metrics.measure(loaded.get_label(node)));
+        }
+    }
+    expected.update();
+    for(index_t node = 0; node < loaded.get_capacity(); ++node)
+    {
+        if(loaded.contains(node))
+        {
+            REQUIRE(layout.get_bounds(node) == expected.get_bounds(node));
+        }
+    }
+    // The adopted layout keeps working incrementally.
+    const auto added = loaded.add_node(loaded.get_root(), NodeKind::action, "added");
+    layout.set_width(added, 100);
+    layout.invalidate(loaded.get_root());
+    const auto &changed = layout.update();
+    REQUIRE(std::find(changed.begin(), changed.end(), added) != changed.end());
+    REQUIRE(layout.get_bounds(added).width == 100);
+
+    const auto timings = loader.get_timings();
+    REQUIRE(timings.reading > 0.0);
+    REQUIRE(timings.laying_out > 0.0);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Loader can be cancelled and reports failures", "[tree_loader]")
+{
+    WorkStealingPool pool{2};
+    TreeLoader loader{pool, make_metrics()};
+
+    SECTION("cancelled")
+    {
+        TreeDocument original;
+        build_valid_tree(original, 200000, 5);
+        const auto path = std::filesystem::temp_directory_path() / "orchard_loader_cancel.tree";
+        save_tree(original, path);
+        loader.start(path);
+        loader.cancel();
+        REQUIRE(wait_until_done(loader) == TreeLoader::Stage::cancelled);
+        TreeDocument loaded;
+        TreeLayout layout{loaded};
+        std::vector<ValidationIssue> issues;
+        REQUIRE_FALSE(loader.take_result(loaded, layout, issues));
+
+        // The loader is reusable afterwards.
+        loader.start(path);
+        REQUIRE(wait_until_done(loader) == TreeLoader::Stage::finished);
+        REQUIRE(loader.take_result(loaded, layout, issues));
+        REQUIRE(loaded.size() == original.size());
+        std::filesystem::remove(path);
+    }
+
+    SECTION("failed")
+    {
+        loader.start(std::filesystem::temp_directory_path() / "orchard_loader_missing.btree");
+        REQUIRE(wait_until_done(loader) == TreeLoader::Stage::failed);
+        REQUIRE(loader.get_error().find("cannot open") != std::string::npos);
+    }
+}
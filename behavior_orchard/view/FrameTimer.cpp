@@ -0,0 +1,94 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "FrameTimer.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+void FrameTimer::begin_frame()
+{
+    frame_start = clock::now();
+}
+
+void FrameTimer::end_frame()
+{
+    const auto elapsed = std::chrono::duration_cast<duration>(clock::now() - frame_start);
+    history[history_position] = elapsed;
+    history_position = (history_position + 1) % history_size;
+    history_used = std::min(history_used + 1, history_size);
+    ++frame_count;
+    if(elapsed > frame_budget)
+    {
+        ++frames_over_budget;
+    }
+}
+
+void FrameTimer::reset()
+{
+    history.fill(duration::zero());
+    history_position = 0;
+    history_used = 0;
+    frame_count = 0;
+    frames_over_budget = 0;
+}
+
+FrameTimer::duration FrameTimer::get_last() const
+{
+    if(history_used == 0)
+    {
+        return duration::zero();
+    }
+    return history[(history_position + history_size - 1) % history_size];
+}
+
+FrameTimer::duration FrameTimer::get_average() const
+{
+    if(history_used == 0)
+    {
+        return duration::zero();
+    }
+    const auto total = std::accumulate(history.begin(), history.begin() + static_cast<std::ptrdiff_t>(history_used),
+                                       duration::zero());
+    return total / static_cast<duration::rep>(history_used);
+}
+
+FrameTimer::duration FrameTimer::get_worst() const
+{
+    if(history_used == 0)
+    {
+        return duration::zero();
+    }
+    return *std::max_element(history.begin(), history.begin() + static_cast<std::ptrdiff_t>(history_used));
+}
+
+uint64_t FrameTimer::get_frame_count() const
+{
+    return frame_count;
+}
+
+uint64_t FrameTimer::get_frames_over_budget() const
+{
+    return frames_over_budget;
+}
@@ -0,0 +1,63 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+// Measures how long the workspace takes to produce a frame. Keeps a short history, so the average
+// and the worst frame of the last few seconds of scrolling can be shown next to the last one.
+class FrameTimer
+{
+public:
+    using clock = std::chrono::steady_clock;
+    using duration = std::chrono::microseconds;
+
+    // One frame at 60 Hz.
+    static constexpr duration frame_budget{16000};
+
+    void begin_frame();
+    void end_frame();
+    void reset();
+
+    duration get_last() const;
+    duration get_average() const;
+    duration get_worst() const;
+    uint64_t get_frame_count() const;
+    uint64_t get_frames_over_budget() const;
+
+private:
+    static constexpr size_t history_size = 120;
+
+    std::array<duration, history_size> history{};
+    size_t history_position = 0;
+    size_t history_used = 0;
+    uint64_t frame_count = 0;
+    uint64_t frames_over_budget = 0;
+    clock::time_point frame_start{};
+};
+
+
@@ -0,0 +1,70 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "IconArtProvider.hpp"
+#include "EmbeddedIcons.hpp"
+
+#include <wx/image.h>
+#include <wx/mstream.h>
+
+#include <cstring>
+
+IconArtProvider::IconArtProvider()
+{
+    if(wxImage::FindHandler(wxBITMAP_TYPE_PNG) == nullptr)
+    {
+        wxImage::AddHandler(new wxPNGHandler);
+    }
+}
+
+size_t IconArtProvider::get_decoded_count() const
+{
+    return bitmaps.size();
+}
+
+wxBitmap IconArtProvider::CreateBitmap(const wxArtID &id, const wxArtClient &, const wxSize &)
+{
+    const std::string name{id.ToStdString()};
+    const auto known = bitmaps.find(name);
+    if(known != bitmaps.end())
+    {
+        return known->second;
+    }
+    for(size_t icon = 0; icon < embedded_icon_count; ++icon)
+    {
+        if(std::strcmp(embedded_icons[icon].name, name.c_str()) != 0)
+        {
+            continue;
+        }
+        wxMemoryInputStream stream{embedded_icons[icon].png, embedded_icons[icon].size};
+        wxImage image;
+        if(!image.LoadFile(stream, wxBITMAP_TYPE_PNG))
+        {
+            break;
+        }
+        return bitmaps[name] = wxBitmap{image};
+    }
+    // Other providers get their turn.
+    return wxNullBitmap;
+}
@@ -0,0 +1,52 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <wx/artprov.h>
+#include <wx/bitmap.h>
+
+#include <string>
+#include <unordered_map>
+
+// Hands out the embedded icons through wxArtProvider::GetBitmap, by the name of their file:
+// wxArtProvider::GetBitmap(wxT("temp0"), wxART_TOOLBAR). Each PNG is decoded the first time it is asked
+// for; the bitmap is kept and shared with every later request, whichever client or size it comes
+// with - wxBitmap is reference counted, so the copies cost nothing.
+class IconArtProvider: public wxArtProvider
+{
+public:
+    IconArtProvider();
+
+    // PNGs decoded so far.
+    size_t get_decoded_count() const;
+
+protected:
+    wxBitmap CreateBitmap(const wxArtID &id, const wxArtClient &client, const wxSize &size) override;
+
+private:
+    std::unordered_map<std::string, wxBitmap> bitmaps;
+};
+
+
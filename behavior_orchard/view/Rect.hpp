@@ -0,0 +1,89 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+// Axis-aligned rectangle in workspace (logical, unscrolled) coordinates.
+struct Rect
+{
+    int32_t x = 0;
+    int32_t y = 0;
+    int32_t width = 0;
+    int32_t height = 0;
+
+    int32_t right() const
+    {
+        return x + width;
+    }
+
+    int32_t bottom() const
+    {
+        return y + height;
+    }
+
+    bool is_empty() const
+    {
+        return width <= 0 || height <= 0;
+    }
+
+    bool intersects(const Rect &other) const
+    {
+        return x < other.right() && other.x < right() && y < other.bottom() && other.y < bottom();
+    }
+
+    Rect united(const Rect &other) const
+    {
+        if(is_empty())
+        {
+            return other;
+        }
+        if(other.is_empty())
+        {
+            return *this;
+        }
+        const auto left = std::min(x, other.x);
+        const auto top = std::min(y, other.y);
+        return {left, top, std::max(right(), other.right()) - left, std::max(bottom(), other.bottom()) - top};
+    }
+
+    Rect inflated(int32_t margin) const
+    {
+        return {x - margin, y - margin, width + 2 * margin, height + 2 * margin};
+    }
+
+    bool operator==(const Rect &other) const
+    {
+        return x == other.x && y == other.y && width == other.width && height == other.height;
+    }
+
+    bool operator!=(const Rect &other) const
+    {
+        return !(*this == other);
+    }
+};
+
+
@@ -0,0 +1,228 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "SpatialGrid.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    int32_t floor_divide(int32_t value, int32_t divisor)
+    {
+        auto quotient = value / divisor;
+        if((value % divisor != 0) && ((value < 0) != (divisor < 0)))
+        {
+            --quotient;
+        }
+        return quotient;
+    }
+}
+
+SpatialGrid::SpatialGrid(int32_t grid_cell_size):
+        cell_size{grid_cell_size},
+        item_count{0},
+        current_stamp{0}
+{
+    if(cell_size <= 0)
+    {
+        throw std::invalid_argument("SpatialGrid: cell size has to be positive");
+    }
+}
+
+void SpatialGrid::insert(item_t item, const Rect &item_bounds)
+{
+    if(contains(item))
+    {
+        move(item, item_bounds);
+        return;
+    }
+    if(item >= bounds.size())
+    {
+        bounds.resize(item + 1);
+        present.resize(item + 1, false);
+        visit_stamp.resize(item + 1, 0);
+    }
+    bounds[item] = item_bounds;
+    present[item] = true;
+    ++item_count;
+
+    const auto range = get_cells(item_bounds);
+    for(auto row = range.first_row; row <= range.last_row; ++row)
+    {
+        for(auto column = range.first_column; column <= range.last_column; ++column)
+        {
+            cells[make_key(column, row)].push_back(item);
+        }
+    }
+}
+
+void SpatialGrid::remove(item_t item)
+{
+    if(!contains(item))
+    {
+        return;
+    }
+    const auto range = get_cells(bounds[item]);
+    for(auto row = range.first_row; row <= range.last_row; ++row)
+    {
+        for(auto column = range.first_column; column <= range.last_column; ++column)
+        {
+            const auto cell = cells.find(make_key(column, row));
+            if(cell == cells.end())
+            {
+                continue;
+            }
+            auto &items = cell->second;
+            const auto position = std::find(items.begin(), items.end(), item);
+            if(position != items.end())
+            {
+                *position = items.back();
+                items.pop_back();
+            }
+            if(items.empty())
+            {
+                cells.erase(cell);
+            }
+        }
+    }
+    present[item] = false;
+    --item_count;
+}
+
+void SpatialGrid::move(item_t item, const Rect &item_bounds)
+{
+    if(!contains(item))
+    {
+        insert(item, item_bounds);
+        return;
+    }
+    const auto old_range = get_cells(bounds[item]);
+    const auto new_range = get_cells(item_bounds);
+    if(old_range.first_column == new_range.first_column && old_range.last_column == new_range.last_column &&
+       old_range.first_row == new_range.first_row && old_range.last_row == new_range.last_row)
+    {
+        // Still covers the same cells - only the stored bounds change.
+        bounds[item] = item_bounds;
+        return;
+    }
+    remove(item);
+    insert(item, item_bounds);
+}
+
+void SpatialGrid::clear()
+{
+    cells.clear();
+    bounds.clear();
+    present.clear();
+    visit_stamp.clear();
+    item_count = 0;
+    current_stamp = 0;
+}
+
+bool SpatialGrid::contains(item_t item) const
+{
+    return item < present.size() && present[item];
+}
+
+const Rect &SpatialGrid::get_bounds(item_t item) const
+{
+    return bounds.at(item);
+}
+
+size_t SpatialGrid::size() const
+{
+    return item_count;
+}
+
+void SpatialGrid::query(const Rect &area, std::vector<item_t> &result) const
+{
+    if(area.is_empty() || item_count == 0)
+    {
+        return;
+    }
+    if(++current_stamp == 0)
+    {
+        std::fill(visit_stamp.begin(), visit_stamp.end(), 0);
+        current_stamp = 1;
+    }
+
+    const auto range = get_cells(area);
+    const auto columns = static_cast<uint64_t>(int64_t{range.last_column} - range.first_column + 1);
+    const auto rows = static_cast<uint64_t>(int64_t{range.last_row} - range.first_row + 1);
+    if(columns * rows > cells.size())
+    {
+        // Area bigger than the populated part of the grid (e.g. zoomed out) - walking the occupied
+        // cells is cheaper than probing every empty one.
+        for(const auto &cell: cells)
+        {
+            collect(cell.second, area, result);
+        }
+        return;
+    }
+    for(auto row = range.first_row; row <= range.last_row; ++row)
+    {
+        for(auto column = range.first_column; column <= range.last_column; ++column)
+        {
+            const auto cell = cells.find(make_key(column, row));
+            if(cell != cells.end())
+            {
+                collect(cell->second, area, result);
+            }
+        }
+    }
+}
+
+SpatialGrid::CellRange SpatialGrid::get_cells(const Rect &area) const
+{
+    // Zero-sized items still occupy the cell they are in.
+    const auto right = area.width > 0 ? area.right() - 1 : area.x;
+    const auto bottom = area.height > 0 ? area.bottom() - 1 : area.y;
+    return {floor_divide(area.x, cell_size), floor_divide(right, cell_size),
+            floor_divide(area.y, cell_size), floor_divide(bottom, cell_size)};
+}
+
+SpatialGrid::cell_key_t SpatialGrid::make_key(int32_t column, int32_t row)
+{
+    return (static_cast<cell_key_t>(static_cast<uint32_t>(column)) << 32u) | static_cast<uint32_t>(row);
+}
+
+void SpatialGrid::collect(const std::vector<item_t> &cell, const Rect &area, std::vector<item_t> &result) const
+{
+    for(const auto item: cell)
+    {
+        if(visit_stamp[item] == current_stamp)
+        {
+            continue;
+        }
+        visit_stamp[item] = current_stamp;
+        const auto &item_bounds = bounds[item];
+        // Degenerate (zero-width or zero-height) bounds, like vertical edges, still count as hits.
+        const Rect probe{item_bounds.x, item_bounds.y, std::max(item_bounds.width, 1), std::max(item_bounds.height, 1)};
+        if(probe.intersects(area))
+        {
+            result.push_back(item);
+        }
+    }
+}
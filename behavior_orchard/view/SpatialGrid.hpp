@@ -0,0 +1,82 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include "Rect.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Uniform grid over the workspace plane. Every item is registered in each cell its bounds touch,
+// so a viewport query only visits the cells under the viewport instead of every item in the tree.
+// Items are dense indices (the renderer uses node indices directly).
+class SpatialGrid
+{
+public:
+    using item_t = uint32_t;
+
+    explicit SpatialGrid(int32_t grid_cell_size = 256);
+
+    void insert(item_t item, const Rect &bounds);
+    void remove(item_t item);
+    void move(item_t item, const Rect &bounds);
+    void clear();
+
+    bool contains(item_t item) const;
+    const Rect &get_bounds(item_t item) const;
+    size_t size() const;
+
+    // Appends every item whose bounds intersect the area; each item is reported once.
+    void query(const Rect &area, std::vector<item_t> &result) const;
+
+private:
+    using cell_key_t = uint64_t;
+
+    struct CellRange
+    {
+        int32_t first_column;
+        int32_t last_column;
+        int32_t first_row;
+        int32_t last_row;
+    };
+
+    CellRange get_cells(const Rect &area) const;
+    static cell_key_t make_key(int32_t column, int32_t row);
+    void collect(const std::vector<item_t> &cell, const Rect &area, std::vector<item_t> &result) const;
+
+    int32_t cell_size;
+    size_t item_count;
+    std::unordered_map<cell_key_t, std::vector<item_t>> cells;
+    std::vector<Rect> bounds;
+    std::vector<bool> present;
+
+    // Per-item stamp of the last query which reported it; lets a query skip duplicates
+    // (items spanning several cells) without a temporary set.
+    mutable std::vector<uint32_t> visit_stamp;
+    mutable uint32_t current_stamp;
+};
+
+
@@ -0,0 +1,70 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "StartupTimer.hpp"
+
+#include <cstdio>
+
+namespace
+{
+    double to_milliseconds(StartupTimer::duration length)
+    {
+        return std::chrono::duration<double, std::milli>(length).count();
+    }
+}
+
+StartupTimer::StartupTimer(): start{clock::now()}, last_mark{start}
+{
+}
+
+void StartupTimer::mark(std::string_view phase)
+{
+    const auto now = clock::now();
+    phases.push_back({std::string{phase}, std::chrono::duration_cast<duration>(now - last_mark),
+                      std::chrono::duration_cast<duration>(now - start)});
+    last_mark = now;
+}
+
+const std::vector<StartupTimer::Phase> &StartupTimer::get_phases() const
+{
+    return phases;
+}
+
+StartupTimer::duration StartupTimer::get_total() const
+{
+    return phases.empty() ? duration::zero() : phases.back().elapsed;
+}
+
+std::string StartupTimer::format() const
+{
+    std::string text;
+    for(const auto &phase: phases)
+    {
+        char line[160];
+        std::snprintf(line, sizeof(line), "%-24s %9.2f ms (%9.2f ms)\n", (phase.name + ":").c_str(),
+                      to_milliseconds(phase.length), to_milliseconds(phase.elapsed));
+        text += line;
+    }
+    return text;
+}
@@ -0,0 +1,65 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Splits the cold start of the editor into phases, from the moment the process starts (construction)
+// to the first frame drawn and the panels built after it. Each mark ends the phase begun by the mark
+// before it.
+class StartupTimer
+{
+public:
+    using clock = std::chrono::steady_clock;
+    using duration = std::chrono::microseconds;
+
+    struct Phase
+    {
+        std::string name;
+        duration length;
+        // Since construction, up to the end of the phase.
+        duration elapsed;
+    };
+
+    StartupTimer();
+
+    void mark(std::string_view phase);
+
+    const std::vector<Phase> &get_phases() const;
+    // Since construction, up to the last mark.
+    duration get_total() const;
+    // One "name: length ms (elapsed ms)" line per phase.
+    std::string format() const;
+
+private:
+    clock::time_point start;
+    clock::time_point last_mark;
+    std::vector<Phase> phases;
+};
+
+
@@ -0,0 +1,423 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#include "WorkspaceRenderer.hpp"
+
+#include <wx/brush.h>
+#include <wx/dcbuffer.h>
+
+#include <algorithm>
+
+namespace
+{
+    constexpr int32_t margin = 20;
+    constexpr int32_t current_outline = 3;
+    constexpr int32_t overlay_inset = 3;
+    constexpr int32_t overlay_bar_height = 4;
+
+    const wxColour success_colour{70, 170, 70};
+    const wxColour failure_colour{210, 60, 50};
+    const wxColour running_colour{150, 150, 150};
+}
+
+WorkspaceRenderer::WorkspaceRenderer(wxScrolledWindow *target_canvas):
+        canvas{target_canvas},
+        current{no_node},
+        edge_pen{wxColour(120, 120, 120)},
+        node_pen{wxColour(60, 60, 60)},
+        current_pen{wxColour(230, 120, 0), current_outline},
+        success_brush{success_colour},
+        failure_brush{failure_colour},
+        running_brush{running_colour},
+        overlay_font{target_canvas->GetFont().Smaller()}
+{
+    // Everything is painted by on_paint into a back buffer; skipping the default background
+    // erase removes flicker while scrolling.
+    canvas->SetBackgroundStyle(wxBG_STYLE_PAINT);
+    canvas->Bind(wxEVT_PAINT, &WorkspaceRenderer::on_paint, this);
+}
+
+WorkspaceRenderer::~WorkspaceRenderer()
+{
+    canvas->Unbind(wxEVT_PAINT, &WorkspaceRenderer::on_paint, this);
+}
+
+void WorkspaceRenderer::set_node(node_t node, node_t parent, const Rect &bounds, const wxString &label,
+                                 const wxColour &fill)
+{
+    const auto highest = parent == no_node ? node : std::max(node, parent);
+    if(highest >= nodes.size())
+    {
+        nodes.resize(highest + 1);
+    }
+    auto &visual = nodes[node];
+    auto damaged = visual.present ? visual.bounds : Rect{};
+    const auto moved = !visual.present || visual.bounds != bounds;
+    const auto reparented = !visual.present || visual.parent != parent;
+
+    if(reparented)
+    {
+        if(visual.present)
+        {
+            damaged = damaged.united(get_edge_bounds(node));
+            detach(node);
+        }
+        attach(node, parent);
+    }
+    visual.bounds = bounds;
+    visual.label = label;
+    visual.fill = wxBrush(fill);
+    visual.present = true;
+
+    node_index.move(node, bounds);
+    damaged = damaged.united(bounds.inflated(current_outline));
+    // The edge to the parent follows both the node and the parent; those to the children only the node.
+    if(moved || reparented)
+    {
+        damaged = damaged.united(edge_index.contains(node) ? edge_index.get_bounds(node) : Rect{});
+        update_edge(node);
+    }
+    if(moved)
+    {
+        for(auto child = visual.first_child; child != no_node; child = nodes[child].next_sibling)
+        {
+            damaged = damaged.united(edge_index.contains(child) ? edge_index.get_bounds(child) : Rect{});
+            update_edge(child);
+            damaged = damaged.united(get_edge_bounds(child));
+        }
+    }
+    damaged = damaged.united(get_edge_bounds(node));
+
+    grow_virtual_size(bounds);
+    invalidate(damaged);
+}
+
+void WorkspaceRenderer::remove_node(node_t node)
+{
+    if(!contains(node))
+    {
+        return;
+    }
+    auto &visual = nodes[node];
+    auto damaged = visual.bounds.inflated(current_outline).united(get_edge_bounds(node));
+    for(auto child = visual.first_child; child != no_node;)
+    {
+        const auto next = nodes[child].next_sibling;
+        damaged = damaged.united(get_edge_bounds(child));
+        nodes[child].parent = no_node;
+        nodes[child].next_sibling = no_node;
+        nodes[child].previous_sibling = no_node;
+        edge_index.remove(child);
+        child = next;
+    }
+    visual.first_child = no_node;
+    detach(node);
+    node_index.remove(node);
+    edge_index.remove(node);
+    visual = NodeVisual{};
+    if(current == node)
+    {
+        current = no_node;
+    }
+    invalidate(damaged);
+}
+
+void WorkspaceRenderer::clear()
+{
+    nodes.clear();
+    node_index.clear();
+    edge_index.clear();
+    content_bounds = Rect{};
+    current = no_node;
+    canvas->SetVirtualSize(0, 0);
+    canvas->Refresh(false);
+}
+
+void WorkspaceRenderer::set_overlay(node_t node, const Overlay &overlay)
+{
+    if(!contains(node))
+    {
+        return;
+    }
+    auto &visual = nodes[node];
+    visual.overlay = overlay;
+    visual.heat = wxBrush(overlay.heat);
+    visual.has_overlay = true;
+    invalidate(visual.bounds);
+}
+
+void WorkspaceRenderer::clear_overlays()
+{
+    for(auto &visual: nodes)
+    {
+        if(visual.has_overlay)
+        {
+            visual.overlay = Overlay{};
+            visual.heat = wxBrush{};
+            visual.has_overlay = false;
+            invalidate(visual.bounds);
+        }
+    }
+}
+
+void WorkspaceRenderer::set_current(node_t node)
+{
+    if(node == current)
+    {
+        return;
+    }
+    if(contains(current))
+    {
+        invalidate(nodes[current].bounds.inflated(current_outline));
+    }
+    current = node;
+    if(contains(current))
+    {
+        invalidate(nodes[current].bounds.inflated(current_outline));
+    }
+}
+
+void WorkspaceRenderer::scroll_to(node_t node)
+{
+    if(!contains(node))
+    {
+        return;
+    }
+    int unit_x = 0;
+    int unit_y = 0;
+    canvas->GetScrollPixelsPerUnit(&unit_x, &unit_y);
+    if(unit_x <= 0 || unit_y <= 0)
+    {
+        return;
+    }
+    const auto client = canvas->GetClientSize();
+    const auto &bounds = nodes[node].bounds;
+    const auto left = std::max(0, bounds.x + bounds.width / 2 - client.GetWidth() / 2);
+    const auto top = std::max(0, bounds.y + bounds.height / 2 - client.GetHeight() / 2);
+    canvas->Scroll(left / unit_x, top / unit_y);
+}
+
+bool WorkspaceRenderer::contains(node_t node) const
+{
+    return node < nodes.size() && nodes[node].present;
+}
+
+const Rect &WorkspaceRenderer::get_bounds(node_t node) const
+{
+    return nodes.at(node).bounds;
+}
+
+const FrameTimer &WorkspaceRenderer::get_frame_timer() const
+{
+    return frame_timer;
+}
+
+void WorkspaceRenderer::set_frame_listener(std::function<void(const FrameTimer &)> listener)
+{
+    frame_listener = std::move(listener);
+}
+
+void WorkspaceRenderer::on_paint(wxPaintEvent &)
+{
+    frame_timer.begin_frame();
+
+    wxAutoBufferedPaintDC dc(canvas);
+    canvas->DoPrepareDC(dc);
+
+    // Update region is in device coordinates; the indices work on unscrolled ones.
+    const auto damaged = canvas->GetUpdateRegion().GetBox();
+    const auto origin = canvas->CalcUnscrolledPosition(damaged.GetTopLeft());
+    const Rect area{origin.x, origin.y, damaged.GetWidth(), damaged.GetHeight()};
+
+    dc.SetPen(*wxTRANSPARENT_PEN);
+    dc.SetBrush(wxBrush(canvas->GetBackgroundColour()));
+    dc.DrawRectangle(area.x, area.y, area.width, area.height);
+
+    visible.clear();
+    edge_index.query(area, visible);
+    dc.SetPen(edge_pen);
+    for(const auto child: visible)
+    {
+        draw_edge(dc, child);
+    }
+
+    visible.clear();
+    node_index.query(area, visible);
+    for(const auto node: visible)
+    {
+        draw_node(dc, node);
+    }
+
+    frame_timer.end_frame();
+    if(frame_listener)
+    {
+        frame_listener(frame_timer);
+    }
+}
+
+void WorkspaceRenderer::attach(node_t node, node_t parent)
+{
+    auto &visual = nodes[node];
+    visual.parent = parent;
+    visual.previous_sibling = no_node;
+    visual.next_sibling = no_node;
+    if(parent == no_node)
+    {
+        return;
+    }
+    auto &parent_visual = nodes[parent];
+    visual.next_sibling = parent_visual.first_child;
+    if(parent_visual.first_child != no_node)
+    {
+        nodes[parent_visual.first_child].previous_sibling = node;
+    }
+    parent_visual.first_child = node;
+}
+
+void WorkspaceRenderer::detach(node_t node)
+{
+    auto &visual = nodes[node];
+    if(visual.parent == no_node)
+    {
+        return;
+    }
+    if(visual.previous_sibling != no_node)
+    {
+        nodes[visual.previous_sibling].next_sibling = visual.next_sibling;
+    }
+    else
+    {
+        nodes[visual.parent].first_child = visual.next_sibling;
+    }
+    if(visual.next_sibling != no_node)
+    {
+        nodes[visual.next_sibling].previous_sibling = visual.previous_sibling;
+    }
+    visual.parent = no_node;
+    visual.next_sibling = no_node;
+    visual.previous_sibling = no_node;
+}
+
+void WorkspaceRenderer::update_edge(node_t child)
+{
+    const auto edge = get_edge_bounds(child);
+    if(edge.is_empty())
+    {
+        edge_index.remove(child);
+        return;
+    }
+    edge_index.move(child, edge);
+}
+
+Rect WorkspaceRenderer::get_edge_bounds(node_t child) const
+{
+    if(!contains(child))
+    {
+        return {};
+    }
+    const auto parent = nodes[child].parent;
+    if(!contains(parent))
+    {
+        return {};
+    }
+    const auto &from = nodes[parent].bounds;
+    const auto &to = nodes[child].bounds;
+    const auto from_x = from.x + from.width / 2;
+    const auto to_x = to.x + to.width / 2;
+    const auto left = std::min(from_x, to_x);
+    const auto top = std::min(from.bottom(), to.y);
+    return Rect{left, top, std::max(from_x, to_x) - left, std::max(from.bottom(), to.y) - top}.inflated(1);
+}
+
+void WorkspaceRenderer::invalidate(const Rect &area)
+{
+    if(area.is_empty())
+    {
+        return;
+    }
+    const auto origin = canvas->CalcScrolledPosition(wxPoint(area.x, area.y));
+    canvas->RefreshRect(wxRect(origin.x, origin.y, area.width, area.height), false);
+}
+
+void WorkspaceRenderer::grow_virtual_size(const Rect &bounds)
+{
+    const auto grown = content_bounds.united(bounds);
+    if(grown == content_bounds)
+    {
+        return;
+    }
+    content_bounds = grown;
+    canvas->SetVirtualSize(std::max(0, content_bounds.right()) + margin, std::max(0, content_bounds.bottom()) + margin);
+}
+
+void WorkspaceRenderer::draw_edge(wxDC &dc, node_t child) const
+{
+    const auto &from = nodes[nodes[child].parent].bounds;
+    const auto &to = nodes[child].bounds;
+    dc.DrawLine(from.x + from.width / 2, from.bottom(), to.x + to.width / 2, to.y);
+}
+
+void WorkspaceRenderer::draw_node(wxDC &dc, node_t node) const
+{
+    const auto &visual = nodes[node];
+    const wxRect box(visual.bounds.x, visual.bounds.y, visual.bounds.width, visual.bounds.height);
+    dc.SetPen(node == current ? current_pen : node_pen);
+    dc.SetBrush(visual.fill);
+    dc.DrawRoundedRectangle(box, 4.0);
+    dc.DrawLabel(visual.label, box, wxALIGN_CENTER);
+    if(visual.has_overlay)
+    {
+        draw_overlay(dc, visual);
+    }
+}
+
+void WorkspaceRenderer::draw_overlay(wxDC &dc, const NodeVisual &visual) const
+{
+    const auto &bounds = visual.bounds;
+    const auto &overlay = visual.overlay;
+    dc.SetPen(*wxTRANSPARENT_PEN);
+
+    const auto bar_x = bounds.x + overlay_inset;
+    const auto bar_y = bounds.y + bounds.height - overlay_inset - overlay_bar_height;
+    const auto bar_width = std::max(0, bounds.width - 2 * overlay_inset);
+    const auto success_width = static_cast<int32_t>(bar_width * std::clamp(overlay.success_share, 0.0, 1.0));
+    const auto failure_width = std::min(bar_width - success_width,
+                                        static_cast<int32_t>(bar_width * std::clamp(overlay.failure_share, 0.0, 1.0)));
+    dc.SetBrush(running_brush);
+    dc.DrawRectangle(bar_x, bar_y, bar_width, overlay_bar_height);
+    dc.SetBrush(success_brush);
+    dc.DrawRectangle(bar_x, bar_y, success_width, overlay_bar_height);
+    dc.SetBrush(failure_brush);
+    dc.DrawRectangle(bar_x + success_width, bar_y, failure_width, overlay_bar_height);
+
+    const auto previous_font = dc.GetFont();
+    dc.SetFont(overlay_font);
+    const auto extent = dc.GetTextExtent(overlay.caption);
+    const auto badge_x = bounds.x + overlay_inset;
+    const auto badge_y = bounds.y + overlay_inset;
+    dc.SetBrush(visual.heat);
+    dc.DrawRectangle(badge_x, badge_y, extent.GetWidth() + 2 * overlay_inset, extent.GetHeight());
+    dc.DrawText(overlay.caption, badge_x + overlay_inset, badge_y);
+    dc.SetFont(previous_font);
+}
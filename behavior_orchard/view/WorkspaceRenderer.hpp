@@ -0,0 +1,143 @@
+/*
+    This file is distributed under MIT License.
+
+    Copyright (c) 2020 draghan
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#pragma once
+
+#include "FrameTimer.hpp"
+#include "Rect.hpp"
+#include "SpatialGrid.hpp"
+
+#include <wx/brush.h>
+#include <wx/colour.h>
+#include <wx/font.h>
+#include <wx/pen.h>
+#include <wx/scrolwin.h>
+#include <wx/string.h>
+
+#include <functional>
+#include <limits>
+#include <vector>
+
+class wxDC;
+class wxPaintEvent;
+
+// Draws the tree on the workspace canvas.
+// Node boxes and parent-child edges are kept in spatial grids, so painting touches only what
+// intersects the damaged part of the viewport - the cost of a frame depends on what is visible,
+// not on the size of the tree. Edits invalidate only the old and new area of the changed items.
+class WorkspaceRenderer
+{
+public:
+    using node_t = SpatialGrid::item_t;
+    static constexpr node_t no_node = std::numeric_limits<node_t>::max();
+
+    // Drawn inside the node box: a caption on a badge in the heat colour at the top left, and a bar
+    // along the bottom split by the shares of results.
+    struct Overlay
+    {
+        wxString caption;
+        wxColour heat;
+        double success_share = 0.0;
+        double failure_share = 0.0;
+    };
+
+    explicit WorkspaceRenderer(wxScrolledWindow *target_canvas);
+    ~WorkspaceRenderer();
+
+    WorkspaceRenderer(const WorkspaceRenderer &) = delete;
+    WorkspaceRenderer &operator=(const WorkspaceRenderer &) = delete;
+
+    // Adds the node or updates it in place. Edge to the parent is drawn from the bottom of the
+    // parent box to the top of the node box.
+    void set_node(node_t node, node_t parent, const Rect &bounds, const wxString &label, const wxColour &fill);
+    // Removes the node and its edge; its children (if any) stay, but lose the edge to it.
+    void remove_node(node_t node);
+    void clear();
+
+    void set_overlay(node_t node, const Overlay &overlay);
+    void clear_overlays();
+
+    void set_current(node_t node);
+    void scroll_to(node_t node);
+
+    bool contains(node_t node) const;
+    const Rect &get_bounds(node_t node) const;
+
+    const FrameTimer &get_frame_timer() const;
+    void set_frame_listener(std::function<void(const FrameTimer &)> listener);
+
+private:
+    struct NodeVisual
+    {
+        Rect bounds;
+        wxString label;
+        // Brushes are made when the node or its overlay is set, not on every paint.
+        wxBrush fill;
+        Overlay overlay;
+        wxBrush heat;
+        bool has_overlay = false;
+        node_t parent = no_node;
+        node_t first_child = no_node;
+        node_t next_sibling = no_node;
+        node_t previous_sibling = no_node;
+        bool present = false;
+    };
+
+    void on_paint(wxPaintEvent &event);
+
+    void attach(node_t node, node_t parent);
+    void detach(node_t node);
+    void update_edge(node_t child);
+    Rect get_edge_bounds(node_t child) const;
+
+    void invalidate(const Rect &area);
+    void grow_virtual_size(const Rect &bounds);
+
+    void draw_edge(wxDC &dc, node_t child) const;
+    void draw_node(wxDC &dc, node_t node) const;
+    void draw_overlay(wxDC &dc, const NodeVisual &visual) const;
+
+    wxScrolledWindow *canvas;
+    std::vector<NodeVisual> nodes;
+    SpatialGrid node_index;
+    // Keyed by the child end of the edge - every node has at most one edge to its parent.
+    SpatialGrid edge_index;
+    Rect content_bounds;
+    node_t current;
+
+    wxPen edge_pen;
+    wxPen node_pen;
+    wxPen current_pen;
+    wxBrush success_brush;
+    wxBrush failure_brush;
+    wxBrush running_brush;
+    wxFont overlay_font;
+
+    FrameTimer frame_timer;
+    std::function<void(const FrameTimer &)> frame_listener;
+    // Reused between frames to keep painting free of allocations.
+    std::vector<SpatialGrid::item_t> visible;
+};
+
+